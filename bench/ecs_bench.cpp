@@ -0,0 +1,144 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <algorithm>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "component.hpp"
+#include "component_types.hpp"
+#include "sparse_set.hpp"
+
+namespace ct = robot::src::exports::component_types;
+using robot::src::Component;
+using robot::src::exports::sparse_set::SparseSet;
+
+namespace
+{
+// Entity ids in a shuffled order, so lookups and erases do not walk memory linearly
+std::vector< std::size_t > shuffledIds( std::size_t n )
+{
+    std::vector< std::size_t > ids( n );
+    for( std::size_t i = 0; i < n; ++i )
+    {
+        ids[ i ] = i;
+    }
+    std::shuffle( ids.begin(), ids.end(), std::mt19937( 7 ) );
+    return ids;
+}
+
+std::string label( std::size_t n )
+{
+    return std::to_string( n / 1000 ) + "k entities";
+}
+} // namespace
+
+TEST_CASE( "SparseSet operations", "[bench][ecs][sparse_set]" )
+{
+    for( std::size_t n : { 1'000, 10'000, 100'000 } )
+    {
+        auto ids = shuffledIds( n );
+        SparseSet<> full;
+        full.insert_range( ids );
+
+        BENCHMARK( "insert one by one, " + label( n ) )
+        {
+            SparseSet<> set;
+            for( auto id : ids )
+            {
+                set.insert( id );
+            }
+            return set.size();
+        };
+
+        BENCHMARK( "insert_range, " + label( n ) )
+        {
+            SparseSet<> set;
+            set.insert_range( ids );
+            return set.size();
+        };
+
+        BENCHMARK( "contains, hits and misses, " + label( n ) )
+        {
+            std::size_t found = 0;
+            for( auto id : ids )
+            {
+                found += full.contains( id ) + full.contains( id + n );
+            }
+            return found;
+        };
+
+        BENCHMARK_ADVANCED( "erase every id, " + label( n ) )( Catch::Benchmark::Chronometer meter )
+        {
+            std::vector< SparseSet<> > sets( meter.runs(), full );
+            meter.measure( [ & ]( int run ) {
+                for( auto id : ids )
+                {
+                    sets[ run ].erase( id );
+                }
+                return sets[ run ].size();
+            } );
+        };
+    }
+}
+
+TEST_CASE( "Component iteration", "[bench][ecs][component]" )
+{
+    for( std::size_t n : { 1'000, 10'000, 100'000 } )
+    {
+        ct::EntityStore store;
+        for( auto id : shuffledIds( n ) )
+        {
+            store.get< ct::Position >().insert( id, ct::Position{ 1.0f, 2.0f } );
+            // Every other entity moves, so the join has to skip half of the positions
+            if( id % 2 == 0 )
+            {
+                store.get< ct::Velocity >().insert( id, ct::Velocity{ 0.5f, 0.25f } );
+            }
+        }
+        const auto & positions = store.get< ct::Position >();
+
+        BENCHMARK( "range-for over (entity, data) pairs, " + label( n ) )
+        {
+            float sum = 0.0f;
+            for( auto [ entity, position ] : positions )
+            {
+                sum += position.x;
+            }
+            return sum;
+        };
+
+        BENCHMARK( "dense_data span, " + label( n ) )
+        {
+            float sum = 0.0f;
+            for( const auto & position : positions.dense_data() )
+            {
+                sum += position.x;
+            }
+            return sum;
+        };
+
+        BENCHMARK( "random lookups by entity, " + label( n ) )
+        {
+            float sum = 0.0f;
+            for( std::size_t id = 0; id < n; id += 7 )
+            {
+                sum += positions[ id ].y;
+            }
+            return sum;
+        };
+
+        BENCHMARK( "view< Velocity, Position > join, " + label( n ) )
+        {
+            float sum = 0.0f;
+            store.view< ct::Velocity, ct::Position >().for_each(
+                [ & ]( std::size_t, const ct::Velocity & velocity, const ct::Position & position ) {
+                    sum += velocity.x * position.x;
+                } );
+            return sum;
+        };
+    }
+}
@@ -0,0 +1,83 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <random>
+#include <string>
+
+#include "component_types.hpp"
+#include "job_system.hpp"
+#include "systems.hpp"
+
+namespace ct = robot::src::exports::component_types;
+namespace sys = robot::src::exports::systems;
+
+namespace
+{
+/// @brief A store with n moving points and no Bounds, so only the integration is measured.
+ct::EntityStore makeMovers( std::size_t n )
+{
+    ct::EntityStore store;
+    std::mt19937 rng( 42 );
+    std::uniform_real_distribution< float > place( sys::WORLD_MIN_X, sys::WORLD_MAX_X );
+    std::uniform_real_distribution< float > speed( -2.0f, 2.0f );
+    for( std::size_t i = 0; i < n; ++i )
+    {
+        auto entity = store.create().id();
+        store.get< ct::Position >().insert( entity, ct::Position{ place( rng ), place( rng ) } );
+        store.get< ct::Velocity >().insert( entity, ct::Velocity{ speed( rng ), speed( rng ) } );
+    }
+    return store;
+}
+
+/// @brief The per-entity join with loop-based wrapping that updatePositions used before the kernel.
+float wrapWithLoops( float value, float min_val, float max_val )
+{
+    float range = max_val - min_val;
+    while( value < min_val )
+        value += range;
+    while( value >= max_val )
+        value -= range;
+    return value;
+}
+
+void updateOneByOne( ct::EntityStore & store )
+{
+    store.view< ct::Velocity, ct::Position >().for_each(
+        []( std::size_t, const ct::Velocity & velocity, ct::Position & position ) {
+            position.x = wrapWithLoops( position.x + velocity.x, sys::WORLD_MIN_X, sys::WORLD_MAX_X );
+            position.y = wrapWithLoops( position.y + velocity.y, sys::WORLD_MIN_Y, sys::WORLD_MAX_Y );
+        } );
+}
+} // namespace
+
+TEST_CASE( "Position integration of moving entities", "[bench][motion]" )
+{
+    robot::src::JobSystem jobs;
+    for( std::size_t n : { 10'000, 100'000, 1'000'000 } )
+    {
+        auto store = makeMovers( n );
+        sys::MotionLayout layout;
+        sys::updatePositions( store, layout );
+        auto label = std::to_string( n / 1000 ) + "k entities";
+
+        BENCHMARK( "per-entity view with loop wrap, " + label )
+        {
+            updateOneByOne( store );
+            return store.get< ct::Position >().size();
+        };
+
+        BENCHMARK( "SIMD kernel over aligned storages, " + label )
+        {
+            sys::updatePositions( store, layout );
+            return layout.size;
+        };
+
+        BENCHMARK( "SIMD kernel chunked across the job system, " + label )
+        {
+            sys::updatePositions( store, layout, jobs );
+            return layout.size;
+        };
+    }
+}
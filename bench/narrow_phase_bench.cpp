@@ -0,0 +1,66 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+#include "component_types.hpp"
+
+namespace ct = robot::src::exports::component_types;
+using robot::src::Vec2;
+
+namespace
+{
+ct::Polygon regularPolygon( int vertex_count, float radius )
+{
+    ct::Polygon polygon;
+    for( int i = 0; i < vertex_count; ++i )
+    {
+        float angle = ( 2.0f * 3.14159265f * i ) / vertex_count;
+        polygon.emplace_back( radius * std::cos( angle ), radius * std::sin( angle ) );
+    }
+    return polygon;
+}
+} // namespace
+
+TEST_CASE( "Narrow phase cost per pair", "[bench][narrow_phase]" )
+{
+    // The robot's square against a heptagon obstacle, the largest shape the
+    // procedural generator produces.
+    auto robot_shape = regularPolygon( 4, 14.1f );
+    auto obstacle = regularPolygon( 7, 20.0f );
+
+    // Each benchmark tests 64 pairs so per-call timer overhead stays negligible;
+    // divide the reported mean by 64 for the cost of a single pair.
+    constexpr int pairs_per_run = 64;
+
+    BENCHMARK( "SAT overlapping pair (all axes tested) x64" )
+    {
+        int hits = 0;
+        for( int i = 0; i < pairs_per_run; ++i )
+        {
+            hits += robot_shape.intersects( obstacle, Vec2{ 10.0f + 0.01f * i, 5.0f } );
+        }
+        return hits;
+    };
+
+    BENCHMARK( "SAT separated pair (early exit) x64" )
+    {
+        int hits = 0;
+        for( int i = 0; i < pairs_per_run; ++i )
+        {
+            hits += robot_shape.intersects( obstacle, Vec2{ 40.0f + 0.01f * i, 0.0f } );
+        }
+        return hits;
+    };
+
+    BENCHMARK( "SAT near miss in the AABB corner x64" )
+    {
+        int hits = 0;
+        for( int i = 0; i < pairs_per_run; ++i )
+        {
+            hits += robot_shape.intersects( obstacle, Vec2{ 24.0f + 0.01f * i, 24.0f } );
+        }
+        return hits;
+    };
+}
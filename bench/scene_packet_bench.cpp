@@ -0,0 +1,160 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <boost/json.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include "component_types.hpp"
+#include "scene_packet.hpp"
+#include "scene_snapshot.hpp"
+
+namespace snap = robot::src::exports::scene_snapshot;
+using robot::src::exports::scene_packet::ScenePacket;
+using namespace robot::src::exports::component_types;
+
+namespace
+{
+Polygon regularPolygon( int vertex_count )
+{
+    Polygon polygon;
+    for( int i = 0; i < vertex_count; ++i )
+    {
+        float angle = ( 2.0f * 3.14159265f * i ) / vertex_count;
+        polygon.emplace_back( 10.0f * std::cos( angle ), 10.0f * std::sin( angle ) );
+    }
+    return polygon;
+}
+
+// A scene shaped like the procedural one, scaled up: the robot plus static
+// polygons of 3 to 7 vertices spread over the world. When instanced, the five
+// distinct polygons are registered once and every entity places one of them.
+EntityStore makeScene( std::size_t entity_count, bool instanced = false )
+{
+    EntityStore store;
+    for( int vertex_count = 3; instanced && vertex_count < 8; ++vertex_count )
+    {
+        store.shapes.add( regularPolygon( vertex_count ) );
+    }
+    for( std::size_t entity = 0; entity < entity_count; ++entity )
+    {
+        if( instanced )
+        {
+            store.get< ShapeInstance >().insert( entity, ShapeInstance{ static_cast< ShapeId >( entity % 5 ), {} } );
+        }
+        else
+        {
+            store.get< Polygon >().insert( entity, regularPolygon( 3 + static_cast< int >( entity % 5 ) ) );
+        }
+        store.get< Position >().insert(
+            entity,
+            Position{ static_cast< float >( entity % 30 ) * 7.0f, static_cast< float >( entity / 30 ) * 7.0f } );
+    }
+    return store;
+}
+
+// The boost::json DOM encoding /output used before ScenePacket, kept as a baseline
+std::string encodeWithDom( const snap::SceneSnapshot & snapshot )
+{
+    boost::json::object scene;
+    boost::json::array geometries;
+    for( std::size_t i = 0; i < snapshot.size(); ++i )
+    {
+        boost::json::object geo;
+        boost::json::array vertices;
+        for( auto v = snapshot.vertex_offsets[ i ]; v < snapshot.vertex_offsets[ i + 1 ]; ++v )
+        {
+            vertices.push_back( boost::json::array{ snapshot.vertices_x[ v ], snapshot.vertices_y[ v ] } );
+        }
+        geo[ "vertices" ] = vertices;
+        if( snapshot.has_position[ i ] )
+        {
+            geo[ "position" ] = boost::json::array{ snapshot.positions[ i ].x, snapshot.positions[ i ].y };
+        }
+        geometries.push_back( geo );
+    }
+    scene[ "geometries" ] = geometries;
+    return boost::json::serialize( scene );
+}
+} // namespace
+
+TEST_CASE( "Scene encoding cost per frame", "[bench][scene_packet]" )
+{
+    constexpr std::size_t entity_count = 900;
+    auto store = makeScene( entity_count );
+
+    auto keyframe = std::make_shared< snap::SceneSnapshot >();
+    keyframe->capture( store, 1 );
+
+    // The next tick only the robot moves, as when the player is driving
+    store.get< Position >()[ 0 ] = Position{ 1.0f, 0.5f };
+    auto next = std::make_shared< snap::SceneSnapshot >();
+    next->capture( store, 2, keyframe.get() );
+
+    auto instanced = std::make_shared< snap::SceneSnapshot >();
+    instanced->capture( makeScene( entity_count, true ), 1 );
+
+    ScenePacket full{ keyframe, 0 };
+    ScenePacket delta{ next, 1 };
+    ScenePacket instanced_full{ instanced, 0 };
+    std::string buffer;
+    auto bytes = [ & ]( auto && write ) {
+        buffer.clear();
+        write( buffer );
+        return buffer.size();
+    };
+
+    // What the encodings are for, checked at this scene size rather than printed
+    auto json_keyframe = bytes( [ & ]( auto & out ) { full.write_json( out ); } );
+    auto binary_keyframe = bytes( [ & ]( auto & out ) { full.write_binary( out ); } );
+    CHECK( bytes( [ & ]( auto & out ) { delta.write_json( out ); } ) < json_keyframe );
+    CHECK( bytes( [ & ]( auto & out ) { delta.write_binary( out ); } ) < binary_keyframe );
+    CHECK( binary_keyframe < json_keyframe );
+    CHECK( bytes( [ & ]( auto & out ) { instanced_full.write_binary( out ); } ) < binary_keyframe );
+
+    BENCHMARK( "DOM JSON full scene (old /output)" )
+    {
+        return encodeWithDom( *keyframe );
+    };
+
+    BENCHMARK( "streaming JSON full scene" )
+    {
+        buffer.clear();
+        full.write_geometries_json( buffer );
+        return buffer.size();
+    };
+
+    BENCHMARK( "streaming JSON keyframe" )
+    {
+        buffer.clear();
+        full.write_json( buffer );
+        return buffer.size();
+    };
+
+    BENCHMARK( "binary keyframe" )
+    {
+        full.write_binary( buffer );
+        return buffer.size();
+    };
+
+    BENCHMARK( "binary keyframe, every entity instancing one of five shapes" )
+    {
+        instanced_full.write_binary( buffer );
+        return buffer.size();
+    };
+
+    BENCHMARK( "streaming JSON delta, one entity moved" )
+    {
+        buffer.clear();
+        delta.write_json( buffer );
+        return buffer.size();
+    };
+
+    BENCHMARK( "binary delta, one entity moved" )
+    {
+        delta.write_binary( buffer );
+        return buffer.size();
+    };
+}
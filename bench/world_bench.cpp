@@ -0,0 +1,75 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "assets.hpp"
+#include "component_types.hpp"
+#include "job_system.hpp"
+#include "scene_packet.hpp"
+#include "scene_snapshot.hpp"
+#include "systems.hpp"
+
+namespace ct = robot::src::exports::component_types;
+namespace sys = robot::src::exports::systems;
+namespace snap = robot::src::exports::scene_snapshot;
+using robot::src::exports::assets::buildProceduralAssets;
+using robot::src::exports::scene_packet::ScenePacket;
+
+// Whole-world paths over the scenes the robot actually serves: buildProceduralAssets
+// with a few keys, scaled from the default 10 assets up to a crowded world.
+TEST_CASE( "Simulation and /output over procedural worlds", "[bench][world]" )
+{
+    robot::src::JobSystem jobs;
+    for( std::string key : { "example_key", "bench_seed_2" } )
+    {
+        for( std::size_t assets : { 10, 100, 1'000 } )
+        {
+            ct::EntityStore store;
+            buildProceduralAssets( store, key, assets );
+            auto label = key + ", " + std::to_string( assets ) + " assets";
+
+            sys::CollisionWorkspace workspace;
+            BENCHMARK( "handleCollisions, serial, " + label )
+            {
+                sys::handleCollisions( store, workspace.grid );
+                return store.get< ct::HitCounter >().size();
+            };
+
+            BENCHMARK( "handleCollisions on the job system, " + label )
+            {
+                sys::handleCollisions( store, workspace, jobs );
+                return workspace.pairs.size();
+            };
+
+            sys::MotionLayout layout;
+            BENCHMARK( "updatePositions, " + label )
+            {
+                sys::updatePositions( store, layout, jobs );
+                return layout.size;
+            };
+
+            BENCHMARK( "full tick: input, collisions, motion, " + label )
+            {
+                sys::handlePlayerInput( store );
+                sys::handleCollisions( store, workspace, jobs );
+                sys::updatePositions( store, layout, jobs );
+                return layout.size;
+            };
+
+            // What handle_output does per request, plus the capture the loop does per tick
+            auto snapshot = std::make_shared< snap::SceneSnapshot >();
+            std::string body;
+            BENCHMARK( "/output: capture and geometries JSON, " + label )
+            {
+                snapshot->capture( store, 1 );
+                body.clear();
+                ScenePacket{ snapshot, 0 }.write_geometries_json( body );
+                return body.size();
+            };
+        }
+    }
+}
@@ -5,6 +5,7 @@ static_assert( __cplusplus > 2020'00 );
 #include <functional>
 #include <random>
 #include <string>
+#include <utility>
 
 #include "component_types.hpp"
 
@@ -15,7 +16,46 @@ namespace robot::src::detail::assets::inline exports
 // remote server, but for this example we'll just generate some simple assets in
 // code from a given key.
 
-void buildProceduralAssets( EntityStore & store, const std::string & key, std::size_t numAssets = 10 )
+/// @brief Add the robot and its two eyes to an empty store.
+///
+/// The robot is created first, so it gets id 0, which is where the REST server
+/// routes player input; the eyes get ids 1 and 2.
+///
+/// @param store Store to add to; must not have issued any id yet.
+/// @param allocator Allocator for the polygons' vertex arrays.
+inline void addRobot( EntityStore & store, const Polygon::allocator_type & allocator = {} )
+{
+    // Position the robot at the center of the world
+    auto robot = store.create().id();
+    store.get< Position >().insert( robot, Position{ 0.0f, 0.0f } );
+    // Add velocity component so robot can move
+    store.get< Velocity >().insert( robot, Velocity{ 0.0f, 0.0f } );
+    // Add hit counter to track collisions
+    store.get< HitCounter >().insert( robot, HitCounter{ 0 } );
+    // Now, generate the robot's geometry as a rectangle centered on the robot's position
+    store.get< Polygon >().insert(
+        robot,
+        Polygon( { Vec2{ -10.0f, -10.0f }, Vec2{ 10.0f, -10.0f }, Vec2{ 10.0f, 10.0f }, Vec2{ -10.0f, 10.0f } },
+                 allocator ) );
+    // Cache the robot's bounding box for the collision broad phase
+    store.get< Bounds >().insert( robot, Bounds( store.get< Polygon >()[ robot ], store.get< Position >()[ robot ] ) );
+
+    // To give it character, we'll add two squares on top to represent eyes
+    store.get< Polygon >().insert(
+        store.create().id(),
+        Polygon( { Vec2{ -5.0f, 5.0f }, Vec2{ -3.0f, 5.0f }, Vec2{ -3.0f, 7.0f }, Vec2{ -5.0f, 7.0f } }, allocator ) );
+    store.get< Polygon >().insert(
+        store.create().id(),
+        Polygon( { Vec2{ 3.0f, 5.0f }, Vec2{ 5.0f, 5.0f }, Vec2{ 5.0f, 7.0f }, Vec2{ 3.0f, 7.0f } }, allocator ) );
+}
+
+/// @brief Replace the contents of store with a scene generated from key.
+/// @param store Store to clear and fill.
+/// @param key Seed for the generator; the same key always yields the same scene.
+/// @param numAssets Number of static obstacles, and separately of moving triangles.
+/// @param allocator Allocator for the polygons' vertex arrays, e.g. from VertexArena::resource().
+inline void buildProceduralAssets( EntityStore & store, const std::string & key, std::size_t numAssets = 10,
+                            const Polygon::allocator_type & allocator = {} )
 {
     // For simplicity, we'll just generate some random polygons based on the key.
     // In a real application, you could use the key to seed a more complex
@@ -26,34 +66,26 @@ void buildProceduralAssets( EntityStore & store, const std::string & key, std::s
     std::mt19937 rng( seed );
     std::uniform_real_distribution< float > dist( -100.0f, 100.0f );
 
-    // First clear out any existing assets in the store
-    store.get< Polygon >().clear();
-    store.get< Position >().clear();
-
-    // Next, position the robot at the center of the world
-    store.get< Position >().insert( 0, Position{ 0.0f, 0.0f } );
-    // Add velocity component so robot can move
-    store.get< Velocity >().insert( 0, Velocity{ 0.0f, 0.0f } );
-    // Add hit counter to track collisions
-    store.get< HitCounter >().insert( 0, HitCounter{ 0 } );
-    // Now, generate the robot's geometry as a rectangle centered on the robot's position
-    store.get< Polygon >().insert(
-        0,
-        Polygon( { Vec2{ -10.0f, -10.0f }, Vec2{ 10.0f, -10.0f }, Vec2{ 10.0f, 10.0f }, Vec2{ -10.0f, 10.0f } } ) );
+    // First clear out any existing entities; the registry then hands out ids from 0 again
+    store.clear();
 
-    // To give it character, we'll add two squares on top to represent eyes
-    store.get< Polygon >()
-        .insert( 1, Polygon( { Vec2{ -5.0f, 5.0f }, Vec2{ -3.0f, 5.0f }, Vec2{ -3.0f, 7.0f }, Vec2{ -5.0f, 7.0f } } ) );
-    store.get< Polygon >()
-        .insert( 2, Polygon( { Vec2{ 3.0f, 5.0f }, Vec2{ 5.0f, 5.0f }, Vec2{ 5.0f, 7.0f }, Vec2{ 3.0f, 7.0f } } ) );
+    // Size the storages for the whole scene up front: the robot and its eyes,
+    // then numAssets obstacles and numAssets movers
+    store.get< Polygon >().reserve( 3 + numAssets );
+    store.get< ShapeInstance >().reserve( numAssets );
+    store.get< Bounds >().reserve( 1 + 2 * numAssets );
+    store.get< Position >().reserve( 1 + 2 * numAssets );
+    store.get< Velocity >().reserve( 1 + numAssets );
 
-    constexpr std::size_t base_entity_id = 3;
+    // Next, the robot at the center of the world
+    addRobot( store, allocator );
 
     // Now, generate some random static obstacles in the world.
     for( std::size_t i = 0; i < numAssets; ++i )
     {
-        Polygon polygon;
+        Polygon polygon( allocator );
         int numVertices = 3 + ( rng() % 5 ); // 3 to 7 vertices
+        polygon.reserve( numVertices );
         // In order for the polygons to collide properly, we need to make sure
         // they are convex and not self-intersecting. A simple way to do this is
         // to generate the vertices in a circular pattern around a center point.
@@ -61,26 +93,50 @@ void buildProceduralAssets( EntityStore & store, const std::string & key, std::s
         for( int j = 0; j < numVertices; ++j )
         {
             float angle = ( 2.0f * 3.14159265f * j ) / numVertices;
-            polygon.vertices_x.push_back( radius * std::cos( angle ) );
-            polygon.vertices_y.push_back( radius * std::sin( angle ) );
+            polygon.emplace_back( radius * std::cos( angle ), radius * std::sin( angle ) );
         }
-        std::size_t entity_id = base_entity_id + i;
-        store.get< Polygon >().insert( entity_id, polygon );
-        store.get< Position >().insert( entity_id, Position{ dist( rng ), dist( rng ) } );
+        auto entity_id = store.create().id();
+        Position position{ dist( rng ), dist( rng ) };
+        store.get< Bounds >().insert( entity_id, Bounds( polygon, position ) );
+        // Moving keeps the vertex arrays where the allocator put them; a copy would go to the heap
+        store.get< Polygon >().insert( entity_id, std::move( polygon ) );
+        store.get< Position >().insert( entity_id, position );
     }
 
     // Next, generate some random dynamic entities in the world that will move around. For simplicity, these will just
-    // be triangles that move in a random direction.
+    // be triangles that move in a random direction. They all instance one registered shape rather than each carrying
+    // a copy of the same three vertices.
+    ShapeId triangle =
+        store.shapes.add( Polygon( { Vec2{ -5.0f, -5.0f }, Vec2{ 5.0f, -5.0f }, Vec2{ 0.0f, 5.0f } }, allocator ) );
     for( std::size_t i = 0; i < numAssets; ++i )
     {
-        Polygon polygon{ Vec2{ -5.0f, -5.0f }, Vec2{ 5.0f, -5.0f }, Vec2{ 0.0f, 5.0f } };
-        std::size_t entity_id = base_entity_id + numAssets + i;
-        store.get< Polygon >().insert( entity_id, polygon );
-        store.get< Position >().insert( entity_id, Position{ dist( rng ), dist( rng ) } );
+        ShapeInstance instance{ triangle, {} };
+        auto entity_id = store.create().id();
+        Position position{ dist( rng ), dist( rng ) };
+        store.get< Bounds >().insert( entity_id, Bounds( store.shapes[ triangle ], instance, position ) );
+        store.get< ShapeInstance >().insert( entity_id, instance );
+        store.get< Position >().insert( entity_id, position );
         // Don't forget to add a Velocity component so they will move in the main loop!
         store.get< Velocity >().insert( entity_id, Velocity{ dist( rng ) * 0.1f, dist( rng ) * 0.1f } );
     }
 }
+
+/// @brief Replace the contents of store with a scene whose geometry lives in an arena.
+///
+/// The previous scene's polygons are destroyed before the arena is released,
+/// so the arena only ever holds the current scene's vertices.
+///
+/// @param store Store to clear and fill.
+/// @param arena Arena owned alongside store; released and refilled.
+/// @param key Seed for the generator.
+/// @param numAssets Number of static obstacles, and separately of moving triangles.
+inline void buildProceduralAssets( EntityStore & store, VertexArena & arena, const std::string & key,
+                            std::size_t numAssets = 10 )
+{
+    store.clear();
+    arena.release();
+    buildProceduralAssets( store, key, numAssets, arena.resource() );
+}
 } // namespace robot::src::detail::assets::inline exports
 
 namespace robot::src::inline exports::inline assets
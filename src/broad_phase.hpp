@@ -0,0 +1,339 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "math.hpp"
+
+/// @file broad_phase.hpp
+/// @brief Uniform-grid broad phase for collision detection in a wrapping world.
+///
+/// The broad phase buckets world-space bounding boxes into a fixed grid of cells
+/// covering the world bounds. Only boxes that share a cell are ever compared, so
+/// the cost of a tick grows with the number of nearby bodies rather than with the
+/// square of the total body count. The grid is toroidal: boxes that hang over one
+/// edge of the world are also bucketed into the cells on the opposite edge, which
+/// matches the coordinate wrapping applied by the movement system.
+
+namespace robot::src::detail::broad_phase::inline exports
+{
+/// @brief Fold a displacement along one axis into [-range/2, range/2].
+/// @param delta Displacement along the axis.
+/// @param range Extent of the world along the axis; values <= 0 disable wrapping.
+/// @return The shortest equivalent displacement in a wrapping world.
+inline Float wrapDelta( Float delta, Float range )
+{
+    if( range <= 0.0f )
+        return delta;
+    return delta - range * std::round( delta / range );
+}
+
+/// @brief Shortest displacement from one point to another in a wrapping world.
+/// @param from Start point.
+/// @param to End point.
+/// @param world_size Width and height of the world.
+/// @return Displacement `to - from`, folded so that each axis takes the short way around.
+inline Vec2 wrappedDelta( Vec2 from, Vec2 to, Vec2 world_size )
+{
+    return { wrapDelta( to.x - from.x, world_size.x ), wrapDelta( to.y - from.y, world_size.y ) };
+}
+
+/// @brief Test two bounding boxes for overlap in a wrapping world.
+///
+/// Compares the minimal-image distance between the box centers with the sum of
+/// their half extents on each axis, so boxes touching across a world edge count
+/// as overlapping.
+///
+/// @param a First bounding box.
+/// @param b Second bounding box.
+/// @param world_size Width and height of the world.
+/// @return True if the boxes overlap once wrapping is taken into account.
+inline bool wrappedIntersects( const AxisAlignedBoundingBox & a, const AxisAlignedBoundingBox & b, Vec2 world_size )
+{
+    auto overlaps = []( Float a_min, Float a_max, Float b_min, Float b_max, Float range ) {
+        Float delta = wrapDelta( ( b_min + b_max - a_min - a_max ) * 0.5f, range );
+        Float reach = ( a_max - a_min + b_max - b_min ) * 0.5f;
+        return std::abs( delta ) <= reach;
+    };
+    return overlaps( a.min.x, a.max.x, b.min.x, b.max.x, world_size.x )
+        && overlaps( a.min.y, a.max.y, b.min.y, b.max.y, world_size.y );
+}
+
+/// @class UniformGrid
+/// @brief Toroidal uniform grid that emits candidate pairs for the narrow phase.
+///
+/// Usage follows a clear / insert / build cycle once per tick. All internal
+/// buffers are retained between ticks, so after the first few ticks a rebuild
+/// performs no allocation. Cells are stored in compressed form (a counting sort
+/// of item indices by cell), which keeps every cell's items contiguous.
+///
+/// @par Example usage:
+/// @code
+/// UniformGrid grid( { { -120, -120 }, { 120, 120 } }, 20.0f );
+/// grid.clear();
+/// grid.insert( 0, robot_box );
+/// grid.insert( 1, obstacle_box );
+/// grid.build();
+/// grid.for_each_candidate_pair( []( std::size_t a, std::size_t b ) {
+///     // Run the narrow phase on a and b
+/// } );
+/// @endcode
+class UniformGrid
+{
+public:
+    using EntityId = std::size_t; ///< Entity identifier type stored in the grid
+
+private:
+    /// @brief A bounding box staged for the current build.
+    struct Item
+    {
+        EntityId entity;
+        AxisAlignedBoundingBox box;
+    };
+
+    /// @brief Inclusive range of cells covered along one axis, before wrapping.
+    struct Span
+    {
+        int first;
+        int last;
+    };
+
+    AxisAlignedBoundingBox bounds_; ///< World bounds covered by the grid
+    Vec2 world_size_; ///< Width and height of the world bounds
+    Vec2 inverse_cell_size_; ///< Reciprocal of the cell extent along each axis
+    int columns_; ///< Number of cells along the x axis
+    int rows_; ///< Number of cells along the y axis
+
+    std::vector< Item > items_; ///< Boxes staged since the last clear()
+    std::vector< std::uint32_t > cell_start_; ///< Offset of each cell's first entry in cell_items_
+    std::vector< std::uint32_t > cell_items_; ///< Item indices grouped by cell
+    mutable std::vector< std::uint32_t > visit_stamp_; ///< Per-item marker used to skip duplicate pairs
+
+    /// @brief Compute the covered cell span of an interval along one axis.
+    static Span span( Float min, Float max, Float origin, Float inverse_cell_size, int cells )
+    {
+        int first = static_cast< int >( std::floor( ( min - origin ) * inverse_cell_size ) );
+        int last = static_cast< int >( std::floor( ( max - origin ) * inverse_cell_size ) );
+        if( last - first + 1 >= cells )
+        {
+            // The interval covers the whole axis; visit every cell exactly once
+            return { 0, cells - 1 };
+        }
+        return { first, last };
+    }
+
+    /// @brief Fold a possibly out-of-range cell coordinate back onto the grid.
+    static int wrapCell( int cell, int cells )
+    {
+        cell %= cells;
+        return cell < 0 ? cell + cells : cell;
+    }
+
+    /// @brief Invoke fn with the linear index of every cell covered by a box.
+    template < typename Fn >
+    void for_each_cell( const AxisAlignedBoundingBox & box, Fn && fn ) const
+    {
+        auto xs = span( box.min.x, box.max.x, bounds_.min.x, inverse_cell_size_.x, columns_ );
+        auto ys = span( box.min.y, box.max.y, bounds_.min.y, inverse_cell_size_.y, rows_ );
+        for( int y = ys.first; y <= ys.last; ++y )
+        {
+            int row = wrapCell( y, rows_ );
+            for( int x = xs.first; x <= xs.last; ++x )
+            {
+                fn( static_cast< std::size_t >( row * columns_ + wrapCell( x, columns_ ) ) );
+            }
+        }
+    }
+
+public:
+    /// @brief Construct a grid covering the given world bounds.
+    ///
+    /// @param bounds World bounds; coordinates outside are wrapped onto the grid.
+    /// @param cell_size Requested edge length of a cell. A good choice is roughly the
+    ///                  size of a typical body, so most bodies touch one to four cells.
+    ///                  The actual cell extent is adjusted so that a whole number of
+    ///                  cells tiles the world exactly, which keeps wrapping consistent.
+    ///
+    /// @pre bounds.max > bounds.min on both axes and cell_size > 0
+    UniformGrid( AxisAlignedBoundingBox bounds, Float cell_size )
+        : bounds_( bounds )
+        , world_size_( bounds.max - bounds.min )
+        , columns_( std::max( 1, static_cast< int >( std::round( world_size_.x / cell_size ) ) ) )
+        , rows_( std::max( 1, static_cast< int >( std::round( world_size_.y / cell_size ) ) ) )
+        , cell_start_( static_cast< std::size_t >( columns_ * rows_ ) + 1, 0 )
+    {
+        inverse_cell_size_ = Vec2{ static_cast< Float >( columns_ ) / world_size_.x,
+                                   static_cast< Float >( rows_ ) / world_size_.y };
+        assert( cell_size > 0.0f );
+        assert( world_size_.x > 0.0f && world_size_.y > 0.0f );
+    }
+
+    /// @brief Number of cells along the x and y axes.
+    /// @return Pair of (columns, rows).
+    std::pair< int, int > dimensions() const noexcept
+    {
+        return { columns_, rows_ };
+    }
+
+    /// @brief World bounds covered by the grid.
+    const AxisAlignedBoundingBox & bounds() const noexcept
+    {
+        return bounds_;
+    }
+
+    /// @brief Width and height of the world covered by the grid.
+    Vec2 world_size() const noexcept
+    {
+        return world_size_;
+    }
+
+    /// @brief Number of boxes staged since the last clear().
+    std::size_t size() const noexcept
+    {
+        return items_.size();
+    }
+
+    /// @brief Discard all staged boxes while keeping allocated capacity.
+    ///
+    /// @note Time complexity: O(1)
+    void clear() noexcept
+    {
+        items_.clear();
+    }
+
+    /// @brief Stage a world-space bounding box for the next build().
+    ///
+    /// @param entity Entity that owns the box.
+    /// @param box World-space bounding box of the entity.
+    ///
+    /// @note Time complexity: O(1) amortized
+    void insert( EntityId entity, const AxisAlignedBoundingBox & box )
+    {
+        items_.push_back( { entity, box } );
+    }
+
+    /// @brief Bucket all staged boxes into cells.
+    ///
+    /// Must be called after the last insert() and before any pair query.
+    ///
+    /// @note Time complexity: O(n + c) where n is the number of covered cells
+    ///       summed over all boxes and c is the number of cells in the grid
+    void build()
+    {
+        assert( items_.size() < std::numeric_limits< std::uint32_t >::max() );
+
+        std::fill( cell_start_.begin(), cell_start_.end(), 0 );
+        for( const auto & item : items_ )
+        {
+            for_each_cell( item.box, [ this ]( std::size_t cell ) {
+                ++cell_start_[ cell + 1 ];
+            } );
+        }
+        for( std::size_t cell = 1; cell < cell_start_.size(); ++cell )
+        {
+            cell_start_[ cell ] += cell_start_[ cell - 1 ];
+        }
+
+        cell_items_.resize( cell_start_.back() );
+        // Reuse the visit stamps as per-cell write cursors while filling
+        std::vector< std::uint32_t > & cursor = visit_stamp_;
+        cursor.assign( cell_start_.begin(), cell_start_.end() - 1 );
+        for( std::uint32_t index = 0; index < items_.size(); ++index )
+        {
+            for_each_cell( items_[ index ].box, [ this, &cursor, index ]( std::size_t cell ) {
+                cell_items_[ cursor[ cell ]++ ] = index;
+            } );
+        }
+        visit_stamp_.assign( items_.size(), std::numeric_limits< std::uint32_t >::max() );
+    }
+
+    /// @brief Invoke fn once for every pair of staged boxes that overlap.
+    ///
+    /// Pairs are reported as (first inserted, later inserted) and never more than
+    /// once, even when two boxes share several cells. The overlap test accounts for
+    /// world wrapping, so the narrow phase only sees pairs that can actually touch.
+    ///
+    /// @param fn Callable invoked as fn(EntityId a, EntityId b).
+    ///
+    /// @pre build() has been called since the last insert()
+    template < typename Fn >
+    void for_each_candidate_pair( Fn && fn ) const
+    {
+        assert( visit_stamp_.size() == items_.size() );
+
+        for( std::uint32_t a = 0; a < items_.size(); ++a )
+        {
+            const auto & box_a = items_[ a ].box;
+            for_each_cell( box_a, [ & ]( std::size_t cell ) {
+                for( auto i = cell_start_[ cell ]; i < cell_start_[ cell + 1 ]; ++i )
+                {
+                    std::uint32_t b = cell_items_[ i ];
+                    if( b <= a || visit_stamp_[ b ] == a )
+                        continue;
+                    visit_stamp_[ b ] = a;
+                    if( wrappedIntersects( box_a, items_[ b ].box, world_size_ ) )
+                    {
+                        fn( items_[ a ].entity, items_[ b ].entity );
+                    }
+                }
+            } );
+        }
+    }
+
+    /// @brief Collect the staged boxes that overlap a query box.
+    ///
+    /// Only the cells the query box covers are visited, so the cost grows with
+    /// the number of boxes near the query rather than with the number staged.
+    /// Const and free of shared scratch state, so any number of threads may
+    /// query a built grid at once.
+    ///
+    /// @param box World-space query box; like staged boxes, it wraps around the world edges.
+    /// @param out Receives the entity of every overlapping box once, in ascending order; it is cleared first.
+    ///
+    /// @pre build() has been called since the last insert()
+    ///
+    /// @note Time complexity: O(e + k log k) where e is the number of entries in the
+    ///       covered cells and k the number of overlapping boxes
+    void query( const AxisAlignedBoundingBox & box, std::vector< EntityId > & out ) const
+    {
+        out.clear();
+        for_each_cell( box, [ & ]( std::size_t cell ) {
+            for( auto i = cell_start_[ cell ]; i < cell_start_[ cell + 1 ]; ++i )
+            {
+                const auto & item = items_[ cell_items_[ i ] ];
+                if( wrappedIntersects( box, item.box, world_size_ ) )
+                {
+                    out.push_back( item.entity );
+                }
+            }
+        } );
+        // A box spanning several covered cells was found once per cell
+        std::sort( out.begin(), out.end() );
+        out.erase( std::unique( out.begin(), out.end() ), out.end() );
+    }
+
+    /// @brief Collect all candidate pairs into a vector.
+    ///
+    /// @param out Vector that receives the pairs; it is cleared first.
+    ///
+    /// @see for_each_candidate_pair() for the allocation-free callback form
+    void candidate_pairs( std::vector< std::pair< EntityId, EntityId > > & out ) const
+    {
+        out.clear();
+        for_each_candidate_pair( [ &out ]( EntityId a, EntityId b ) {
+            out.emplace_back( a, b );
+        } );
+    }
+};
+} // namespace robot::src::detail::broad_phase::inline exports
+
+namespace robot::src::inline exports::inline broad_phase
+{
+using namespace detail::broad_phase::exports;
+}
@@ -3,6 +3,10 @@ static_assert( __cplusplus > 2020'00 );
 
 #include <boost/iterator/zip_iterator.hpp>
 #include <cstdint>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include "sparse_set.hpp"
@@ -36,14 +40,14 @@ namespace robot::src::detail::component ::inline exports
 /// - A std::vector<T> for actual component data storage
 ///
 /// @tparam T The component data type. Must be copy-constructible or move-constructible.
-/// @tparam MaxEntities The maximum number of entities that can have this component
-///                     (default: 1000). This determines the size of the sparse array.
+/// @tparam PageSize Number of entity IDs per page of the sparse index (default: 1024).
+///                  Entity IDs are unbounded; pages are allocated as IDs are first used.
 ///
 /// @par Example usage:
 /// @code
 /// struct Position { float x, y, z; };
 ///
-/// Component<Position, 5000> positions;
+/// Component<Position> positions;
 ///
 /// // Insert component for entities
 /// positions.insert(entity1, Position{1.0f, 2.0f, 3.0f});
@@ -60,11 +64,11 @@ namespace robot::src::detail::component ::inline exports
 ///     // Process position for entityId
 /// }
 /// @endcode
-template < typename T, unsigned int MaxEntities = 1000 >
+template < typename T, std::size_t PageSize = 1024 >
 class Component
 {
 private:
-    robot::src::SparseSet< MaxEntities > entities; ///< Sparse set mapping entity IDs to data indices
+    robot::src::SparseSet< PageSize > entities; ///< Sparse set mapping entity IDs to data indices
     std::vector< T > data; ///< Dense array of component data
 
 public:
@@ -73,6 +77,9 @@ public:
     using reference = T &; ///< Reference to component data
     using const_reference = const T &; ///< Const reference to component data
 
+    /// @brief Value returned by find_index() for an entity without this component.
+    static constexpr size_type npos = SparseSet< PageSize >::npos;
+
     /// @brief Default constructs an empty component storage.
     ///
     /// Initializes the component storage with no entities or data.
@@ -82,8 +89,8 @@ public:
     /// @brief Inserts an entity with associated component data (copy version).
     ///
     /// Adds a new entity to the component storage with a copy of the provided data.
-    /// If the entity is already present, it will be added again (no deduplication).
-    /// New component data is appended to the dense vector.
+    /// New component data is appended to the dense vector. If the entity is already
+    /// present, its existing data is replaced instead.
     ///
     /// @param entity The entity ID to insert.
     /// @param value The component data to associate with the entity (copied).
@@ -93,6 +100,11 @@ public:
     /// @see emplace(std::size_t, Args&&...) for in-place construction
     void insert( std::size_t entity, const T & value )
     {
+        if( auto * existing = find( entity ) )
+        {
+            *existing = value;
+            return;
+        }
         entities.insert( entity );
         data.push_back( value );
     }
@@ -102,7 +114,7 @@ public:
     /// Adds a new entity to the component storage by moving the provided data.
     /// This is more efficient than the copy version when the data is a temporary
     /// or when you no longer need the original value. If the entity is already present,
-    /// it will be added again (no deduplication).
+    /// its existing data is replaced instead.
     ///
     /// @param entity The entity ID to insert.
     /// @param value The component data to associate with the entity (moved).
@@ -111,6 +123,11 @@ public:
     /// @see insert(std::size_t, const T&) for the copy version
     void insert( std::size_t entity, T && value )
     {
+        if( auto * existing = find( entity ) )
+        {
+            *existing = std::move( value );
+            return;
+        }
         entities.insert( entity );
         data.push_back( std::move( value ) );
     }
@@ -120,6 +137,7 @@ public:
     /// Constructs component data directly in the dense vector without requiring a
     /// temporary object. This is the most efficient method when component construction
     /// is non-trivial. Arguments are perfectly forwarded to the component constructor.
+    /// If the entity is already present, its data is replaced by a newly constructed value.
     ///
     /// @tparam Args Parameter types for the component constructor.
     /// @param entity The entity ID to insert.
@@ -131,10 +149,74 @@ public:
     template < typename... Args >
     void emplace( std::size_t entity, Args &&... args )
     {
+        if( auto * existing = find( entity ) )
+        {
+            *existing = T( std::forward< Args >( args )... );
+            return;
+        }
         entities.insert( entity );
         data.emplace_back( std::forward< Args >( args )... );
     }
 
+    /// @brief Inserts a batch of entities with their component data.
+    ///
+    /// The dense arrays are grown once for the whole batch, so spawning many
+    /// entities does not reallocate repeatedly. Each pair is inserted as by
+    /// insert(), so entities already present have their data replaced.
+    ///
+    /// @param ids Entity IDs to insert.
+    /// @param values Component data, one per entity ID, in the same order.
+    ///
+    /// @throw std::invalid_argument if ids and values differ in length; nothing is inserted.
+    /// @note Time complexity: O(n) amortized for n entities
+    template < std::ranges::sized_range Ids, std::ranges::sized_range Values >
+    void insert_range( Ids && ids, Values && values )
+    {
+        if( std::ranges::size( ids ) != std::ranges::size( values ) )
+        {
+            throw std::invalid_argument( "Component::insert_range: ids and values differ in length" );
+        }
+        reserve( size() + std::ranges::size( ids ) );
+        auto value = std::ranges::begin( values );
+        for( auto id : ids )
+        {
+            insert( static_cast< std::size_t >( id ), *value );
+            ++value;
+        }
+    }
+
+    /// @brief Removes the components of a batch of entities.
+    ///
+    /// Entities without this component are ignored.
+    ///
+    /// @param ids Entity IDs to remove; must not be a view of this storage's own entities_view().
+    /// @note Time complexity: O(n) for n entities
+    template < std::ranges::input_range Ids >
+    void erase_range( Ids && ids )
+    {
+        for( auto id : ids )
+        {
+            erase( static_cast< std::size_t >( id ) );
+        }
+    }
+
+    /// @brief Pre-allocates room for a number of components.
+    ///
+    /// Reserves both the dense entity array and the component data; like
+    /// std::vector::reserve, a capacity below the current size does nothing.
+    ///
+    /// @param new_cap Number of components to make room for.
+    /// @note Time complexity: O(size()) if a reallocation happens, O(1) otherwise
+    void reserve( size_type new_cap )
+    {
+        if( new_cap <= data.size() )
+        {
+            return;
+        }
+        entities.reserve( new_cap );
+        data.reserve( new_cap );
+    }
+
     /// @brief Removes an entity and its associated component data.
     ///
     /// Erases the component for the given entity. Uses the "swap and pop" technique
@@ -211,6 +293,73 @@ public:
         return data[ entities.indexFor( entity ) ];
     }
 
+    /// @brief Looks up the component data for an entity, if present.
+    ///
+    /// Checks membership and locates the data with a single sparse lookup, unlike
+    /// a contains() check followed by get().
+    ///
+    /// @param entity The entity ID to look up.
+    /// @return A pointer to the component data, or nullptr if the entity has no component.
+    ///
+    /// @note Time complexity: O(1)
+    [[nodiscard]] T * find( std::size_t entity ) noexcept
+    {
+        auto index = entities.findIndex( entity );
+        return index == entities.npos ? nullptr : &data[ index ];
+    }
+
+    /// @brief Looks up the component data for an entity, if present (const version).
+    ///
+    /// @param entity The entity ID to look up.
+    /// @return A pointer to the component data, or nullptr if the entity has no component.
+    ///
+    /// @note Time complexity: O(1)
+    [[nodiscard]] const T * find( std::size_t entity ) const noexcept
+    {
+        auto index = entities.findIndex( entity );
+        return index == entities.npos ? nullptr : &data[ index ];
+    }
+
+    /// @brief Looks up the dense index of an entity, if present.
+    ///
+    /// @param entity The entity ID to look up.
+    /// @return The index into dense_entities() and dense_data(), or npos if the entity has no component.
+    ///
+    /// @note Time complexity: O(1)
+    [[nodiscard]] size_type find_index( std::size_t entity ) const noexcept
+    {
+        return entities.findIndex( entity );
+    }
+
+    /// @brief Returns the entity IDs in dense order.
+    ///
+    /// Entity dense_entities()[i] owns the component dense_data()[i].
+    ///
+    /// @return A const reference to the dense entity array.
+    /// @note Time complexity: O(1)
+    [[nodiscard]] const std::vector< std::size_t > & dense_entities() const noexcept
+    {
+        return entities.dense();
+    }
+
+    /// @brief Returns the component data in dense order.
+    ///
+    /// @return A reference to the dense data array, parallel to dense_entities().
+    /// @note Time complexity: O(1)
+    [[nodiscard]] std::vector< T > & dense_data() noexcept
+    {
+        return data;
+    }
+
+    /// @brief Returns the component data in dense order (const version).
+    ///
+    /// @return A const reference to the dense data array, parallel to dense_entities().
+    /// @note Time complexity: O(1)
+    [[nodiscard]] const std::vector< T > & dense_data() const noexcept
+    {
+        return data;
+    }
+
     /// @brief Accesses component data by entity ID using subscript notation.
     ///
     /// Provides convenient mutable access to component data using the subscript operator.
@@ -267,13 +416,36 @@ public:
         return entities.empty();
     }
 
+    /// @brief Exchanges the dense positions of two entities and their data.
+    ///
+    /// @param a First dense index; must be < size().
+    /// @param b Second dense index; must be < size().
+    ///
+    /// @note Time complexity: O(1)
+    /// @see align() to line the dense order up with another storage
+    void swap_dense( size_type a, size_type b ) noexcept
+    {
+        entities.swapIndices( a, b );
+        std::swap( data[ a ], data[ b ] );
+    }
+
+    /// @brief Counter that changes whenever entities are added, removed or reordered.
+    ///
+    /// @return The revision of the underlying sparse set.
+    /// @note Time complexity: O(1)
+    [[nodiscard]] std::uint64_t revision() const noexcept
+    {
+        return entities.revision();
+    }
+
     /// @brief Removes all entities and their component data.
     ///
     /// Clears both the sparse set and the data vector, leaving the component storage empty.
     /// All entity-component associations are destroyed.
     ///
     /// @post empty() == true && size() == 0
-    /// @note Time complexity: O(n) where n is the number of entities
+    /// @note Time complexity: O(n) where n is the number of entities, independent of
+    ///       the largest entity ID ever stored
     /// @see erase() to remove a single entity's component
     void clear()
     {
@@ -281,22 +453,22 @@ public:
         data.clear();
     }
 
-    /// @brief Returns a range of entity IDs in this component storage.
+    /// @brief Returns a view of the entity IDs in this component storage.
     ///
-    /// Provides a std::ranges-compatible view over all entity IDs that have
-    /// this component. Useful for filtering, transforming, or composing with
-    /// other range algorithms.
+    /// A non-owning span over the dense entity array; nothing is copied. Useful
+    /// for filtering, transforming, or composing with other range algorithms.
+    /// It is invalidated by any insertion or removal.
     ///
-    /// @return A range view of entity IDs.
-    /// @note Time complexity: O(1) (lazy evaluation)
+    /// @return A read-only view of entity IDs in dense order.
+    /// @note Time complexity: O(1)
     /// @see begin() for iteration over (entity, data) pairs
     ///
     /// @par Example:
     /// @code
-    /// auto active = positions.entities()
+    /// auto active = positions.entities_view()
     ///     | std::views::filter([](auto id) { return id > 100; });
     /// @endcode
-    [[nodiscard]] auto entities_view() const
+    [[nodiscard]] std::span< const std::size_t > entities_view() const noexcept
     {
         return entities.entities();
     }
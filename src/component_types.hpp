@@ -1,13 +1,20 @@
 static_assert( __cplusplus > 2020'00 );
 #pragma once
 
+#include <algorithm>
 #include <boost/iterator/zip_iterator.hpp>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <limits>
+#include <memory_resource>
 #include <tuple>
 #include <vector>
 
 #include "components.hpp"
 #include "math.hpp"
+#include "narrow_phase.hpp"
 
 /// @file component_types.hpp
 /// @brief Type definitions for commonly used components in the ECS.
@@ -51,44 +58,196 @@ struct HitCounter
     std::uint32_t hits = 0; ///< Number of hits an entity has taken.
 };
 
+/// @brief Arena the vertex arrays of a scene's polygons are carved from.
+///
+/// Polygons built with the arena's resource() place their vertex and normal
+/// arrays back to back in a few large blocks instead of four separate heap
+/// blocks each, so walking every polygon of a scene (the narrow phase, scene
+/// capture) streams through contiguous memory. Memory is only reclaimed by
+/// release(), which must not be called while any polygon still uses the arena;
+/// the usual owner keeps it next to the EntityStore and releases it after
+/// clearing the store. Not thread-safe: allocate from it only on the thread
+/// that owns the store.
+///
+/// This is an allocator under each Polygon's own arrays. The alternative was one
+/// store-wide SoA array that polygons address by offset and count; it was not
+/// chosen because every reader of vertices_x / vertices_y (the narrow phase,
+/// scene capture, world files) keeps working against real vectors, and a polygon
+/// that grows reallocates inside the arena instead of relocating a range shared
+/// with its neighbours. The cost is that a polygon's four arrays are adjacent
+/// rather than interleaved into one range, and memory a grown array leaves
+/// behind is only reclaimed by release(). Geometry shared by many bodies is not
+/// copied per polygon at all: it lives once in the store's ShapeRegistry.
+class VertexArena
+{
+private:
+    std::pmr::monotonic_buffer_resource resource_; ///< Bump allocator backed by the default heap
+
+public:
+    /// @brief Create an arena whose first block holds initial_bytes.
+    /// @param initial_bytes Size of the first block; later blocks grow geometrically.
+    explicit VertexArena( std::size_t initial_bytes = 64 * 1024 )
+        : resource_( initial_bytes )
+    {}
+
+    /// @brief Memory resource to construct polygons with.
+    std::pmr::memory_resource * resource() noexcept
+    {
+        return &resource_;
+    }
+
+    /// @brief Free every block at once.
+    void release()
+    {
+        resource_.release();
+    }
+};
+
 /// @brief Polygon represented by separate vectors of x and y vertex coordinates.
+///
+/// Edge normals are precomputed alongside the vertex arrays by the constructors and
+/// emplace_back(). Code that writes vertices_x / vertices_y directly must call
+/// update_normals() afterwards so the narrow phase sees the new edges.
+///
+/// The arrays use a polymorphic allocator, so a polygon may live in a VertexArena
+/// rather than on the heap. Moving a polygon keeps its memory resource; copying
+/// one without passing an allocator places the copy on the default resource.
 struct Polygon
 {
-    std::vector< Float > vertices_x; ///< X-coordinates of the polygon's vertices.
-    std::vector< Float > vertices_y; ///< Y-coordinates of the polygon's vertices.
+    using allocator_type = std::pmr::polymorphic_allocator< Float >; ///< Allocator of every vertex array
+
+    std::pmr::vector< Float > vertices_x; ///< X-coordinates of the polygon's vertices.
+    std::pmr::vector< Float > vertices_y; ///< Y-coordinates of the polygon's vertices.
+    std::pmr::vector< Float > normals_x; ///< X-components of the unnormalized edge normals.
+    std::pmr::vector< Float > normals_y; ///< Y-components of the unnormalized edge normals.
 
     /// @brief Construct a polygon from a list of vertices.
     /// @param vertices List of (x, y) vertex coordinates.
-    Polygon( std::initializer_list< std::pair< Float, Float > > vertices )
+    /// @param allocator Allocator for the vertex arrays, e.g. from VertexArena::resource().
+    Polygon( std::initializer_list< std::pair< Float, Float > > vertices, const allocator_type & allocator = {} )
+        : Polygon( allocator )
     {
+        reserve( vertices.size() );
         for( const auto & [ x, y ] : vertices )
         {
             vertices_x.push_back( x );
             vertices_y.push_back( y );
         }
+        update_normals();
     }
 
     /// @brief Construct a polygon from a list of Vec2 vertices.
     /// @param vertices List of Vec2 vertex coordinates.
-    explicit Polygon( std::initializer_list< Vec2 > vertices )
+    /// @param allocator Allocator for the vertex arrays, e.g. from VertexArena::resource().
+    explicit Polygon( std::initializer_list< Vec2 > vertices, const allocator_type & allocator = {} )
+        : Polygon( allocator )
     {
+        reserve( vertices.size() );
         for( const auto & v : vertices )
         {
             vertices_x.push_back( v.x );
             vertices_y.push_back( v.y );
         }
+        update_normals();
     }
 
     /// @brief Default constructor for an empty polygon.
     Polygon() = default;
 
+    /// @brief Construct an empty polygon whose arrays will use an allocator.
+    /// @param allocator Allocator for the vertex arrays.
+    explicit Polygon( const allocator_type & allocator )
+        : vertices_x( allocator )
+        , vertices_y( allocator )
+        , normals_x( allocator )
+        , normals_y( allocator )
+    {}
+
+    Polygon( const Polygon & ) = default;
+    Polygon( Polygon && ) noexcept = default;
+    Polygon & operator=( const Polygon & ) = default;
+    Polygon & operator=( Polygon && ) = default;
+
+    /// @brief Copy a polygon into the memory of another allocator.
+    /// @param other Polygon to copy.
+    /// @param allocator Allocator for the copy's arrays.
+    Polygon( const Polygon & other, const allocator_type & allocator )
+        : vertices_x( other.vertices_x, allocator )
+        , vertices_y( other.vertices_y, allocator )
+        , normals_x( other.normals_x, allocator )
+        , normals_y( other.normals_y, allocator )
+    {}
+
+    /// @brief Allocator the vertex arrays use.
+    allocator_type get_allocator() const noexcept
+    {
+        return vertices_x.get_allocator();
+    }
+
+    /// @brief Reserve room for count vertices in every array.
+    ///
+    /// Building a polygon vertex by vertex in an arena otherwise leaves the
+    /// blocks of each outgrown array behind until the arena is released.
+    ///
+    /// @param count Number of vertices to make room for.
+    void reserve( std::size_t count )
+    {
+        vertices_x.reserve( count );
+        vertices_y.reserve( count );
+        normals_x.reserve( count );
+        normals_y.reserve( count );
+    }
+
     /// @brief Emplace a new vertex into the polygon.
+    ///
+    /// Only the two edges adjacent to the new vertex have their normals recomputed.
+    ///
     /// @param x X-coordinate of the vertex.
     /// @param y Y-coordinate of the vertex.
     void emplace_back( Float x, Float y )
     {
         vertices_x.push_back( x );
         vertices_y.push_back( y );
+        std::size_t count = size();
+        normals_x.resize( count );
+        normals_y.resize( count );
+        if( count >= 2 )
+        {
+            store_normal( count - 2 );
+        }
+        store_normal( count - 1 );
+    }
+
+    /// @brief Recompute every cached edge normal from the vertex arrays.
+    void update_normals()
+    {
+        std::size_t count = size();
+        normals_x.resize( count );
+        normals_y.resize( count );
+        for( std::size_t i = 0; i < count; ++i )
+        {
+            store_normal( i );
+        }
+    }
+
+    /// @brief Return true if the cached normals match the current vertex count.
+    bool has_normals() const
+    {
+        return normals_x.size() == size() && normals_y.size() == size();
+    }
+
+    /// @brief Return a non-owning SoA view for the narrow phase.
+    /// @return View over the vertices, including cached normals when they are current.
+    ConvexView view() const
+    {
+        bool cached = has_normals() && size() > 0;
+        return {
+            vertices_x.data(),
+            vertices_y.data(),
+            cached ? normals_x.data() : nullptr,
+            cached ? normals_y.data() : nullptr,
+            size(),
+        };
     }
 
     /// @brief Return the number of vertices in the polygon.
@@ -153,10 +312,7 @@ struct Polygon
     /// @return Pair containing the (x, y) components of the normal.
     Vec2 get_edge_normal( std::size_t i ) const
     {
-        std::size_t vertex_count = this->size();
-        Float edge_x = vertices_x[ ( i + 1 ) % vertex_count ] - vertices_x[ i ];
-        Float edge_y = vertices_y[ ( i + 1 ) % vertex_count ] - vertices_y[ i ];
-        return { -edge_y, edge_x }; // Perpendicular to the edge
+        return view().edge_normal( i );
     }
 
     /// @brief Project a polygon onto the axis defined by (normal_x, normal_y).
@@ -165,43 +321,210 @@ struct Polygon
     /// @return Tuple containing the minimum and maximum projection values.
     auto project_onto_axis( Polygon const & poly, Vec2 normal ) const
     {
-        Float min_a = std::numeric_limits< Float >::infinity();
-        Float max_a = -std::numeric_limits< Float >::infinity();
-        for( auto const & [ vertex_x, vertex_y ] : poly )
-        {
-            Float projection = normal.x * vertex_x + normal.y * vertex_y;
-            min_a = std::min( min_a, projection );
-            max_a = std::max( max_a, projection );
-        }
+        auto [ min_a, max_a ] = projectExtents( poly.vertices_x.data(), poly.vertices_y.data(), poly.size(), normal );
         return std::make_tuple( min_a, max_a );
     }
 
     /// @brief Determine whether this polygon intersects another using the SAT.
+    ///
+    /// Both polygons' edge normals are tested as candidate axes, returning on the
+    /// first separating axis. No vertex data is copied and nothing is allocated.
+    ///
     /// @param other Polygon to test against.
+    /// @param offset Translation of other's vertices relative to this polygon's vertices,
+    ///               e.g. the difference of the two entities' positions.
     /// @return True when the polygons intersect; otherwise false.
-    bool intersects( const Polygon & other ) const
+    bool intersects( const Polygon & other, Vec2 offset = {} ) const
     {
-        auto checkSeparationWith = [ *this, &other ]( const Polygon & poly ) {
-            // Check for separation on this polygon's edges
-            for( std::size_t i = 0; i < poly.size(); ++i )
+        return satIntersects( view(), other.view(), offset );
+    }
+
+private:
+    /// @brief Compute and cache the normal of edge i.
+    void store_normal( std::size_t i )
+    {
+        std::size_t next = ( i + 1 ) % size();
+        normals_x[ i ] = -( vertices_y[ next ] - vertices_y[ i ] );
+        normals_y[ i ] = vertices_x[ next ] - vertices_x[ i ];
+    }
+};
+
+/// @brief Index of a shape in a ShapeRegistry.
+using ShapeId = std::uint32_t;
+
+/// @brief ShapeId that refers to no shape.
+inline constexpr ShapeId NO_SHAPE = std::numeric_limits< ShapeId >::max();
+
+/// @brief Immutable geometry shared by every entity that instances it.
+struct ShapeAsset
+{
+    Polygon polygon; ///< Vertices in the shape's own frame, with cached edge normals.
+    AxisAlignedBoundingBox local_bounds; ///< Bounding box of the vertices in the shape's frame.
+};
+
+/// @class ShapeRegistry
+/// @brief Append-only table of shapes that ShapeInstance components refer to by id.
+///
+/// Registering computes a shape's normals and bounds once; every instance then
+/// reads the same vertex arrays, so a thousand identical obstacles store (and
+/// send to viewers) one polygon. Shapes cannot be changed or removed
+/// individually; ids stay valid until clear().
+///
+/// @par Example usage:
+/// @code
+/// ShapeId triangle = store.shapes.add( Polygon{ Vec2{ -5, -5 }, Vec2{ 5, -5 }, Vec2{ 0, 5 } } );
+/// store.get< ShapeInstance >().insert( entity, ShapeInstance{ triangle } );
+/// @endcode
+class ShapeRegistry
+{
+private:
+    std::deque< ShapeAsset > shapes_; ///< Indexed by ShapeId; a deque so references survive add()
+
+public:
+    /// @brief Register a shape.
+    /// @param polygon Geometry of the shape in its own frame; moved in, keeping its allocator.
+    /// @return Id of the new shape.
+    ShapeId add( Polygon polygon )
+    {
+        if( !polygon.has_normals() )
+        {
+            polygon.update_normals();
+        }
+        AxisAlignedBoundingBox bounds = polygon.empty() ? AxisAlignedBoundingBox{} : polygon.get_aabb();
+        shapes_.push_back( ShapeAsset{ std::move( polygon ), bounds } );
+        return static_cast< ShapeId >( shapes_.size() - 1 );
+    }
+
+    /// @brief Access a registered shape.
+    /// @param id Id returned by add().
+    const ShapeAsset & operator[]( ShapeId id ) const
+    {
+        assert( id < shapes_.size() );
+        return shapes_[ id ];
+    }
+
+    /// @brief Look up a shape that may not exist.
+    /// @return Pointer to the shape, or nullptr if id is not registered.
+    const ShapeAsset * find( ShapeId id ) const noexcept
+    {
+        return id < shapes_.size() ? &shapes_[ id ] : nullptr;
+    }
+
+    /// @brief Number of registered shapes; ids run from 0 to size() - 1.
+    std::size_t size() const noexcept
+    {
+        return shapes_.size();
+    }
+
+    /// @brief Remove every shape; ids are handed out from 0 again.
+    void clear() noexcept
+    {
+        shapes_.clear();
+    }
+};
+
+/// @brief Component placing a registered shape on an entity.
+///
+/// The transform maps the shape's frame into the entity's; the entity's
+/// Position then places it in the world, as for a Polygon. An entity with both
+/// a Polygon and a ShapeInstance uses its Polygon.
+struct ShapeInstance
+{
+    ShapeId shape = NO_SHAPE; ///< Shape in EntityStore::shapes.
+    Transform2D transform; ///< Shape frame relative to the entity's Position.
+
+    /// @brief Map from the shape's frame into the entity's: T * R * S, as Transform2D composes.
+    ///
+    /// Every path that places instance vertices uses this one composition. The
+    /// translates_only() shortcuts add the translation instead, which is exactly
+    /// what it reduces to: cos 0 and sin 0 are 1 and 0, so no term is rounded.
+    Affine2 placement() const
+    {
+        return transform.toAffine();
+    }
+
+    /// @brief Whether the transform is a plain translation, so the shape's vertices can be used as they are.
+    bool translates_only() const noexcept
+    {
+        return transform.rotationRadians == 0.0f && transform.scale.x == 1.0f && transform.scale.y == 1.0f;
+    }
+};
+
+/// @brief Cached local and world-space bounding boxes of an entity's polygon.
+///
+/// The local box is computed once from the polygon's vertices; the world box is
+/// the local box translated by the entity's Position and must be refreshed with
+/// update() whenever the Position changes (updatePositions does this for moving
+/// entities). Readers such as the broad phase use the world box directly instead
+/// of scanning vertex data.
+struct Bounds
+{
+    AxisAlignedBoundingBox local; ///< Bounding box of the polygon's vertices in local space.
+    AxisAlignedBoundingBox world; ///< Local box translated by the entity's Position.
+
+    /// @brief Default constructor for empty bounds at the origin.
+    Bounds() = default;
+
+    /// @brief Compute bounds for a polygon placed at a position.
+    /// @param polygon Polygon whose vertices define the local box.
+    /// @param position World position of the polygon's local origin.
+    Bounds( const Polygon & polygon, Vec2 position )
+    {
+        if( !polygon.empty() )
+        {
+            local = polygon.get_aabb();
+        }
+        update( position );
+    }
+
+    /// @brief Compute bounds for an instance of a shared shape placed at a position.
+    /// @param shape Shape the instance refers to.
+    /// @param instance Placement of the shape relative to position.
+    /// @param position World position of the entity.
+    Bounds( const ShapeAsset & shape, const ShapeInstance & instance, Vec2 position )
+    {
+        const auto & polygon = shape.polygon;
+        if( instance.translates_only() )
+        {
+            local = { shape.local_bounds.min + instance.transform.translation,
+                      shape.local_bounds.max + instance.transform.translation };
+        }
+        else if( !polygon.empty() )
+        {
+            Affine2 transform = instance.placement();
+            local.min = local.max = transform * Vec2{ polygon.vertices_x[ 0 ], polygon.vertices_y[ 0 ] };
+            for( std::size_t i = 1; i < polygon.size(); ++i )
             {
-                auto normal = get_edge_normal( i );
-                auto [ min_a, max_a ] = project_onto_axis( *this, normal );
-                auto [ min_b, max_b ] = project_onto_axis( other, normal );
-
-                if( max_a < min_b or max_b < min_a )
-                {
-                    return false; // Separation found
-                }
+                Vec2 vertex = transform * Vec2{ polygon.vertices_x[ i ], polygon.vertices_y[ i ] };
+                local.min = Vec2{ std::min( local.min.x, vertex.x ), std::min( local.min.y, vertex.y ) };
+                local.max = Vec2{ std::max( local.max.x, vertex.x ), std::max( local.max.y, vertex.y ) };
             }
-            return true;
-        };
+        }
+        update( position );
+    }
 
-        return checkSeparationWith( *this ) && checkSeparationWith( other );
+    /// @brief Refresh the world box after the entity has moved.
+    /// @param position New world position of the polygon's local origin.
+    void update( Vec2 position )
+    {
+        world = { local.min + position, local.max + position };
     }
 };
 
-using EntityStore = Components< Position, Velocity, PlayerInput, HitCounter, Polygon >;
+/// @brief Component storages of the simulation, plus the shapes its ShapeInstance components refer to.
+struct EntityStore : Components< Position, Velocity, PlayerInput, HitCounter, Polygon, ShapeInstance, Bounds >
+{
+    using Storages = Components< Position, Velocity, PlayerInput, HitCounter, Polygon, ShapeInstance, Bounds >;
+
+    ShapeRegistry shapes; ///< Shared geometry placed by ShapeInstance components
+
+    /// @brief Remove every entity and every shape.
+    void clear()
+    {
+        Storages::clear();
+        shapes.clear();
+    }
+};
 } // namespace robot::src::detail::component_types::inline exports
 
 namespace robot::src::inline exports::inline component_types
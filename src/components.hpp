@@ -1,13 +1,216 @@
 static_assert( __cplusplus > 2020'00 );
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "component.hpp"
+#include "entity_registry.hpp"
 
 namespace robot::src::detail::components ::inline exports
 {
+/// @brief Join over the entities that have every one of a set of components.
+///
+/// The view walks the dense entity list of whichever storage is smallest when
+/// iteration starts and looks each entity up in the others, skipping it as soon
+/// as one storage lacks it. The smallest storage's own component is read from
+/// its dense array directly, so a join costs one sparse lookup per entity per
+/// additional storage, and a system joining a handful of players with thousands
+/// of velocities visits only the players.
+///
+/// Component values may be modified through the view, but no storage in the
+/// view may gain or lose entities while it is being iterated.
+///
+/// @par Example usage:
+/// @code
+/// store.view< Velocity, Position >().for_each( []( std::size_t entity, Velocity & v, Position & p ) {
+///     p.x += v.x;
+/// } );
+/// for( auto [ entity, velocity, position ] : store.view< Velocity, Position >() ) { ... }
+/// @endcode
+///
+/// @tparam Storages Component storage types, const-qualified for a read-only view.
+template < typename... Storages >
+class View
+{
+    static_assert( sizeof...( Storages ) > 0, "View needs at least one component type" );
+
+private:
+    std::tuple< Storages *... > storages_;
+
+    /// @brief Index into storages_ of the storage with the fewest entities.
+    std::size_t smallest() const noexcept
+    {
+        std::array< std::size_t, sizeof...( Storages ) > sizes = std::apply(
+            []( auto *... storage ) { return std::array< std::size_t, sizeof...( Storages ) >{ storage->size()... }; },
+            storages_ );
+        std::size_t pivot = 0;
+        for( std::size_t i = 1; i < sizes.size(); ++i )
+        {
+            if( sizes[ i ] < sizes[ pivot ] )
+            {
+                pivot = i;
+            }
+        }
+        return pivot;
+    }
+
+    /// @brief Call fn for every joined entity, walking storage Pivot.
+    template < std::size_t Pivot, typename Fn, std::size_t... I >
+    void for_each_from( Fn & fn, std::index_sequence< I... > ) const
+    {
+        auto & pivot = *std::get< Pivot >( storages_ );
+        const auto & entities = pivot.dense_entities();
+        auto & values = pivot.dense_data();
+        for( std::size_t i = 0; i < entities.size(); ++i )
+        {
+            std::size_t entity = entities[ i ];
+            auto components = std::make_tuple( [ & ]() {
+                if constexpr( I == Pivot )
+                {
+                    return &values[ i ];
+                }
+                else
+                {
+                    return std::get< I >( storages_ )->find( entity );
+                }
+            }()... );
+            if( ( ( std::get< I >( components ) != nullptr ) && ... ) )
+            {
+                fn( entity, *std::get< I >( components )... );
+            }
+        }
+    }
+
+public:
+    /// @brief Value produced by iterating the view: the entity id and a reference to each component.
+    using value_type = std::tuple< std::size_t, decltype( *std::declval< Storages & >().find( 0 ) )... >;
+
+    explicit View( Storages &... storages ) noexcept
+        : storages_( &storages... )
+    {}
+
+    /// @brief Call fn( entity, components&... ) for every entity that has all the components.
+    ///
+    /// This is the fastest way to run a system over the join: the walk over the
+    /// smallest storage is resolved at compile time.
+    ///
+    /// @param fn Callable taking the entity id followed by a reference to each component, in view order.
+    /// @note Time complexity: O(size of the smallest storage)
+    template < typename Fn >
+    void for_each( Fn && fn ) const
+    {
+        auto sequence = std::index_sequence_for< Storages... >{};
+        std::size_t pivot = smallest();
+        [ & ]< std::size_t... P >( std::index_sequence< P... > ) {
+            ( ( pivot == P ? for_each_from< P >( fn, sequence ) : void() ), ... );
+        }( sequence );
+    }
+
+    /// @brief Forward iterator over the joined entities.
+    class iterator
+    {
+    private:
+        const View * view_ = nullptr;
+        const std::vector< std::size_t > * entities_ = nullptr;
+        std::size_t index_ = 0;
+
+        bool matches() const noexcept
+        {
+            std::size_t entity = ( *entities_ )[ index_ ];
+            return std::apply( [ entity ]( auto *... storage ) { return ( storage->find( entity ) && ... ); },
+                               view_->storages_ );
+        }
+
+        void skip() noexcept
+        {
+            while( index_ < entities_->size() && !matches() )
+            {
+                ++index_;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = View::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        iterator( const View * view, const std::vector< std::size_t > * entities, std::size_t index ) noexcept
+            : view_( view )
+            , entities_( entities )
+            , index_( index )
+        {
+            skip();
+        }
+
+        value_type operator*() const noexcept
+        {
+            std::size_t entity = ( *entities_ )[ index_ ];
+            return std::apply(
+                [ entity ]( auto *... storage ) { return value_type( entity, *storage->find( entity )... ); },
+                view_->storages_ );
+        }
+
+        iterator & operator++() noexcept
+        {
+            ++index_;
+            skip();
+            return *this;
+        }
+
+        iterator operator++( int ) noexcept
+        {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        friend bool operator==( const iterator & a, const iterator & b ) noexcept
+        {
+            return a.index_ == b.index_;
+        }
+    };
+
+    /// @brief Iterator to the first joined entity.
+    ///
+    /// Range iteration looks every component up by entity, including the
+    /// smallest storage's; prefer for_each() in hot loops.
+    iterator begin() const
+    {
+        return iterator( this, &pivot_entities(), 0 );
+    }
+
+    /// @brief Iterator past the last joined entity.
+    iterator end() const
+    {
+        const auto & entities = pivot_entities();
+        return iterator( this, &entities, entities.size() );
+    }
+
+private:
+    const std::vector< std::size_t > & pivot_entities() const
+    {
+        const std::vector< std::size_t > * entities = nullptr;
+        std::size_t pivot = smallest();
+        [ & ]< std::size_t... P >( std::index_sequence< P... > ) {
+            ( ( pivot == P ? void( entities = &std::get< P >( storages_ )->dense_entities() ) : void() ), ... );
+        }( std::index_sequence_for< Storages... >{} );
+        return *entities;
+    }
+};
+
 /// @brief A collection of component storages for multiple component types.
+///
+/// Entities are created and destroyed through the embedded EntityRegistry, so
+/// their ids are recycled safely and destroying one removes it from every
+/// storage at once.
 /// @tparam ...ComponentTypes
 template < typename... ComponentTypes >
 struct Components
@@ -15,6 +218,51 @@ struct Components
     /// @brief Tuple of component storages, one for each component type.
     std::tuple< Component< ComponentTypes >... > storages;
 
+    /// @brief Allocator of the entity ids used as keys in every storage.
+    EntityRegistry registry;
+
+    /// @brief Create a new entity with no components.
+    /// @return Handle to the entity; use handle.id() as the key into the storages.
+    Entity create()
+    {
+        return registry.create();
+    }
+
+    /// @brief Whether a handle refers to a live entity.
+    bool alive( Entity entity ) const noexcept
+    {
+        return registry.alive( entity );
+    }
+
+    /// @brief Remove an entity from every storage and release its id.
+    /// @param entity Handle to destroy.
+    /// @return False, doing nothing, if the handle is stale; its id may belong to another entity by now.
+    bool destroy( Entity entity )
+    {
+        if( !registry.alive( entity ) )
+        {
+            return false;
+        }
+        erase( entity.id() );
+        return registry.destroy( entity );
+    }
+
+    /// @brief Remove an entity id from every storage without touching the registry.
+    /// @param entity Storage key to remove.
+    void erase( std::size_t entity )
+    {
+        std::apply( [ entity ]( auto &... storage ) { ( storage.erase( entity ), ... ); }, storages );
+    }
+
+    /// @brief Remove every entity from every storage and reset the registry.
+    ///
+    /// @note Time complexity: O(live components), plus O(ids ever issued) for the registry.
+    void clear()
+    {
+        std::apply( []( auto &... storage ) { ( storage.clear(), ... ); }, storages );
+        registry.clear();
+    }
+
     /// @brief  Get the component storage for a specific component type.
     /// @tparam T
     /// @return Reference to the component storage for type T.
@@ -32,6 +280,65 @@ struct Components
     {
         return std::get< Component< T > >( storages );
     }
+
+    /// @brief Reorder two storages so the entities they share come first, in the same order.
+    ///
+    /// Afterwards, for every i below the returned count, dense_entities()[i] is
+    /// the same entity in both storages, so a system can walk the two
+    /// dense_data() arrays in lockstep without any lookups. The order is kept
+    /// until either storage gains, loses or reorders entities, which shows as a
+    /// change of its revision().
+    ///
+    /// @tparam A First component type; its relative order is preserved for shared entities.
+    /// @tparam B Second component type.
+    /// @return Number of entities that have both components.
+    ///
+    /// @note Time complexity: O(size of storage A)
+    template < typename A, typename B >
+    std::size_t align()
+    {
+        static_assert( !std::is_same_v< A, B >, "align needs two different component types" );
+
+        auto & first = get< A >();
+        auto & second = get< B >();
+        std::size_t shared = 0;
+        for( std::size_t i = 0; i < first.size(); ++i )
+        {
+            auto j = second.find_index( first.dense_entities()[ i ] );
+            if( j == second.npos )
+            {
+                continue;
+            }
+            if( i != shared )
+            {
+                first.swap_dense( i, shared );
+            }
+            if( j != shared )
+            {
+                second.swap_dense( j, shared );
+            }
+            ++shared;
+        }
+        return shared;
+    }
+
+    /// @brief Join the storages of several component types.
+    /// @tparam Ts Component types every visited entity must have.
+    /// @return A View yielding the entity id and a mutable reference to each component.
+    template < typename... Ts >
+    View< Component< Ts >... > view()
+    {
+        return View< Component< Ts >... >( get< Ts >()... );
+    }
+
+    /// @brief Join the storages of several component types (read-only).
+    /// @tparam Ts Component types every visited entity must have.
+    /// @return A View yielding the entity id and a const reference to each component.
+    template < typename... Ts >
+    View< const Component< Ts >... > view() const
+    {
+        return View< const Component< Ts >... >( get< Ts >()... );
+    }
 };
 } // namespace robot::src::detail::components::inline exports
 
@@ -0,0 +1,226 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+/// @file entity_registry.hpp
+/// @brief Allocation of entity ids with generational handles.
+///
+/// Component storages are keyed by a plain entity index. The registry hands
+/// those indices out, recycles them through a free list once they are
+/// destroyed, and pairs each with a generation counter so that a handle kept
+/// past its entity's destruction can be detected instead of silently aliasing
+/// whichever entity reuses the index.
+
+namespace robot::src::detail::entity_registry::inline exports
+{
+/// @brief Versioned handle to an entity.
+///
+/// The index is the key used by every component storage; the generation is
+/// bumped each time the index is recycled, so two handles with the same index
+/// but different generations refer to different entities.
+struct Entity
+{
+    std::uint32_t index = std::numeric_limits< std::uint32_t >::max(); ///< Storage key of the entity
+    std::uint32_t generation = 0; ///< Incarnation of the index this handle refers to
+
+    /// @brief Storage key of the entity, as used by Component and SparseSet.
+    constexpr std::size_t id() const noexcept
+    {
+        return index;
+    }
+
+    /// @brief Whether this handle was ever issued (default-constructed handles are null).
+    constexpr bool is_null() const noexcept
+    {
+        return index == std::numeric_limits< std::uint32_t >::max();
+    }
+
+    friend constexpr bool operator==( Entity, Entity ) noexcept = default;
+};
+
+/// @class EntityRegistry
+/// @brief Issues entity handles and recycles destroyed indices.
+///
+/// Fresh indices are issued in increasing order starting from zero, and clear()
+/// restores that order, so the first entity created is always index 0.
+/// Destroyed indices go on a free list and are reused, most recently destroyed
+/// first, with their generation incremented.
+///
+/// @par Example usage:
+/// @code
+/// EntityRegistry registry;
+/// auto a = registry.create(); // index 0, generation 0
+/// registry.destroy( a );
+/// auto b = registry.create(); // index 0, generation 1
+/// assert( !registry.alive( a ) && registry.alive( b ) );
+/// @endcode
+class EntityRegistry
+{
+private:
+    std::vector< std::uint32_t > generations_; ///< Current generation of every index ever issued
+    std::vector< std::uint8_t > alive_; ///< Whether each index is currently in use
+    std::vector< std::uint32_t > free_; ///< Destroyed indices available for reuse
+    std::size_t live_count_ = 0; ///< Number of live entities
+
+public:
+    /// @brief Issue a handle to a new entity.
+    /// @return A handle that stays valid until destroy() is called with it.
+    /// @throw std::length_error if every 32-bit index is in use.
+    /// @note Time complexity: O(1) amortized
+    Entity create()
+    {
+        std::uint32_t index;
+        if( !free_.empty() )
+        {
+            index = free_.back();
+            free_.pop_back();
+        }
+        else
+        {
+            if( generations_.size() >= std::numeric_limits< std::uint32_t >::max() )
+            {
+                throw std::length_error( "EntityRegistry::create: out of entity indices" );
+            }
+            index = static_cast< std::uint32_t >( generations_.size() );
+            generations_.push_back( 0 );
+            alive_.push_back( 0 );
+        }
+        alive_[ index ] = 1;
+        ++live_count_;
+        return Entity{ index, generations_[ index ] };
+    }
+
+    /// @brief Whether a handle refers to a live entity.
+    /// @note Time complexity: O(1)
+    bool alive( Entity entity ) const noexcept
+    {
+        return entity.index < generations_.size() && alive_[ entity.index ]
+               && generations_[ entity.index ] == entity.generation;
+    }
+
+    /// @brief Release an entity's index for reuse.
+    /// @param entity Handle to destroy.
+    /// @return False, doing nothing, if the handle is stale or null.
+    /// @note Time complexity: O(1) amortized
+    bool destroy( Entity entity )
+    {
+        if( !alive( entity ) )
+        {
+            return false;
+        }
+        alive_[ entity.index ] = 0;
+        ++generations_[ entity.index ];
+        free_.push_back( entity.index );
+        --live_count_;
+        return true;
+    }
+
+    /// @brief Current handle of a live index.
+    /// @param index Storage key to look up.
+    /// @return The live handle for index, or a null handle if the index is not in use.
+    /// @note Time complexity: O(1)
+    Entity handle( std::size_t index ) const noexcept
+    {
+        if( index >= generations_.size() || !alive_[ index ] )
+        {
+            return Entity{};
+        }
+        return Entity{ static_cast< std::uint32_t >( index ), generations_[ index ] };
+    }
+
+    /// @brief Number of live entities.
+    std::size_t size() const noexcept
+    {
+        return live_count_;
+    }
+
+    /// @brief Whether no entity is live.
+    bool empty() const noexcept
+    {
+        return live_count_ == 0;
+    }
+
+    /// @brief Current generation of every index ever issued.
+    const std::vector< std::uint32_t > & generations() const noexcept
+    {
+        return generations_;
+    }
+
+    /// @brief Whether each index ever issued is in use (1) or free (0).
+    const std::vector< std::uint8_t > & alive_flags() const noexcept
+    {
+        return alive_;
+    }
+
+    /// @brief Free indices, the next to be reused last.
+    const std::vector< std::uint32_t > & free_list() const noexcept
+    {
+        return free_;
+    }
+
+    /// @brief Replace the registry's state with one saved through the accessors above.
+    ///
+    /// The registry afterwards issues exactly the handles the saved one would
+    /// have, so a restored world recycles ids like the original.
+    ///
+    /// @throw std::invalid_argument if the arrays disagree in length, or the free
+    ///        list names an index that is out of range or in use; the registry is unchanged.
+    /// @note Time complexity: O(number of indices)
+    template < typename Generations, typename Alive, typename Free >
+    void restore( const Generations & generations, const Alive & alive, const Free & free )
+    {
+        if( std::size( generations ) != std::size( alive )
+            || std::size( generations ) >= std::numeric_limits< std::uint32_t >::max() )
+        {
+            throw std::invalid_argument( "EntityRegistry::restore: generations and alive flags differ in length" );
+        }
+        for( auto index : free )
+        {
+            if( index >= std::size( generations ) || alive[ index ] )
+            {
+                throw std::invalid_argument( "EntityRegistry::restore: free index out of range or alive" );
+            }
+        }
+        generations_.assign( std::begin( generations ), std::end( generations ) );
+        alive_.assign( std::begin( alive ), std::end( alive ) );
+        free_.assign( std::begin( free ), std::end( free ) );
+        live_count_ = static_cast< std::size_t >( std::count_if( alive_.begin(), alive_.end(),
+                                                                 []( std::uint8_t flag ) { return flag != 0; } ) );
+    }
+
+    /// @brief Destroy every entity.
+    ///
+    /// All indices become free again and are reissued lowest first, so the next
+    /// create() returns index 0. Generations of live entities are bumped, so
+    /// handles from before the clear stay invalid.
+    ///
+    /// @note Time complexity: O(number of indices ever issued)
+    void clear()
+    {
+        free_.clear();
+        free_.reserve( generations_.size() );
+        for( auto index = generations_.size(); index-- > 0; )
+        {
+            if( alive_[ index ] )
+            {
+                alive_[ index ] = 0;
+                ++generations_[ index ];
+            }
+            free_.push_back( static_cast< std::uint32_t >( index ) );
+        }
+        live_count_ = 0;
+    }
+};
+} // namespace robot::src::detail::entity_registry::inline exports
+
+namespace robot::src::inline exports::inline entity_registry
+{
+using namespace detail::entity_registry::exports;
+}
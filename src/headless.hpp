@@ -0,0 +1,152 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <utility>
+
+#include "input_recording.hpp"
+#include "job_system.hpp"
+#include "simulation.hpp"
+#include "world_file.hpp"
+#include "worldgen.hpp"
+
+/// @file headless.hpp
+/// @brief Runs the simulation as fast as possible with no clock and no network.
+///
+/// Used for regression runs and load studies: a recording made by the
+/// interactive server (or by an earlier headless run) is replayed tick for tick,
+/// and the final state hash is compared with the one recorded, so a collision
+/// bug seen in the browser can be reproduced and bisected offline.
+
+namespace robot::src::detail::headless::inline exports
+{
+/// @brief What a headless run simulates.
+struct HeadlessOptions
+{
+    std::string key = "example_key"; ///< Asset key; a replay's own key takes precedence
+    std::size_t num_assets = 10; ///< Asset count; a replay's own count takes precedence
+    std::uint64_t ticks = 0; ///< Steps to run; 0 runs to the end of the replay, or until stopped without one
+    std::size_t sim_threads = defaultWorkerCount(); ///< Worker threads besides the calling thread
+    std::optional< InputRecording > replay; ///< Inputs to apply, if any
+    /// Generate the world in chunks, with num_assets obstacles and movers, instead of buildProceduralAssets();
+    /// a replay's own generator options, or their absence, take precedence
+    std::optional< WorldGenOptions > worldgen;
+    std::string load_path; ///< World file to start from instead of building; its key and asset count take precedence
+    std::string checkpoint_path; ///< File the world is checkpointed to while running and saved to at the end
+    std::uint64_t checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL; ///< Ticks between checkpoints; 0 for the end only
+};
+
+/// @brief Outcome of a headless run.
+struct HeadlessResult
+{
+    InputRecording recording; ///< The run itself, with its inputs, tick count and final hash
+    std::chrono::nanoseconds elapsed{ 0 }; ///< Wall time spent stepping
+    std::optional< bool > matches_replay; ///< Whether the final hash equals the replay's, if it recorded one
+    std::uint64_t checkpoints_failed = 0; ///< Checkpoints, the final save included, that could not be written
+};
+
+/// @brief Build or load a world and step it back to back.
+/// @param options World, length and inputs of the run.
+/// @param stop_token Ends the run early when a stop is requested.
+/// @return The recording of the run and how long it took.
+/// @throw std::system_error or std::runtime_error if options.load_path cannot be loaded,
+///        std::invalid_argument if options.worldgen is impossible or the world is not the one
+///        options.replay started from.
+inline HeadlessResult runHeadless( const HeadlessOptions & options, std::stop_token stop_token = {} )
+{
+    HeadlessResult result;
+    auto & recording = result.recording;
+    recording.key = options.replay ? options.replay->key : options.key;
+    recording.num_assets = options.replay ? options.replay->num_assets : options.num_assets;
+    if( options.replay )
+    {
+        recording.worldgen = options.replay->worldgen;
+    }
+    else if( options.worldgen )
+    {
+        recording.worldgen = *options.worldgen;
+        recording.worldgen->obstacles = recording.worldgen->movers = recording.num_assets;
+    }
+
+    auto ticks = options.ticks;
+    InputReplay replay( options.replay ? options.replay->events : std::vector< InputEvent >{} );
+    if( ticks == 0 && options.replay )
+    {
+        ticks = options.replay->end_tick.value_or( replay.last_tick() );
+    }
+
+    Simulation simulation( options.sim_threads );
+    if( !options.load_path.empty() )
+    {
+        // Ticks, and so replayed inputs, carry on from the tick the world was saved at
+        simulation.restore( options.load_path );
+        recording.key = simulation.key();
+        recording.num_assets = simulation.num_assets();
+        recording.worldgen.reset();
+        recording.loaded = LoadedWorld{ simulation.tick(), stateHash( simulation.store() ) };
+    }
+    else if( recording.worldgen )
+    {
+        simulation.generate( recording.key, *recording.worldgen );
+    }
+    else
+    {
+        simulation.build( recording.key, recording.num_assets );
+    }
+    if( options.replay && options.replay->loaded != recording.loaded )
+    {
+        if( !recording.loaded )
+        {
+            throw std::invalid_argument( "the replay starts from a world file saved at tick "
+                                         + std::to_string( options.replay->loaded->tick ) + "; pass it with --load" );
+        }
+        throw std::invalid_argument( options.replay->loaded ? "the world loaded is not the one the replay started from"
+                                                            : "the replay builds its world from its key, not a file" );
+    }
+    std::optional< Checkpointer > checkpointer;
+    if( !options.checkpoint_path.empty() )
+    {
+        checkpointer.emplace( options.checkpoint_path, options.checkpoint_interval );
+    }
+    InputRecorder recorder;
+    simulation.record_inputs( &recorder );
+    auto start = std::chrono::steady_clock::now();
+    while( ( ticks == 0 || simulation.tick() < ticks ) && !stop_token.stop_requested() )
+    {
+        replay.apply( simulation.tick() + 1, simulation.store() );
+        simulation.step();
+        if( checkpointer )
+        {
+            checkpointer->maybe_checkpoint( simulation.store(), simulation.world_info() );
+        }
+    }
+    result.elapsed = std::chrono::steady_clock::now() - start;
+    if( checkpointer )
+    {
+        checkpointer->flush();
+        checkpointer->checkpoint( simulation.store(), simulation.world_info() );
+        checkpointer->flush();
+        result.checkpoints_failed = checkpointer->failed();
+    }
+
+    recording.events = recorder.events();
+    recording.end_tick = simulation.tick();
+    recording.end_hash = stateHash( simulation.store() );
+    if( options.replay && options.replay->end_hash && options.replay->end_tick == recording.end_tick )
+    {
+        result.matches_replay = options.replay->end_hash == recording.end_hash;
+    }
+    return result;
+}
+} // namespace robot::src::detail::headless::inline exports
+
+namespace robot::src::inline exports::inline headless
+{
+using namespace detail::headless::exports;
+}
@@ -0,0 +1,64 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <cstddef>
+
+#include "component_types.hpp"
+#include "mpsc_queue.hpp"
+
+/// @file input_queue.hpp
+/// @brief Hand-off of viewer input from the network threads to the simulation.
+///
+/// REST and WebSocket handlers push parsed inputs onto a lock-free queue and
+/// return at once; the simulation drains the queue into the PlayerInput
+/// components at the start of each tick. Neither side ever waits for the other,
+/// and the network threads never touch the store.
+
+namespace robot::src::detail::input_queue::inline exports
+{
+/// @brief A PlayerInput submitted by a viewer, waiting for the next tick.
+struct InputCommand
+{
+    std::size_t entity = 0; ///< Entity to steer
+    PlayerInput input; ///< Requested input
+};
+
+/// @brief Commands pushed by the network threads and drained by the simulation once per tick.
+using InputQueue = MpscQueue< InputCommand >;
+
+/// @brief Default capacity of an InputQueue, far more commands than viewers send in one tick.
+inline constexpr std::size_t INPUT_QUEUE_CAPACITY = 4096;
+
+/// @brief Move every queued command into the PlayerInput components, oldest first.
+///
+/// Commands for the same entity coalesce: each overwrites the one before, so
+/// only the newest input per entity is seen by the tick. Commands naming an
+/// entity that is not alive in the store's registry are dropped, so a bad id
+/// from a viewer cannot attach a component to an entity that does not exist.
+/// Only the simulation thread may call this.
+///
+/// @return Number of commands drained, including the ones dropped.
+inline std::size_t drainInputCommands( InputQueue & queue, EntityStore & store )
+{
+    auto & inputs = store.get< PlayerInput >();
+    return queue.drain( [ & ]( InputCommand command ) {
+        if( store.registry.handle( command.entity ).is_null() )
+        {
+            return;
+        }
+        if( inputs.contains( command.entity ) )
+        {
+            inputs[ command.entity ] = command.input;
+        }
+        else
+        {
+            inputs.insert( command.entity, command.input );
+        }
+    } );
+}
+} // namespace robot::src::detail::input_queue::inline exports
+
+namespace robot::src::inline exports::inline input_queue
+{
+using namespace detail::input_queue::exports;
+}
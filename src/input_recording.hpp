@@ -0,0 +1,303 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "component_types.hpp"
+#include "worldgen.hpp"
+
+/// @file input_recording.hpp
+/// @brief Recording and bit-exact replay of the PlayerInput stream.
+///
+/// The simulation is deterministic given its asset key and the PlayerInput
+/// components present at the start of every tick, so a run is reproduced by
+/// recording only the inputs that changed and the tick they were first seen
+/// on. Recordings are text: a header naming the world, one line per input
+/// change, and optionally the tick count and state hash the run ended with so a
+/// replay can check it arrived at the same place. A world generated in chunks
+/// records the generator's options (its seed is the key), and a run that
+/// started from a world file instead records the tick and state hash the file
+/// was loaded at, so it is only replayed from that same file.
+/// Floats are written in their shortest round-trip form, which reads back to
+/// the identical bits.
+///
+/// @code
+/// robot-input 1
+/// world 10 example_key
+/// input 120 0 1 0
+/// input 300 0 0 -1
+/// end 600 9f3b2c6a01d4e857
+/// @endcode
+///
+/// The optional world sources, after the world line:
+///
+/// @code
+/// worldgen <obstacles> <movers> <chunks_per_axis> <min_radius> <max_radius> <reject_overlaps> <max_attempts>
+/// load <tick> <state hash>
+/// @endcode
+
+namespace robot::src::detail::input_recording::inline exports
+{
+/// @brief A PlayerInput that took effect at the start of a tick.
+struct InputEvent
+{
+    std::uint64_t tick = 0; ///< Step the input was first applied on, counting from 1
+    std::size_t entity = 0; ///< Entity the input was given to
+    PlayerInput input; ///< The input itself
+
+    bool operator==( const InputEvent & other ) const
+    {
+        return tick == other.tick && entity == other.entity && input.x == other.input.x
+               && input.y == other.input.y;
+    }
+};
+
+/// @brief World file a recorded run started from instead of building its world.
+struct LoadedWorld
+{
+    std::uint64_t tick = 0; ///< Tick the file was saved at
+    std::uint64_t hash = 0; ///< stateHash() of the world as loaded
+
+    bool operator==( const LoadedWorld & other ) const = default;
+};
+
+/// @brief Everything needed to reproduce a run.
+struct InputRecording
+{
+    std::string key = "example_key"; ///< Asset key the world was built from
+    std::size_t num_assets = 10; ///< Asset count the world was built with
+    std::optional< WorldGenOptions > worldgen; ///< Generator options, if the world was generated in chunks
+    std::optional< LoadedWorld > loaded; ///< World file the run started from, if it did not build its world
+    std::vector< InputEvent > events; ///< Input changes in tick order
+    std::optional< std::uint64_t > end_tick; ///< Ticks the recorded run lasted, if it finished
+    std::optional< std::uint64_t > end_hash; ///< stateHash() after end_tick, if recorded
+};
+
+/// @class InputRecorder
+/// @brief Records the PlayerInput components whose value changed since the previous tick.
+class InputRecorder
+{
+private:
+    std::unordered_map< std::size_t, PlayerInput > last_; ///< Last recorded input per entity
+    std::vector< InputEvent > events_;
+
+public:
+    /// @brief Record the inputs a tick is about to apply.
+    /// @param tick Number of the step that is about to run.
+    /// @param store Store whose PlayerInput components are read.
+    void record( std::uint64_t tick, const EntityStore & store )
+    {
+        for( auto [ entity, input ] : store.get< PlayerInput >() )
+        {
+            auto found = last_.find( entity );
+            if( found != last_.end() && found->second.x == input.x && found->second.y == input.y )
+            {
+                continue;
+            }
+            last_.insert_or_assign( entity, input );
+            events_.push_back( InputEvent{ tick, entity, input } );
+        }
+    }
+
+    /// @brief The changes recorded so far, in tick order.
+    const std::vector< InputEvent > & events() const noexcept
+    {
+        return events_;
+    }
+};
+
+/// @class InputReplay
+/// @brief Applies recorded input changes to a store at the ticks they were recorded on.
+class InputReplay
+{
+private:
+    std::vector< InputEvent > events_;
+    std::size_t next_ = 0;
+
+public:
+    explicit InputReplay( std::vector< InputEvent > events )
+        : events_( std::move( events ) )
+    {}
+
+    /// @brief Apply every event due by a tick, exactly as a viewer submitting it would have.
+    /// @param tick Number of the step that is about to run.
+    /// @param store Store whose PlayerInput components are written.
+    void apply( std::uint64_t tick, EntityStore & store )
+    {
+        auto & inputs = store.get< PlayerInput >();
+        for( ; next_ < events_.size() && events_[ next_ ].tick <= tick; ++next_ )
+        {
+            const auto & event = events_[ next_ ];
+            if( inputs.contains( event.entity ) )
+            {
+                inputs[ event.entity ] = event.input;
+            }
+            else
+            {
+                inputs.insert( event.entity, event.input );
+            }
+        }
+    }
+
+    /// @brief Whether every event has been applied.
+    bool finished() const noexcept
+    {
+        return next_ == events_.size();
+    }
+
+    /// @brief Tick of the last event, or 0 if there are none.
+    std::uint64_t last_tick() const noexcept
+    {
+        return events_.empty() ? 0 : events_.back().tick;
+    }
+};
+
+/// @brief Write a recording in the text format described in input_recording.hpp.
+inline void writeInputRecording( std::ostream & out, const InputRecording & recording )
+{
+    auto number = []( auto value ) {
+        std::array< char, 32 > text{};
+        auto result = std::to_chars( text.data(), text.data() + text.size(), value );
+        return std::string( text.data(), result.ptr );
+    };
+    out << "robot-input 1\n";
+    out << "world " << recording.num_assets << ' ' << recording.key << '\n';
+    if( const auto & worldgen = recording.worldgen )
+    {
+        out << "worldgen " << worldgen->obstacles << ' ' << worldgen->movers << ' ' << worldgen->chunks_per_axis << ' '
+            << number( worldgen->min_radius ) << ' ' << number( worldgen->max_radius ) << ' '
+            << ( worldgen->reject_overlaps ? 1 : 0 ) << ' ' << worldgen->max_attempts << '\n';
+    }
+    if( recording.loaded )
+    {
+        out << "load " << recording.loaded->tick << ' ' << std::hex << recording.loaded->hash << std::dec << '\n';
+    }
+    for( const auto & event : recording.events )
+    {
+        out << "input " << event.tick << ' ' << event.entity << ' ' << number( event.input.x ) << ' '
+            << number( event.input.y ) << '\n';
+    }
+    if( recording.end_tick )
+    {
+        out << "end " << *recording.end_tick;
+        if( recording.end_hash )
+        {
+            out << ' ' << std::hex << *recording.end_hash << std::dec;
+        }
+        out << '\n';
+    }
+}
+
+/// @brief Read a recording written by writeInputRecording().
+/// @throw std::runtime_error if the text is not a recording or a line is malformed.
+inline InputRecording readInputRecording( std::istream & in )
+{
+    InputRecording recording;
+    std::string line;
+    std::size_t line_number = 1;
+    auto fail = [ & ]( std::string_view what ) {
+        throw std::runtime_error( "input recording line " + std::to_string( line_number ) + ": "
+                                  + std::string( what ) );
+    };
+    auto parse = [ & ]( std::string_view & rest, auto & value, int base = 10 ) {
+        while( !rest.empty() && rest.front() == ' ' )
+            rest.remove_prefix( 1 );
+        std::from_chars_result result;
+        if constexpr( std::is_floating_point_v< std::remove_reference_t< decltype( value ) > > )
+            result = std::from_chars( rest.data(), rest.data() + rest.size(), value );
+        else
+            result = std::from_chars( rest.data(), rest.data() + rest.size(), value, base );
+        if( result.ec != std::errc{} )
+            fail( "expected a number" );
+        rest.remove_prefix( static_cast< std::size_t >( result.ptr - rest.data() ) );
+    };
+
+    if( !std::getline( in, line ) || line != "robot-input 1" )
+    {
+        fail( "not a version 1 input recording" );
+    }
+    while( std::getline( in, line ) )
+    {
+        ++line_number;
+        std::string_view rest = line;
+        auto word = rest.substr( 0, rest.find( ' ' ) );
+        rest.remove_prefix( word.size() );
+        if( word == "world" )
+        {
+            parse( rest, recording.num_assets );
+            if( rest.size() < 2 || rest.front() != ' ' )
+                fail( "expected an asset key" );
+            recording.key = std::string( rest.substr( 1 ) );
+        }
+        else if( word == "worldgen" )
+        {
+            WorldGenOptions worldgen;
+            int reject_overlaps = 0;
+            parse( rest, worldgen.obstacles );
+            parse( rest, worldgen.movers );
+            parse( rest, worldgen.chunks_per_axis );
+            parse( rest, worldgen.min_radius );
+            parse( rest, worldgen.max_radius );
+            parse( rest, reject_overlaps );
+            parse( rest, worldgen.max_attempts );
+            if( reject_overlaps != 0 && reject_overlaps != 1 )
+                fail( "expected 0 or 1" );
+            worldgen.reject_overlaps = reject_overlaps == 1;
+            recording.worldgen = worldgen;
+        }
+        else if( word == "load" )
+        {
+            LoadedWorld loaded;
+            parse( rest, loaded.tick );
+            parse( rest, loaded.hash, 16 );
+            recording.loaded = loaded;
+        }
+        else if( word == "input" )
+        {
+            InputEvent event;
+            parse( rest, event.tick );
+            parse( rest, event.entity );
+            parse( rest, event.input.x );
+            parse( rest, event.input.y );
+            if( !recording.events.empty() && event.tick < recording.events.back().tick )
+                fail( "events out of tick order" );
+            recording.events.push_back( event );
+        }
+        else if( word == "end" )
+        {
+            std::uint64_t value = 0;
+            parse( rest, value );
+            recording.end_tick = value;
+            if( !rest.empty() )
+            {
+                parse( rest, value, 16 );
+                recording.end_hash = value;
+            }
+        }
+        else if( !word.empty() )
+        {
+            fail( "unknown record " + std::string( word ) );
+        }
+    }
+    return recording;
+}
+} // namespace robot::src::detail::input_recording::inline exports
+
+namespace robot::src::inline exports::inline input_recording
+{
+using namespace detail::input_recording::exports;
+}
@@ -0,0 +1,319 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// @file job_system.hpp
+/// @brief Work-stealing thread pool for running simulation work across cores.
+///
+/// Every worker owns a queue. A worker pushes and pops jobs at the back of its
+/// own queue, so the jobs it has just spawned run first while their data is
+/// still in cache, and steals from the front of other queues when its own runs
+/// dry. Threads that wait for jobs to finish (including the thread that called
+/// into the pool) run queued jobs instead of blocking, so jobs may spawn and
+/// wait for more jobs without deadlocking.
+
+namespace robot::src::detail::job_system::inline exports
+{
+/// @brief Tracks a batch of jobs so a caller can wait for all of them.
+///
+/// The first exception thrown by a job in the batch is kept and rethrown by
+/// JobSystem::wait().
+class JobCounter
+{
+private:
+    friend class JobSystem;
+
+    std::atomic< std::size_t > pending_{ 0 }; ///< Jobs submitted but not finished
+    std::mutex error_mutex_; ///< Guards error_
+    std::exception_ptr error_; ///< First exception thrown by a job
+
+public:
+    /// @brief Whether every job submitted against this counter has finished.
+    bool done() const noexcept
+    {
+        return pending_.load( std::memory_order_acquire ) == 0;
+    }
+};
+
+/// @brief Default number of worker threads: one per hardware thread besides the caller's.
+inline std::size_t defaultWorkerCount()
+{
+    auto hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 0;
+}
+
+/// @class JobSystem
+/// @brief Pool of worker threads with per-worker queues and work stealing.
+///
+/// A JobSystem with zero workers is valid and runs every job on the thread that
+/// waits for it, which makes it the serial fallback for code written against
+/// the pool.
+///
+/// @par Example usage:
+/// @code
+/// JobSystem jobs;
+/// jobs.parallel_for( 0, positions.size(), 4096, [ & ]( std::size_t begin, std::size_t end ) {
+///     integrate( positions, begin, end );
+/// } );
+/// @endcode
+class JobSystem
+{
+public:
+    using Job = std::function< void() >; ///< Unit of work run by the pool
+
+private:
+    /// @brief Queue owned by one worker; other threads steal from its front.
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque< Job > jobs;
+    };
+
+    std::vector< std::unique_ptr< Queue > > queues_; ///< One per worker, plus one shared by outside threads
+    std::vector< std::jthread > workers_; ///< Worker threads; joined on destruction
+    std::atomic< std::size_t > queued_{ 0 }; ///< Jobs sitting in any queue
+    std::mutex sleep_mutex_; ///< Guards sleeping on wake_
+    std::condition_variable wake_; ///< Signalled when a job is queued or the pool stops
+    bool stopping_ = false; ///< Set under sleep_mutex_ when the pool shuts down
+
+    /// @brief Queue index of the calling thread in the pool it works for.
+    static inline thread_local const JobSystem * current_pool_ = nullptr;
+    static inline thread_local std::size_t current_queue_ = 0;
+
+    /// @brief Queue the calling thread should push to: its own if it is a worker, else the shared one.
+    std::size_t home_queue() const noexcept
+    {
+        return current_pool_ == this ? current_queue_ : queues_.size() - 1;
+    }
+
+    /// @brief Take a job, own queue first (newest), then the others (oldest).
+    std::optional< Job > take()
+    {
+        if( queued_.load( std::memory_order_acquire ) == 0 )
+        {
+            return std::nullopt;
+        }
+        std::size_t home = home_queue();
+        {
+            auto & queue = *queues_[ home ];
+            std::lock_guard< std::mutex > lock( queue.mutex );
+            if( !queue.jobs.empty() )
+            {
+                Job job = std::move( queue.jobs.back() );
+                queue.jobs.pop_back();
+                queued_.fetch_sub( 1, std::memory_order_relaxed );
+                return job;
+            }
+        }
+        for( std::size_t offset = 1; offset < queues_.size(); ++offset )
+        {
+            auto & queue = *queues_[ ( home + offset ) % queues_.size() ];
+            std::lock_guard< std::mutex > lock( queue.mutex );
+            if( !queue.jobs.empty() )
+            {
+                Job job = std::move( queue.jobs.front() );
+                queue.jobs.pop_front();
+                queued_.fetch_sub( 1, std::memory_order_relaxed );
+                return job;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void work( std::stop_token stop_token, std::size_t index )
+    {
+        current_pool_ = this;
+        current_queue_ = index;
+        while( !stop_token.stop_requested() )
+        {
+            if( auto job = take() )
+            {
+                ( *job )();
+                continue;
+            }
+            std::unique_lock< std::mutex > lock( sleep_mutex_ );
+            wake_.wait( lock, [ this ] { return stopping_ || queued_.load( std::memory_order_acquire ) > 0; } );
+            if( stopping_ )
+            {
+                return;
+            }
+        }
+    }
+
+public:
+    /// @brief Start a pool.
+    /// @param workers Number of worker threads; 0 runs every job on the waiting thread.
+    explicit JobSystem( std::size_t workers = defaultWorkerCount() )
+    {
+        queues_.reserve( workers + 1 );
+        for( std::size_t i = 0; i < workers + 1; ++i )
+        {
+            queues_.push_back( std::make_unique< Queue >() );
+        }
+        workers_.reserve( workers );
+        for( std::size_t i = 0; i < workers; ++i )
+        {
+            workers_.emplace_back( [ this, i ]( std::stop_token stop_token ) { work( stop_token, i ); } );
+        }
+    }
+
+    JobSystem( const JobSystem & ) = delete;
+    JobSystem & operator=( const JobSystem & ) = delete;
+
+    /// @brief Stop and join the workers; jobs still queued are discarded.
+    ~JobSystem()
+    {
+        {
+            std::lock_guard< std::mutex > lock( sleep_mutex_ );
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for( auto & worker : workers_ )
+        {
+            worker.request_stop();
+        }
+        workers_.clear();
+    }
+
+    /// @brief Number of worker threads, not counting threads that wait on the pool.
+    std::size_t worker_count() const noexcept
+    {
+        return workers_.size();
+    }
+
+    /// @brief Queue a job as part of a batch.
+    ///
+    /// @param counter Batch the job belongs to; must outlive the job.
+    /// @param job Work to run on some thread of the pool.
+    void submit( JobCounter & counter, Job job )
+    {
+        counter.pending_.fetch_add( 1, std::memory_order_relaxed );
+        Job wrapped = [ &counter, job = std::move( job ) ] {
+            try
+            {
+                job();
+            }
+            catch( ... )
+            {
+                std::lock_guard< std::mutex > lock( counter.error_mutex_ );
+                if( !counter.error_ )
+                {
+                    counter.error_ = std::current_exception();
+                }
+            }
+            counter.pending_.fetch_sub( 1, std::memory_order_acq_rel );
+        };
+        {
+            auto & queue = *queues_[ home_queue() ];
+            std::lock_guard< std::mutex > lock( queue.mutex );
+            queue.jobs.push_back( std::move( wrapped ) );
+            queued_.fetch_add( 1, std::memory_order_release );
+        }
+        if( !workers_.empty() )
+        {
+            {
+                // Orders the queued_ update with a worker about to sleep, so the wake-up is not lost
+                std::lock_guard< std::mutex > lock( sleep_mutex_ );
+            }
+            wake_.notify_one();
+        }
+    }
+
+    /// @brief Run queued jobs until every job of a batch has finished.
+    ///
+    /// @param counter Batch to wait for.
+    /// @throw Whatever the first failing job of the batch threw.
+    void wait( JobCounter & counter )
+    {
+        while( !counter.done() )
+        {
+            if( auto job = take() )
+            {
+                ( *job )();
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        std::exception_ptr error;
+        {
+            std::lock_guard< std::mutex > lock( counter.error_mutex_ );
+            error = std::exchange( counter.error_, nullptr );
+        }
+        if( error )
+        {
+            std::rethrow_exception( error );
+        }
+    }
+
+    /// @brief Call fn( chunk_begin, chunk_end ) over [begin, end) split into chunks across the pool.
+    ///
+    /// Ranges no longer than grain, and every range when the pool has no
+    /// workers, run inline on the caller. Otherwise the range is cut into at
+    /// most four chunks per thread, each at least grain long, and the caller
+    /// runs the first chunk itself before helping with the rest.
+    ///
+    /// @param begin First index.
+    /// @param end One past the last index.
+    /// @param grain Smallest chunk worth handing to another thread.
+    /// @param fn Callable taking a half-open index range; called concurrently for disjoint ranges.
+    /// @throw Whatever the first failing chunk threw, after every chunk has finished.
+    template < typename Fn >
+    void parallel_for( std::size_t begin, std::size_t end, std::size_t grain, Fn && fn )
+    {
+        if( end <= begin )
+        {
+            return;
+        }
+        std::size_t count = end - begin;
+        grain = std::max< std::size_t >( grain, 1 );
+        if( workers_.empty() || count <= grain )
+        {
+            fn( begin, end );
+            return;
+        }
+
+        std::size_t chunks = std::min( ( count + grain - 1 ) / grain, ( workers_.size() + 1 ) * 4 );
+        std::size_t chunk_size = ( count + chunks - 1 ) / chunks;
+        JobCounter counter;
+        for( std::size_t first = begin + chunk_size; first < end; first += chunk_size )
+        {
+            std::size_t last = std::min( first + chunk_size, end );
+            submit( counter, [ &fn, first, last ] { fn( first, last ); } );
+        }
+        std::exception_ptr error;
+        try
+        {
+            fn( begin, std::min( begin + chunk_size, end ) );
+        }
+        catch( ... )
+        {
+            error = std::current_exception();
+        }
+        wait( counter );
+        if( error )
+        {
+            std::rethrow_exception( error );
+        }
+    }
+};
+} // namespace robot::src::detail::job_system::inline exports
+
+namespace robot::src::inline exports::inline job_system
+{
+using namespace detail::job_system::exports;
+}
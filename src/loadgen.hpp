@@ -0,0 +1,642 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// @file loadgen.hpp
+/// @brief Viewer load against a running server, and the end-to-end latency it sees.
+///
+/// Pollers fetch `/output?since=` deltas back to back, stream subscribers hold a
+/// `/stream` WebSocket open, and writers POST `/input` at a mean rate. Every
+/// accepted input is numbered by the server, and every versioned scene says how
+/// many inputs its tick had applied, so the first scene any viewer receives
+/// with a count at or past an input's number is the one that made it visible.
+/// The server's own tick counters are scraped from `/metrics` before and after.
+
+namespace robot::src::detail::loadgen::inline exports
+{
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+/// @brief Find an unsigned number member in a JSON object without parsing the document.
+///
+/// Only the first occurrence counts, which for a scene packet is its header,
+/// however many entities follow it.
+///
+/// @param json JSON text such as {"version":2,"type":"delta","base":1,"tick":2,"inputs":5,...}.
+/// @param key Member name, without quotes.
+/// @return The value, or an empty optional if the member is absent or not an unsigned integer.
+inline std::optional< std::uint64_t > jsonUnsigned( std::string_view json, std::string_view key )
+{
+    std::string needle = "\"" + std::string( key ) + "\":";
+    auto at = json.find( needle );
+    if( at == std::string_view::npos )
+    {
+        return std::nullopt;
+    }
+    std::uint64_t value = 0;
+    auto begin = json.data() + at + needle.size();
+    auto [ end, ec ] = std::from_chars( begin, json.data() + json.size(), value );
+    if( ec != std::errc{} || end == begin )
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+/// @brief Read an unlabelled sample from a Prometheus text exposition.
+/// @param text Body of a `/metrics` response.
+/// @param name Metric name, such as robot_ticks_total.
+/// @return The sample's value, or an empty optional if there is no such sample.
+inline std::optional< double > prometheusValue( std::string_view text, std::string_view name )
+{
+    while( !text.empty() )
+    {
+        auto line = text.substr( 0, text.find( '\n' ) );
+        text.remove_prefix( std::min( text.size(), line.size() + 1 ) );
+        if( line.size() > name.size() && line.starts_with( name ) && line[ name.size() ] == ' ' )
+        {
+            auto number = line.substr( name.size() + 1 );
+            double value = 0.0;
+            auto [ end, ec ] = std::from_chars( number.data(), number.data() + number.size(), value );
+            if( ec == std::errc{} )
+            {
+                return value;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+/// @brief An accepted POST /input: when it was sent, and the number the server gave it.
+struct SentInput
+{
+    std::uint64_t number = 0; ///< The "input" member of the response
+    Clock::time_point sent; ///< When the request started to be written
+};
+
+/// @brief The first time any viewer received a scene that had applied this many inputs.
+struct Visibility
+{
+    std::uint64_t inputs = 0; ///< The scene's "inputs" member
+    Clock::time_point seen; ///< When the response or frame carrying it arrived
+};
+
+/// @brief How long accepted inputs took to reach a viewer.
+struct InputLatencies
+{
+    std::vector< std::chrono::nanoseconds > latencies; ///< One per input seen, in ascending order
+    std::size_t unseen = 0; ///< Inputs no viewer received a scene for before the run ended
+};
+
+/// @brief Match each input with the first scene that had applied it.
+/// @param sent Inputs in any order.
+/// @param seen Visibility marks with strictly increasing input counts, as LatencyLog keeps them.
+/// @return The sorted latencies, and how many inputs never became visible.
+inline InputLatencies matchInputLatencies( std::span< const SentInput > sent, std::span< const Visibility > seen )
+{
+    InputLatencies result;
+    result.latencies.reserve( sent.size() );
+    for( const auto & input : sent )
+    {
+        auto mark = std::lower_bound( seen.begin(), seen.end(), input.number,
+                                      []( const Visibility & v, std::uint64_t n ) { return v.inputs < n; } );
+        if( mark == seen.end() )
+        {
+            ++result.unseen;
+            continue;
+        }
+        result.latencies.push_back( std::max( std::chrono::nanoseconds{ 0 }, mark->seen - input.sent ) );
+    }
+    std::sort( result.latencies.begin(), result.latencies.end() );
+    return result;
+}
+
+/// @brief Nearest-rank percentile of sorted samples.
+/// @param sorted Samples in ascending order.
+/// @param q Fraction in [0, 1], such as 0.99.
+/// @return The smallest sample at or above that fraction of the samples, or zero if there are none.
+inline std::chrono::nanoseconds percentile( std::span< const std::chrono::nanoseconds > sorted, double q )
+{
+    if( sorted.empty() )
+    {
+        return std::chrono::nanoseconds{ 0 };
+    }
+    auto rank = static_cast< std::size_t >( std::ceil( q * static_cast< double >( sorted.size() ) ) );
+    return sorted[ std::clamp< std::size_t >( rank, 1, sorted.size() ) - 1 ];
+}
+
+/// @brief Inputs sent and scenes seen by every client of a run.
+///
+/// Viewers only take the lock when a scene applied more inputs than any seen
+/// before, which is at most once per tick.
+class LatencyLog
+{
+private:
+    std::mutex mutex_;
+    std::vector< SentInput > sent_;
+    std::vector< Visibility > seen_;
+    std::atomic< std::uint64_t > most_seen_{ 0 };
+
+public:
+    /// @brief Record an input the server accepted.
+    void sent( SentInput input )
+    {
+        std::lock_guard< std::mutex > lock( mutex_ );
+        sent_.push_back( input );
+    }
+
+    /// @brief Record a scene that arrived at a viewer.
+    void seen( std::uint64_t inputs, Clock::time_point at )
+    {
+        if( inputs <= most_seen_.load( std::memory_order_relaxed ) )
+        {
+            return;
+        }
+        std::lock_guard< std::mutex > lock( mutex_ );
+        if( seen_.empty() || inputs > seen_.back().inputs )
+        {
+            seen_.push_back( { inputs, at } );
+            most_seen_.store( inputs, std::memory_order_relaxed );
+        }
+    }
+
+    /// @brief Match what was sent with what was seen; call once the clients have stopped.
+    InputLatencies latencies()
+    {
+        std::lock_guard< std::mutex > lock( mutex_ );
+        return matchInputLatencies( sent_, seen_ );
+    }
+};
+
+/// @brief The load to apply, and where.
+struct LoadOptions
+{
+    std::string host = "127.0.0.1"; ///< Server to connect to
+    std::string port = "8080"; ///< Its REST port
+    std::optional< std::size_t > world; ///< World to load under /worlds/<id>/, or the unprefixed routes
+    std::size_t pollers = 8; ///< Connections polling /output back to back
+    std::size_t streams = 0; ///< WebSocket subscribers on /stream
+    std::size_t writers = 2; ///< Connections posting /input
+    double input_rate = 20.0; ///< Mean inputs per second each writer sends, with exponential gaps
+    std::chrono::milliseconds poll_interval{ 0 }; ///< Pause after each poll; 0 polls back to back
+    std::chrono::milliseconds duration{ 10'000 }; ///< How long the load runs
+    unsigned int threads = 2; ///< Threads running the clients
+};
+
+/// @brief What the clients and the server's counters saw during a run.
+struct LoadReport
+{
+    std::chrono::nanoseconds elapsed{ 0 }; ///< Wall time the load ran for
+    std::uint64_t outputs = 0; ///< /output responses received
+    std::uint64_t output_bytes = 0; ///< Their body bytes
+    std::uint64_t frames = 0; ///< /stream frames received
+    std::uint64_t frame_bytes = 0; ///< Their payload bytes
+    std::uint64_t inputs = 0; ///< /input requests accepted
+    std::uint64_t inputs_rejected = 0; ///< /input requests answered 503 because the queue was full
+    std::uint64_t errors = 0; ///< Failed connections, requests and unexpected statuses
+    InputLatencies input_latency; ///< Input-to-visible latency of the accepted inputs
+    std::optional< double > ticks; ///< Server ticks during the run, if /metrics could be read
+    std::optional< double > overruns; ///< Server tick overruns during the run, if /metrics could be read
+
+    /// @brief Overruns per tick during the run, if both counters were read and any tick ran.
+    std::optional< double > overrun_rate() const noexcept
+    {
+        if( !ticks || !overruns || *ticks <= 0.0 )
+        {
+            return std::nullopt;
+        }
+        return *overruns / *ticks;
+    }
+};
+
+} // namespace robot::src::detail::loadgen::inline exports
+
+namespace robot::src::detail::loadgen
+{
+/// @brief Counters the clients bump as they go.
+struct LoadCounters
+{
+    std::atomic< std::uint64_t > outputs{ 0 };
+    std::atomic< std::uint64_t > output_bytes{ 0 };
+    std::atomic< std::uint64_t > frames{ 0 };
+    std::atomic< std::uint64_t > frame_bytes{ 0 };
+    std::atomic< std::uint64_t > inputs{ 0 };
+    std::atomic< std::uint64_t > inputs_rejected{ 0 };
+    std::atomic< std::uint64_t > errors{ 0 };
+};
+
+/// @brief What every client of one run shares.
+struct LoadContext
+{
+    tcp::resolver::results_type endpoints; ///< The server's resolved addresses
+    std::string host; ///< Host header value
+    std::string prefix; ///< "/" or "/worlds/<id>/"
+    LatencyLog log;
+    LoadCounters counters;
+};
+
+/// @brief How long a connection waits before trying again after an error.
+inline constexpr auto RECONNECT_DELAY = std::chrono::milliseconds( 100 );
+
+/// @brief How long one request, response or handshake may take before the connection is dropped.
+inline constexpr auto REQUEST_TIMEOUT = std::chrono::seconds( 10 );
+
+/// @brief A keep-alive HTTP connection that either polls /output or posts /input, until the io_context stops.
+class HttpClient : public std::enable_shared_from_this< HttpClient >
+{
+public:
+    /// @brief What the connection sends.
+    enum class Role
+    {
+        poller,
+        writer
+    };
+
+private:
+    beast::tcp_stream stream_;
+    net::steady_timer timer_;
+    LoadContext & context_;
+    Role role_;
+    Clock::duration interval_; ///< Pause between polls, or mean period between inputs
+    std::mt19937_64 random_; ///< Draws the writer's gaps between inputs
+    Clock::time_point next_input_; ///< When the writer's next input is due
+    std::uint64_t since_ = 0; ///< Last tick the poller received
+    std::uint64_t sent_count_ = 0; ///< Inputs the writer has sent, choosing each one's direction
+    Clock::time_point sent_at_;
+    beast::flat_buffer buffer_;
+    http::request< http::string_body > request_;
+    std::optional< http::response_parser< http::string_body > > parser_;
+
+public:
+    HttpClient( net::io_context & ioc, LoadContext & context, Role role, Clock::duration interval,
+                std::uint64_t seed = 0 )
+        : stream_( net::make_strand( ioc ) )
+        , timer_( stream_.get_executor() )
+        , context_( context )
+        , role_( role )
+        , interval_( interval )
+        , random_( seed )
+    {}
+
+    /// @brief Connect and start sending.
+    void run()
+    {
+        next_input_ = Clock::now();
+        connect();
+    }
+
+private:
+    void connect()
+    {
+        stream_.expires_after( REQUEST_TIMEOUT );
+        stream_.async_connect( context_.endpoints,
+                               [ self = shared_from_this() ]( beast::error_code ec, const tcp::endpoint & ) {
+                                   if( ec )
+                                   {
+                                       return self->fail();
+                                   }
+                                   self->send();
+                               } );
+    }
+
+    /// @brief Count the error, drop the connection and reconnect after a pause.
+    void fail()
+    {
+        context_.counters.errors.fetch_add( 1, std::memory_order_relaxed );
+        beast::error_code ignored;
+        stream_.socket().close( ignored );
+        buffer_.clear();
+        timer_.expires_after( RECONNECT_DELAY );
+        timer_.async_wait( [ self = shared_from_this() ]( beast::error_code ec ) {
+            if( !ec )
+            {
+                self->connect();
+            }
+        } );
+    }
+
+    void send()
+    {
+        request_ = {};
+        request_.version( 11 );
+        request_.set( http::field::host, context_.host );
+        request_.keep_alive( true );
+        if( role_ == Role::poller )
+        {
+            request_.method( http::verb::get );
+            request_.target( context_.prefix + "output?since=" + std::to_string( since_ ) );
+        }
+        else
+        {
+            // Turn a quarter circle each time, so every input changes the robot's course
+            static constexpr std::string_view DIRECTIONS[] = { R"({"x":1,"y":0})", R"({"x":0,"y":1})",
+                                                               R"({"x":-1,"y":0})", R"({"x":0,"y":-1})" };
+            request_.method( http::verb::post );
+            request_.target( context_.prefix + "input" );
+            request_.set( http::field::content_type, "application/json" );
+            request_.body() = DIRECTIONS[ sent_count_++ % 4 ];
+            request_.prepare_payload();
+        }
+        sent_at_ = Clock::now();
+        stream_.expires_after( REQUEST_TIMEOUT );
+        http::async_write( stream_, request_, [ self = shared_from_this() ]( beast::error_code ec, std::size_t ) {
+            if( ec )
+            {
+                return self->fail();
+            }
+            self->receive();
+        } );
+    }
+
+    void receive()
+    {
+        // Keyframes of large worlds outgrow the parser's default body limit
+        parser_.emplace();
+        parser_->body_limit( std::numeric_limits< std::uint64_t >::max() );
+        http::async_read( stream_, buffer_, *parser_,
+                          [ self = shared_from_this() ]( beast::error_code ec, std::size_t ) {
+                              if( ec )
+                              {
+                                  return self->fail();
+                              }
+                              self->handle_response( Clock::now() );
+                          } );
+    }
+
+    void handle_response( Clock::time_point received )
+    {
+        auto & counters = context_.counters;
+        const auto & response = parser_->get();
+        const auto & body = response.body();
+        if( role_ == Role::poller && response.result() == http::status::ok )
+        {
+            counters.outputs.fetch_add( 1, std::memory_order_relaxed );
+            counters.output_bytes.fetch_add( body.size(), std::memory_order_relaxed );
+            since_ = jsonUnsigned( body, "tick" ).value_or( 0 );
+            context_.log.seen( jsonUnsigned( body, "inputs" ).value_or( 0 ), received );
+        }
+        else if( role_ == Role::writer && response.result() == http::status::ok )
+        {
+            counters.inputs.fetch_add( 1, std::memory_order_relaxed );
+            if( auto number = jsonUnsigned( body, "input" ) )
+            {
+                context_.log.sent( { *number, sent_at_ } );
+            }
+        }
+        else if( role_ == Role::writer && response.result() == http::status::service_unavailable )
+        {
+            counters.inputs_rejected.fetch_add( 1, std::memory_order_relaxed );
+        }
+        else
+        {
+            counters.errors.fetch_add( 1, std::memory_order_relaxed );
+        }
+        if( !response.keep_alive() )
+        {
+            beast::error_code ignored;
+            stream_.socket().close( ignored );
+            return connect();
+        }
+        schedule();
+    }
+
+    void schedule()
+    {
+        if( role_ == Role::writer )
+        {
+            // Open loop: inputs stay on their schedule however slowly the server answers. The gaps
+            // are exponential, so the inputs arrive as a Poisson process instead of locking to the tick
+            auto gap = std::exponential_distribution< double >( 1.0 )( random_ );
+            next_input_ += std::chrono::duration_cast< Clock::duration >( gap * interval_ );
+            timer_.expires_at( next_input_ );
+        }
+        else if( interval_ > Clock::duration::zero() )
+        {
+            timer_.expires_after( interval_ );
+        }
+        else
+        {
+            return send();
+        }
+        timer_.async_wait( [ self = shared_from_this() ]( beast::error_code ec ) {
+            if( !ec )
+            {
+                self->send();
+            }
+        } );
+    }
+};
+
+/// @brief A /stream WebSocket subscriber that reads JSON frames until the io_context stops.
+class StreamClient : public std::enable_shared_from_this< StreamClient >
+{
+private:
+    net::io_context & ioc_;
+    websocket::stream< beast::tcp_stream > ws_;
+    net::steady_timer timer_;
+    LoadContext & context_;
+    beast::flat_buffer buffer_;
+
+public:
+    StreamClient( net::io_context & ioc, LoadContext & context )
+        : ioc_( ioc )
+        , ws_( net::make_strand( ioc ) )
+        , timer_( ws_.get_executor() )
+        , context_( context )
+    {}
+
+    /// @brief Connect, subscribe and start reading.
+    void run()
+    {
+        auto & layer = beast::get_lowest_layer( ws_ );
+        layer.expires_after( REQUEST_TIMEOUT );
+        layer.async_connect( context_.endpoints,
+                             [ self = shared_from_this() ]( beast::error_code ec, const tcp::endpoint & ) {
+                                 if( ec )
+                                 {
+                                     return self->fail();
+                                 }
+                                 self->handshake();
+                             } );
+    }
+
+private:
+    void fail()
+    {
+        context_.counters.errors.fetch_add( 1, std::memory_order_relaxed );
+        timer_.expires_after( RECONNECT_DELAY );
+        timer_.async_wait( [ self = shared_from_this() ]( beast::error_code ec ) {
+            if( !ec )
+            {
+                // A failed websocket stream cannot be reused; start over with a fresh one
+                std::make_shared< StreamClient >( self->ioc_, self->context_ )->run();
+            }
+        } );
+    }
+
+    void handshake()
+    {
+        beast::get_lowest_layer( ws_ ).expires_never();
+        ws_.set_option( websocket::stream_base::timeout::suggested( beast::role_type::client ) );
+        ws_.read_message_max( std::numeric_limits< std::size_t >::max() );
+        ws_.async_handshake( context_.host, context_.prefix + "stream?format=json",
+                             [ self = shared_from_this() ]( beast::error_code ec ) {
+                                 if( ec )
+                                 {
+                                     return self->fail();
+                                 }
+                                 self->read();
+                             } );
+    }
+
+    void read()
+    {
+        ws_.async_read( buffer_, [ self = shared_from_this() ]( beast::error_code ec, std::size_t bytes ) {
+            if( ec )
+            {
+                return self->fail();
+            }
+            auto received = Clock::now();
+            auto & counters = self->context_.counters;
+            counters.frames.fetch_add( 1, std::memory_order_relaxed );
+            counters.frame_bytes.fetch_add( bytes, std::memory_order_relaxed );
+            auto data = self->buffer_.cdata();
+            auto frame = std::string_view( static_cast< const char * >( data.data() ), data.size() );
+            self->context_.log.seen( jsonUnsigned( frame, "inputs" ).value_or( 0 ), received );
+            self->buffer_.consume( self->buffer_.size() );
+            self->read();
+        } );
+    }
+};
+} // namespace robot::src::detail::loadgen
+
+namespace robot::src::detail::loadgen::inline exports
+{
+/// @brief GET a path from the server on a short-lived connection.
+/// @return The response body.
+/// @throw boost::system::system_error if the server cannot be reached or the request fails.
+inline std::string httpGet( const std::string & host, const std::string & port, const std::string & target )
+{
+    net::io_context ioc;
+    tcp::resolver resolver( ioc );
+    beast::tcp_stream stream( ioc );
+    stream.connect( resolver.resolve( host, port ) );
+    http::request< http::empty_body > request( http::verb::get, target, 11 );
+    request.set( http::field::host, host );
+    http::write( stream, request );
+    beast::flat_buffer buffer;
+    http::response< http::string_body > response;
+    http::read( stream, buffer, response );
+    beast::error_code ignored;
+    stream.socket().shutdown( tcp::socket::shutdown_both, ignored );
+    return std::move( response.body() );
+}
+
+/// @brief Apply the load for the configured duration and report what it saw.
+/// @param options Clients to open and where.
+/// @return Throughput, input latency and the server's tick counters over the run.
+/// @throw boost::system::system_error if the server's address cannot be resolved.
+inline LoadReport runLoad( const LoadOptions & options )
+{
+    net::io_context ioc;
+    LoadContext context;
+    context.endpoints = tcp::resolver( ioc ).resolve( options.host, options.port );
+    context.host = options.host;
+    context.prefix = options.world ? "/worlds/" + std::to_string( *options.world ) + "/" : "/";
+
+    // /metrics covers every world; its counters may be missing if the server is an older build
+    auto scrape = [ & ]() -> std::pair< std::optional< double >, std::optional< double > > {
+        try
+        {
+            auto text = httpGet( options.host, options.port, "/metrics" );
+            return { prometheusValue( text, "robot_ticks_total" ),
+                     prometheusValue( text, "robot_tick_overruns_total" ) };
+        }
+        catch( const std::exception & )
+        {
+            return {};
+        }
+    };
+    auto [ ticks_before, overruns_before ] = scrape();
+
+    auto poll_interval = std::chrono::duration_cast< Clock::duration >( options.poll_interval );
+    auto input_period = std::chrono::duration_cast< Clock::duration >(
+        std::chrono::duration< double >( options.input_rate > 0.0 ? 1.0 / options.input_rate : 1.0 ) );
+    using Role = HttpClient::Role;
+    for( std::size_t i = 0; i < options.pollers; ++i )
+    {
+        std::make_shared< HttpClient >( ioc, context, Role::poller, poll_interval )->run();
+    }
+    for( std::size_t i = 0; i < options.streams; ++i )
+    {
+        std::make_shared< StreamClient >( ioc, context )->run();
+    }
+    for( std::size_t i = 0; options.input_rate > 0.0 && i < options.writers; ++i )
+    {
+        std::make_shared< HttpClient >( ioc, context, Role::writer, input_period, i )->run();
+    }
+
+    auto start = Clock::now();
+    {
+        std::vector< std::jthread > threads;
+        for( unsigned int i = 0; i < std::max( 1u, options.threads ); ++i )
+        {
+            threads.emplace_back( [ &ioc ] { ioc.run(); } );
+        }
+        std::this_thread::sleep_for( options.duration );
+        // The clients never finish on their own; stopping drops them mid-request
+        ioc.stop();
+    }
+    LoadReport report;
+    report.elapsed = Clock::now() - start;
+
+    auto [ ticks_after, overruns_after ] = scrape();
+    if( ticks_before && ticks_after )
+    {
+        report.ticks = *ticks_after - *ticks_before;
+    }
+    if( overruns_before && overruns_after )
+    {
+        report.overruns = *overruns_after - *overruns_before;
+    }
+    const auto & counters = context.counters;
+    report.outputs = counters.outputs.load();
+    report.output_bytes = counters.output_bytes.load();
+    report.frames = counters.frames.load();
+    report.frame_bytes = counters.frame_bytes.load();
+    report.inputs = counters.inputs.load();
+    report.inputs_rejected = counters.inputs_rejected.load();
+    report.errors = counters.errors.load();
+    report.input_latency = context.log.latencies();
+    return report;
+}
+} // namespace robot::src::detail::loadgen::inline exports
+
+namespace robot::src::inline exports::inline loadgen
+{
+using namespace detail::loadgen::exports;
+}
@@ -0,0 +1,268 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// @file logging.hpp
+/// @brief Leveled logger whose callers never wait on the output streams.
+///
+/// A call below the logger's level costs one relaxed atomic load. Otherwise the
+/// message is formatted on the caller and appended to a bounded queue under a
+/// short lock; a background thread drains the queue and does all the writing.
+/// When the queue is full the message is dropped and counted, so a flood of
+/// requests slows nobody down.
+
+namespace robot::src::detail::logging::inline exports
+{
+/// @brief Severity of a log message, in increasing order.
+enum class LogLevel : std::uint8_t
+{
+    debug,
+    info,
+    warning,
+    error,
+    off, ///< Only as a logger level: disables every message
+};
+
+/// @brief Name of a level as printed in front of each message.
+inline std::string_view levelName( LogLevel level )
+{
+    switch( level )
+    {
+    case LogLevel::debug:
+        return "debug";
+    case LogLevel::info:
+        return "info";
+    case LogLevel::warning:
+        return "warning";
+    case LogLevel::error:
+        return "error";
+    case LogLevel::off:
+        break;
+    }
+    return "off";
+}
+
+/// @brief Parse a level name as accepted by --log-level.
+/// @return The level, or an empty optional if the name is not one of levelName()'s results.
+inline std::optional< LogLevel > parseLogLevel( std::string_view name )
+{
+    for( auto level : { LogLevel::debug, LogLevel::info, LogLevel::warning, LogLevel::error, LogLevel::off } )
+    {
+        if( levelName( level ) == name )
+        {
+            return level;
+        }
+    }
+    return std::nullopt;
+}
+
+/// @class Logger
+/// @brief Asynchronous leveled logger.
+///
+/// Messages of warning level and above go to the error stream, the others to
+/// the output stream, each on its own line with the level in brackets.
+///
+/// @par Example usage:
+/// @code
+/// Logger logger( std::cout, std::cerr, LogLevel::debug );
+/// logger.info( "REST client connected first time from ", client_ip );
+/// @endcode
+class Logger
+{
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 4096; ///< Messages queued before new ones are dropped
+
+private:
+    struct Entry
+    {
+        LogLevel level;
+        std::string text;
+    };
+
+    std::ostream & out_;
+    std::ostream & err_;
+    std::size_t capacity_;
+    std::atomic< LogLevel > level_;
+    std::atomic< std::uint64_t > dropped_{ 0 };
+    std::mutex mutex_;
+    std::condition_variable_any wake_; ///< Signalled when a message is queued
+    std::condition_variable_any drained_; ///< Signalled when the writer has written everything taken
+    std::vector< Entry > queue_;
+    std::uint64_t queued_ = 0; ///< Messages ever queued, under mutex_
+    std::uint64_t written_ = 0; ///< Messages ever written, under mutex_
+    std::jthread writer_; ///< Declared last so it starts after, and stops before, the members it uses
+
+    void write( std::stop_token stop_token )
+    {
+        std::vector< Entry > batch;
+        std::unique_lock< std::mutex > lock( mutex_ );
+        while( true )
+        {
+            wake_.wait( lock, stop_token, [ this ] { return !queue_.empty(); } );
+            if( queue_.empty() )
+            {
+                return; // Stop requested and nothing left to write
+            }
+            batch.swap( queue_ );
+            lock.unlock();
+            bool wrote_out = false;
+            bool wrote_err = false;
+            for( const auto & entry : batch )
+            {
+                auto & stream = entry.level >= LogLevel::warning ? err_ : out_;
+                ( entry.level >= LogLevel::warning ? wrote_err : wrote_out ) = true;
+                stream << '[' << levelName( entry.level ) << "] " << entry.text << '\n';
+            }
+            if( wrote_out )
+                out_.flush();
+            if( wrote_err )
+                err_.flush();
+            lock.lock();
+            written_ += batch.size();
+            batch.clear();
+            drained_.notify_all();
+        }
+    }
+
+public:
+    /// @brief Start a logger and its writer thread.
+    /// @param out Stream for debug and info messages.
+    /// @param err Stream for warnings and errors.
+    /// @param level Least severe level that is logged.
+    /// @param capacity Messages that may wait for the writer before new ones are dropped.
+    explicit Logger( std::ostream & out = std::cout, std::ostream & err = std::cerr, LogLevel level = LogLevel::info,
+                     std::size_t capacity = DEFAULT_CAPACITY )
+        : out_( out )
+        , err_( err )
+        , capacity_( capacity )
+        , level_( level )
+        , writer_( [ this ]( std::stop_token stop_token ) { write( stop_token ); } )
+    {}
+
+    Logger( const Logger & ) = delete;
+    Logger & operator=( const Logger & ) = delete;
+
+    /// @brief Stops the writer once every queued message has been written.
+    ~Logger()
+    {
+        writer_.request_stop();
+    }
+
+    /// @brief Change the least severe level that is logged. Safe to call from any thread.
+    void set_level( LogLevel level ) noexcept
+    {
+        level_.store( level, std::memory_order_relaxed );
+    }
+
+    /// @brief Least severe level that is logged.
+    LogLevel level() const noexcept
+    {
+        return level_.load( std::memory_order_relaxed );
+    }
+
+    /// @brief Whether messages of a level would be logged; check before building an expensive message.
+    bool enabled( LogLevel level ) const noexcept
+    {
+        return level != LogLevel::off && level >= this->level();
+    }
+
+    /// @brief Queue a message without waiting for it to be written.
+    /// @return False if the level is disabled or the queue was full and the message was dropped.
+    bool log( LogLevel level, std::string text )
+    {
+        if( !enabled( level ) )
+        {
+            return false;
+        }
+        {
+            std::lock_guard< std::mutex > lock( mutex_ );
+            if( queue_.size() >= capacity_ )
+            {
+                dropped_.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+            queue_.push_back( Entry{ level, std::move( text ) } );
+            ++queued_;
+        }
+        wake_.notify_one();
+        return true;
+    }
+
+    /// @brief Format the arguments with operator<< and queue the result.
+    template < typename... Args >
+    bool log( LogLevel level, const Args &... args )
+    {
+        if( !enabled( level ) )
+        {
+            return false;
+        }
+        std::ostringstream text;
+        ( text << ... << args );
+        return log( level, std::move( text ).str() );
+    }
+
+    template < typename... Args >
+    bool debug( const Args &... args )
+    {
+        return log( LogLevel::debug, args... );
+    }
+
+    template < typename... Args >
+    bool info( const Args &... args )
+    {
+        return log( LogLevel::info, args... );
+    }
+
+    template < typename... Args >
+    bool warning( const Args &... args )
+    {
+        return log( LogLevel::warning, args... );
+    }
+
+    template < typename... Args >
+    bool error( const Args &... args )
+    {
+        return log( LogLevel::error, args... );
+    }
+
+    /// @brief Block until every message queued before the call has been written.
+    void flush()
+    {
+        std::unique_lock< std::mutex > lock( mutex_ );
+        auto target = queued_;
+        drained_.wait( lock, [ & ] { return written_ >= target; } );
+    }
+
+    /// @brief Messages dropped because the queue was full.
+    std::uint64_t dropped() const noexcept
+    {
+        return dropped_.load( std::memory_order_relaxed );
+    }
+};
+
+/// @brief Process-wide logger writing to std::cout and std::cerr.
+inline Logger & defaultLogger()
+{
+    static Logger logger;
+    return logger;
+}
+} // namespace robot::src::detail::logging::inline exports
+
+namespace robot::src::inline exports::inline logging
+{
+using namespace detail::logging::exports;
+}
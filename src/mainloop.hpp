@@ -1,69 +1,246 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
-#include <chrono>
+#include <deque>
+#include <fstream>
+#include <functional>
 #include <iostream>
-#include <mutex>
+#include <optional>
 #include <stop_token>
+#include <string>
 #include <thread>
+#include <vector>
 
-#include "assets.hpp"
 #include "component_types.hpp"
+#include "input_recording.hpp"
+#include "job_system.hpp"
+#include "metrics.hpp"
 #include "rest.hpp"
-#include "systems.hpp"
+#include "scene_snapshot.hpp"
+#include "simulation.hpp"
+#include "tick_scheduler.hpp"
+#include "world_file.hpp"
+
+namespace robot::src::detail::mainloop
+{
+/// @brief One world the server runs: its simulation, the schedule stepping it and what viewers read of it.
+///
+/// A world is only ever stepped by its own loop thread and shares no lock with
+/// any other world, so worlds scale across cores independently.
+struct World
+{
+    TickScheduler & scheduler; ///< Built before the worlds, so Metrics can watch every world's counters
+    Simulation simulation;
+    SnapshotBuffer snapshots; ///< Scenes published for the REST readers
+    StreamHub stream_hub; ///< WebSocket viewers, pushed each snapshot as soon as it is published
+
+    World( TickScheduler & world_scheduler, std::size_t sim_threads, Metrics & metrics )
+        : scheduler( world_scheduler )
+        , simulation( sim_threads, &metrics )
+    {}
+};
+
+/// @brief The file a world reads or writes: the path itself for a single world, else the path with ".<id>" appended.
+inline std::string worldFilePath( const std::string & path, std::size_t world, std::size_t world_count )
+{
+    if( path.empty() || world_count == 1 )
+    {
+        return path;
+    }
+    return path + "." + std::to_string( world );
+}
+} // namespace robot::src::detail::mainloop
 
 namespace robot::src::detail::mainloop::inline exports
 {
-void runMainloop( std::stop_source & stop_source )
+/// @brief Run the simulated worlds and the REST server until a stop is requested.
+///
+/// World 0 is served at /input, /output, /stream and /; every world, 0 included,
+/// is also served under /worlds/<id>/. Each world is stepped by its own loop
+/// thread, with its own store, input queue and snapshots.
+///
+/// @param stop_source Source whose stop request shuts everything down.
+/// @param rest_threads Number of threads serving REST and WebSocket clients.
+/// @param sim_threads Number of worker threads each world's systems may spread across, besides its loop thread.
+/// @param record_path File to write the viewers' input stream to on exit, for replay with --replay; empty for none.
+/// @param load_path World file to start from instead of building the procedural assets; empty for none.
+/// @param checkpoint_path File the world is saved to in the background and on exit; empty for none.
+/// @param checkpoint_interval Ticks between background checkpoints; 0 only saves on exit.
+/// @param world_count Number of independent worlds to run. With more than one, each world records to,
+///                    loads from and checkpoints to its own file, the given path with ".<id>" appended.
+void runMainloop( std::stop_source & stop_source,
+                  unsigned int rest_threads = defaultRestThreadCount(),
+                  std::size_t sim_threads = defaultWorkerCount(),
+                  const std::string & record_path = {},
+                  const std::string & load_path = {},
+                  const std::string & checkpoint_path = {},
+                  std::uint64_t checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL,
+                  std::size_t world_count = 1 )
 {
-    // The REST server and main loop will both access the EntityStore, so we
-    // need to protect it with a mutex.
-    std::mutex store_mutex;
-    EntityStore store;
-    boost::asio::io_context ioc;
+    world_count = std::max< std::size_t >( world_count, 1 );
+    // Fixed ~60 Hz timestep per world; their counters are served summed on /metrics with the histograms.
+    std::deque< TickScheduler > schedulers( world_count );
+    std::vector< const TickStats * > tick_stats;
+    for( const auto & scheduler : schedulers )
+    {
+        tick_stats.push_back( &scheduler.stats() );
+    }
+    Metrics metrics( std::move( tick_stats ) );
+    // Only a world's loop thread touches its EntityStore: viewers push input onto the
+    // simulation's lock-free queue and read published snapshots, so no lock is shared.
+    std::deque< World > worlds;
+    std::vector< WorldEndpoint > endpoints;
+    for( auto & scheduler : schedulers )
+    {
+        auto & world = worlds.emplace_back( scheduler, sim_threads, metrics );
+        endpoints.push_back( { world.simulation.inputs(), world.snapshots, world.stream_hub } );
+    }
+    rest_threads = std::max( rest_threads, 1u );
+    boost::asio::io_context ioc( static_cast< int >( rest_threads ) );
     std::string theKey =
         "example_key"; // In a real application, you might want to get this from user input or a config file.
 
-    std::jthread loop_thread(
-        [ &stop_source, &store_mutex, &store, &theKey ]( std::stop_token stop_token ) {
-            std::cout << "Building procedural assets from key " << theKey << "..." << std::endl;
-            buildProceduralAssets( store, theKey );
-            std::cout << "Done." << std::endl;
+    auto run_world = [ &metrics, &theKey, checkpoint_interval, &stop_source ](
+                         World & world, std::string label, std::string record_file, std::string load_file,
+                         std::string checkpoint_file, std::stop_token stop_token ) {
+        auto & simulation = world.simulation;
+        std::optional< LoadedWorld > loaded; // Recorded so a replay is checked against the same file
+        if( !load_file.empty() )
+        {
+            std::cout << label << "Loading world from " << load_file << "..." << std::endl;
+            try
+            {
+                simulation.restore( load_file );
+            }
+            catch( const std::exception & e )
+            {
+                std::cerr << label << "Cannot load world " << load_file << ": " << e.what() << std::endl;
+                stop_source.request_stop();
+                return;
+            }
+            loaded = LoadedWorld{ simulation.tick(), stateHash( simulation.store() ) };
+            std::cout << label << "Done: " << simulation.store().registry.size() << " entities of key "
+                      << simulation.key() << " at tick " << simulation.tick() << "." << std::endl;
+        }
+        else
+        {
+            std::cout << label << "Building procedural assets from key " << theKey << "..." << std::endl;
+            simulation.build( theKey );
+            std::cout << label << "Done." << std::endl;
+        }
+        // Saves are copied on this thread between ticks, then encoded and written by the checkpointer's own
+        std::optional< Checkpointer > checkpointer;
+        if( !checkpoint_file.empty() )
+        {
+            checkpointer.emplace( checkpoint_file, checkpoint_interval );
+        }
 
-            std::cout << "Main loop started. Press Ctrl+C to stop." << std::endl;
+        std::cout << label << "Main loop started. Press Ctrl+C to stop." << std::endl;
 
-            while( !stop_token.stop_requested() )
+        InputRecorder recorder;
+        if( !record_file.empty() )
+        {
+            simulation.record_inputs( &recorder );
+        }
+        world.scheduler.run( stop_token, [ & ] {
+            ScopedTimer tick_timer( metrics.tick );
+            simulation.step();
+            // Publish an immutable copy of the scene for the REST readers
+            auto & snapshot = world.snapshots.write_buffer();
+            snapshot.capture( simulation.store(), simulation.tick(), world.snapshots.latest().get() );
+            snapshot.inputs = simulation.inputs().popped();
+            world.snapshots.publish();
+            world.stream_hub.broadcast();
+            if( checkpointer )
             {
-                std::lock_guard< std::mutex > lock( store_mutex );
-                handlePlayerInput( store );
-                handleCollisions( store );
-                updatePositions( store );
-                std::this_thread::sleep_for( std::chrono::milliseconds( 16 ) ); // ~60 FPS
+                checkpointer->maybe_checkpoint( simulation.store(), simulation.world_info() );
             }
+        } );
+
+        auto const & stats = world.scheduler.stats();
+        auto ticks = stats.ticks.load();
+        std::cout << "\r" << label << "Main loop exiting after " << ticks << " ticks (" << stats.overruns.load()
+                  << " overruns, " << stats.dropped_steps.load() << " dropped steps, max tick "
+                  << stats.max_tick_ns.load() / 1000 << " us, mean tick "
+                  << ( ticks ? stats.total_tick_ns.load() / static_cast< std::int64_t >( ticks ) / 1000 : 0 )
+                  << " us)..." << std::endl;
 
-            std::cout << "\rMain loop exiting..." << std::endl;
-        },
-        stop_source.get_token() );
+        if( checkpointer )
+        {
+            checkpointer->flush();
+            checkpointer->checkpoint( simulation.store(), simulation.world_info() );
+            checkpointer->flush();
+            std::cout << label << "Final checkpoint at tick " << simulation.tick() << " to " << checkpointer->path()
+                      << " (" << checkpointer->written() << " checkpoints written, " << checkpointer->skipped()
+                      << " skipped, " << checkpointer->failed() << " failed)." << std::endl;
+        }
 
-    std::jthread rest_thread(
-        [ &stop_source, &store_mutex, &store, &ioc ]( std::stop_token stop_token ) {
-            std::cout << "REST server started on port 8080." << std::endl;
-            // print a clickable URL if the terminal supports it
-            std::cout << "Open http://localhost:8080 in your browser to control the robot." << std::endl;
-            auto rest_server = std::make_shared< RESTServer >( ioc, store_mutex, store, 8080 );
-            rest_server->run();
+        if( !record_file.empty() )
+        {
+            InputRecording recording{ simulation.key(), simulation.num_assets(), std::nullopt, loaded,
+                                      recorder.events(), simulation.tick(), stateHash( simulation.store() ) };
+            std::ofstream out( record_file );
+            writeInputRecording( out, recording );
+            std::cout << label << "Recorded " << recording.events.size() << " input changes over "
+                      << simulation.tick() << " ticks to " << record_file << "." << std::endl;
+        }
+    };
 
-            // Register a callback to stop the io_context when the stop token is requested
-            std::stop_callback stop_cb( stop_token, [ &ioc ]() {
-                ioc.stop();
-            } );
+    std::vector< std::jthread > loop_threads;
+    loop_threads.reserve( world_count );
+    for( std::size_t i = 0; i < world_count; ++i )
+    {
+        auto label = world_count == 1 ? std::string() : "World " + std::to_string( i ) + ": ";
+        loop_threads.emplace_back( run_world, std::ref( worlds[ i ] ), std::move( label ),
+                                   worldFilePath( record_path, i, world_count ),
+                                   worldFilePath( load_path, i, world_count ),
+                                   worldFilePath( checkpoint_path, i, world_count ), stop_source.get_token() );
+    }
 
+    std::cout << "REST server started on port 8080 with " << rest_threads << " threads; " << world_count
+              << ( world_count == 1 ? " world" : " worlds" ) << " using " << sim_threads
+              << " worker threads each." << std::endl;
+    // print a clickable URL if the terminal supports it
+    std::cout << "Open http://localhost:8080 in your browser to control the robot." << std::endl;
+    if( world_count > 1 )
+    {
+        std::cout << "World N is at http://localhost:8080/worlds/N/ for N from 0 to " << world_count - 1 << "."
+                  << std::endl;
+    }
+    try
+    {
+        std::make_shared< RESTServer >( ioc, endpoints, metrics, 8080 )->run();
+    }
+    catch( const std::exception & e )
+    {
+        std::cerr << "REST server failed to start: " << e.what() << std::endl;
+        stop_source.request_stop();
+        return;
+    }
+
+    // Stop the io_context when the stop token is requested; this outlives the
+    // REST threads below, which are joined first.
+    std::stop_callback stop_cb( stop_source.get_token(), [ &ioc ]() {
+        ioc.stop();
+    } );
+
+    // Every thread runs the same io_context; per-session strands keep each
+    // client's handlers serialized.
+    std::vector< std::jthread > rest_pool;
+    rest_pool.reserve( rest_threads );
+    for( unsigned int i = 0; i < rest_threads; ++i )
+    {
+        rest_pool.emplace_back( [ &ioc ] {
             // Run the io_context - this will block until ioc.stop() is called
             ioc.run();
-
-            std::cout << "\rREST server exiting..." << std::endl;
-        },
-        stop_source.get_token() );
+        } );
+    }
+    for( auto & thread : rest_pool )
+    {
+        thread.join();
+    }
+    std::cout << "\rREST server exiting..." << std::endl;
 }
 } // namespace robot::src::detail::mainloop::inline exports
 
@@ -4,6 +4,14 @@ static_assert( __cplusplus > 2020'00 );
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
+
+#if __has_include( <experimental/simd> )
+#include <experimental/simd>
+#define ROBOT_HAS_STD_SIMD 1
+#else
+#define ROBOT_HAS_STD_SIMD 0
+#endif
 
 namespace robot::src::detail::math::inline exports
 {
@@ -144,9 +152,9 @@ inline Vec2 clampVec2( Vec2 v, Vec2 minV, Vec2 maxV )
 }
 
 struct Mat3;
-inline Mat3 operator*( Mat3 const & a, Mat3 const & b );
-inline Vec2 operator*( Mat3 const & m, Vec2 v );
-inline Vec2 operator*( Vec2 v, Mat3 const & m );
+inline constexpr Mat3 operator*( Mat3 const & a, Mat3 const & b );
+inline constexpr Vec2 operator*( Mat3 const & m, Vec2 v );
+inline constexpr Vec2 operator*( Vec2 v, Mat3 const & m );
 
 // ------------------------------------------------------------
 // Mat3 (homogeneous 2D affine)
@@ -156,22 +164,22 @@ struct Mat3
 {
     std::array< Float, 9 > m{ { 1, 0, 0, 0, 1, 0, 0, 0, 1 } };
 
-    static Mat3 identity()
+    static constexpr Mat3 identity()
     {
         return Mat3{};
     }
 
-    Float & operator()( int row, int col )
+    constexpr Float & operator()( int row, int col )
     {
         return m[ col * 3 + row ];
     }
 
-    Float operator()( int row, int col ) const
+    constexpr Float operator()( int row, int col ) const
     {
         return m[ col * 3 + row ];
     }
 
-    static Mat3 translation( Vec2 t )
+    static constexpr Mat3 translation( Vec2 t )
     {
         Mat3 r = identity();
         r( 0, 2 ) = t.x;
@@ -179,13 +187,13 @@ struct Mat3
         return r;
     }
 
-    auto & translate( Vec2 t )
+    constexpr auto & translate( Vec2 t )
     {
         *this = Mat3::translation( t ) * *this;
         return *this;
     }
 
-    static Mat3 scaled( Vec2 s )
+    static constexpr Mat3 scaled( Vec2 s )
     {
         Mat3 r = identity();
         r( 0, 0 ) = s.x;
@@ -193,17 +201,16 @@ struct Mat3
         return r;
     }
 
-    auto & scale( Vec2 s )
+    constexpr auto & scale( Vec2 s )
     {
         *this = Mat3::scaled( s ) * *this;
         return *this;
     }
 
-    static Mat3 rotation( Float radians )
+    // std::cos and std::sin are not constexpr, so neither are the forms taking an angle
+    static constexpr Mat3 rotation( Float c, Float s )
     {
         Mat3 r = identity();
-        auto const c = std::cos( radians );
-        auto const s = std::sin( radians );
 
         // [ c -s 0
         //   s  c 0
@@ -215,6 +222,11 @@ struct Mat3
         return r;
     }
 
+    static Mat3 rotation( Float radians )
+    {
+        return rotation( std::cos( radians ), std::sin( radians ) );
+    }
+
     auto & rotate( Float radians )
     {
         *this = Mat3::rotation( radians ) * *this;
@@ -222,7 +234,7 @@ struct Mat3
     }
 };
 
-inline Mat3 operator*( Mat3 const & a, Mat3 const & b )
+inline constexpr Mat3 operator*( Mat3 const & a, Mat3 const & b )
 {
     Mat3 out = Mat3::identity();
     for( int col = 0; col < 3; ++col )
@@ -240,7 +252,7 @@ inline Mat3 operator*( Mat3 const & a, Mat3 const & b )
     return out;
 }
 
-inline Vec2 operator*( Mat3 const & m, Vec2 v )
+inline constexpr Vec2 operator*( Mat3 const & m, Vec2 v )
 {
     // [x',y',1]^T = M * [x,y,1]^T
     return {
@@ -249,7 +261,7 @@ inline Vec2 operator*( Mat3 const & m, Vec2 v )
     };
 }
 
-inline Vec2 operator*( Vec2 v, Mat3 const & m )
+inline constexpr Vec2 operator*( Vec2 v, Mat3 const & m )
 {
     // [x',y',1] = [x,y,1] * M^T
     return {
@@ -258,9 +270,138 @@ inline Vec2 operator*( Vec2 v, Mat3 const & m )
     };
 }
 
+// ------------------------------------------------------------
+// Affine2 (2D affine with the constant bottom row of Mat3 dropped)
+// Named like the Canvas setTransform arguments:
+// [ a c e
+//   b d f ]
+// so p' = ( a*x + c*y + e, b*x + d*y + f ). Composition and
+// application are written out in closed form: 6 multiplies
+// per point instead of 9, and 12 per product instead of 27.
+// ------------------------------------------------------------
+struct Affine2
+{
+    Float a = 1, b = 0, c = 0, d = 1, e = 0, f = 0;
+
+    static constexpr Affine2 identity()
+    {
+        return Affine2{};
+    }
+
+    static constexpr Affine2 translation( Vec2 t )
+    {
+        return { 1, 0, 0, 1, t.x, t.y };
+    }
+
+    static constexpr Affine2 scaled( Vec2 s )
+    {
+        return { s.x, 0, 0, s.y, 0, 0 };
+    }
+
+    // Rotation by the angle with cosine c and sine s
+    static constexpr Affine2 rotation( Float c, Float s )
+    {
+        return { c, s, -s, c, 0, 0 };
+    }
+
+    static Affine2 rotation( Float radians )
+    {
+        return rotation( std::cos( radians ), std::sin( radians ) );
+    }
+
+    // T * R * S for a rotation given by its cosine and sine
+    static constexpr Affine2 trs( Vec2 t, Float c, Float s, Vec2 scale )
+    {
+        return { c * scale.x, s * scale.x, -s * scale.y, c * scale.y, t.x, t.y };
+    }
+
+    static constexpr Affine2 fromMatrix( Mat3 const & m )
+    {
+        return { m( 0, 0 ), m( 1, 0 ), m( 0, 1 ), m( 1, 1 ), m( 0, 2 ), m( 1, 2 ) };
+    }
+
+    constexpr Mat3 toMatrix() const
+    {
+        Mat3 r;
+        r( 0, 0 ) = a;
+        r( 1, 0 ) = b;
+        r( 0, 1 ) = c;
+        r( 1, 1 ) = d;
+        r( 0, 2 ) = e;
+        r( 1, 2 ) = f;
+        return r;
+    }
+
+    // Apply the linear part only, e.g. to a direction
+    constexpr Vec2 linear( Vec2 v ) const
+    {
+        return { a * v.x + c * v.y, b * v.x + d * v.y };
+    }
+
+    friend constexpr bool operator==( Affine2 const &, Affine2 const & ) = default;
+};
+
+// Composition: ( x * y ) applied to p is x applied to y applied to p
+inline constexpr Affine2 operator*( Affine2 const & x, Affine2 const & y )
+{
+    return {
+        x.a * y.a + x.c * y.b,
+        x.b * y.a + x.d * y.b,
+        x.a * y.c + x.c * y.d,
+        x.b * y.c + x.d * y.d,
+        x.a * y.e + x.c * y.f + x.e,
+        x.b * y.e + x.d * y.f + x.f,
+    };
+}
+
+inline constexpr Vec2 operator*( Affine2 const & x, Vec2 v )
+{
+    return { x.a * v.x + x.c * v.y + x.e, x.b * v.x + x.d * v.y + x.f };
+}
+
+/// @brief Apply one affine transform to SoA vertex arrays.
+///
+/// Several vertices are transformed at a time with std::experimental::simd
+/// where the standard library provides it. The output may alias the input.
+///
+/// @param transform Transform to apply.
+/// @param xs X-coordinates of the vertices.
+/// @param ys Y-coordinates of the vertices.
+/// @param count Number of vertices.
+/// @param out_x Receives the transformed x-coordinates; count entries, or xs itself.
+/// @param out_y Receives the transformed y-coordinates; count entries, or ys itself.
+inline void transformVertices( Affine2 const & transform, const Float * xs, const Float * ys, std::size_t count,
+                               Float * out_x, Float * out_y )
+{
+    std::size_t i = 0;
+#if ROBOT_HAS_STD_SIMD
+    namespace stdx = std::experimental;
+    using Batch = stdx::native_simd< Float >;
+    constexpr std::size_t width = Batch::size();
+    for( ; i + width <= count; i += width )
+    {
+        Batch x( xs + i, stdx::element_aligned );
+        Batch y( ys + i, stdx::element_aligned );
+        Batch tx = x * transform.a + y * transform.c + transform.e;
+        Batch ty = x * transform.b + y * transform.d + transform.f;
+        tx.copy_to( out_x + i, stdx::element_aligned );
+        ty.copy_to( out_y + i, stdx::element_aligned );
+    }
+#endif
+    for( ; i < count; ++i )
+    {
+        Vec2 vertex = transform * Vec2{ xs[ i ], ys[ i ] };
+        out_x[ i ] = vertex.x;
+        out_y[ i ] = vertex.y;
+    }
+}
+
 // ------------------------------------------------------------
 // Transform2D (TRS stored, matrix built on demand)
-// Convention: column vectors; compose as T * R * S
+// Convention: column vectors; compose as T * R * S, so a point
+// is scaled, then rotated, then translated. (The original
+// Mat3().translate().rotate().scale() chain pre-multiplied and
+// so built S * R * T, against this convention.)
 // ------------------------------------------------------------
 struct Transform2D
 {
@@ -268,9 +409,14 @@ struct Transform2D
     Float rotationRadians = 0;
     Vec2 scale{ 1, 1 };
 
+    Affine2 toAffine() const
+    {
+        return Affine2::trs( translation, std::cos( rotationRadians ), std::sin( rotationRadians ), scale );
+    }
+
     Mat3 toMatrix() const
     {
-        return Mat3().translate( translation ).rotate( rotationRadians ).scale( scale );
+        return toAffine().toMatrix();
     }
 };
 
@@ -286,7 +432,12 @@ struct CanvasXform
     Float a, b, c, d, e, f;
 };
 
-inline CanvasXform toCanvas( Mat3 const & m )
+inline constexpr CanvasXform toCanvas( Affine2 const & x )
+{
+    return { x.a, x.b, x.c, x.d, x.e, x.f };
+}
+
+inline constexpr CanvasXform toCanvas( Mat3 const & m )
 {
     return {
         m( 0, 0 ), // a
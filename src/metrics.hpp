@@ -0,0 +1,380 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tick_scheduler.hpp"
+
+/// @file metrics.hpp
+/// @brief Low-overhead histograms and their Prometheus text exposition.
+///
+/// Hot paths only ever touch a Histogram: observe() is a handful of relaxed
+/// atomic increments into power-of-two buckets, with no locks and no
+/// allocation. The families that name histograms take a mutex only when a
+/// histogram is added or when /metrics renders them, so a scrape never stalls
+/// the simulation or a request.
+
+namespace robot::src::detail::metrics::inline exports
+{
+/// @class Histogram
+/// @brief Thread-safe histogram of unsigned integer samples in power-of-two buckets.
+///
+/// Bucket i counts samples no larger than 2^(first_exponent + i); one more
+/// bucket catches everything above the largest bound. Samples are integers in
+/// the unit of the quantity (nanoseconds, bytes), converted only on exposition.
+class Histogram
+{
+public:
+    static constexpr std::size_t MAX_BUCKETS = 32; ///< Finite buckets a histogram can have
+
+private:
+    unsigned first_exponent_;
+    std::size_t buckets_;
+    std::array< std::atomic< std::uint64_t >, MAX_BUCKETS + 1 > counts_{};
+    std::atomic< std::uint64_t > count_{ 0 };
+    std::atomic< std::uint64_t > sum_{ 0 };
+
+public:
+    /// @brief Create an empty histogram.
+    /// @param first_exponent Exponent of the smallest bucket bound, 2^first_exponent.
+    /// @param buckets Number of finite buckets, at most MAX_BUCKETS.
+    Histogram( unsigned first_exponent, std::size_t buckets )
+        : first_exponent_( first_exponent )
+        , buckets_( std::min( buckets, MAX_BUCKETS ) )
+    {}
+
+    /// @brief Record one sample.
+    void observe( std::uint64_t value ) noexcept
+    {
+        // value <= 2^k exactly when bit_width( value - 1 ) <= k
+        auto width = value == 0 ? 0u : static_cast< unsigned >( std::bit_width( value - 1 ) );
+        auto bucket = width <= first_exponent_ ? 0 : std::min< std::size_t >( width - first_exponent_, buckets_ );
+        counts_[ bucket ].fetch_add( 1, std::memory_order_relaxed );
+        count_.fetch_add( 1, std::memory_order_relaxed );
+        sum_.fetch_add( value, std::memory_order_relaxed );
+    }
+
+    /// @brief Number of finite buckets.
+    std::size_t buckets() const noexcept
+    {
+        return buckets_;
+    }
+
+    /// @brief Upper bound of finite bucket i.
+    std::uint64_t bound( std::size_t i ) const noexcept
+    {
+        return std::uint64_t{ 1 } << ( first_exponent_ + i );
+    }
+
+    /// @brief Samples that fell into bucket i alone; bucket buckets() holds those above every bound.
+    std::uint64_t bucket_count( std::size_t i ) const noexcept
+    {
+        return counts_[ i ].load( std::memory_order_relaxed );
+    }
+
+    /// @brief Number of samples recorded.
+    std::uint64_t count() const noexcept
+    {
+        return count_.load( std::memory_order_relaxed );
+    }
+
+    /// @brief Sum of all samples recorded.
+    std::uint64_t sum() const noexcept
+    {
+        return sum_.load( std::memory_order_relaxed );
+    }
+};
+
+/// @brief Bucket layout for durations in nanoseconds: 1 us (2^10 ns) up to ~34 s.
+inline constexpr unsigned DURATION_FIRST_EXPONENT = 10;
+inline constexpr std::size_t DURATION_BUCKETS = 26;
+
+/// @brief Bucket layout for sizes in bytes: 64 B up to 64 MiB.
+inline constexpr unsigned SIZE_FIRST_EXPONENT = 6;
+inline constexpr std::size_t SIZE_BUCKETS = 21;
+
+/// @brief Bucket layout for small counts: 1 up to 4096.
+inline constexpr std::size_t COUNT_BUCKETS = 13;
+
+/// @class ScopedTimer
+/// @brief Records the lifetime of a scope, in nanoseconds, into a histogram.
+class ScopedTimer
+{
+private:
+    Histogram & histogram_;
+    std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+
+public:
+    explicit ScopedTimer( Histogram & histogram ) noexcept
+        : histogram_( histogram )
+    {}
+
+    ScopedTimer( const ScopedTimer & ) = delete;
+    ScopedTimer & operator=( const ScopedTimer & ) = delete;
+
+    ~ScopedTimer()
+    {
+        histogram_.observe( elapsedNanoseconds( start_ ) );
+    }
+
+    /// @brief Nanoseconds from start until now, never negative.
+    static std::uint64_t elapsedNanoseconds( std::chrono::steady_clock::time_point start ) noexcept
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast< std::uint64_t >(
+            std::max< std::int64_t >( 0, std::chrono::duration_cast< std::chrono::nanoseconds >( elapsed ).count() ) );
+    }
+};
+
+/// @class HistogramFamily
+/// @brief Histograms sharing a metric name, told apart by the value of one label.
+///
+/// Histograms live in a deque, so references returned by add() stay valid
+/// while others are added and can be observed without any lock.
+class HistogramFamily
+{
+private:
+    std::string name_;
+    std::string help_;
+    std::string label_;
+    double scale_;
+    unsigned first_exponent_;
+    std::size_t buckets_;
+    mutable std::mutex mutex_; ///< Guards the deque's structure, not the samples
+    std::deque< std::pair< std::string, Histogram > > members_;
+
+    static void appendNumber( std::string & out, double value )
+    {
+        std::array< char, 32 > text{};
+        auto written = std::snprintf( text.data(), text.size(), "%.9g", value );
+        out.append( text.data(), static_cast< std::size_t >( std::max( written, 0 ) ) );
+    }
+
+    void appendSeries( std::string & out, std::string_view suffix, const std::string & label_value,
+                       std::string_view le ) const
+    {
+        out += name_;
+        out += suffix;
+        if( !label_.empty() || !le.empty() )
+        {
+            out += '{';
+            if( !label_.empty() )
+            {
+                out += label_;
+                out += "=\"";
+                out += label_value;
+                out += '"';
+                if( !le.empty() )
+                    out += ',';
+            }
+            if( !le.empty() )
+            {
+                out += "le=\"";
+                out += le;
+                out += '"';
+            }
+            out += '}';
+        }
+        out += ' ';
+    }
+
+public:
+    /// @brief Create an empty family.
+    /// @param name Metric name, e.g. "robot_tick_seconds".
+    /// @param help One-line description for the # HELP comment.
+    /// @param label Name of the label telling members apart; empty for a family of one unlabelled histogram.
+    /// @param scale Factor converting samples to the exposed unit, e.g. 1e-9 for nanoseconds to seconds.
+    /// @param first_exponent Bucket layout of every member, see Histogram.
+    /// @param buckets Bucket layout of every member, see Histogram.
+    HistogramFamily( std::string name, std::string help, std::string label, double scale, unsigned first_exponent,
+                     std::size_t buckets )
+        : name_( std::move( name ) )
+        , help_( std::move( help ) )
+        , label_( std::move( label ) )
+        , scale_( scale )
+        , first_exponent_( first_exponent )
+        , buckets_( buckets )
+    {}
+
+    /// @brief The histogram for a label value, created on first use.
+    /// @return A reference that stays valid for the family's lifetime.
+    Histogram & add( std::string_view label_value = {} )
+    {
+        std::lock_guard< std::mutex > lock( mutex_ );
+        auto found = std::find_if( members_.begin(), members_.end(), [ & ]( const auto & member ) {
+            return member.first == label_value;
+        } );
+        if( found != members_.end() )
+        {
+            return found->second;
+        }
+        return members_
+            .emplace_back( std::piecewise_construct, std::forward_as_tuple( label_value ),
+                           std::forward_as_tuple( first_exponent_, buckets_ ) )
+            .second;
+    }
+
+    /// @brief Append the family in the Prometheus text exposition format.
+    void write_prometheus( std::string & out ) const
+    {
+        std::lock_guard< std::mutex > lock( mutex_ );
+        out += "# HELP " + name_ + ' ' + help_ + '\n';
+        out += "# TYPE " + name_ + " histogram\n";
+        std::string le;
+        for( const auto & [ label_value, histogram ] : members_ )
+        {
+            // Read the buckets first; a sample landing meanwhile only makes count a little larger
+            std::uint64_t cumulative = 0;
+            for( std::size_t i = 0; i < histogram.buckets(); ++i )
+            {
+                cumulative += histogram.bucket_count( i );
+                le.clear();
+                appendNumber( le, static_cast< double >( histogram.bound( i ) ) * scale_ );
+                appendSeries( out, "_bucket", label_value, le );
+                out += std::to_string( cumulative ) + '\n';
+            }
+            cumulative += histogram.bucket_count( histogram.buckets() );
+            auto count = std::max( cumulative, histogram.count() );
+            appendSeries( out, "_bucket", label_value, "+Inf" );
+            out += std::to_string( count ) + '\n';
+            appendSeries( out, "_sum", label_value, {} );
+            appendNumber( out, static_cast< double >( histogram.sum() ) * scale_ );
+            out += '\n';
+            appendSeries( out, "_count", label_value, {} );
+            out += std::to_string( count ) + '\n';
+        }
+    }
+};
+
+/// @class Metrics
+/// @brief Every histogram the robot exposes on /metrics.
+///
+/// Durations are observed in nanoseconds and exposed in seconds. The REST
+/// routes are fixed at construction, so looking one up never locks. When a
+/// server runs several worlds they share one Metrics: their samples land in
+/// the same histograms and their schedulers' counters are summed.
+class Metrics
+{
+private:
+    HistogramFamily tick_seconds_{ "robot_tick_seconds", "Duration of one simulation step, including publishing.",
+                                   "", 1e-9, DURATION_FIRST_EXPONENT, DURATION_BUCKETS };
+    HistogramFamily system_seconds_{ "robot_system_seconds", "Duration of one run of a simulation system.", "system",
+                                     1e-9, DURATION_FIRST_EXPONENT, DURATION_BUCKETS };
+    HistogramFamily input_batch_{ "robot_input_batch_commands", "Input commands drained by one tick.", "", 1.0, 0,
+                                  COUNT_BUCKETS };
+    HistogramFamily request_seconds_{ "robot_http_request_seconds",
+                                      "Time from reading a request to finishing its response.", "route", 1e-9,
+                                      DURATION_FIRST_EXPONENT, DURATION_BUCKETS };
+    HistogramFamily response_bytes_{ "robot_http_response_bytes", "Size of HTTP responses written, with headers.",
+                                     "route", 1.0, SIZE_FIRST_EXPONENT, SIZE_BUCKETS };
+    std::vector< const TickStats * > tick_stats_;
+
+public:
+    /// @brief Histograms of one REST route.
+    struct Route
+    {
+        std::string_view name; ///< Route label, e.g. "/output"
+        Histogram & seconds; ///< Request latency
+        Histogram & bytes; ///< Response size
+    };
+
+    /// @brief Routes the REST server distinguishes; anything else is counted as "other".
+    static constexpr std::array< std::string_view, 5 > ROUTES{ "/input", "/output", "/client", "/metrics", "other" };
+
+private:
+    std::deque< Route > routes_;
+
+public:
+    Histogram & tick; ///< Whole simulation step
+    Histogram & input_batch; ///< Input commands drained per step
+    std::atomic< std::uint64_t > inputs_rejected{ 0 }; ///< Input commands dropped because the queue was full
+
+    /// @param tick_stats Scheduler counters to expose alongside the histograms, if any.
+    explicit Metrics( const TickStats * tick_stats = nullptr )
+        : Metrics( tick_stats ? std::vector{ tick_stats } : std::vector< const TickStats * >{} )
+    {}
+
+    /// @param tick_stats Counters of every scheduler stepping a world, exposed as their sums.
+    explicit Metrics( std::vector< const TickStats * > tick_stats )
+        : tick_stats_( std::move( tick_stats ) )
+        , tick( tick_seconds_.add() )
+        , input_batch( input_batch_.add() )
+    {
+        for( auto name : ROUTES )
+        {
+            routes_.push_back( Route{ name, request_seconds_.add( name ), response_bytes_.add( name ) } );
+        }
+    }
+
+    Metrics( const Metrics & ) = delete;
+    Metrics & operator=( const Metrics & ) = delete;
+
+    /// @brief Histogram for a simulation system, created on first use.
+    Histogram & system( std::string_view name )
+    {
+        return system_seconds_.add( name );
+    }
+
+    /// @brief Histograms of a REST route.
+    /// @param path Request path without its query; paths not in ROUTES map to "other".
+    Route & route( std::string_view path )
+    {
+        auto found = std::find_if( routes_.begin(), routes_.end() - 1, [ & ]( const Route & route ) {
+            return route.name == path;
+        } );
+        return *found;
+    }
+
+    /// @brief Render every metric in the Prometheus text exposition format (version 0.0.4).
+    void write_prometheus( std::string & out ) const
+    {
+        tick_seconds_.write_prometheus( out );
+        system_seconds_.write_prometheus( out );
+        input_batch_.write_prometheus( out );
+        request_seconds_.write_prometheus( out );
+        response_bytes_.write_prometheus( out );
+        auto counter = [ &out ]( std::string_view name, std::string_view help, std::uint64_t value ) {
+            out += "# HELP " + std::string( name ) + ' ' + std::string( help ) + '\n';
+            out += "# TYPE " + std::string( name ) + " counter\n";
+            out += std::string( name ) + ' ' + std::to_string( value ) + '\n';
+        };
+        counter( "robot_inputs_rejected_total", "Input commands dropped because the input queue was full.",
+                 inputs_rejected.load( std::memory_order_relaxed ) );
+        if( !tick_stats_.empty() )
+        {
+            auto total = [ this ]( auto member ) {
+                std::uint64_t sum = 0;
+                for( const auto * stats : tick_stats_ )
+                {
+                    sum += ( stats->*member ).load();
+                }
+                return sum;
+            };
+            counter( "robot_ticks_total", "Fixed simulation steps executed.", total( &TickStats::ticks ) );
+            counter( "robot_tick_overruns_total", "Wake-ups whose work ran past the next deadline.",
+                     total( &TickStats::overruns ) );
+            counter( "robot_tick_dropped_steps_total", "Steps discarded by the catch-up limit.",
+                     total( &TickStats::dropped_steps ) );
+        }
+    }
+};
+} // namespace robot::src::detail::metrics::inline exports
+
+namespace robot::src::inline exports::inline metrics
+{
+using namespace detail::metrics::exports;
+}
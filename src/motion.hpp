@@ -0,0 +1,135 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#include "math.hpp"
+
+/// @file motion.hpp
+/// @brief Branch-free coordinate wrapping and a SIMD kernel for integrating positions.
+///
+/// The kernel works on dense arrays of Vec2-derived components, which are laid
+/// out as interleaved x,y floats. It treats them as one flat float array, so a
+/// SIMD register holds alternating x and y lanes and is paired with registers of
+/// alternating per-axis bounds. Wrapping is done with lane masks instead of
+/// branches, so a batch costs the same whichever of its lanes crossed an edge.
+/// Where the standard library has no std::experimental::simd (see
+/// ROBOT_HAS_STD_SIMD in math.hpp) every float takes the scalar path instead.
+
+namespace robot::src::detail::motion
+{
+/// @brief Flat float view of a dense array of Vec2-derived values.
+template < typename V >
+auto * lanes( V * values ) noexcept
+{
+    static_assert( std::is_base_of_v< Vec2, std::remove_const_t< V > > && sizeof( V ) == sizeof( Vec2 ),
+                   "integration needs components that are exactly a Vec2" );
+    static_assert( sizeof( Vec2 ) == 2 * sizeof( Float ), "Vec2 must be two packed floats" );
+    return &values->x;
+}
+
+#if ROBOT_HAS_STD_SIMD
+namespace stdx = std::experimental;
+
+/// @brief Lane-wise floor using only adds and compares.
+///
+/// stdx::floor falls back to a slow per-lane path on targets without a SIMD
+/// rounding instruction (baseline x86-64). Adding and subtracting 2^23 rounds
+/// any float of smaller magnitude to an integer in the default rounding mode;
+/// larger floats are integers already and are passed through.
+template < typename Batch >
+inline Batch floorLanes( Batch t ) noexcept
+{
+    constexpr Float integral = 8388608.0f; // 2^23, the smallest float with no fractional bits
+    Batch rounded = ( t + integral ) - integral;
+    stdx::where( t < 0.0f, rounded ) = ( t - integral ) + integral;
+    stdx::where( rounded > t, rounded ) -= 1.0f;
+    stdx::where( !( stdx::abs( t ) < integral ), rounded ) = t;
+    return rounded;
+}
+#endif
+} // namespace robot::src::detail::motion
+
+namespace robot::src::detail::motion::inline exports
+{
+/// @brief Wrap a value periodically into [min, min + range).
+///
+/// Unlike repeated add/subtract loops this takes the same time for any input and
+/// handles values any number of periods away.
+///
+/// @param value Value to wrap.
+/// @param min Lower bound of the interval (inclusive).
+/// @param range Length of the interval; must be positive.
+/// @return The value shifted by a whole number of periods into the interval.
+inline Float wrapPeriodic( Float value, Float min, Float range ) noexcept
+{
+    Float wrapped = value - range * std::floor( ( value - min ) / range );
+    // Rounding can land a value just below min exactly on the upper bound
+    return wrapped >= min + range ? wrapped - range : wrapped;
+}
+
+/// @brief Add velocities to positions and wrap the results into a periodic world.
+///
+/// positions[i] += velocities[i] for every i, then each coordinate is wrapped
+/// into [world.min, world.max). Positions that are already inside the world
+/// and have zero velocity come out bit-for-bit unchanged.
+///
+/// @param positions Dense positions to update, e.g. the front of Component<Position>::dense_data().
+/// @param velocities Velocities paired index-by-index with positions.
+/// @param world Wrapping bounds; both extents must be positive.
+///
+/// @note Time complexity: O(n), processed stdx::native_simd<float>::size() floats at a time where
+///       ROBOT_HAS_STD_SIMD, one at a time otherwise
+template < typename P, typename V >
+void integrateWrapped( std::span< P > positions, std::span< const V > velocities, const AxisAlignedBoundingBox & world )
+{
+    assert( positions.size() == velocities.size() );
+    assert( world.max.x > world.min.x && world.max.y > world.min.y );
+
+    Float * position = lanes( positions.data() );
+    const Float * velocity = lanes( velocities.data() );
+    std::size_t count = positions.size() * 2;
+    Vec2 size = world.max - world.min;
+
+    std::size_t i = 0;
+#if ROBOT_HAS_STD_SIMD
+    using Batch = stdx::native_simd< Float >;
+    static_assert( Batch::size() % 2 == 0, "batches must hold whole x,y pairs" );
+
+    const Batch min( [ & ]( auto lane ) { return lane % 2 == 0 ? world.min.x : world.min.y; } );
+    const Batch range( [ & ]( auto lane ) { return lane % 2 == 0 ? size.x : size.y; } );
+    const Batch max = min + range;
+
+    for( ; i + Batch::size() <= count; i += Batch::size() )
+    {
+        Batch p( position + i, stdx::element_aligned );
+        p += Batch( velocity + i, stdx::element_aligned );
+        // One period covers every step slower than the world is wide; only
+        // batches with a lane still outside take the general floor() path.
+        stdx::where( p < min, p ) += range;
+        stdx::where( p >= max, p ) -= range;
+        if( stdx::any_of( p < min || p >= max ) ) [[unlikely]]
+        {
+            p -= range * floorLanes( ( p - min ) / range );
+            stdx::where( p >= max, p ) -= range;
+        }
+        p.copy_to( position + i, stdx::element_aligned );
+    }
+#endif
+    for( ; i < count; ++i )
+    {
+        bool is_x = i % 2 == 0;
+        position[ i ] = wrapPeriodic( position[ i ] + velocity[ i ], is_x ? world.min.x : world.min.y,
+                                      is_x ? size.x : size.y );
+    }
+}
+} // namespace robot::src::detail::motion::inline exports
+
+namespace robot::src::inline exports::inline motion
+{
+using namespace detail::motion::exports;
+}
@@ -0,0 +1,170 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/// @file mpsc_queue.hpp
+/// @brief Bounded lock-free queue for many producers and a single consumer.
+///
+/// The ring of cells follows Dmitry Vyukov's bounded queue: each cell carries a
+/// sequence number telling producers whether it is free for the position they
+/// claimed and the consumer whether it has been filled. Producers claim
+/// positions with one compare-and-swap on a shared counter; the single
+/// consumer needs no atomic read-modify-write at all. Nothing allocates after
+/// construction, and a full queue rejects pushes instead of blocking.
+
+namespace robot::src::detail::mpsc_queue::inline exports
+{
+/// @class MpscQueue
+/// @brief Fixed-capacity FIFO that any number of threads may push to and one thread pops from.
+///
+/// @par Example usage:
+/// @code
+/// MpscQueue< int > queue( 1024 );
+/// queue.try_push( 42 );                              // any thread
+/// queue.drain( []( int value ) { use( value ); } ); // the consumer thread only
+/// @endcode
+///
+/// @tparam T Element type; must be default constructible and move assignable.
+template < typename T >
+class MpscQueue
+{
+private:
+    struct Cell
+    {
+        std::atomic< std::size_t > sequence;
+        T value;
+    };
+
+    // Producers and the consumer write different counters; keep them on separate cache lines
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    std::unique_ptr< Cell[] > cells_;
+    std::size_t mask_;
+    alignas( CACHE_LINE ) std::atomic< std::size_t > enqueue_position_{ 0 };
+    alignas( CACHE_LINE ) std::size_t dequeue_position_ = 0; ///< Touched by the consumer only
+    std::atomic< std::uint64_t > rejected_{ 0 };
+
+public:
+    /// @brief Create an empty queue.
+    /// @param capacity Most elements the queue holds at once, rounded up to a power of two.
+    explicit MpscQueue( std::size_t capacity )
+        : cells_( std::make_unique< Cell[] >( std::bit_ceil( std::max< std::size_t >( capacity, 2 ) ) ) )
+        , mask_( std::bit_ceil( std::max< std::size_t >( capacity, 2 ) ) - 1 )
+    {
+        for( std::size_t i = 0; i <= mask_; ++i )
+        {
+            cells_[ i ].sequence.store( i, std::memory_order_relaxed );
+        }
+    }
+
+    MpscQueue( const MpscQueue & ) = delete;
+    MpscQueue & operator=( const MpscQueue & ) = delete;
+
+    /// @brief Number of elements the queue can hold.
+    std::size_t capacity() const noexcept
+    {
+        return mask_ + 1;
+    }
+
+    /// @brief Append an element. Safe to call from any thread; never blocks.
+    /// @return False, leaving the queue unchanged, if it was full.
+    bool try_push( T value )
+    {
+        auto position = enqueue_position_.load( std::memory_order_relaxed );
+        Cell * cell;
+        while( true )
+        {
+            cell = &cells_[ position & mask_ ];
+            auto sequence = cell->sequence.load( std::memory_order_acquire );
+            auto difference = static_cast< std::intptr_t >( sequence ) - static_cast< std::intptr_t >( position );
+            if( difference == 0 )
+            {
+                // The cell is free for this position; try to claim it
+                if( enqueue_position_.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+                    break;
+            }
+            else if( difference < 0 )
+            {
+                // The consumer has not yet freed the cell a full lap ago
+                rejected_.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+            else
+            {
+                // Another producer claimed this position first
+                position = enqueue_position_.load( std::memory_order_relaxed );
+            }
+        }
+        cell->value = std::move( value );
+        cell->sequence.store( position + 1, std::memory_order_release );
+        return true;
+    }
+
+    /// @brief Remove the oldest element. Consumer thread only.
+    /// @return False if the queue was empty, or the oldest push has claimed its cell but not finished writing.
+    bool try_pop( T & out )
+    {
+        auto & cell = cells_[ dequeue_position_ & mask_ ];
+        if( cell.sequence.load( std::memory_order_acquire ) != dequeue_position_ + 1 )
+        {
+            return false;
+        }
+        out = std::move( cell.value );
+        cell.sequence.store( dequeue_position_ + mask_ + 1, std::memory_order_release );
+        ++dequeue_position_;
+        return true;
+    }
+
+    /// @brief Pop what is available and pass each element to a callable, oldest first. Consumer thread only.
+    ///
+    /// At most capacity() elements are popped, so producers that keep pushing
+    /// cannot hold the consumer here indefinitely.
+    ///
+    /// @return Number of elements popped.
+    template < typename F >
+    std::size_t drain( F && consume )
+    {
+        std::size_t popped = 0;
+        T value{};
+        while( popped <= mask_ && try_pop( value ) )
+        {
+            consume( std::move( value ) );
+            ++popped;
+        }
+        return popped;
+    }
+
+    /// @brief Positions claimed so far: every push that succeeded, and any still writing its element.
+    ///
+    /// Elements leave in the order their positions were claimed, so once popped()
+    /// reaches a value read here after a push returned, that push has been consumed.
+    std::uint64_t pushed() const noexcept
+    {
+        return enqueue_position_.load( std::memory_order_acquire );
+    }
+
+    /// @brief Elements popped so far. Consumer thread only.
+    std::uint64_t popped() const noexcept
+    {
+        return dequeue_position_;
+    }
+
+    /// @brief Pushes rejected because the queue was full.
+    std::uint64_t rejected() const noexcept
+    {
+        return rejected_.load( std::memory_order_relaxed );
+    }
+};
+} // namespace robot::src::detail::mpsc_queue::inline exports
+
+namespace robot::src::inline exports::inline mpsc_queue
+{
+using namespace detail::mpsc_queue::exports;
+}
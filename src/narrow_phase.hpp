@@ -0,0 +1,213 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <utility>
+
+#include "math.hpp"
+
+/// @file narrow_phase.hpp
+/// @brief Allocation-free separating axis test for convex polygons in SoA layout.
+///
+/// The narrow phase works on non-owning views of structure-of-arrays vertex data
+/// (separate x and y arrays) with optional precomputed edge normals. Projections
+/// onto an axis are computed several vertices at a time with std::experimental::simd
+/// where the standard library provides it, and the test returns on the first
+/// separating axis it finds. Nothing here allocates or copies vertex data.
+///
+/// The swept form finds when two translating polygons first touch. Translation
+/// leaves the edge normals unchanged, so on each axis the times at which the
+/// projections overlap form one interval, and the polygons touch exactly at the
+/// times every axis's interval shares. The projections are the same ones the
+/// static test uses, so a swept test costs about as much as a static one.
+
+namespace robot::src::detail::narrow_phase::inline exports
+{
+/// @brief Non-owning view of a convex polygon stored as SoA arrays.
+///
+/// Normals are the unnormalized outward-or-inward perpendiculars of each edge
+/// (edge i runs from vertex i to vertex i + 1). When normals_x / normals_y are
+/// null the normals are derived from the vertices on the fly.
+struct ConvexView
+{
+    const Float * vertices_x = nullptr; ///< X-coordinates of the vertices
+    const Float * vertices_y = nullptr; ///< Y-coordinates of the vertices
+    const Float * normals_x = nullptr; ///< X-components of the edge normals, or null
+    const Float * normals_y = nullptr; ///< Y-components of the edge normals, or null
+    std::size_t count = 0; ///< Number of vertices (and edges)
+
+    /// @brief Get the normal of edge i, from the cache when available.
+    /// @param i Edge index in [0, count).
+    /// @return Unnormalized normal vector of the edge.
+    Vec2 edge_normal( std::size_t i ) const
+    {
+        if( normals_x != nullptr )
+        {
+            return { normals_x[ i ], normals_y[ i ] };
+        }
+        std::size_t next = i + 1 == count ? 0 : i + 1;
+        return { -( vertices_y[ next ] - vertices_y[ i ] ), vertices_x[ next ] - vertices_x[ i ] };
+    }
+};
+
+/// @brief Project SoA vertices onto an axis and return the (min, max) extents.
+///
+/// @param xs X-coordinates of the vertices.
+/// @param ys Y-coordinates of the vertices.
+/// @param count Number of vertices.
+/// @param axis Axis to project onto (need not be normalized).
+/// @return Pair (min, max) of the projections; (+inf, -inf) when count is zero.
+inline std::pair< Float, Float > projectExtents( const Float * xs, const Float * ys, std::size_t count, Vec2 axis )
+{
+    Float lo = std::numeric_limits< Float >::infinity();
+    Float hi = -std::numeric_limits< Float >::infinity();
+    std::size_t i = 0;
+#if ROBOT_HAS_STD_SIMD
+    namespace stdx = std::experimental;
+    using Batch = stdx::native_simd< Float >;
+    constexpr std::size_t width = Batch::size();
+    if( count >= width )
+    {
+        Batch batch_lo( lo );
+        Batch batch_hi( hi );
+        for( ; i + width <= count; i += width )
+        {
+            Batch x( xs + i, stdx::element_aligned );
+            Batch y( ys + i, stdx::element_aligned );
+            Batch projection = x * axis.x + y * axis.y;
+            batch_lo = stdx::min( batch_lo, projection );
+            batch_hi = stdx::max( batch_hi, projection );
+        }
+        lo = stdx::hmin( batch_lo );
+        hi = stdx::hmax( batch_hi );
+    }
+#endif
+    for( ; i < count; ++i )
+    {
+        Float projection = axis.x * xs[ i ] + axis.y * ys[ i ];
+        lo = std::min( lo, projection );
+        hi = std::max( hi, projection );
+    }
+    return { lo, hi };
+}
+
+/// @brief Test whether any edge normal of `axes` separates polygons a and b.
+///
+/// @param axes Polygon whose edge normals are used as candidate axes.
+/// @param a First polygon, in its own local frame.
+/// @param b Second polygon, whose vertices are translated by offset.
+/// @param offset Translation of b's vertices relative to a's frame.
+/// @return True as soon as a separating axis is found; false if none exists.
+inline bool hasSeparatingAxis( const ConvexView & axes, const ConvexView & a, const ConvexView & b, Vec2 offset )
+{
+    for( std::size_t i = 0; i < axes.count; ++i )
+    {
+        Vec2 normal = axes.edge_normal( i );
+        auto [ min_a, max_a ] = projectExtents( a.vertices_x, a.vertices_y, a.count, normal );
+        auto [ min_b, max_b ] = projectExtents( b.vertices_x, b.vertices_y, b.count, normal );
+        Float shift = dot( normal, offset );
+        if( max_a < min_b + shift or max_b + shift < min_a )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief Narrow [enter, exit] to the times at which no edge normal of `axes` separates a and b.
+///
+/// @param axes Polygon whose edge normals are used as candidate axes.
+/// @param a First polygon, in its own local frame.
+/// @param b Second polygon, translated by offset + t * motion at time t.
+/// @param offset Translation of b's vertices relative to a's frame at time 0.
+/// @param motion Displacement of b relative to a between time 0 and time 1.
+/// @param enter Earliest time still possible; raised to the latest time an axis starts overlapping.
+/// @param exit Latest time still possible; lowered to the earliest time an axis stops overlapping.
+/// @return False as soon as the interval is empty, i.e. some axis separates the polygons throughout.
+inline bool narrowOverlapInterval( const ConvexView & axes, const ConvexView & a, const ConvexView & b, Vec2 offset,
+                                   Vec2 motion, Float & enter, Float & exit )
+{
+    for( std::size_t i = 0; i < axes.count; ++i )
+    {
+        Vec2 normal = axes.edge_normal( i );
+        auto [ min_a, max_a ] = projectExtents( a.vertices_x, a.vertices_y, a.count, normal );
+        auto [ min_b, max_b ] = projectExtents( b.vertices_x, b.vertices_y, b.count, normal );
+        // The projections overlap while the shift of b stays within [lo, hi]
+        Float lo = min_a - max_b;
+        Float hi = max_a - min_b;
+        Float shift = dot( normal, offset );
+        Float speed = dot( normal, motion );
+        if( speed == 0.0f )
+        {
+            if( shift < lo or hi < shift )
+            {
+                return false;
+            }
+            continue;
+        }
+        Float first = ( lo - shift ) / speed;
+        Float last = ( hi - shift ) / speed;
+        if( first > last )
+        {
+            std::swap( first, last );
+        }
+        enter = std::max( enter, first );
+        exit = std::min( exit, last );
+        if( enter > exit )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Separating axis test between two convex polygons.
+///
+/// @param a First polygon, in its own local frame.
+/// @param b Second polygon, whose vertices are translated by offset.
+/// @param offset Translation of b's vertices relative to a's frame.
+/// @return True when the polygons overlap (touching counts as overlapping).
+inline bool satIntersects( const ConvexView & a, const ConvexView & b, Vec2 offset = {} )
+{
+    if( a.count == 0 || b.count == 0 )
+    {
+        return false;
+    }
+    return !hasSeparatingAxis( a, a, b, offset ) && !hasSeparatingAxis( b, a, b, offset );
+}
+
+/// @brief Time of first contact between two convex polygons moving at constant velocities.
+///
+/// Overlap at time 0 gives exactly the answer of satIntersects( a, b, offset ),
+/// so the static test is the special case of no motion.
+///
+/// @param a First polygon, in its own local frame.
+/// @param b Second polygon, whose vertices are translated by offset at time 0.
+/// @param offset Translation of b's vertices relative to a's frame at time 0.
+/// @param motion Displacement of b relative to a over the step, i.e. b's velocity minus a's.
+/// @return Fraction of the step in [0, 1] at which the polygons first touch, 0 if they
+///         already overlap, or nothing if they stay apart for the whole step.
+inline std::optional< Float > sweptTimeOfImpact( const ConvexView & a, const ConvexView & b, Vec2 offset, Vec2 motion )
+{
+    if( a.count == 0 || b.count == 0 )
+    {
+        return std::nullopt;
+    }
+    Float enter = 0.0f;
+    Float exit = 1.0f;
+    if( !narrowOverlapInterval( a, a, b, offset, motion, enter, exit )
+        || !narrowOverlapInterval( b, a, b, offset, motion, enter, exit ) )
+    {
+        return std::nullopt;
+    }
+    return enter;
+}
+} // namespace robot::src::detail::narrow_phase::inline exports
+
+namespace robot::src::inline exports::inline narrow_phase
+{
+using namespace detail::narrow_phase::exports;
+}
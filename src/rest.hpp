@@ -1,16 +1,38 @@
 static_assert( __cplusplus > 2020'00 );
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/json.hpp>
-#include <iostream>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <tuple>
 #include <unordered_set>
+#include <vector>
 
 #include "component_types.hpp"
+#include "input_queue.hpp"
+#include "logging.hpp"
+#include "metrics.hpp"
+#include "scene_codec.hpp"
+#include "scene_interest.hpp"
+#include "scene_packet.hpp"
+#include "scene_snapshot.hpp"
+#include "static_asset.hpp"
 
 namespace robot::src::detail::rest::inline exports
 {
@@ -20,22 +42,473 @@ namespace websocket = beast::websocket;
 namespace net = boost::asio;
 using tcp = net::ip::tcp;
 
+/// @brief Find a query parameter in a request target.
+/// @param target Request target such as "/output?since=42".
+/// @param name Parameter name to look for.
+/// @return The raw (undecoded) value, or an empty optional if the parameter is absent.
+inline std::optional< std::string_view > queryParameter( std::string_view target, std::string_view name )
+{
+    auto query_pos = target.find( '?' );
+    if( query_pos == std::string_view::npos )
+    {
+        return std::nullopt;
+    }
+    auto query = target.substr( query_pos + 1 );
+    while( !query.empty() )
+    {
+        auto param = query.substr( 0, query.find( '&' ) );
+        query.remove_prefix( std::min( query.size(), param.size() + 1 ) );
+        auto eq = param.find( '=' );
+        if( param.substr( 0, eq ) == name )
+        {
+            return eq == std::string_view::npos ? std::string_view{} : param.substr( eq + 1 );
+        }
+    }
+    return std::nullopt;
+}
+
+/// @brief A request path split into the world it addresses and the path within that world.
+struct WorldPath
+{
+    std::size_t world = 0; ///< Index of the world; paths without a /worlds/<id> prefix address world 0
+    std::string_view path; ///< Path within the world, e.g. "/output"; empty for "/worlds/<id>" itself
+    bool prefixed = false; ///< Whether the path named its world
+};
+
+/// @brief Split "/worlds/<id>/rest" into world id and "/rest"; other paths address world 0.
+/// @param path Request path without its query.
+/// @return The world and the rest of the path, or an empty optional if the id is not a number in
+///         canonical form (no sign, no leading zeros, no overflow), so each world has exactly one prefix.
+inline std::optional< WorldPath > splitWorldPath( std::string_view path )
+{
+    constexpr std::string_view prefix = "/worlds/";
+    if( !path.starts_with( prefix ) )
+    {
+        return WorldPath{ 0, path, false };
+    }
+    auto id = path.substr( prefix.size() );
+    auto rest = id.find( '/' );
+    auto digits = id.substr( 0, rest );
+    WorldPath route{ 0, rest == std::string_view::npos ? std::string_view{} : id.substr( rest ), true };
+    auto [ end, ec ] = std::from_chars( digits.data(), digits.data() + digits.size(), route.world );
+    if( digits.empty() || ec != std::errc{} || end != digits.data() + digits.size()
+        || ( digits.size() > 1 && digits.front() == '0' ) )
+    {
+        return std::nullopt;
+    }
+    return route;
+}
+
+/// @brief Split a request path with splitWorldPath() and check that its world exists.
+/// @param path Request path without its query.
+/// @param world_count Number of worlds the server routes to.
+/// @return The world and the rest of the path, or an empty optional, answered with 404, if the id is
+///         malformed or names no world; a bad prefix never falls back to world 0.
+inline std::optional< WorldPath > routeWorldPath( std::string_view path, std::size_t world_count )
+{
+    auto world_path = splitWorldPath( path );
+    if( !world_path || world_path->world >= world_count )
+    {
+        return std::nullopt;
+    }
+    return world_path;
+}
+
+/// @brief Parse a {"x":..,"y":..} input message.
+/// @param body JSON text; fields other than x and y (such as IDs) are ignored.
+/// @return The requested player input.
+/// @throw std::exception if the body is not valid JSON or lacks x or y.
+inline PlayerInput parsePlayerInput( const boost::json::object & obj )
+{
+    // Only extract x and y - ignore any other fields like IDs
+    float x = boost::json::value_to< float >( obj.at( "x" ) );
+    float y = boost::json::value_to< float >( obj.at( "y" ) );
+    return PlayerInput( x, y );
+}
+
+/// @copydoc parsePlayerInput(const boost::json::object &)
+inline PlayerInput parsePlayerInput( std::string_view body )
+{
+    auto jv = boost::json::parse( body );
+    return parsePlayerInput( jv.as_object() );
+}
+
+/// @brief Read a view coordinate or margin of a stream message as a Float.
+/// @throw std::exception if the value is not a number, or is beyond the range of Float.
+inline Float parseViewNumber( const boost::json::value & value )
+{
+    // Narrowing a double outside float's range is undefined, so check before converting
+    auto number = boost::json::value_to< double >( value );
+    if( !( std::abs( number ) <= static_cast< double >( std::numeric_limits< Float >::max() ) ) )
+    {
+        throw std::invalid_argument( "view numbers must be finite floats" );
+    }
+    return static_cast< Float >( number );
+}
+
+/// @brief Parse the "view" member of a {"view":[min_x,min_y,max_x,max_y]} stream message.
+/// @param view The member's value; null asks for the whole world again.
+/// @return The viewport, or an empty optional for null.
+/// @throw std::exception if the value is neither null nor four finite numbers describing a box.
+inline std::optional< AxisAlignedBoundingBox > parseViewJson( const boost::json::value & view )
+{
+    if( view.is_null() )
+    {
+        return std::nullopt;
+    }
+    const auto & values = view.as_array();
+    if( values.size() != 4 )
+    {
+        throw std::invalid_argument( "view must be [min_x,min_y,max_x,max_y]" );
+    }
+    AxisAlignedBoundingBox box{ { parseViewNumber( values.at( 0 ) ), parseViewNumber( values.at( 1 ) ) },
+                                { parseViewNumber( values.at( 2 ) ), parseViewNumber( values.at( 3 ) ) } };
+    if( !isValidViewport( box ) )
+    {
+        throw std::invalid_argument( "view must be finite and not inverted" );
+    }
+    return box;
+}
+
+/// @brief Read the optional `margin` query parameter of a culled request.
+/// @return The margin in world units, DEFAULT_VIEW_MARGIN if absent, or an empty optional
+///         if it is malformed, not finite or negative.
+inline std::optional< Float > viewMargin( std::string_view target )
+{
+    auto param = queryParameter( target, "margin" );
+    if( !param )
+    {
+        return DEFAULT_VIEW_MARGIN;
+    }
+    Float margin = 0.0f;
+    auto [ end, ec ] = std::from_chars( param->data(), param->data() + param->size(), margin );
+    if( ec != std::errc{} || end != param->data() + param->size() || !isValidViewMargin( margin ) )
+    {
+        return std::nullopt;
+    }
+    return margin;
+}
+
+/// @brief Queue a player input for the robot (entity 0); the next tick applies it.
+/// @param queue Queue the simulation drains.
+/// @param input Input to apply.
+/// @param metrics Metrics counting inputs dropped because the queue was full.
+/// @return False if the input was dropped.
+inline bool submitPlayerInput( InputQueue & queue, PlayerInput input, Metrics & metrics )
+{
+    if( queue.try_push( InputCommand{ 0, input } ) )
+    {
+        return true;
+    }
+    metrics.inputs_rejected.fetch_add( 1, std::memory_order_relaxed );
+    return false;
+}
+
+/// @brief Pick the scene encoding a request asks for.
+///
+/// `?format=binary` or `?format=json` in the target wins; otherwise an Accept
+/// header naming application/octet-stream selects binary. JSON is the default.
+///
+/// @param target Request target.
+/// @param accept Value of the Accept header, possibly empty.
+/// @return The negotiated format.
+inline SceneFormat negotiateSceneFormat( std::string_view target, std::string_view accept )
+{
+    if( auto format = queryParameter( target, "format" ) )
+    {
+        return *format == "binary" ? SceneFormat::binary : SceneFormat::json;
+    }
+    return accept.find( "application/octet-stream" ) != std::string_view::npos ? SceneFormat::binary
+                                                                               : SceneFormat::json;
+}
+
+/// @brief Default number of threads to run the REST io_context on.
+/// @return One less than the hardware concurrency, leaving a core for the simulation; at least 1.
+inline unsigned int defaultRestThreadCount()
+{
+    auto hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 1;
+}
+
+class StreamSession;
+class StreamHub;
+
+/// @brief What the REST server needs of one world: where its input goes and where its scenes come from.
+///
+/// Every world has its own queue, snapshots and subscribers, so requests to
+/// different worlds never contend on anything but the io_context.
+struct WorldEndpoint
+{
+    InputQueue & inputs; ///< Queue the world's simulation drains
+    const SnapshotBuffer & snapshots; ///< Scenes the world's loop publishes
+    StreamHub & stream_hub; ///< WebSocket viewers of the world
+};
+
+/// @brief Registry of WebSocket subscribers that are told about new snapshots.
+///
+/// The simulation thread calls broadcast() after each publish; every live
+/// subscriber is then notified on its own executor. Closed sessions are pruned
+/// lazily during broadcasts.
+class StreamHub
+{
+private:
+    std::mutex mutex_;
+    std::vector< std::weak_ptr< StreamSession > > subscribers_;
+
+public:
+    /// @brief Register a session to be notified of every published snapshot.
+    void subscribe( std::weak_ptr< StreamSession > session )
+    {
+        std::lock_guard< std::mutex > lock( mutex_ );
+        subscribers_.push_back( std::move( session ) );
+    }
+
+    /// @brief Number of subscribers registered, including ones not yet pruned.
+    std::size_t size()
+    {
+        std::lock_guard< std::mutex > lock( mutex_ );
+        return subscribers_.size();
+    }
+
+    /// @brief Notify every live subscriber that a new snapshot is available.
+    void broadcast();
+};
+
+/// @brief WebSocket session on /stream that pushes published ticks to one viewer.
+///
+/// The first frame is a keyframe; every later frame is a delta from the last tick
+/// sent (see ScenePacket), so a dropped frame costs nothing but latency.
+/// At most one write is in flight per client; if further snapshots are published
+/// while it is outstanding, only the newest one is sent once the write finishes
+/// and the ones in between are dropped, so a slow client never builds a queue.
+/// Text frames received from the client are parsed as PlayerInput messages,
+/// except {"view":[min_x,min_y,max_x,max_y],"margin":m} which culls the frames
+/// to that viewport from then on ({"view":null} sends the whole world again).
+/// A viewport may also be given in the handshake, as `/stream?view=...`.
+class StreamSession : public std::enable_shared_from_this< StreamSession >
+{
+private:
+    websocket::stream< beast::tcp_stream > ws_;
+    beast::flat_buffer read_buffer_;
+    std::string write_buffer_;
+    InputQueue & inputs_;
+    const SnapshotBuffer & snapshots_;
+    StreamHub & hub_;
+    Metrics & metrics_;
+    std::uint64_t last_sent_tick_ = 0;
+    SceneFormat format_ = SceneFormat::json;
+    std::optional< AxisAlignedBoundingBox > view_; ///< Viewport with margin, if the viewer culls
+    SceneInterest interest_; ///< What the viewer holds while it culls
+    bool writing_ = false;
+    bool pending_ = false;
+    std::atomic< bool > closed_{ false }; ///< Read by StreamHub::broadcast() from the simulation thread
+
+public:
+    StreamSession(
+        tcp::socket socket,
+        InputQueue & inputs,
+        const SnapshotBuffer & snapshots,
+        StreamHub & hub,
+        Metrics & metrics )
+        : ws_( std::move( socket ) )
+        , inputs_( inputs )
+        , snapshots_( snapshots )
+        , hub_( hub )
+        , metrics_( metrics )
+    {}
+
+    /// @brief Complete the WebSocket handshake for an upgrade request.
+    /// @param req The HTTP upgrade request read by the REST session.
+    void run( http::request< http::string_body > req )
+    {
+        auto accept = req[ http::field::accept ];
+        auto target = std::string_view( req.target() );
+        format_ = negotiateSceneFormat( target, std::string_view( accept.data(), accept.size() ) );
+        if( auto view = queryParameter( target, "view" ) )
+        {
+            auto box = parseViewport( *view );
+            auto margin = viewMargin( target );
+            if( box && margin )
+            {
+                view_ = expandBox( *box, *margin );
+            }
+        }
+        beast::get_lowest_layer( ws_ ).expires_never();
+        ws_.set_option( websocket::stream_base::timeout::suggested( beast::role_type::server ) );
+        auto self = shared_from_this();
+        ws_.async_accept( req, [ self ]( beast::error_code ec ) {
+            if( ec )
+            {
+                defaultLogger().warning( "Stream accept error: ", ec.message() );
+                return;
+            }
+            self->hub_.subscribe( self );
+            self->do_read();
+            self->notify();
+        } );
+    }
+
+    /// @brief Executor on which notify() must be invoked.
+    auto get_executor()
+    {
+        return ws_.get_executor();
+    }
+
+    /// @brief Send the latest snapshot, or mark it pending if a write is in flight.
+    void notify()
+    {
+        if( closed_ )
+            return;
+        if( writing_ )
+        {
+            pending_ = true; // Only the newest snapshot is sent when the write completes
+            return;
+        }
+        do_write();
+    }
+
+    /// @brief Whether the connection has been closed. Safe to call from any thread.
+    bool closed() const
+    {
+        return closed_;
+    }
+
+private:
+    void do_write()
+    {
+        auto snapshot = snapshots_.latest();
+        if( !snapshot || snapshot->tick == last_sent_tick_ )
+            return;
+        ScenePacket packet{ snapshot, last_sent_tick_ };
+        if( view_ )
+        {
+            interest_.select( *snapshot, *view_, last_sent_tick_ );
+            packet.interest = &interest_;
+        }
+        packet.write( format_, write_buffer_ );
+        last_sent_tick_ = snapshot->tick;
+
+        writing_ = true;
+        ws_.binary( format_ == SceneFormat::binary );
+        auto self = shared_from_this();
+        ws_.async_write( net::buffer( write_buffer_ ), [ self ]( beast::error_code ec, std::size_t ) {
+            self->writing_ = false;
+            if( ec )
+            {
+                self->closed_ = true;
+                return;
+            }
+            if( self->pending_ )
+            {
+                self->pending_ = false;
+                self->do_write();
+            }
+        } );
+    }
+
+    /// @brief Cull later frames to a viewport, or stop culling.
+    void set_view( std::optional< AxisAlignedBoundingBox > view, Float margin )
+    {
+        if( !view && view_ )
+        {
+            // The viewer only holds its old view; start it over from a keyframe of the world
+            interest_.reset();
+            last_sent_tick_ = 0;
+        }
+        view_ = view ? std::optional( expandBox( *view, margin ) ) : std::nullopt;
+        notify();
+    }
+
+    void do_read()
+    {
+        auto self = shared_from_this();
+        ws_.async_read( read_buffer_, [ self ]( beast::error_code ec, std::size_t ) {
+            if( ec )
+            {
+                if( ec != websocket::error::closed )
+                {
+                    defaultLogger().warning( "Stream read error: ", ec.message() );
+                }
+                self->closed_ = true;
+                return;
+            }
+            try
+            {
+                auto message = beast::buffers_to_string( self->read_buffer_.data() );
+                auto jv = boost::json::parse( message );
+                const auto & obj = jv.as_object();
+                if( const auto * view = obj.if_contains( "view" ) )
+                {
+                    const auto * margin_value = obj.if_contains( "margin" );
+                    auto margin = margin_value ? parseViewNumber( *margin_value ) : DEFAULT_VIEW_MARGIN;
+                    if( !isValidViewMargin( margin ) )
+                    {
+                        throw std::invalid_argument( "margin must be finite and not negative" );
+                    }
+                    self->set_view( parseViewJson( *view ), margin );
+                }
+                else if( !submitPlayerInput( self->inputs_, parsePlayerInput( obj ), self->metrics_ ) )
+                {
+                    defaultLogger().warning( "Stream input dropped: input queue full" );
+                }
+            }
+            catch( const std::exception & e )
+            {
+                defaultLogger().warning( "Stream input error: ", e.what() );
+            }
+            self->read_buffer_.consume( self->read_buffer_.size() );
+            self->do_read();
+        } );
+    }
+};
+
+inline void StreamHub::broadcast()
+{
+    std::lock_guard< std::mutex > lock( mutex_ );
+    std::erase_if( subscribers_, []( const std::weak_ptr< StreamSession > & weak ) {
+        auto session = weak.lock();
+        if( !session || session->closed() )
+            return true;
+        net::post( session->get_executor(), [ session ] {
+            session->notify();
+        } );
+        return false;
+    } );
+}
+
 class Session : public std::enable_shared_from_this< Session >
 {
 private:
+    /// Header fields drawn from the session's pool, so a keep-alive connection reuses their memory
+    using Fields = http::basic_fields< std::pmr::polymorphic_allocator< char > >;
+    using Parser = http::request_parser< http::string_body, std::pmr::polymorphic_allocator< char > >;
+
+    /// How long an idle keep-alive connection, or a slow request, may hold the session
+    static constexpr std::chrono::seconds KEEP_ALIVE_TIMEOUT{ 30 };
+
     net::io_context & ioc_;
     beast::tcp_stream stream_;
-    beast::flat_buffer buffer_;
-    std::mutex & store_mutex_;
-    EntityStore & entity_store_;
-    http::request< http::string_body > req_;
+    beast::flat_buffer buffer_; ///< Also holds pipelined requests read ahead of the current one
+    std::span< const WorldEndpoint > worlds_; ///< Worlds the server routes to, by index
+    const WorldEndpoint * world_ = nullptr; ///< World the current request addresses
+    Metrics & metrics_;
+    std::pmr::unsynchronized_pool_resource pool_; ///< Declared before everything allocating from it
+    std::optional< Parser > parser_; ///< Rebuilt for every request; its fields come from pool_
+    http::response< http::string_body, Fields > response_; ///< Reused for every generated response
+    http::response< http::span_body< const char >, Fields > asset_response_; ///< Views a StaticAsset
+    bool keep_alive_ = false; ///< Whether the current request lets the connection stay open
+    SceneInterest interest_; ///< What a viewer polling /output with a viewport holds, of world_
+    std::chrono::steady_clock::time_point request_start_; ///< When the current request was read
+    Metrics::Route * route_ = nullptr; ///< Histograms the current request is recorded in
 
 public:
-    Session( net::io_context & ioc, tcp::socket socket, std::mutex & store_mutex, EntityStore & entity_store )
+    Session( net::io_context & ioc, tcp::socket socket, std::span< const WorldEndpoint > worlds, Metrics & metrics )
         : ioc_( ioc )
         , stream_( std::move( socket ) )
-        , store_mutex_( store_mutex )
-        , entity_store_( entity_store )
+        , worlds_( worlds )
+        , metrics_( metrics )
+        , response_( std::piecewise_construct, std::make_tuple(), std::make_tuple( &pool_ ) )
+        , asset_response_( std::piecewise_construct, std::make_tuple(), std::make_tuple( &pool_ ) )
     {}
 
     void run()
@@ -44,30 +517,47 @@ public:
     }
 
 private:
+    /// @brief The request being answered.
+    const http::request< http::string_body, Fields > & request() const
+    {
+        return parser_->get();
+    }
+
     void do_read()
     {
+        // A parser only reads one message, so each request gets a fresh one over the same pool
+        parser_.emplace( std::piecewise_construct, std::make_tuple(), std::make_tuple( &pool_ ) );
+        stream_.expires_after( KEEP_ALIVE_TIMEOUT );
         auto self = shared_from_this();
-        http::async_read( stream_, buffer_, req_, [ self ]( beast::error_code ec, std::size_t ) {
-            if( ec == http::error::end_of_stream )
+        http::async_read( stream_, buffer_, *parser_, [ self ]( beast::error_code ec, std::size_t ) {
+            // The viewer closing or idling on a keep-alive connection is routine
+            if( ec == http::error::end_of_stream || ec == beast::error::timeout )
                 return self->do_close();
             if( ec )
             {
-                std::cerr << "REST read error: " << ec.message() << std::endl;
+                defaultLogger().warning( "REST read error: ", ec.message() );
                 return self->do_close();
             }
-            std::cout << "REST request: " << self->req_.method_string() << " " << self->req_.target() << std::endl;
+            self->request_start_ = std::chrono::steady_clock::now();
+            self->route_ = &self->metrics_.route( "other" );
+            self->keep_alive_ = self->request().keep_alive();
+            defaultLogger().debug( "REST request: ", self->request().method_string(), " ", self->request().target() );
+            if( websocket::is_upgrade( self->request() ) )
+            {
+                return self->handle_upgrade();
+            }
             try
             {
                 self->handle_request();
             }
             catch( const std::exception & e )
             {
-                std::cerr << "REST request error: " << e.what() << std::endl;
+                defaultLogger().error( "REST request error: ", e.what() );
                 self->send_response( http::status::internal_server_error, "Internal Server Error" );
             }
             catch( ... )
             {
-                std::cerr << "REST request error: unknown exception" << std::endl;
+                defaultLogger().error( "REST request error: unknown exception" );
                 self->send_response( http::status::internal_server_error, "Internal Server Error" );
             }
         } );
@@ -75,7 +565,8 @@ private:
 
     void handle_request()
     {
-        auto target = req_.target();
+        const auto & req = request();
+        auto target = req.target();
         // Strip query parameters (e.g., ?id=...&vscodeBrowserReqId=...) from the path
         auto target_view = target;
         auto query_pos = target_view.find( '?' );
@@ -83,55 +574,112 @@ private:
         {
             target_view = target_view.substr( 0, query_pos );
         }
+        // /worlds/<id>/output and friends address one world; the bare paths address world 0
+        auto world_path = select_world( std::string_view( target_view.data(), target_view.size() ) );
+        if( !world_path )
+        {
+            return send_response( http::status::not_found, "Not Found" );
+        }
+        if( world_path->prefixed && world_path->path.empty() )
+        {
+            // The client page uses relative URLs, which need the trailing slash to resolve into the world
+            reset_response( http::status::permanent_redirect, "text/plain" );
+            response_.set( http::field::location, std::string( target_view ) + "/" );
+            return send_prepared();
+        }
+        target_view = { world_path->path.data(), world_path->path.size() };
+        route_ = &metrics_.route( std::string_view( target_view.data(), target_view.size() ) );
 
-        if( target_view == "/input" && req_.method() == http::verb::post )
+        if( target_view == "/input" && req.method() == http::verb::post )
         {
             handle_input();
         }
-        else if( target_view == "/output" && req_.method() == http::verb::get )
+        else if( target_view == "/output" && req.method() == http::verb::get )
         {
             handle_output();
         }
-        else if( ( target_view == "/client" || target_view == "/" ) && req_.method() == http::verb::get )
+        else if( ( target_view == "/client" || target_view == "/" ) && req.method() == http::verb::get )
         {
             handle_client();
         }
+        else if( target_view == "/metrics" && req.method() == http::verb::get )
+        {
+            handle_metrics();
+        }
+        else if( target_view == "/worlds" && !world_path->prefixed && req.method() == http::verb::get )
+        {
+            handle_worlds();
+        }
         else
         {
             send_response( http::status::not_found, "Not Found" );
         }
     }
 
-    void handle_input()
+    /// @brief Point the session at the world a request path addresses.
+    /// @param path Request path without its query.
+    /// @return The path within the world, or an empty optional if no such world exists.
+    std::optional< WorldPath > select_world( std::string_view path )
     {
-        try
+        auto world_path = routeWorldPath( path, worlds_.size() );
+        if( !world_path )
         {
-            std::lock_guard< std::mutex > lock( store_mutex_ );
-            auto body = req_.body();
-            auto jv = boost::json::parse( body );
-            auto obj = jv.as_object();
-            // Only extract x and y - ignore any other fields like IDs
-            float x = boost::json::value_to< float >( obj.at( "x" ) );
-            float y = boost::json::value_to< float >( obj.at( "y" ) );
-
-            // std::cout << "REST input: entity 0 <- PlayerInput(" << x << ", " << y << ")" << std::endl;
+            return std::nullopt;
+        }
+        const auto * world = &worlds_[ world_path->world ];
+        if( world != world_ )
+        {
+            // Culled deltas follow on from what this connection was sent of one world only
+            interest_.reset();
+            world_ = world;
+        }
+        return world_path;
+    }
 
-            auto & inputs = entity_store_.get< PlayerInput >();
+    void handle_upgrade()
+    {
+        auto target_view = std::string_view( request().target() );
+        auto world_path = select_world( target_view.substr( 0, target_view.find( '?' ) ) );
+        if( !world_path || world_path->path != "/stream" )
+        {
+            return send_response( http::status::not_found, "Not Found" );
+        }
+        // The handshake outlives this session and its pool, so copy the request out of it
+        http::request< http::string_body > upgrade( request().method(), request().target(), request().version() );
+        for( const auto & field : request() )
+        {
+            upgrade.insert( field.name_string(), field.value() );
+        }
+        // Hand the socket over to a WebSocket session; this HTTP session ends here
+        stream_.expires_never();
+        std::make_shared< StreamSession >(
+            stream_.release_socket(),
+            world_->inputs,
+            world_->snapshots,
+            world_->stream_hub,
+            metrics_ )
+            ->run( std::move( upgrade ) );
+    }
 
-            if( inputs.contains( 0 ) )
-            {
-                inputs[ 0 ] = PlayerInput( x, y );
-            }
-            else
+    void handle_input()
+    {
+        try
+        {
+            auto input = parsePlayerInput( request().body() );
+            defaultLogger().debug( "REST input: entity 0 <- PlayerInput(", input.x, ", ", input.y, ")" );
+            if( !submitPlayerInput( world_->inputs, input, metrics_ ) )
             {
-                inputs.insert( 0, PlayerInput( x, y ) );
+                return send_response( http::status::service_unavailable, R"({"status":"input queue full"})" );
             }
-            send_response( http::status::ok, R"({"status":"ok"})" );
+            // Read after the push, so the input is applied once a scene's "inputs" reaches this count
+            auto & body = reset_response( http::status::ok, "application/json" );
+            body = R"({"status":"ok","input":)" + std::to_string( world_->inputs.pushed() ) + "}";
+            send_prepared();
         }
         catch( const std::exception & e )
         {
-            std::cerr << "REST input error: " << e.what() << std::endl;
-            send_response( http::status::bad_request, std::string( e.what() ) );
+            defaultLogger().warning( "REST input error: ", e.what() );
+            send_response( http::status::bad_request, e.what() );
         }
     }
 
@@ -139,37 +687,86 @@ private:
     {
         try
         {
-            std::lock_guard< std::mutex > lock( store_mutex_ );
-            boost::json::object scene;
-            boost::json::array geometries;
-
-            // Iterate over entities but don't expose entity_id to client
-            for( auto [ entity_id, polygon ] : entity_store_.get< Polygon >() )
+            // Read the latest published snapshot; the store belongs to the simulation thread alone
+            auto snapshot = world_->snapshots.latest();
+            auto target = std::string_view( request().target() );
+            auto since_param = queryParameter( target, "since" );
+            std::uint64_t since = 0;
+            if( since_param )
+            {
+                std::from_chars( since_param->data(), since_param->data() + since_param->size(), since );
+            }
+            auto accept = request()[ http::field::accept ];
+            auto format = negotiateSceneFormat( target, std::string_view( accept.data(), accept.size() ) );
+            ScenePacket packet{ std::move( snapshot ), since };
+            if( auto view_param = queryParameter( target, "view" ) )
             {
-                boost::json::object geo;
-                boost::json::array vertices;
-                for( auto [ x, y ] : polygon )
+                // Culled to the viewport; deltas follow on from what this connection was sent
+                auto view = parseViewport( *view_param );
+                if( !view )
+                {
+                    return send_response( http::status::bad_request, R"({"status":"invalid view"})" );
+                }
+                auto margin = viewMargin( target );
+                if( !margin )
                 {
-                    vertices.push_back( boost::json::array{ x, y } );
+                    return send_response( http::status::bad_request, R"({"status":"invalid margin"})" );
                 }
-                // Only send vertices and position - no entity IDs
-                geo[ "vertices" ] = vertices;
-                if( entity_store_.get< Position >().contains( entity_id ) )
+                if( packet.snapshot )
                 {
-                    auto pos = entity_store_.get< Position >()[ entity_id ];
-                    geo[ "position" ] = boost::json::array{ pos.x, pos.y };
+                    interest_.select( *packet.snapshot, expandBox( *view, *margin ), since );
+                    packet.interest = &interest_;
                 }
-                geometries.push_back( geo );
             }
-
-            scene[ "geometries" ] = geometries;
-            send_response( http::status::ok, boost::json::serialize( scene ) );
+            else
+            {
+                // An unculled update leaves the viewer holding more than the interest knows of
+                interest_.reset();
+            }
+            // The packet is encoded straight into the reused response body, keeping its capacity
+            if( format == SceneFormat::binary )
+            {
+                // The binary format always uses the versioned protocol; no since means a keyframe
+                packet.write_binary( reset_response( http::status::ok, "application/octet-stream" ) );
+                return send_prepared();
+            }
+            auto & body = reset_response( http::status::ok, "application/json" );
+            if( since_param )
+            {
+                // Versioned protocol: a delta from the viewer's tick, or a keyframe
+                packet.write_json( body );
+            }
+            else
+            {
+                packet.write_geometries_json( body );
+            }
+            send_prepared();
         }
         catch( const std::exception & e )
         {
-            std::cerr << "REST output error: " << e.what() << std::endl;
-            send_response( http::status::internal_server_error, std::string( e.what() ) );
+            defaultLogger().error( "REST output error: ", e.what() );
+            send_response( http::status::internal_server_error, e.what() );
+        }
+    }
+
+    /// @brief Serve every histogram and counter in the Prometheus text format.
+    void handle_metrics()
+    {
+        metrics_.write_prometheus( reset_response( http::status::ok, "text/plain; version=0.0.4" ) );
+        send_prepared();
+    }
+
+    /// @brief List the ids of the worlds served, as {"worlds":[0,1,...]}.
+    void handle_worlds()
+    {
+        auto & body = reset_response( http::status::ok, "application/json" );
+        body = R"({"worlds":[)";
+        for( std::size_t i = 0; i < worlds_.size(); ++i )
+        {
+            body += ( i ? "," : "" ) + std::to_string( i );
         }
+        body += "]}";
+        send_prepared();
     }
 
     void handle_client()
@@ -316,10 +913,16 @@ private:
         }
         
         async function sendInput(x, y) {
+            if( streamOpen() )
+            {
+                // Explicitly send only x and y coordinates - no IDs
+                stream.send( JSON.stringify( { x: Number( x ), y: Number( y ) } ) );
+                return;
+            }
             try {
                 console.log(`sendInput: POSTing (${x.toFixed(2)}, ${y.toFixed(2)}) to /input`);
                 // Explicitly send only x and y coordinates - no IDs
-                await fetch('/input', {
+                await fetch('input', {
                     method: 'POST',
                     headers: { 'Content-Type': 'application/json' },
                     body: JSON.stringify({ x: Number(x), y: Number(y) })
@@ -329,14 +932,94 @@ private:
             }
         }
         
+        // Decode the binary scene protocol (little-endian 32-bit words) into the
+        // same object shape as the JSON protocol
+        function decodeSceneUpdate( buffer )
+        {
+            const words = new Uint32Array( buffer );
+            const floats = new Float32Array( buffer );
+            if( words.length < 12 || words[ 0 ] !== 0x32534252 )
+            {
+                return null;
+            }
+            const [ despawnCount, spawnCount, moveCount, vertexCount, shapeCount ] = words.subarray( 6, 11 );
+            let at = 12;
+            const despawn = Array.from( words.subarray( at, at += despawnCount ) );
+            const ids = words.subarray( at, at += spawnCount );
+            const flags = words.subarray( at, at += spawnCount );
+            const shapeRefs = words.subarray( at, at += spawnCount );
+            const transformsAt = at;
+            const offsets = words.subarray( at += spawnCount * 5, at += spawnCount + 1 );
+            const positionsAt = at;
+            const verticesAt = ( at += spawnCount * 2 );
+            const moveIdsAt = ( at += vertexCount * 2 );
+            const movePositionsAt = ( at += moveCount );
+            const shapeIds = words.subarray( at += moveCount * 2, at += shapeCount );
+            const shapeOffsets = words.subarray( at, at += shapeCount + 1 );
+            const shapeVerticesAt = at;
+
+            const readVertices = ( from, begin, end ) => {
+                const vertices = [];
+                for( let v = begin; v < end; v++ )
+                {
+                    vertices.push( [ floats[ from + 2 * v ], floats[ from + 2 * v + 1 ] ] );
+                }
+                return vertices;
+            };
+
+            const shapes = [];
+            for( let s = 0; s < shapeCount; s++ )
+            {
+                shapes.push( {
+                    shape: shapeIds[ s ],
+                    vertices: readVertices( shapeVerticesAt, shapeOffsets[ s ], shapeOffsets[ s + 1 ] )
+                } );
+            }
+            const spawn = [];
+            for( let i = 0; i < spawnCount; i++ )
+            {
+                const geo = { id: ids[ i ] };
+                if( flags[ i ] & 2 )
+                {
+                    geo.shape = shapeRefs[ i ];
+                    geo.transform = Array.from( floats.subarray( transformsAt + 5 * i, transformsAt + 5 * i + 5 ) );
+                }
+                else
+                {
+                    geo.vertices = readVertices( verticesAt, offsets[ i ], offsets[ i + 1 ] );
+                }
+                if( flags[ i ] & 1 )
+                {
+                    geo.position = [ floats[ positionsAt + 2 * i ], floats[ positionsAt + 2 * i + 1 ] ];
+                }
+                spawn.push( geo );
+            }
+            const move = [];
+            for( let i = 0; i < moveCount; i++ )
+            {
+                const p = movePositionsAt + 2 * i;
+                move.push( [ words[ moveIdsAt + i ], floats[ p ], floats[ p + 1 ] ] );
+            }
+            return {
+                version: 2,
+                type: words[ 1 ] === 1 ? 'keyframe' : 'delta',
+                tick: words[ 2 ] + words[ 3 ] * 4294967296,
+                base: words[ 4 ] + words[ 5 ] * 4294967296,
+                shapes,
+                despawn,
+                spawn,
+                move
+            };
+        }
+
         async function fetchScene() {
             try {
-                const response = await fetch('/output');
+                const response = await fetch(`output?since=${sceneTick}&format=binary`);
                 if (!response.ok) {
                     console.error(`fetch /output failed: status ${response.status}`);
                     return null;
                 }
-                const data = await response.json();
+                const data = decodeSceneUpdate( await response.arrayBuffer() );
                 console.log('fetchScene succeeded:', data);
                 return data;
             } catch (err) {
@@ -462,7 +1145,7 @@ private:
                 ctx.save();
 
                 // Draw filled polygon
-                ctx.fillStyle = idx === 0 ? '#4a9eff' : '#ff6b6b';
+                ctx.fillStyle = geo.id === 0 ? '#4a9eff' : '#ff6b6b';
                 ctx.strokeStyle = '#fff';
                 ctx.lineWidth = 2;
                 ctx.beginPath();
@@ -484,11 +1167,118 @@ private:
         let lastScene = null;
         let fetchCount = 0;
 
+        // Entities and shared shapes known to the client, keyed by id, and the tick they reflect
+        const sceneEntities = new Map();
+        const sceneShapes = new Map();
+        let sceneTick = 0;
+
+        // Vertices of an instance: its shape's vertices through [tx, ty, rotation, sx, sy]
+        function instanceVertices( shape, transform )
+        {
+            const [ tx, ty, rotation, sx, sy ] = transform;
+            const c = Math.cos( rotation );
+            const s = Math.sin( rotation );
+            return ( sceneShapes.get( shape ) || [] ).map( ( [ x, y ] ) => [
+                tx + c * sx * x - s * sy * y,
+                ty + s * sx * x + c * sy * y
+            ] );
+        }
+
+        function applySceneUpdate( update )
+        {
+            if( !update || update.version !== 2 )
+            {
+                return;
+            }
+            if( update.type === 'keyframe' )
+            {
+                sceneEntities.clear();
+                sceneShapes.clear();
+            }
+            else if( update.base !== sceneTick )
+            {
+                return; // Out of order; the next request asks from sceneTick again
+            }
+            ( update.shapes || [] ).forEach( ( shape ) => sceneShapes.set( shape.shape, shape.vertices ) );
+            ( update.despawn || [] ).forEach( ( id ) => sceneEntities.delete( id ) );
+            ( update.spawn || [] ).forEach( ( geo ) => {
+                if( geo.shape !== undefined )
+                {
+                    geo.vertices = instanceVertices( geo.shape, geo.transform );
+                }
+                sceneEntities.set( geo.id, geo );
+            } );
+            ( update.move || [] ).forEach( ( [ id, x, y ] ) => {
+                const geo = sceneEntities.get( id );
+                if( geo )
+                {
+                    geo.position = [ x, y ];
+                }
+            } );
+            sceneTick = update.tick;
+            lastScene = { geometries: Array.from( sceneEntities.values() ) };
+        }
+
+        // Scene updates are pushed over /stream; polling /output is only the fallback
+        let stream = null;
+        let pollTimer = null;
+
+        function streamOpen()
+        {
+            return stream !== null && stream.readyState === WebSocket.OPEN;
+        }
+
+        function startPolling()
+        {
+            if( pollTimer === null )
+            {
+                // Fetch every 33ms (~30fps) instead of 16ms to reduce server load
+                pollTimer = setInterval( updateSceneData, 33 );
+            }
+        }
+
+        function stopPolling()
+        {
+            if( pollTimer !== null )
+            {
+                clearInterval( pollTimer );
+                pollTimer = null;
+            }
+        }
+
+        function connectStream()
+        {
+            if( !( 'WebSocket' in window ) )
+            {
+                startPolling();
+                return;
+            }
+            // Relative to the page, so /worlds/<id>/ streams its own world
+            const url = new URL( 'stream?format=binary', location.href );
+            url.protocol = location.protocol === 'https:' ? 'wss:' : 'ws:';
+            stream = new WebSocket( url );
+            stream.binaryType = 'arraybuffer';
+            stream.onopen = () => {
+                console.log( 'Stream connected; polling stopped' );
+                stopPolling();
+            };
+            stream.onmessage = ( event ) => {
+                applySceneUpdate( typeof event.data === 'string' ? JSON.parse( event.data )
+                                                                 : decodeSceneUpdate( event.data ) );
+            };
+            stream.onclose = () => {
+                console.warn( 'Stream closed; falling back to polling' );
+                stream = null;
+                startPolling();
+                setTimeout( connectStream, 2000 );
+            };
+        }
+
         async function updateSceneData()
         {
             try
             {
-                lastScene = await fetchScene();
+                applySceneUpdate( await fetchScene() );
                 fetchCount++;
                 // Always log first fetch, then occasionally
                 if( fetchCount === 1 || fetchCount % 60 === 0 )
@@ -533,8 +1323,8 @@ private:
             requestAnimationFrame( animate );
         }
 
-        // Fetch every 33ms (~30fps) instead of 16ms to reduce server load
-        setInterval( updateSceneData, 33 );
+        startPolling();
+        connectStream();
         
         window.addEventListener( 'resize', resizeCanvas );
 
@@ -546,53 +1336,106 @@ private:
 </body>
 </html>)html";
 
-        send_html_response( http::status::ok, html );
+        // Compressed and tagged once; the literal itself is the identity body
+        static const StaticAsset asset = StaticAsset::build( "text/html", html );
+        send_asset( asset );
+    }
+
+    /// @brief Clear the reused response for the current request.
+    /// @return Its body, empty but keeping the capacity earlier responses grew it to.
+    std::string & reset_response( http::status status, std::string_view content_type )
+    {
+        response_.clear();
+        response_.result( status );
+        response_.version( request().version() );
+        response_.set( http::field::content_type, beast::string_view( content_type.data(), content_type.size() ) );
+        response_.body().clear();
+        return response_.body();
     }
 
-    void send_response( http::status status, std::string_view body )
+    void send_response( http::status status, std::string_view body, std::string_view content_type = "application/json" )
     {
-        auto res = std::make_shared< http::response< http::string_body > >();
-        res->result( status );
-        res->set( http::field::content_type, "application/json" );
-        res->body() = std::string( body );
-        res->prepare_payload();
+        reset_response( status, content_type ).assign( body );
+        send_prepared();
+    }
 
+    /// @brief Send the response built by reset_response().
+    void send_prepared()
+    {
+        response_.keep_alive( keep_alive_ );
+        response_.prepare_payload();
         auto self = shared_from_this();
-        http::async_write( stream_, *res, [ self, res ]( beast::error_code ec, std::size_t ) {
-            if( ec )
-            {
-                std::cerr << "REST write error: " << ec.message() << std::endl;
-                self->do_close();
-            }
-            else
-            {
-                self->do_read();
-            }
+        http::async_write( stream_, response_, [ self ]( beast::error_code ec, std::size_t bytes ) {
+            self->on_write( ec, bytes );
         } );
     }
 
-    void send_html_response( http::status status, std::string_view body )
+    /// @brief Send a prepared asset without copying it, or 304 if the viewer's copy is current.
+    ///
+    /// The gzip encoding is chosen whenever the request accepts it, and each
+    /// encoding is tagged and revalidated under its own ETag. The asset is
+    /// always revalidated, so a rebuilt server is picked up on the next load.
+    void send_asset( const StaticAsset & asset )
     {
-        auto res = std::make_shared< http::response< http::string_body > >();
-        res->result( status );
-        res->set( http::field::content_type, "text/html" );
-        res->body() = std::string( body );
-        res->prepare_payload();
+        const auto & req = request();
+        auto header = [ &req ]( http::field field ) {
+            auto value = req[ field ];
+            return std::string_view( value.data(), value.size() );
+        };
+        auto view = []( std::string_view text ) { return beast::string_view( text.data(), text.size() ); };
 
-        auto self = shared_from_this();
-        http::async_write( stream_, *res, [ self, res ]( beast::error_code ec, std::size_t ) {
-            if( ec )
-            {
-                std::cerr << "REST write error: " << ec.message() << std::endl;
-                self->do_close();
-            }
-            else
+        bool gzip = asset.has_gzip() && acceptsGzip( header( http::field::accept_encoding ) );
+        const auto & etag = gzip ? asset.gzip_etag : asset.etag;
+        asset_response_.clear();
+        asset_response_.version( req.version() );
+        asset_response_.set( http::field::etag, view( etag ) );
+        asset_response_.set( http::field::cache_control, "no-cache" );
+        asset_response_.set( http::field::vary, "Accept-Encoding" );
+        if( etagMatches( header( http::field::if_none_match ), etag ) )
+        {
+            asset_response_.result( http::status::not_modified );
+            asset_response_.body() = {};
+        }
+        else
+        {
+            asset_response_.result( http::status::ok );
+            asset_response_.set( http::field::content_type, view( asset.content_type ) );
+            std::string_view bytes = asset.identity;
+            if( gzip )
             {
-                self->do_read();
+                bytes = asset.gzip;
+                asset_response_.set( http::field::content_encoding, "gzip" );
             }
+            asset_response_.body() = { bytes.data(), bytes.size() };
+        }
+        asset_response_.keep_alive( keep_alive_ );
+        asset_response_.prepare_payload();
+        auto self = shared_from_this();
+        http::async_write( stream_, asset_response_, [ self ]( beast::error_code ec, std::size_t bytes ) {
+            self->on_write( ec, bytes );
         } );
     }
 
+    /// @brief Record the finished request, then read the next one unless the connection is done.
+    void on_write( beast::error_code ec, std::size_t bytes )
+    {
+        if( route_ )
+        {
+            route_->seconds.observe( ScopedTimer::elapsedNanoseconds( request_start_ ) );
+            route_->bytes.observe( bytes );
+        }
+        if( ec )
+        {
+            defaultLogger().warning( "REST write error: ", ec.message() );
+            return do_close();
+        }
+        if( !keep_alive_ )
+        {
+            return do_close();
+        }
+        do_read();
+    }
+
     void do_close()
     {
         beast::error_code ec;
@@ -605,16 +1448,23 @@ class RESTServer : public std::enable_shared_from_this< RESTServer >
 private:
     net::io_context & ioc_;
     tcp::acceptor acceptor_;
-    std::mutex & store_mutex_;
-    EntityStore & entity_store_;
+    std::span< const WorldEndpoint > worlds_;
+    Metrics & metrics_;
+    std::mutex known_clients_mutex_; ///< Guards known_clients_
     std::unordered_set< std::string > known_clients_;
 
 public:
-    RESTServer( net::io_context & ioc, std::mutex & store_mutex, EntityStore & entity_store, unsigned short port )
+    /// @brief Listen for viewers of a set of worlds.
+    /// @param ioc Context the sessions run on.
+    /// @param worlds Worlds to serve, by index; must outlive the server and its sessions, and hold at least one.
+    /// @param metrics Metrics shared by every world.
+    /// @param port TCP port to listen on.
+    RESTServer( net::io_context & ioc, std::span< const WorldEndpoint > worlds, Metrics & metrics,
+                unsigned short port )
         : ioc_( ioc )
         , acceptor_( ioc, tcp::endpoint( tcp::v4(), port ) )
-        , store_mutex_( store_mutex )
-        , entity_store_( entity_store )
+        , worlds_( worlds )
+        , metrics_( metrics )
     {}
 
     void run()
@@ -623,37 +1473,44 @@ public:
     }
 
 private:
+    /// @brief Record a client address.
+    /// @return True the first time the address is seen.
+    bool remember_client( const std::string & client_ip )
+    {
+        std::lock_guard< std::mutex > lock( known_clients_mutex_ );
+        return known_clients_.insert( client_ip ).second;
+    }
+
     void do_accept()
     {
-        acceptor_.async_accept( [ shared_this = shared_from_this() ]( beast::error_code ec, tcp::socket socket ) {
+        // Each connection gets its own strand, so a session's handlers never run
+        // concurrently even when several threads are running the io_context.
+        auto strand = net::make_strand( ioc_ );
+        auto self = shared_from_this();
+        acceptor_.async_accept( strand, [ self ]( beast::error_code ec, tcp::socket socket ) {
             if( !ec )
             {
                 beast::error_code endpoint_ec;
                 auto remote_endpoint = socket.remote_endpoint( endpoint_ec );
                 if( endpoint_ec )
                 {
-                    std::cerr << "REST accept error: " << endpoint_ec.message() << std::endl;
+                    defaultLogger().warning( "REST accept error: ", endpoint_ec.message() );
                 }
                 else
                 {
                     auto client_ip = remote_endpoint.address().to_string();
-                    if( shared_this->known_clients_.insert( client_ip ).second )
+                    if( self->remember_client( client_ip ) )
                     {
-                        std::cout << "REST client connected first time from " << client_ip << std::endl;
+                        defaultLogger().info( "REST client connected first time from ", client_ip );
                     }
                 }
-                std::make_shared< Session >(
-                    shared_this->ioc_,
-                    std::move( socket ),
-                    shared_this->store_mutex_,
-                    shared_this->entity_store_ )
-                    ->run();
+                std::make_shared< Session >( self->ioc_, std::move( socket ), self->worlds_, self->metrics_ )->run();
             }
             else
             {
-                std::cerr << "REST accept error: " << ec.message() << std::endl;
+                defaultLogger().warning( "REST accept error: ", ec.message() );
             }
-            shared_this->do_accept();
+            self->do_accept();
         } );
     }
 };
@@ -662,4 +1519,4 @@ private:
 namespace robot::src::inline exports::inline rest
 {
 using namespace detail::rest::exports;
-}
\ No newline at end of file
+}
@@ -1,7 +1,20 @@
+#include <algorithm>
+#include <chrono>
 #include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
 
+#include "headless.hpp"
+#include "input_recording.hpp"
 #include "mainloop.hpp"
+#include "world_file.hpp"
 
 // Global stop token
 std::stop_source stop_source;
@@ -14,15 +27,198 @@ void signal_handler( int signal )
     }
 }
 
+/// @brief Run the simulation headless and report its final state.
+/// @return 0 on success, 1 if the replay or world cannot be read or the recording or world written,
+///         2 if the replay diverged.
+int runHeadlessCommand( robot::src::headless::HeadlessOptions options, const std::string & replay_path,
+                        const std::string & record_path )
+{
+    namespace ir = robot::src::input_recording;
+    if( !replay_path.empty() )
+    {
+        std::ifstream in( replay_path );
+        if( !in )
+        {
+            std::cerr << "Cannot open replay " << replay_path << std::endl;
+            return 1;
+        }
+        try
+        {
+            options.replay = ir::readInputRecording( in );
+        }
+        catch( const std::exception & e )
+        {
+            std::cerr << replay_path << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    robot::src::headless::HeadlessResult result;
+    try
+    {
+        result = robot::src::headless::runHeadless( options, stop_source.get_token() );
+    }
+    catch( const std::exception & e )
+    {
+        std::cerr << "Cannot build world: " << e.what() << std::endl;
+        return 1;
+    }
+    const auto & recording = result.recording;
+    auto seconds = std::chrono::duration< double >( result.elapsed ).count();
+    std::cout << "Headless run of " << recording.key << " with " << recording.num_assets << " assets: "
+              << *recording.end_tick << " ticks in " << seconds * 1000.0 << " ms ("
+              << ( seconds > 0.0 ? static_cast< double >( *recording.end_tick ) / seconds : 0.0 )
+              << " ticks/s), state hash " << std::hex << *recording.end_hash << std::dec << std::endl;
+
+    if( !record_path.empty() )
+    {
+        std::ofstream out( record_path );
+        ir::writeInputRecording( out, recording );
+        if( !out )
+        {
+            std::cerr << "Cannot write recording " << record_path << std::endl;
+            return 1;
+        }
+    }
+    if( result.checkpoints_failed > 0 )
+    {
+        std::cerr << "Cannot write world " << options.checkpoint_path << std::endl;
+        return 1;
+    }
+    if( result.matches_replay )
+    {
+        std::cout << ( *result.matches_replay ? "Replay matches" : "Replay DIVERGED from" )
+                  << " the recorded state hash " << std::hex << *options.replay->end_hash << std::dec << "."
+                  << std::endl;
+        return *result.matches_replay ? 0 : 2;
+    }
+    return 0;
+}
+
 int main( int argc, char* argv[] )
 {
     std::cout << "Robot application started." << std::endl;
 
     std::signal( SIGINT, signal_handler );
 
-    robot::src::mainloop::runMainloop( stop_source );
+    // --rest-threads N sets how many threads serve REST and WebSocket clients,
+    // --sim-threads N how many worker threads the systems may use besides the loop thread,
+    // --log-level LEVEL (debug, info, warning, error or off) which messages are logged,
+    // --record FILE where the input stream is written on exit,
+    // --load FILE a world file to start from instead of the procedural assets,
+    // --checkpoint FILE where the world is saved every --checkpoint-every TICKS ticks and on exit,
+    // --worlds N how many independent worlds to serve, each with its own loop thread and files
+    // (--sim-threads then defaults to 0, as the worlds already spread across the cores).
+    // --headless runs the systems back to back without the REST server, for --ticks N steps
+    // of the world --key KEY with --assets N assets, or of the recording given by --replay FILE;
+    // --chunked generates that world in parallel chunks, and --no-overlaps also keeps its bodies apart.
+    unsigned int rest_threads = robot::src::rest::defaultRestThreadCount();
+    std::optional< std::size_t > sim_threads;
+    std::size_t world_count = 1;
+    bool headless = false;
+    robot::src::headless::HeadlessOptions headless_options;
+    std::string replay_path;
+    std::string record_path;
+    std::string load_path;
+    std::string checkpoint_path;
+    std::uint64_t checkpoint_interval = robot::src::world_file::DEFAULT_CHECKPOINT_INTERVAL;
+    for( int i = 1; i < argc; ++i )
+    {
+        auto option = std::string_view( argv[ i ] );
+        if( option == "--headless" )
+        {
+            headless = true;
+            continue;
+        }
+        if( option == "--chunked" || option == "--no-overlaps" )
+        {
+            if( !headless_options.worldgen )
+            {
+                headless_options.worldgen.emplace();
+            }
+            headless_options.worldgen->reject_overlaps |= option == "--no-overlaps";
+            continue;
+        }
+        if( i + 1 == argc )
+        {
+            break;
+        }
+        if( option == "--rest-threads" )
+        {
+            rest_threads = static_cast< unsigned int >( std::max( 1, std::atoi( argv[ ++i ] ) ) );
+        }
+        else if( option == "--sim-threads" )
+        {
+            sim_threads = static_cast< std::size_t >( std::max( 0, std::atoi( argv[ ++i ] ) ) );
+        }
+        else if( option == "--worlds" )
+        {
+            world_count = static_cast< std::size_t >( std::max( 1, std::atoi( argv[ ++i ] ) ) );
+        }
+        else if( option == "--log-level" )
+        {
+            auto level = robot::src::logging::parseLogLevel( argv[ ++i ] );
+            if( !level )
+            {
+                std::cerr << "Unknown log level " << argv[ i ] << std::endl;
+                return 1;
+            }
+            robot::src::logging::defaultLogger().set_level( *level );
+        }
+        else if( option == "--ticks" )
+        {
+            headless_options.ticks = std::strtoull( argv[ ++i ], nullptr, 10 );
+        }
+        else if( option == "--key" )
+        {
+            headless_options.key = argv[ ++i ];
+        }
+        else if( option == "--assets" )
+        {
+            headless_options.num_assets = static_cast< std::size_t >( std::max( 0, std::atoi( argv[ ++i ] ) ) );
+        }
+        else if( option == "--replay" )
+        {
+            replay_path = argv[ ++i ];
+        }
+        else if( option == "--record" )
+        {
+            record_path = argv[ ++i ];
+        }
+        else if( option == "--load" )
+        {
+            load_path = argv[ ++i ];
+        }
+        else if( option == "--checkpoint" )
+        {
+            checkpoint_path = argv[ ++i ];
+        }
+        else if( option == "--checkpoint-every" )
+        {
+            checkpoint_interval = std::strtoull( argv[ ++i ], nullptr, 10 );
+        }
+    }
+
+    if( !sim_threads )
+    {
+        sim_threads = world_count > 1 ? 0 : robot::src::job_system::defaultWorkerCount();
+    }
+    int status = 0;
+    if( headless )
+    {
+        headless_options.sim_threads = *sim_threads;
+        headless_options.load_path = load_path;
+        headless_options.checkpoint_path = checkpoint_path;
+        headless_options.checkpoint_interval = checkpoint_interval;
+        status = runHeadlessCommand( std::move( headless_options ), replay_path, record_path );
+    }
+    else
+    {
+        robot::src::mainloop::runMainloop( stop_source, rest_threads, *sim_threads, record_path, load_path,
+                                           checkpoint_path, checkpoint_interval, world_count );
+    }
 
     std::cout << "Robot application exiting." << std::endl;
 
-    return 0;
-}
\ No newline at end of file
+    return status;
+}
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "loadgen.hpp"
+
+/// @brief Milliseconds, to two decimals, of a latency.
+double milliseconds( std::chrono::nanoseconds duration )
+{
+    return static_cast< double >( duration.count() / 10'000 ) / 100.0;
+}
+
+int main( int argc, char* argv[] )
+{
+    namespace lg = robot::src::loadgen;
+
+    // --host HOST and --port PORT name the running robot server (127.0.0.1:8080 by default),
+    // --world N loads world N under /worlds/N/ instead of the unprefixed routes,
+    // --pollers N opens N connections polling /output?since= back to back (or every --poll-interval MS),
+    // --streams N opens N /stream WebSocket subscribers,
+    // --writers N opens N connections each posting --input-rate HZ inputs to /input,
+    // --duration S runs the load for S seconds, and --threads N runs the clients on N threads.
+    lg::LoadOptions options;
+    for( int i = 1; i + 1 < argc; ++i )
+    {
+        auto option = std::string_view( argv[ i ] );
+        if( option == "--host" )
+        {
+            options.host = argv[ ++i ];
+        }
+        else if( option == "--port" )
+        {
+            options.port = argv[ ++i ];
+        }
+        else if( option == "--world" )
+        {
+            options.world = static_cast< std::size_t >( std::max( 0, std::atoi( argv[ ++i ] ) ) );
+        }
+        else if( option == "--pollers" )
+        {
+            options.pollers = static_cast< std::size_t >( std::max( 0, std::atoi( argv[ ++i ] ) ) );
+        }
+        else if( option == "--streams" )
+        {
+            options.streams = static_cast< std::size_t >( std::max( 0, std::atoi( argv[ ++i ] ) ) );
+        }
+        else if( option == "--writers" )
+        {
+            options.writers = static_cast< std::size_t >( std::max( 0, std::atoi( argv[ ++i ] ) ) );
+        }
+        else if( option == "--input-rate" )
+        {
+            options.input_rate = std::max( 0.0, std::atof( argv[ ++i ] ) );
+        }
+        else if( option == "--poll-interval" )
+        {
+            options.poll_interval = std::chrono::milliseconds( std::max( 0, std::atoi( argv[ ++i ] ) ) );
+        }
+        else if( option == "--duration" )
+        {
+            options.duration = std::chrono::milliseconds(
+                static_cast< long long >( std::max( 0.0, std::atof( argv[ ++i ] ) ) * 1000.0 ) );
+        }
+        else if( option == "--threads" )
+        {
+            options.threads = static_cast< unsigned int >( std::max( 1, std::atoi( argv[ ++i ] ) ) );
+        }
+    }
+
+    std::cout << "Loading " << options.host << ":" << options.port
+              << ( options.world ? "/worlds/" + std::to_string( *options.world ) + "/" : "/" ) << " with "
+              << options.pollers << " pollers, " << options.streams << " stream subscribers and " << options.writers
+              << " writers at " << options.input_rate << " inputs/s for "
+              << std::chrono::duration< double >( options.duration ).count() << " s..." << std::endl;
+
+    lg::LoadReport report;
+    try
+    {
+        report = lg::runLoad( options );
+    }
+    catch( const std::exception & e )
+    {
+        std::cerr << "Cannot load " << options.host << ":" << options.port << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    auto seconds = std::max( 1e-9, std::chrono::duration< double >( report.elapsed ).count() );
+    auto per_second = [ & ]( std::uint64_t count ) { return static_cast< double >( count ) / seconds; };
+    std::cout << "Output: " << report.outputs << " responses (" << per_second( report.outputs ) << "/s, "
+              << per_second( report.output_bytes ) / 1e6 << " MB/s)" << std::endl;
+    std::cout << "Stream: " << report.frames << " frames (" << per_second( report.frames ) << "/s, "
+              << per_second( report.frame_bytes ) / 1e6 << " MB/s)" << std::endl;
+    std::cout << "Input: " << report.inputs << " accepted (" << per_second( report.inputs ) << "/s), "
+              << report.inputs_rejected << " rejected as queue full, " << report.errors << " errors" << std::endl;
+
+    const auto & latency = report.input_latency;
+    std::cout << "Input to visible: " << latency.latencies.size() << " seen, " << latency.unseen << " unseen";
+    if( !latency.latencies.empty() )
+    {
+        std::cout << ", p50 " << milliseconds( lg::percentile( latency.latencies, 0.50 ) ) << " ms, p99 "
+                  << milliseconds( lg::percentile( latency.latencies, 0.99 ) ) << " ms, p999 "
+                  << milliseconds( lg::percentile( latency.latencies, 0.999 ) ) << " ms, max "
+                  << milliseconds( latency.latencies.back() ) << " ms";
+    }
+    std::cout << std::endl;
+
+    if( auto rate = report.overrun_rate() )
+    {
+        std::cout << "Server: " << *report.ticks << " ticks (" << *report.ticks / seconds << "/s), "
+                  << *report.overruns << " overruns (" << *rate * 100.0 << "% of ticks)" << std::endl;
+    }
+    else
+    {
+        std::cout << "Server: tick counters unavailable from /metrics" << std::endl;
+    }
+    return report.errors > 0 ? 2 : 0;
+}
@@ -0,0 +1,144 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "math.hpp"
+
+/// @file scene_codec.hpp
+/// @brief Low-level writers for the scene wire formats.
+///
+/// ScenePacket (scene_packet.hpp) decides what goes on the wire; the writers here
+/// only append encoded values to a caller-owned std::string. Neither writer
+/// builds an intermediate document or allocates beyond growing that string, so
+/// a buffer reused across frames stops allocating once it has reached the
+/// largest frame size.
+
+namespace robot::src::detail::scene_codec::inline exports
+{
+/// @brief Wire formats a viewer can ask for.
+enum class SceneFormat
+{
+    json, ///< Text, see ScenePacket::write_json()
+    binary ///< Little-endian 32-bit words, see ScenePacket::write_binary()
+};
+
+inline constexpr std::uint32_t SCENE_BINARY_MAGIC = 0x32534252; ///< "RBS2" when read as bytes
+inline constexpr std::uint32_t SCENE_BINARY_KEYFRAME = 1; ///< Binary update type of a keyframe
+inline constexpr std::uint32_t SCENE_BINARY_DELTA = 2; ///< Binary update type of a delta
+inline constexpr std::size_t SCENE_BINARY_HEADER_WORDS = 12; ///< 32-bit words before the first section
+inline constexpr std::uint32_t SCENE_BINARY_HAS_POSITION = 1; ///< Spawn flag: the entity has a position
+inline constexpr std::uint32_t SCENE_BINARY_INSTANCE = 2; ///< Spawn flag: the entity instances a shape
+
+/// @brief Writes consecutive little-endian 32-bit words into a byte buffer.
+///
+/// The buffer must already be large enough; the writer does no bounds checks.
+class WordWriter
+{
+private:
+    char * at_;
+
+public:
+    explicit WordWriter( char * at )
+        : at_( at )
+    {}
+
+    void put( std::uint32_t word ) noexcept
+    {
+        if constexpr( std::endian::native == std::endian::big )
+        {
+            word = ( word >> 24 ) | ( ( word >> 8 ) & 0xff00 ) | ( ( word << 8 ) & 0xff0000 ) | ( word << 24 );
+        }
+        std::memcpy( at_, &word, sizeof( word ) );
+        at_ += sizeof( word );
+    }
+
+    void put( float value ) noexcept
+    {
+        put( std::bit_cast< std::uint32_t >( value ) );
+    }
+
+    void put( Vec2 value ) noexcept
+    {
+        put( value.x );
+        put( value.y );
+    }
+
+    void put( const Transform2D & transform ) noexcept
+    {
+        put( transform.translation );
+        put( transform.rotationRadians );
+        put( transform.scale );
+    }
+};
+
+/// @brief Appends JSON tokens to a string.
+///
+/// Numbers are formatted with std::to_chars, which gives the shortest text that
+/// round-trips a float; non-finite values are written as null since JSON has no
+/// representation for them. Structure (braces, keys, commas) is written with
+/// raw(), so callers are responsible for producing well-formed output.
+class JsonWriter
+{
+private:
+    std::string & out_;
+
+public:
+    explicit JsonWriter( std::string & out )
+        : out_( out )
+    {}
+
+    /// @brief Append text verbatim.
+    JsonWriter & raw( std::string_view text )
+    {
+        out_.append( text );
+        return *this;
+    }
+
+    /// @brief Append a single character verbatim.
+    JsonWriter & raw( char c )
+    {
+        out_.push_back( c );
+        return *this;
+    }
+
+    /// @brief Append a float in shortest round-trip form.
+    JsonWriter & number( float value )
+    {
+        if( !std::isfinite( value ) )
+        {
+            return raw( "null" );
+        }
+        char text[ 32 ];
+        auto result = std::to_chars( text, text + sizeof( text ), value );
+        out_.append( text, result.ptr );
+        return *this;
+    }
+
+    /// @brief Append an unsigned integer.
+    JsonWriter & number( std::uint64_t value )
+    {
+        char text[ 24 ];
+        auto result = std::to_chars( text, text + sizeof( text ), value );
+        out_.append( text, result.ptr );
+        return *this;
+    }
+
+    /// @brief Append a point as a two-element array.
+    JsonWriter & point( float x, float y )
+    {
+        return raw( '[' ).number( x ).raw( ',' ).number( y ).raw( ']' );
+    }
+};
+} // namespace robot::src::detail::scene_codec::inline exports
+
+namespace robot::src::inline exports::inline scene_codec
+{
+using namespace detail::scene_codec::exports;
+}
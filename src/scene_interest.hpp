@@ -0,0 +1,262 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "math.hpp"
+#include "scene_snapshot.hpp"
+
+/// @file scene_interest.hpp
+/// @brief Interest management: which geometries a viewer with a viewport is sent.
+///
+/// A viewer that declares a viewport only holds the geometries that were inside
+/// it (plus a margin) when it was last sent an update. On each update, the
+/// snapshot's spatial index is queried for the viewport, and the result is
+/// compared with what the viewer holds. Geometries that came into view are
+/// spawned in full, those still in view have their moves sent, and those that
+/// left the view or the world are despawned. Because this depends on what this
+/// viewer was sent, a SceneInterest belongs to one connection. A request whose
+/// `since` does not match the interest's last update gets a keyframe of the view.
+
+namespace robot::src::detail::scene_interest::inline exports
+{
+/// @brief Distance around a viewport within which geometries are still sent, in world units.
+///
+/// Keeps geometries that sit on the edge of the view from being despawned and
+/// respawned as they jitter across it, and covers a frame or two of scrolling.
+inline constexpr Float DEFAULT_VIEW_MARGIN = 10.0f;
+
+/// @brief Grow a box by a margin on every side.
+inline AxisAlignedBoundingBox expandBox( const AxisAlignedBoundingBox & box, Float margin ) noexcept
+{
+    return { { box.min.x - margin, box.min.y - margin }, { box.max.x + margin, box.max.y + margin } };
+}
+
+/// @brief Whether a viewport sent by a client can be queried: every bound finite, and none inverted.
+inline bool isValidViewport( const AxisAlignedBoundingBox & box ) noexcept
+{
+    return std::isfinite( box.min.x ) && std::isfinite( box.min.y ) && std::isfinite( box.max.x )
+           && std::isfinite( box.max.y ) && box.min.x <= box.max.x && box.min.y <= box.max.y;
+}
+
+/// @brief Whether a view margin sent by a client is usable: finite and not negative.
+inline bool isValidViewMargin( Float margin ) noexcept
+{
+    return std::isfinite( margin ) && margin >= 0.0f;
+}
+
+/// @brief Move a viewport onto a wrapping world without changing what it covers.
+///
+/// Along each axis, a box at least as wide as the world becomes the whole
+/// axis, and any other box is shifted by whole world widths so that its
+/// minimum lies inside the world. Queries then only see coordinates within
+/// two world widths of the origin, however far off the client's box was;
+/// an infinite extent, as a huge margin can produce, covers the whole axis.
+///
+/// @param box Viewport with margin; its width may be infinite but not NaN.
+/// @param world Bounds of the wrapping world.
+inline AxisAlignedBoundingBox wrapViewToWorld( const AxisAlignedBoundingBox & box,
+                                               const AxisAlignedBoundingBox & world ) noexcept
+{
+    auto fold = []( Float min, Float max, Float world_min, Float world_max, Float & out_min, Float & out_max ) {
+        Float size = world_max - world_min;
+        Float width = max - min;
+        if( !( width < size ) )
+        {
+            out_min = world_min;
+            out_max = world_max;
+            return;
+        }
+        // fmod is exact, so the shifted box keeps its width
+        Float offset = std::fmod( min - world_min, size );
+        out_min = world_min + ( offset < 0.0f ? offset + size : offset );
+        out_max = out_min + width;
+    };
+    AxisAlignedBoundingBox out;
+    fold( box.min.x, box.max.x, world.min.x, world.max.x, out.min.x, out.max.x );
+    fold( box.min.y, box.max.y, world.min.y, world.max.y, out.min.y, out.max.y );
+    return out;
+}
+
+/// @brief Parse a viewport given as "min_x,min_y,max_x,max_y".
+/// @param text Four comma-separated numbers, as in `/output?view=-50,-30,50,30`.
+/// @return The viewport, or an empty optional if the text is malformed, a bound is not finite or the box is inverted.
+inline std::optional< AxisAlignedBoundingBox > parseViewport( std::string_view text )
+{
+    Float values[ 4 ];
+    for( std::size_t i = 0; i < 4; ++i )
+    {
+        auto result = std::from_chars( text.data(), text.data() + text.size(), values[ i ] );
+        if( result.ec != std::errc{} )
+        {
+            return std::nullopt;
+        }
+        text.remove_prefix( static_cast< std::size_t >( result.ptr - text.data() ) );
+        if( i < 3 )
+        {
+            if( text.empty() || text.front() != ',' )
+                return std::nullopt;
+            text.remove_prefix( 1 );
+        }
+    }
+    AxisAlignedBoundingBox box{ { values[ 0 ], values[ 1 ] }, { values[ 2 ], values[ 3 ] } };
+    if( !text.empty() || !isValidViewport( box ) )
+    {
+        return std::nullopt;
+    }
+    return box;
+}
+
+/// @class SceneInterest
+/// @brief What one viewer holds of the scene, and what its next update must change.
+///
+/// @par Example usage:
+/// @code
+/// SceneInterest interest;                                   // one per connection
+/// interest.select( *snapshot, expandBox( view, DEFAULT_VIEW_MARGIN ), since );
+/// ScenePacket{ snapshot, since, &interest }.write_json( out ); // sends only the selection
+/// @endcode
+///
+/// Every buffer is kept between updates, so a viewer whose view holds a steady
+/// number of geometries stops allocating after the first few updates.
+class SceneInterest
+{
+private:
+    static constexpr std::uint32_t NOT_HELD = std::numeric_limits< std::uint32_t >::max();
+
+    std::vector< std::uint32_t > held_generations_; ///< Generation the viewer holds per entity id, or NOT_HELD
+    std::vector< std::uint64_t > seen_; ///< Selection in which each entity id was last in view
+    std::vector< std::size_t > held_; ///< Entity ids the viewer holds
+    std::vector< std::size_t > visible_; ///< Geometry indices found in the view by the last selection
+    std::vector< std::size_t > spawns_;
+    std::vector< std::size_t > moves_;
+    std::vector< std::size_t > despawns_;
+    std::uint64_t selection_ = 0;
+    std::uint64_t tick_ = 0;
+    bool keyframe_ = true;
+
+    void forget()
+    {
+        for( auto entity : held_ )
+        {
+            held_generations_[ entity ] = NOT_HELD;
+        }
+        held_.clear();
+    }
+
+public:
+    /// @brief Work out the update that brings the viewer from `since` to a snapshot.
+    ///
+    /// Afterwards the interest holds the snapshot's geometries in view, as the
+    /// viewer will once it applies the update.
+    ///
+    /// @param snapshot Snapshot the update is taken from.
+    /// @param view World-space region to send, margin included; any finite box, which wraps like the world.
+    /// @param since Last tick the viewer has applied; the update is a keyframe
+    ///              unless it is the tick of the previous selection.
+    void select( const SceneSnapshot & snapshot, const AxisAlignedBoundingBox & view, std::uint64_t since )
+    {
+        keyframe_ = since == 0 || since != tick_ || !snapshot.can_delta_from( since );
+        if( keyframe_ )
+        {
+            forget();
+        }
+        spawns_.clear();
+        moves_.clear();
+        despawns_.clear();
+        ++selection_;
+
+        // Client viewports may lie far outside the world; the grid only takes coordinates near it
+        snapshot.index.query( wrapViewToWorld( view, snapshot.index.bounds() ), visible_ );
+        for( auto slot : visible_ )
+        {
+            auto entity = snapshot.entities[ slot ];
+            if( entity >= held_generations_.size() )
+            {
+                held_generations_.resize( entity + 1, NOT_HELD );
+                seen_.resize( entity + 1, 0 );
+            }
+            seen_[ entity ] = selection_;
+            auto generation = snapshot.generations[ slot ];
+            if( held_generations_[ entity ] == generation && snapshot.spawn_ticks[ slot ] <= since )
+            {
+                if( snapshot.move_ticks[ slot ] > since )
+                {
+                    moves_.push_back( slot );
+                }
+                continue;
+            }
+            // New to the viewer, a recycled id, or re-shaped since the viewer's tick
+            if( held_generations_[ entity ] == NOT_HELD )
+            {
+                held_.push_back( entity );
+            }
+            held_generations_[ entity ] = generation;
+            spawns_.push_back( slot );
+        }
+
+        // Whatever the viewer holds that is out of view, or gone from the world, is removed
+        std::erase_if( held_, [ this ]( std::size_t entity ) {
+            if( seen_[ entity ] == selection_ )
+            {
+                return false;
+            }
+            held_generations_[ entity ] = NOT_HELD;
+            despawns_.push_back( entity );
+            return true;
+        } );
+        tick_ = snapshot.tick;
+    }
+
+    /// @brief Forget what the viewer holds, so the next selection is a keyframe.
+    void reset()
+    {
+        forget();
+        tick_ = 0;
+    }
+
+    /// @brief Whether the last selection replaces the viewer's scene.
+    bool keyframe() const noexcept
+    {
+        return keyframe_;
+    }
+
+    /// @brief Tick of the snapshot last selected from, or 0 if none.
+    std::uint64_t tick() const noexcept
+    {
+        return tick_;
+    }
+
+    /// @brief Geometry indices to send in full, in ascending order.
+    const std::vector< std::size_t > & spawns() const noexcept
+    {
+        return spawns_;
+    }
+
+    /// @brief Geometry indices whose position alone is sent, in ascending order.
+    const std::vector< std::size_t > & moves() const noexcept
+    {
+        return moves_;
+    }
+
+    /// @brief Entity ids the viewer must remove.
+    const std::vector< std::size_t > & despawns() const noexcept
+    {
+        return despawns_;
+    }
+};
+} // namespace robot::src::detail::scene_interest::inline exports
+
+namespace robot::src::inline exports::inline scene_interest
+{
+using namespace detail::scene_interest::exports;
+}
@@ -1,88 +1,412 @@
 static_assert( __cplusplus > 2020'00 );
 #pragma once
 
-#include <boost/json.hpp>
+#include <cstdint>
+#include <memory>
+#include <ostream>
 #include <string>
-#include <tuple>
-#include <vector>
+
+#include "scene_codec.hpp"
+#include "scene_interest.hpp"
+#include "scene_snapshot.hpp"
 
 namespace robot::src::detail::scene_packet::inline exports
 {
+/// @brief The scene as it is sent to one viewer.
+///
+/// A packet pairs a published snapshot with the last tick the viewer has
+/// applied, and decides from the snapshot's version information which
+/// geometries go on the wire. Every encoding served by /output and /stream is
+/// produced from a packet, so the keyframe/delta rules live in one place:
+///
+/// - keyframe(): the viewer has nothing usable (since is 0, or older than the
+///   snapshot's history horizon), so every geometry is spawned and the viewer
+///   drops whatever it had;
+/// - otherwise a delta from `since`: ids despawned after it, geometries spawned
+///   or re-shaped after it, and positions changed after it.
+///
+/// Shapes shared by several entities travel in their own section: all of them
+/// in a keyframe, and in a delta only those registered or changed after
+/// `since`. An entity that instances a shape is spawned with the shape id and
+/// its instance transform instead of vertices.
+///
+/// Viewers apply shapes, then despawn, then spawn, then move. The geometry is sent in the
+/// robot's own coordinate system; the client does the flip and scaling into
+/// canvas space, so the per-frame work here is copying numbers only.
+///
+/// A packet may instead be culled to a viewport by a SceneInterest. Its
+/// selection then decides what is spawned, moved and despawned, and the packet
+/// is a keyframe exactly when the selection is. Shapes are not culled; the
+/// table is small and shared by every instance.
+///
+/// The writers append straight into a caller-owned string with no intermediate
+/// document, so a buffer kept per session stops allocating once it has grown to
+/// the largest frame.
 struct ScenePacket
 {
-    // This is a simple struct that will be serialized to JSON and sent to
-    // the client.  It contains the necessary information for rendering the
-    // scene, such as the positions and shapes of entities. For simplicity,
-    // we'll just include polygons with their positions.
-
-    // N.b. The geometry here is meant to be rendered by an HTML canvas, so
-    // we must do the necessary transformations to convert from the robot's
-    // coordinate system to the canvas coordinate system on the client side.
-    // This includes flipping the y-axis and applying any necessary scaling.
-    // Then, we store just the raw polygon drawing instructions. This way,
-    // the client can be really dumb and just render the polygons as they
-    // are without needing to understand the robot's coordinate system.
-
-    // We need to store the stroke width and color, as well as the fill
-    // color for each polygon, followed by the vertex list. The client will
-    // use the stroke color and width to draw the outline of the polygon,
-    // and the fill color to fill it in. This allows for more flexible
-    // rendering on the client side, as different entities can have
-    // different visual styles.
-
-    std::vector< std::tuple< float, std::string, std::string, std::vector< std::pair< float, float > > > > geometries;
-
-    /// @brief Add a polygon to the scene packet.
-    /// @param stroke_width Width of the polygon's outline.
-    /// @param stroke_color Color of the polygon's outline (e.g., "#FF0000" for red).
-    /// @param fill_color Color to fill the polygon (e.g., "#00FF00" for green).
-    /// @param vertices List of (x, y) vertex coordinates for the polygon.
-    void add_polygon(
-        float stroke_width,
-        std::string stroke_color,
-        std::string fill_color,
-        std::vector< std::pair< float, float > > vertices )
-    {
-        geometries.emplace_back( stroke_width, stroke_color, fill_color, std::move( vertices ) );
-    }
-
-    /// @brief Serialize the scene packet to a JSON string.
-    /// @return JSON string representation of the scene packet.
-    std::string to_json() const
+    /// @brief Version of the keyframe/delta protocol written by write_json() and write_binary().
+    static constexpr std::uint64_t PROTOCOL_VERSION = 2;
+
+    std::shared_ptr< const SceneSnapshot > snapshot; ///< Snapshot to send; null means an empty scene
+    std::uint64_t since = 0; ///< Last tick the viewer has applied, or 0 if it has nothing
+    /// Selection made by SceneInterest::select() for this snapshot and since, or null to send the whole scene
+    const SceneInterest * interest = nullptr;
+
+    /// @brief Input commands applied by the packet's tick; see SceneSnapshot::inputs.
+    std::uint64_t inputs() const noexcept
+    {
+        return snapshot ? snapshot->inputs : 0;
+    }
+
+    /// @brief Whether the packet replaces the viewer's scene instead of updating it.
+    bool keyframe() const noexcept
+    {
+        if( interest && snapshot )
+        {
+            return interest->keyframe();
+        }
+        return !snapshot || !snapshot->can_delta_from( since );
+    }
+
+    /// @brief Tick the packet brings the viewer to.
+    std::uint64_t tick() const noexcept
+    {
+        return snapshot ? snapshot->tick : 0;
+    }
+
+    /// @brief Whether geometry i is sent in full.
+    bool spawns( std::size_t i ) const noexcept
+    {
+        return keyframe() || snapshot->spawn_ticks[ i ] > since;
+    }
+
+    /// @brief Whether shape s of the snapshot's shape table is sent.
+    bool sends_shape( ShapeId s ) const noexcept
+    {
+        return keyframe() || snapshot->shape_ticks[ s ] > since;
+    }
+
+    /// @brief Whether only the position of geometry i is sent.
+    bool moves( std::size_t i ) const noexcept
+    {
+        return !spawns( i ) && snapshot->move_ticks[ i ] > since;
+    }
+
+    /// @brief Call fn(i) for every geometry index sent in full, in ascending order.
+    template < typename Fn >
+    void for_each_spawn( Fn && fn ) const
     {
-        // We'll use Boost.JSON to serialize the scene packet to JSON. The structure will be:
-        // {
-        //   "geometries": [
-        //     {
-        //       "stroke_width": 2.0,
-        //       "stroke_color": "#FF0000",
-        //       "fill_color": "#00FF00",
-        //       "vertices": [[0, 0], [1, 0], [1, 1], [0, 1]]
-        //     },
-        //     ...
-        //   ]
-        // }
-        boost::json::object scene;
-        boost::json::array geometries_json;
-
-        for( const auto & [ stroke_width, stroke_color, fill_color, vertices ] : geometries )
-        {
-            boost::json::object geo;
-            geo[ "stroke_width" ] = stroke_width;
-            geo[ "stroke_color" ] = stroke_color;
-            geo[ "fill_color" ] = fill_color;
-
-            boost::json::array vertices_json;
-            for( const auto & [ x, y ] : vertices )
+        if( interest && snapshot )
+        {
+            for( auto i : interest->spawns() )
+                fn( i );
+            return;
+        }
+        for( std::size_t i = 0; snapshot && i < snapshot->size(); ++i )
+        {
+            if( spawns( i ) )
+                fn( i );
+        }
+    }
+
+    /// @brief Call fn(i) for every geometry index whose position alone is sent, in ascending order.
+    template < typename Fn >
+    void for_each_move( Fn && fn ) const
+    {
+        if( keyframe() )
+        {
+            return;
+        }
+        if( interest )
+        {
+            for( auto i : interest->moves() )
+                fn( i );
+            return;
+        }
+        for( std::size_t i = 0; i < snapshot->size(); ++i )
+        {
+            if( moves( i ) )
+                fn( i );
+        }
+    }
+
+    /// @brief Call fn(entity) for every entity the viewer must remove.
+    template < typename Fn >
+    void for_each_despawn( Fn && fn ) const
+    {
+        if( keyframe() )
+        {
+            return;
+        }
+        if( interest )
+        {
+            for( auto entity : interest->despawns() )
+                fn( entity );
+            return;
+        }
+        for( auto [ entity, tick ] : snapshot->despawns )
+        {
+            if( tick > since )
             {
-                vertices_json.push_back( boost::json::array{ x, y } );
+                fn( entity );
             }
-            geo[ "vertices" ] = vertices_json;
+        }
+    }
 
-            geometries_json.push_back( geo );
+    /// @brief Append the update as JSON.
+    ///
+    /// A keyframe is {"version":2,"type":"keyframe","tick":t,"inputs":n,"shapes":[shape,...],"spawn":[entity,...]};
+    /// a delta is {"version":2,"type":"delta","base":since,"tick":t,"inputs":n,"shapes":[shape,...],
+    /// "despawn":[id,...],"spawn":[entity,...],"move":[[id,x,y],...]}. Each shape is
+    /// {"shape":s,"vertices":[[x,y],...]}; each entity is either
+    /// {"id":id,"vertices":[[x,y],...],"position":[x,y]} or
+    /// {"id":id,"shape":s,"transform":[tx,ty,rotation,sx,sy],"position":[x,y]},
+    /// and position is omitted when absent. inputs counts the input commands applied
+    /// by tick t, so a client that was told its input's sequence number by POST /input
+    /// can tell which frame first shows it.
+    ///
+    /// @param out Buffer to append to.
+    void write_json( std::string & out ) const
+    {
+        JsonWriter json( out );
+        bool is_keyframe = keyframe();
+        json.raw( R"({"version":)" ).number( PROTOCOL_VERSION );
+        json.raw( is_keyframe ? R"(,"type":"keyframe")" : R"(,"type":"delta","base":)" );
+        if( !is_keyframe )
+        {
+            json.number( since );
+        }
+        json.raw( R"(,"tick":)" ).number( tick() ).raw( R"(,"inputs":)" ).number( inputs() );
+
+        json.raw( R"(,"shapes":[)" );
+        const char * separator = "";
+        for( ShapeId s = 0; snapshot && s < snapshot->shape_count(); ++s )
+        {
+            if( sends_shape( s ) )
+            {
+                json.raw( separator ).raw( R"({"shape":)" ).number( std::uint64_t{ s } ).raw( R"(,"vertices":[)" );
+                for( auto v = snapshot->shape_offsets[ s ]; v < snapshot->shape_offsets[ s + 1 ]; ++v )
+                {
+                    json.raw( v == snapshot->shape_offsets[ s ] ? "" : "," );
+                    json.point( snapshot->shape_vertices_x[ v ], snapshot->shape_vertices_y[ v ] );
+                }
+                json.raw( "]}" );
+                separator = ",";
+            }
         }
-        scene[ "geometries" ] = geometries_json;
-        return boost::json::serialize( scene );
+        json.raw( ']' );
+
+        if( !is_keyframe )
+        {
+            json.raw( R"(,"despawn":[)" );
+            separator = "";
+            for_each_despawn( [ & ]( std::size_t entity ) {
+                json.raw( separator ).number( std::uint64_t{ entity } );
+                separator = ",";
+            } );
+            json.raw( ']' );
+        }
+
+        json.raw( R"(,"spawn":[)" );
+        separator = "";
+        for_each_spawn( [ & ]( std::size_t i ) {
+            json.raw( separator );
+            write_entity_json( json, i, true );
+            separator = ",";
+        } );
+        json.raw( ']' );
+
+        if( !is_keyframe )
+        {
+            json.raw( R"(,"move":[)" );
+            separator = "";
+            for_each_move( [ & ]( std::size_t i ) {
+                auto position = snapshot->positions[ i ];
+                json.raw( separator ).raw( '[' ).number( std::uint64_t{ snapshot->entities[ i ] } );
+                json.raw( ',' ).number( position.x ).raw( ',' ).number( position.y ).raw( ']' );
+                separator = ",";
+            } );
+            json.raw( ']' );
+        }
+        json.raw( '}' );
+    }
+
+    /// @brief Append the whole scene in the unversioned format of plain /output.
+    ///
+    /// {"geometries":[{"vertices":[[x,y],...],"position":[x,y]},...]}, without entity ids.
+    /// Instanced shapes are written out as vertices of their own. `since` is ignored;
+    /// with an interest, the geometries it selected for spawning are written.
+    ///
+    /// @param out Buffer to append to.
+    void write_geometries_json( std::string & out ) const
+    {
+        JsonWriter json( out );
+        json.raw( R"({"geometries":[)" );
+        const char * separator = "";
+        auto write = [ & ]( std::size_t i ) {
+            json.raw( separator );
+            write_entity_json( json, i, false );
+            separator = ",";
+        };
+        if( interest )
+        {
+            for_each_spawn( write );
+        }
+        else
+        {
+            for( std::size_t i = 0; snapshot && i < snapshot->size(); ++i )
+                write( i );
+        }
+        json.raw( "]}" );
+    }
+
+    /// @brief Overwrite a buffer with the update in the binary format.
+    ///
+    /// The buffer is a sequence of little-endian 32-bit words, so a browser can wrap
+    /// it in a Uint32Array and a Float32Array without copying. The header is
+    /// [magic, type, tick_lo, tick_hi, base_lo, base_hi, despawns, spawns, moves, vertices,
+    /// shapes, shape_vertices]. It is followed by these sections:
+    /// - despawned ids (u32 × despawns)
+    /// - spawned ids (u32 × spawns)
+    /// - spawned flags (u32 × spawns), SCENE_BINARY_HAS_POSITION | SCENE_BINARY_INSTANCE
+    /// - spawned shape ids (u32 × spawns), NO_SHAPE unless instanced
+    /// - spawned instance transforms (f32 tx,ty,rotation,sx,sy × spawns)
+    /// - spawned vertex offsets (u32 × (spawns + 1)), empty ranges for instances
+    /// - spawned positions (f32 x,y × spawns)
+    /// - spawned vertices (f32 x,y × vertices)
+    /// - moved ids (u32 × moves)
+    /// - moved positions (f32 x,y × moves)
+    /// - shape ids (u32 × shapes)
+    /// - shape vertex offsets (u32 × (shapes + 1))
+    /// - shape vertices (f32 x,y × shape_vertices)
+    ///
+    /// A keyframe has type SCENE_BINARY_KEYFRAME, base 0 and no despawns or moves.
+    ///
+    /// @param out Buffer to overwrite; its capacity is reused between calls.
+    void write_binary( std::string & out ) const
+    {
+        bool is_keyframe = keyframe();
+        std::uint32_t despawn_count = 0, spawn_count = 0, move_count = 0, vertex_count = 0;
+        std::uint32_t shape_count = 0, shape_vertex_count = 0;
+        for_each_despawn( [ & ]( std::size_t ) { ++despawn_count; } );
+        for_each_spawn( [ & ]( std::size_t i ) {
+            ++spawn_count;
+            vertex_count += snapshot->vertex_offsets[ i + 1 ] - snapshot->vertex_offsets[ i ];
+        } );
+        for_each_move( [ & ]( std::size_t ) { ++move_count; } );
+        for( ShapeId s = 0; snapshot && s < snapshot->shape_count(); ++s )
+        {
+            if( sends_shape( s ) )
+            {
+                ++shape_count;
+                shape_vertex_count += snapshot->shape_offsets[ s + 1 ] - snapshot->shape_offsets[ s ];
+            }
+        }
+
+        std::size_t words = SCENE_BINARY_HEADER_WORDS + despawn_count + spawn_count * 11 + 1 + vertex_count * 2
+                            + move_count * 3 + shape_count * 2 + 1 + shape_vertex_count * 2;
+        out.resize( words * sizeof( std::uint32_t ) );
+
+        // One cursor per section, so each section is filled in a single pass
+        char * base = out.data();
+        auto section = [ & ]( std::size_t word_offset ) {
+            return WordWriter( base + word_offset * sizeof( std::uint32_t ) );
+        };
+        std::size_t offset = SCENE_BINARY_HEADER_WORDS;
+        auto despawn_ids = section( offset );
+        auto spawn_ids = section( offset += despawn_count );
+        auto spawn_flags = section( offset += spawn_count );
+        auto spawn_shapes = section( offset += spawn_count );
+        auto spawn_transforms = section( offset += spawn_count );
+        auto spawn_offsets = section( offset += spawn_count * 5 );
+        auto spawn_positions = section( offset += spawn_count + 1 );
+        auto spawn_vertices = section( offset += spawn_count * 2 );
+        auto move_ids = section( offset += vertex_count * 2 );
+        auto move_positions = section( offset += move_count );
+        auto shape_ids = section( offset += move_count * 2 );
+        auto shape_offsets = section( offset += shape_count );
+        auto shape_vertices = section( offset += shape_count + 1 );
+
+        std::uint64_t base_tick = is_keyframe ? 0 : since;
+        auto header = section( 0 );
+        header.put( SCENE_BINARY_MAGIC );
+        header.put( is_keyframe ? SCENE_BINARY_KEYFRAME : SCENE_BINARY_DELTA );
+        header.put( static_cast< std::uint32_t >( tick() ) );
+        header.put( static_cast< std::uint32_t >( tick() >> 32 ) );
+        header.put( static_cast< std::uint32_t >( base_tick ) );
+        header.put( static_cast< std::uint32_t >( base_tick >> 32 ) );
+        header.put( despawn_count );
+        header.put( spawn_count );
+        header.put( move_count );
+        header.put( vertex_count );
+        header.put( shape_count );
+        header.put( shape_vertex_count );
+
+        for_each_despawn( [ & ]( std::size_t entity ) { despawn_ids.put( static_cast< std::uint32_t >( entity ) ); } );
+
+        std::uint32_t spawn_vertex = 0;
+        spawn_offsets.put( spawn_vertex );
+        for_each_spawn( [ & ]( std::size_t i ) {
+            ShapeId shape = snapshot->shapes[ i ];
+            std::uint32_t flags = snapshot->has_position[ i ] ? SCENE_BINARY_HAS_POSITION : 0;
+            flags |= shape != NO_SHAPE ? SCENE_BINARY_INSTANCE : 0;
+            spawn_ids.put( static_cast< std::uint32_t >( snapshot->entities[ i ] ) );
+            spawn_flags.put( flags );
+            spawn_shapes.put( shape );
+            spawn_transforms.put( snapshot->transforms[ i ] );
+            spawn_positions.put( snapshot->positions[ i ] );
+            for( auto v = snapshot->vertex_offsets[ i ]; v < snapshot->vertex_offsets[ i + 1 ]; ++v )
+            {
+                spawn_vertices.put( snapshot->vertices_x[ v ] );
+                spawn_vertices.put( snapshot->vertices_y[ v ] );
+                ++spawn_vertex;
+            }
+            spawn_offsets.put( spawn_vertex );
+        } );
+        for_each_move( [ & ]( std::size_t i ) {
+            move_ids.put( static_cast< std::uint32_t >( snapshot->entities[ i ] ) );
+            move_positions.put( snapshot->positions[ i ] );
+        } );
+
+        std::uint32_t shape_vertex = 0;
+        shape_offsets.put( shape_vertex );
+        for( ShapeId s = 0; snapshot && s < snapshot->shape_count(); ++s )
+        {
+            if( sends_shape( s ) )
+            {
+                shape_ids.put( s );
+                for( auto v = snapshot->shape_offsets[ s ]; v < snapshot->shape_offsets[ s + 1 ]; ++v )
+                {
+                    shape_vertices.put( snapshot->shape_vertices_x[ v ] );
+                    shape_vertices.put( snapshot->shape_vertices_y[ v ] );
+                    ++shape_vertex;
+                }
+                shape_offsets.put( shape_vertex );
+            }
+        }
+    }
+
+    /// @brief Overwrite a buffer with the update in the requested format.
+    /// @param format Encoding to produce.
+    /// @param out Buffer to overwrite; its capacity is reused between calls.
+    void write( SceneFormat format, std::string & out ) const
+    {
+        if( format == SceneFormat::binary )
+        {
+            write_binary( out );
+            return;
+        }
+        out.clear();
+        write_json( out );
+    }
+
+    /// @brief Serialize the packet to a JSON string.
+    /// @return JSON string representation of the scene packet.
+    std::string to_json() const
+    {
+        std::string out;
+        write_json( out );
+        return out;
     }
 
     /// @brief Define the ostream operator for easy printing of the scene packet.
@@ -94,10 +418,43 @@ struct ScenePacket
         os << packet.to_json();
         return os;
     }
+
+private:
+    void write_entity_json( JsonWriter & json, std::size_t i, bool versioned ) const
+    {
+        json.raw( '{' );
+        if( versioned )
+        {
+            json.raw( R"("id":)" ).number( std::uint64_t{ snapshot->entities[ i ] } ).raw( ',' );
+        }
+        if( versioned && snapshot->shapes[ i ] != NO_SHAPE )
+        {
+            const auto & transform = snapshot->transforms[ i ];
+            json.raw( R"("shape":)" ).number( std::uint64_t{ snapshot->shapes[ i ] } );
+            json.raw( R"(,"transform":[)" ).number( transform.translation.x ).raw( ',' );
+            json.number( transform.translation.y ).raw( ',' ).number( transform.rotationRadians ).raw( ',' );
+            json.number( transform.scale.x ).raw( ',' ).number( transform.scale.y ).raw( ']' );
+        }
+        else
+        {
+            json.raw( R"("vertices":[)" );
+            const char * separator = "";
+            snapshot->for_each_vertex( i, [ & ]( Float x, Float y ) {
+                json.raw( separator ).point( x, y );
+                separator = ",";
+            } );
+            json.raw( ']' );
+        }
+        if( snapshot->has_position[ i ] )
+        {
+            json.raw( R"(,"position":)" ).point( snapshot->positions[ i ].x, snapshot->positions[ i ].y );
+        }
+        json.raw( '}' );
+    }
 };
 } // namespace robot::src::detail::scene_packet::inline exports
 
 namespace robot::src::inline exports::inline scene_packet
 {
 using namespace detail::scene_packet::exports;
-}
\ No newline at end of file
+}
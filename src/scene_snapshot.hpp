@@ -0,0 +1,454 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "broad_phase.hpp"
+#include "component_types.hpp"
+#include "systems.hpp"
+
+/// @file scene_snapshot.hpp
+/// @brief Immutable per-tick copies of the renderable scene for lock-free readers.
+///
+/// After every tick the main loop copies the data viewers need (polygon geometry
+/// and positions) out of the EntityStore into a SceneSnapshot and publishes it
+/// through a SnapshotBuffer. Readers such as the REST server grab the latest
+/// snapshot with a single atomic load and serialize it without ever touching the
+/// store, so the number of connected viewers has no effect on how long a tick
+/// takes.
+///
+/// Snapshots are also versioned so viewers can be sent deltas: every geometry
+/// records the tick it was spawned (or re-shaped) at and the tick its position
+/// last changed, and each snapshot carries a bounded log of recent despawns.
+/// From those, the changes between any tick inside the history window and the
+/// snapshot can be derived without keeping older snapshots alive.
+///
+/// Geometries that instance a shared shape store only the shape id and the
+/// instance transform; the shapes themselves are copied once per snapshot into
+/// a separate table, with the tick each was registered (or changed) at, so a
+/// viewer is sent each shape once rather than with every instance.
+
+namespace robot::src::detail::scene_snapshot::inline exports
+{
+/// @brief Flat, read-only copy of every polygon in the scene at one tick.
+///
+/// Geometry is stored SoA: geometry i owns the vertices in
+/// [vertex_offsets[i], vertex_offsets[i + 1]) of vertices_x / vertices_y. A
+/// geometry that instances a shape owns no vertices; shapes[i] names the shape,
+/// whose vertices are [shape_offsets[s], shape_offsets[s + 1]) of
+/// shape_vertices_x / shape_vertices_y, and transforms[i] places it.
+/// All vectors keep their capacity across capture() calls, so re-capturing into
+/// a recycled snapshot does not allocate once the scene size has settled.
+struct SceneSnapshot
+{
+    /// @brief Number of ticks a viewer may lag behind and still be sent a delta.
+    static constexpr std::uint64_t HISTORY_TICKS = 120;
+
+    /// @brief Marker in entity_slots for entities without a geometry.
+    static constexpr std::uint32_t NO_SLOT = std::numeric_limits< std::uint32_t >::max();
+
+    std::uint64_t tick = 0; ///< Simulation tick the snapshot was taken after
+    std::uint64_t horizon = 0; ///< Oldest tick a delta to this snapshot can start from
+    std::uint64_t inputs = 0; ///< Input commands the world had drained by this tick
+    std::vector< std::size_t > entities; ///< Entity id of each geometry
+    std::vector< Vec2 > positions; ///< World position of each geometry (origin if none)
+    std::vector< std::uint8_t > has_position; ///< Whether each geometry's entity has a Position
+    std::vector< std::uint32_t > vertex_offsets{ 0 }; ///< Start of each geometry's vertices, plus end sentinel
+    std::vector< Float > vertices_x; ///< Local x-coordinates of all vertices
+    std::vector< Float > vertices_y; ///< Local y-coordinates of all vertices
+    std::vector< ShapeId > shapes; ///< Shape each geometry instances, or NO_SHAPE for its own vertices
+    std::vector< Transform2D > transforms; ///< Placement of each instanced shape relative to the position
+    std::vector< std::uint32_t > shape_offsets{ 0 }; ///< Start of each shape's vertices, plus end sentinel
+    std::vector< Float > shape_vertices_x; ///< X-coordinates of all shape vertices, indexed by ShapeId
+    std::vector< Float > shape_vertices_y; ///< Y-coordinates of all shape vertices, indexed by ShapeId
+    std::vector< std::uint64_t > shape_ticks; ///< Tick each shape was registered or changed
+    std::vector< std::uint32_t > generations; ///< Registry generation of each geometry's entity
+    std::vector< std::uint64_t > spawn_ticks; ///< Tick each geometry appeared or changed shape
+    std::vector< std::uint64_t > move_ticks; ///< Tick each geometry's position last changed
+    std::vector< std::uint32_t > entity_slots; ///< Geometry index of each entity id, or NO_SLOT
+    std::vector< std::pair< std::size_t, std::uint64_t > > despawns; ///< (entity, tick) removed after horizon
+    std::vector< AxisAlignedBoundingBox > bounds; ///< World-space bounds of each geometry
+    UniformGrid index{ WORLD_BOUNDS, COLLISION_CELL_SIZE }; ///< Geometry indices bucketed by their bounds
+
+    /// @brief Number of geometries in the snapshot.
+    std::size_t size() const noexcept
+    {
+        return entities.size();
+    }
+
+    /// @brief Remove all geometries while keeping allocated capacity.
+    void clear() noexcept
+    {
+        tick = 0;
+        horizon = 0;
+        inputs = 0;
+        entities.clear();
+        positions.clear();
+        has_position.clear();
+        vertex_offsets.assign( 1, 0 );
+        vertices_x.clear();
+        vertices_y.clear();
+        shapes.clear();
+        transforms.clear();
+        shape_offsets.assign( 1, 0 );
+        shape_vertices_x.clear();
+        shape_vertices_y.clear();
+        shape_ticks.clear();
+        generations.clear();
+        spawn_ticks.clear();
+        move_ticks.clear();
+        entity_slots.clear();
+        despawns.clear();
+        bounds.clear();
+        index.clear();
+        index.build();
+    }
+
+    /// @brief Number of shapes in the shape table.
+    std::size_t shape_count() const noexcept
+    {
+        return shape_ticks.size();
+    }
+
+    /// @brief Call fn(x, y) for each vertex of geometry i relative to its position.
+    ///
+    /// Instanced shapes are passed through their instance transform, so the
+    /// result is the same as if the geometry owned the vertices.
+    template < typename Fn >
+    void for_each_vertex( std::size_t i, Fn && fn ) const
+    {
+        if( shapes[ i ] == NO_SHAPE )
+        {
+            for( auto v = vertex_offsets[ i ]; v < vertex_offsets[ i + 1 ]; ++v )
+            {
+                fn( vertices_x[ v ], vertices_y[ v ] );
+            }
+            return;
+        }
+        // The same composition as ShapeInstance::placement(), which the collision code uses
+        Affine2 transform = transforms[ i ].toAffine();
+        for( auto v = shape_offsets[ shapes[ i ] ]; v < shape_offsets[ shapes[ i ] + 1 ]; ++v )
+        {
+            Vec2 vertex = transform * Vec2{ shape_vertices_x[ v ], shape_vertices_y[ v ] };
+            fn( vertex.x, vertex.y );
+        }
+    }
+
+    /// @brief Geometry index of an entity.
+    /// @param entity Entity id to look up.
+    /// @return Index into the per-geometry arrays, or NO_SLOT if the entity has no geometry.
+    std::uint32_t slot_of( std::size_t entity ) const noexcept
+    {
+        return entity < entity_slots.size() ? entity_slots[ entity ] : NO_SLOT;
+    }
+
+    /// @brief Whether geometry i of this snapshot and geometry j of other have the same shape.
+    ///
+    /// Own vertices are compared vertex by vertex; instances compare equal when
+    /// they place the same shape id with the same transform.
+    bool same_shape( std::size_t i, const SceneSnapshot & other, std::size_t j ) const noexcept
+    {
+        if( shapes[ i ] != other.shapes[ j ] )
+        {
+            return false;
+        }
+        if( shapes[ i ] != NO_SHAPE )
+        {
+            const auto &a = transforms[ i ], &b = other.transforms[ j ];
+            return a.translation.x == b.translation.x && a.translation.y == b.translation.y
+                   && a.rotationRadians == b.rotationRadians && a.scale.x == b.scale.x && a.scale.y == b.scale.y;
+        }
+        return same_vertices( vertex_offsets, vertices_x, vertices_y, i, other.vertex_offsets, other.vertices_x,
+                              other.vertices_y, j );
+    }
+
+    /// @brief Whether shape s has the same vertices in this snapshot's table and in other's.
+    bool same_shape_asset( ShapeId s, const SceneSnapshot & other ) const noexcept
+    {
+        return s < other.shape_count()
+               && same_vertices( shape_offsets, shape_vertices_x, shape_vertices_y, s, other.shape_offsets,
+                                 other.shape_vertices_x, other.shape_vertices_y, s );
+    }
+
+    /// @brief Whether a delta from the given tick to this snapshot can be produced.
+    /// @param since Last tick the viewer has applied; 0 means it has nothing yet.
+    bool can_delta_from( std::uint64_t since ) const noexcept
+    {
+        return since != 0 && since >= horizon && since <= tick;
+    }
+
+    /// @brief Copy the renderable state of a store into this snapshot.
+    ///
+    /// @param store Store to copy from; the caller must hold whatever lock guards it.
+    /// @param tick_number Tick the store has just completed.
+    /// @param previous Snapshot of the preceding tick, used to carry version information
+    ///                 forward; without it every geometry counts as spawned at tick_number.
+    void capture( const EntityStore & store, std::uint64_t tick_number, const SceneSnapshot * previous = nullptr )
+    {
+        clear();
+        tick = tick_number;
+        horizon = tick_number;
+        if( previous != nullptr && previous->tick < tick_number )
+        {
+            horizon = std::max( previous->horizon, tick_number > HISTORY_TICKS ? tick_number - HISTORY_TICKS : 1 );
+        }
+        else
+        {
+            previous = nullptr;
+        }
+
+        shape_offsets.reserve( store.shapes.size() + 1 );
+        shape_ticks.reserve( store.shapes.size() );
+        for( ShapeId s = 0; s < store.shapes.size(); ++s )
+        {
+            const auto & polygon = store.shapes[ s ].polygon;
+            shape_vertices_x.insert( shape_vertices_x.end(), polygon.vertices_x.begin(), polygon.vertices_x.end() );
+            shape_vertices_y.insert( shape_vertices_y.end(), polygon.vertices_y.begin(), polygon.vertices_y.end() );
+            shape_offsets.push_back( static_cast< std::uint32_t >( shape_vertices_x.size() ) );
+            bool unchanged = previous != nullptr && same_shape_asset( s, *previous );
+            shape_ticks.push_back( unchanged ? previous->shape_ticks[ s ] : tick );
+        }
+
+        const auto & polygons = store.get< Polygon >();
+        const auto & instances = store.get< ShapeInstance >();
+        std::size_t count = polygons.size() + instances.size();
+        entities.reserve( count );
+        positions.reserve( count );
+        has_position.reserve( count );
+        vertex_offsets.reserve( count + 1 );
+        shapes.reserve( count );
+        transforms.reserve( count );
+        generations.reserve( count );
+        spawn_ticks.reserve( count );
+        move_ticks.reserve( count );
+        bounds.reserve( count );
+
+        for( auto [ entity, polygon ] : polygons )
+        {
+            vertices_x.insert( vertices_x.end(), polygon.vertices_x.begin(), polygon.vertices_x.end() );
+            vertices_y.insert( vertices_y.end(), polygon.vertices_y.begin(), polygon.vertices_y.end() );
+            add_geometry( store, entity, NO_SHAPE, Transform2D{}, previous );
+        }
+        for( auto [ entity, instance ] : instances )
+        {
+            // A Polygon takes precedence over a ShapeInstance on the same entity
+            if( !polygons.contains( entity ) && instance.shape < shape_count() )
+            {
+                add_geometry( store, entity, instance.shape, instance.transform, previous );
+            }
+        }
+
+        index.clear();
+        for( std::size_t i = 0; i < size(); ++i )
+        {
+            index.insert( i, bounds[ i ] );
+        }
+        index.build();
+
+        if( previous != nullptr )
+        {
+            for( auto despawn : previous->despawns )
+            {
+                if( despawn.second > horizon )
+                {
+                    despawns.push_back( despawn );
+                }
+            }
+            for( std::size_t i = 0; i < previous->size(); ++i )
+            {
+                if( slot_of( previous->entities[ i ] ) == NO_SLOT )
+                {
+                    despawns.emplace_back( previous->entities[ i ], tick );
+                }
+            }
+        }
+    }
+
+private:
+    static bool same_vertices( const std::vector< std::uint32_t > & offsets, const std::vector< Float > & xs,
+                               const std::vector< Float > & ys, std::size_t i,
+                               const std::vector< std::uint32_t > & other_offsets,
+                               const std::vector< Float > & other_xs, const std::vector< Float > & other_ys,
+                               std::size_t j ) noexcept
+    {
+        auto begin = offsets[ i ], end = offsets[ i + 1 ];
+        auto other_begin = other_offsets[ j ], other_end = other_offsets[ j + 1 ];
+        if( end - begin != other_end - other_begin )
+        {
+            return false;
+        }
+        for( auto v = begin, w = other_begin; v < end; ++v, ++w )
+        {
+            if( xs[ v ] != other_xs[ w ] || ys[ v ] != other_ys[ w ] )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief World bounds of geometry i: the cached Bounds if the entity has them, else its vertices.
+    AxisAlignedBoundingBox world_bounds( const EntityStore & store, std::size_t i ) const
+    {
+        const auto & cached = store.get< Bounds >();
+        if( has_position[ i ] && cached.contains( entities[ i ] ) )
+        {
+            return cached[ entities[ i ] ].world;
+        }
+        // A geometry without vertices is indexed as the point it is placed at
+        AxisAlignedBoundingBox box{ positions[ i ], positions[ i ] };
+        bool first = true;
+        for_each_vertex( i, [ & ]( Float x, Float y ) {
+            Vec2 vertex = positions[ i ] + Vec2{ x, y };
+            box.min = first ? vertex : Vec2{ std::min( box.min.x, vertex.x ), std::min( box.min.y, vertex.y ) };
+            box.max = first ? vertex : Vec2{ std::max( box.max.x, vertex.x ), std::max( box.max.y, vertex.y ) };
+            first = false;
+        } );
+        return box;
+    }
+
+    /// @brief Append one geometry whose own vertices (if any) have just been appended.
+    void add_geometry( const EntityStore & store, std::size_t entity, ShapeId shape, const Transform2D & transform,
+                       const SceneSnapshot * previous )
+    {
+        const auto & store_positions = store.get< Position >();
+        bool positioned = store_positions.contains( entity );
+        entities.push_back( entity );
+        positions.push_back( positioned ? Vec2( store_positions[ entity ] ) : Vec2{} );
+        has_position.push_back( positioned ? 1 : 0 );
+        vertex_offsets.push_back( static_cast< std::uint32_t >( vertices_x.size() ) );
+        shapes.push_back( shape );
+        transforms.push_back( transform );
+
+        auto slot = entities.size() - 1;
+        if( entity >= entity_slots.size() )
+        {
+            entity_slots.resize( entity + 1, NO_SLOT );
+        }
+        entity_slots[ entity ] = static_cast< std::uint32_t >( slot );
+        generations.push_back( store.registry.handle( entity ).generation );
+        bounds.push_back( world_bounds( store, slot ) );
+
+        // A recycled id is a different entity even if it looks the same, and an
+        // instance of a shape that changed this tick has to be drawn again
+        auto previous_slot = previous ? previous->slot_of( entity ) : NO_SLOT;
+        if( previous_slot == NO_SLOT || previous->generations[ previous_slot ] != generations[ slot ]
+            || previous->has_position[ previous_slot ] != has_position[ slot ]
+            || !same_shape( slot, *previous, previous_slot ) || ( shape != NO_SHAPE && shape_ticks[ shape ] == tick ) )
+        {
+            spawn_ticks.push_back( tick );
+            move_ticks.push_back( tick );
+        }
+        else
+        {
+            spawn_ticks.push_back( previous->spawn_ticks[ previous_slot ] );
+            auto before = previous->positions[ previous_slot ], now = positions[ slot ];
+            bool moved = before.x != now.x || before.y != now.y;
+            move_ticks.push_back( moved ? tick : previous->move_ticks[ previous_slot ] );
+        }
+    }
+};
+
+/// @class SnapshotBuffer
+/// @brief Single-writer, many-reader publication of SceneSnapshots.
+///
+/// The writer fills a recycled snapshot with write_buffer() and makes it visible
+/// with publish(); readers call latest() and keep the returned shared_ptr for as
+/// long as they need it. A small ring of snapshots is recycled: a slot is only
+/// reused once neither the buffer nor any reader references it, so a published
+/// snapshot is never modified. If every slot is still held by slow readers, a
+/// fresh snapshot is allocated instead of waiting, so the writer never blocks.
+///
+/// @par Example usage:
+/// @code
+/// // Simulation thread, after each tick
+/// buffer.write_buffer().capture( store, tick, buffer.latest().get() );
+/// buffer.publish();
+///
+/// // Any reader thread, no lock required
+/// if( auto snapshot = buffer.latest() ) { serialize( *snapshot ); }
+/// @endcode
+class SnapshotBuffer
+{
+public:
+    static constexpr std::size_t SLOT_COUNT = 3; ///< Triple buffering: published, in flight, being written
+
+private:
+    std::array< std::shared_ptr< SceneSnapshot >, SLOT_COUNT > slots_; ///< Writer-owned recycled snapshots
+    std::size_t writing_ = 0; ///< Index of the slot handed out by write_buffer()
+    std::atomic< std::shared_ptr< const SceneSnapshot > > published_; ///< Snapshot visible to readers
+
+public:
+    /// @brief Construct a buffer with no published snapshot.
+    SnapshotBuffer()
+    {
+        for( auto & slot : slots_ )
+        {
+            slot = std::make_shared< SceneSnapshot >();
+        }
+    }
+
+    SnapshotBuffer( const SnapshotBuffer & ) = delete;
+    SnapshotBuffer & operator=( const SnapshotBuffer & ) = delete;
+
+    /// @brief Get a snapshot that no reader can observe, ready to be filled.
+    ///
+    /// Writer thread only. The returned reference stays valid until publish().
+    ///
+    /// @return A recycled snapshot that is not published and not held by any reader.
+    SceneSnapshot & write_buffer()
+    {
+        for( std::size_t i = 0; i < SLOT_COUNT; ++i )
+        {
+            // Only the ring references the slot: it is neither published nor being read
+            if( slots_[ i ].use_count() == 1 )
+            {
+                // use_count() is a relaxed load, so on its own it orders nothing. The last reader
+                // let go with a release decrement (shared_ptr's acq_rel), and the count of 1 seen
+                // here was written by it; this fence turns that observation into synchronization,
+                // so every read the reader made of the snapshot happens before the rewrite below.
+                // A count of 1 also means the slot is not published, so no reader can pin it again.
+                std::atomic_thread_fence( std::memory_order_acquire );
+                writing_ = i;
+                return *slots_[ i ];
+            }
+        }
+
+        // Every slot is pinned by readers; retire the first unpublished one to them
+        auto published = published_.load( std::memory_order_acquire );
+        writing_ = slots_[ 0 ] == published ? 1 : 0;
+        slots_[ writing_ ] = std::make_shared< SceneSnapshot >();
+        return *slots_[ writing_ ];
+    }
+
+    /// @brief Atomically make the snapshot from write_buffer() visible to readers.
+    ///
+    /// Writer thread only.
+    void publish()
+    {
+        published_.store( slots_[ writing_ ], std::memory_order_release );
+    }
+
+    /// @brief Get the most recently published snapshot.
+    ///
+    /// Safe to call from any thread without holding a lock.
+    ///
+    /// @return The latest snapshot, or null if nothing has been published yet.
+    std::shared_ptr< const SceneSnapshot > latest() const
+    {
+        return published_.load( std::memory_order_acquire );
+    }
+};
+} // namespace robot::src::detail::scene_snapshot::inline exports
+
+namespace robot::src::inline exports::inline scene_snapshot
+{
+using namespace detail::scene_snapshot::exports;
+}
@@ -0,0 +1,286 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "assets.hpp"
+#include "component_types.hpp"
+#include "input_queue.hpp"
+#include "input_recording.hpp"
+#include "job_system.hpp"
+#include "metrics.hpp"
+#include "system_graph.hpp"
+#include "systems.hpp"
+#include "world_file.hpp"
+#include "worldgen.hpp"
+
+/// @file simulation.hpp
+/// @brief The world and the systems that advance it, independent of any clock or network.
+///
+/// The interactive main loop steps a Simulation at ~60 Hz on its own thread, which
+/// alone touches the store: the REST server queues inputs for it to drain and reads
+/// the snapshots it publishes. The headless mode steps one as fast as it can.
+/// Both run exactly the same systems in the same order, so a run replayed
+/// headless reproduces an interactive one.
+
+namespace robot::src::detail::simulation::inline exports
+{
+/// @class Simulation
+/// @brief An EntityStore plus the system graph that steps it one fixed tick at a time.
+///
+/// @par Example usage:
+/// @code
+/// Simulation simulation( 3 );
+/// simulation.build( "example_key" );
+/// for( int i = 0; i < 600; ++i )
+///     simulation.step();
+/// auto hash = stateHash( simulation.store() );
+/// @endcode
+class Simulation
+{
+private:
+    VertexArena vertex_arena_; ///< Declared first so it outlives the store's polygons
+    EntityStore store_;
+    JobSystem jobs_;
+    // The collision workspace keeps its buffers and the motion layout its alignment across ticks
+    CollisionWorkspace collisions_;
+    MotionLayout motion_layout_;
+    SystemGraph< EntityStore > systems_;
+    InputQueue inputs_{ INPUT_QUEUE_CAPACITY };
+    InputRecorder * recorder_ = nullptr;
+    std::string key_;
+    std::size_t num_assets_ = 0;
+    std::uint64_t tick_ = 0;
+
+    template < typename R, typename W, typename F >
+    void add( std::string name, R reads, W writes, Metrics * metrics, F system )
+    {
+        if( !metrics )
+        {
+            systems_.add( std::move( name ), reads, writes, std::move( system ) );
+            return;
+        }
+        // Every system is timed into its own histogram on /metrics
+        auto & histogram = metrics->system( name );
+        systems_.add( std::move( name ), reads, writes,
+                      [ &histogram, system = std::move( system ) ]( EntityStore & world, JobSystem & pool ) {
+                          ScopedTimer timer( histogram );
+                          system( world, pool );
+                      } );
+    }
+
+public:
+    /// @brief Create an empty world and register the systems.
+    /// @param sim_threads Worker threads the systems may spread across, besides the stepping thread.
+    /// @param metrics Metrics to time each system into, if any.
+    explicit Simulation( std::size_t sim_threads = defaultWorkerCount(), Metrics * metrics = nullptr )
+        : jobs_( sim_threads )
+    {
+        // Each system declares what it touches; conflicting systems run in this order.
+        // Queued viewer input is drained first, in one batch, and recorded as the tick will apply it.
+        add( "handlePlayerInput", Reads<>{}, Writes< PlayerInput, Velocity >{}, metrics,
+             [ this, metrics ]( EntityStore & world, JobSystem & ) {
+                 auto drained = drainInputCommands( inputs_, world );
+                 if( metrics )
+                 {
+                     metrics->input_batch.observe( drained );
+                 }
+                 if( recorder_ )
+                 {
+                     recorder_->record( tick_ + 1, world );
+                 }
+                 handlePlayerInput( world );
+             } );
+        add( "handleCollisions", Reads< Polygon, ShapeInstance, Position, Bounds >{}, Writes< HitCounter, Velocity >{},
+             metrics, [ this ]( EntityStore & world, JobSystem & pool ) {
+                 handleCollisions( world, collisions_, pool );
+             } );
+        // updatePositions reorders the Velocity storage as well as writing positions and bounds
+        add( "updatePositions", Reads<>{}, Writes< Velocity, Position, Bounds >{}, metrics,
+             [ this ]( EntityStore & world, JobSystem & pool ) { updatePositions( world, motion_layout_, pool ); } );
+    }
+
+    // The registered systems capture this
+    Simulation( const Simulation & ) = delete;
+    Simulation & operator=( const Simulation & ) = delete;
+
+    /// @brief Replace the world with the procedural assets for a key and restart the tick count.
+    void build( const std::string & key, std::size_t num_assets = 10 )
+    {
+        buildProceduralAssets( store_, vertex_arena_, key, num_assets );
+        key_ = key;
+        num_assets_ = num_assets;
+        tick_ = 0;
+    }
+
+    /// @brief Replace the world with a chunked one generated on the simulation's workers.
+    /// @return How many bodies were placed; options.obstacles is recorded as the asset count.
+    /// @throw std::invalid_argument if the options describe an impossible chunk layout.
+    WorldGenStats generate( const std::string & key, const WorldGenOptions & options )
+    {
+        auto stats = generateWorld( store_, vertex_arena_, key, options, jobs_ );
+        key_ = key;
+        num_assets_ = options.obstacles;
+        tick_ = 0;
+        return stats;
+    }
+
+    /// @brief Replace the world with one saved by saveWorld() or a Checkpointer, and carry on from its tick.
+    ///
+    /// Stepping the restored world gives the same states the saved one would
+    /// have reached, so replays and state hashes line up across a restart.
+    ///
+    /// @throw std::system_error if the file cannot be mapped, std::runtime_error if it is invalid;
+    ///        the world is then empty.
+    void restore( const std::string & path )
+    {
+        auto info = loadWorld( path, store_, vertex_arena_ );
+        key_ = std::move( info.key );
+        num_assets_ = info.num_assets;
+        tick_ = info.tick;
+    }
+
+    /// @brief What a world file of the current state records besides the store.
+    WorldFileInfo world_info() const
+    {
+        return { key_, num_assets_, tick_ };
+    }
+
+    /// @brief Asset key of the last build() or restore().
+    const std::string & key() const noexcept
+    {
+        return key_;
+    }
+
+    /// @brief Asset count of the last build() or restore().
+    std::size_t num_assets() const noexcept
+    {
+        return num_assets_;
+    }
+
+    /// @brief Run every system once and advance the tick count.
+    void step()
+    {
+        systems_.run( store_, jobs_ );
+        ++tick_;
+    }
+
+    /// @brief Queue viewers push input to; the next step drains it. Safe to push to from any thread.
+    InputQueue & inputs() noexcept
+    {
+        return inputs_;
+    }
+
+    /// @brief Record the inputs each step applies, after the queue is drained; nullptr to stop recording.
+    void record_inputs( InputRecorder * recorder ) noexcept
+    {
+        recorder_ = recorder;
+    }
+
+    /// @brief Number of steps run since the last build(), counting those before a restore()d save.
+    std::uint64_t tick() const noexcept
+    {
+        return tick_;
+    }
+
+    /// @brief The world; only the thread calling step() may touch it.
+    EntityStore & store() noexcept
+    {
+        return store_;
+    }
+
+    /// @copydoc store()
+    const EntityStore & store() const noexcept
+    {
+        return store_;
+    }
+};
+
+/// @brief FNV-1a accumulator over the bit patterns of simulation values.
+class StateHasher
+{
+private:
+    static constexpr std::uint64_t OFFSET_BASIS = 0xcbf29ce484222325ull;
+    static constexpr std::uint64_t PRIME = 0x100000001b3ull;
+    std::uint64_t hash_ = OFFSET_BASIS;
+
+public:
+    void add( std::uint32_t word ) noexcept
+    {
+        for( int shift = 0; shift < 32; shift += 8 )
+        {
+            hash_ = ( hash_ ^ ( ( word >> shift ) & 0xffu ) ) * PRIME;
+        }
+    }
+
+    void add( Float value ) noexcept
+    {
+        add( std::bit_cast< std::uint32_t >( value ) );
+    }
+
+    void add( const Vec2 & value ) noexcept
+    {
+        add( value.x );
+        add( value.y );
+    }
+
+    void add( const HitCounter & value ) noexcept
+    {
+        add( value.hits );
+    }
+
+    void add( const Bounds & value ) noexcept
+    {
+        add( value.world.min );
+        add( value.world.max );
+    }
+
+    /// @brief Add every (entity, value) pair of a storage in dense order.
+    template < typename T >
+    void add_storage( const EntityStore & store )
+    {
+        const auto & storage = store.get< T >();
+        const auto & entities = storage.dense_entities();
+        const auto & data = storage.dense_data();
+        add( static_cast< std::uint32_t >( entities.size() ) );
+        for( std::size_t i = 0; i < entities.size(); ++i )
+        {
+            add( static_cast< std::uint32_t >( entities[ i ] ) );
+            add( data[ i ] );
+        }
+    }
+
+    std::uint64_t value() const noexcept
+    {
+        return hash_;
+    }
+};
+
+/// @brief Fingerprint of the simulated state, for checking that two runs agree bit for bit.
+///
+/// FNV-1a over the exact bit patterns of every component the systems write or
+/// read each tick (positions, velocities, inputs, hit counters and world
+/// bounds) in storage order. Static geometry is fixed by the asset key and is
+/// not included.
+///
+/// @return A 64-bit hash; equal states give equal hashes.
+inline std::uint64_t stateHash( const EntityStore & store )
+{
+    StateHasher hasher;
+    hasher.add_storage< Position >( store );
+    hasher.add_storage< Velocity >( store );
+    hasher.add_storage< PlayerInput >( store );
+    hasher.add_storage< HitCounter >( store );
+    hasher.add_storage< Bounds >( store );
+    return hasher.value();
+}
+} // namespace robot::src::detail::simulation::inline exports
+
+namespace robot::src::inline exports::inline simulation
+{
+using namespace detail::simulation::exports;
+}
@@ -1,8 +1,15 @@
 static_assert( __cplusplus > 2020'00 );
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <span>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 /// @file sparse_set.hpp
@@ -22,17 +29,23 @@ namespace robot::src::detail::sparse_set ::inline exports
 /// efficient iteration over active entities.
 ///
 /// The sparse set uses two arrays:
-/// - A sparse array (dataIndex) that maps entity IDs to their positions in the dense array
+/// - A paged sparse index that maps entity IDs to their positions in the dense array
 /// - A dense array (data) that stores the actual entity IDs in contiguous memory
 ///
-/// @tparam EntityCount The maximum number of entities that can be stored (default: 1000).
-///                     This determines the size of the sparse array.
+/// The sparse index is split into fixed-size pages of 32-bit dense indices that are
+/// allocated the first time an entity in their range is inserted. There is no upper
+/// bound on entity IDs fixed at compile time: the index grows as larger IDs arrive,
+/// and a storage only pays for pages it actually touches, so a component held by a
+/// handful of entities costs a handful of pages no matter how large IDs get.
+///
+/// @tparam PageSize Number of entity IDs covered by one page of the sparse index
+///                  (default: 1024). Must be a power of two.
 ///
 /// @par Example usage:
 /// @code
-/// SparseSet<5000> entities;
+/// SparseSet<> entities;
 /// entities.insert(42);
-/// entities.insert(100);
+/// entities.insert(1'000'000); // Allocates one more page, nothing in between
 ///
 /// if (entities.contains(42)) {
 ///     // Process entity 42
@@ -42,37 +55,123 @@ namespace robot::src::detail::sparse_set ::inline exports
 ///     // Iterate over all active entities
 /// }
 /// @endcode
-template < unsigned int EntityCount = 1000 >
+template < std::size_t PageSize = 1024 >
 class SparseSet
 {
+    static_assert( PageSize > 0 && ( PageSize & ( PageSize - 1 ) ) == 0, "PageSize must be a power of two" );
+
 public:
     using ContainerType = std::vector< std::size_t >; ///< Type alias for the dense array
-    using IndexContainerType = std::vector< std::size_t >; ///< Type alias for the sparse array
+    using IndexType = std::uint32_t; ///< Type of the dense indices held in the sparse index
+    using PageType = std::unique_ptr< IndexType[] >; ///< One page of the sparse index
+
+    /// @brief Sparse index value of an entity that is not in the set.
+    static constexpr IndexType npos = std::numeric_limits< IndexType >::max();
+
+    /// @brief Number of entity IDs covered by one page.
+    static constexpr std::size_t page_size = PageSize;
 
 private:
-    IndexContainerType dataIndex; ///< Sparse array mapping entity IDs to dense array indices
+    std::vector< PageType > pages; ///< Paged sparse index; null pages hold no entities
     ContainerType data; ///< Dense array storing active entity IDs
+    std::uint64_t revision_ = 0; ///< Bumped whenever the dense order changes
+
+    static constexpr std::size_t pageOf( std::size_t value ) noexcept
+    {
+        return value / PageSize;
+    }
+
+    static constexpr std::size_t offsetOf( std::size_t value ) noexcept
+    {
+        return value & ( PageSize - 1 );
+    }
+
+    /// @brief Dense index of value, or npos if absent. Never allocates.
+    IndexType lookup( std::size_t value ) const noexcept
+    {
+        auto page = pageOf( value );
+        if( page >= pages.size() || !pages[ page ] )
+        {
+            return npos;
+        }
+        return pages[ page ][ offsetOf( value ) ];
+    }
+
+    /// @brief Sparse index slot for value, allocating its page if needed.
+    IndexType & slot( std::size_t value )
+    {
+        auto page = pageOf( value );
+        if( page >= pages.size() )
+        {
+            pages.resize( page + 1 );
+        }
+        if( !pages[ page ] )
+        {
+            pages[ page ] = std::make_unique_for_overwrite< IndexType[] >( PageSize );
+            std::fill_n( pages[ page ].get(), PageSize, npos );
+        }
+        return pages[ page ][ offsetOf( value ) ];
+    }
+
+    void copyPagesFrom( const SparseSet & other )
+    {
+        pages.clear();
+        pages.resize( other.pages.size() );
+        for( std::size_t page = 0; page < other.pages.size(); ++page )
+        {
+            if( other.pages[ page ] )
+            {
+                pages[ page ] = std::make_unique_for_overwrite< IndexType[] >( PageSize );
+                std::copy_n( other.pages[ page ].get(), PageSize, pages[ page ].get() );
+            }
+        }
+    }
 
 public:
     /// @brief Constructs an empty sparse set.
     ///
-    /// Initializes the sparse array with size EntityCount, with all entries marked as invalid.
-    /// The dense array starts empty and grows as entities are inserted.
-    SparseSet()
-        : dataIndex( EntityCount, static_cast< std::size_t >( -1 ) )
-    {}
+    /// No pages are allocated until the first insertion.
+    SparseSet() = default;
 
-    /// @brief Copy constructor (defaulted).
-    SparseSet( const SparseSet & ) = default;
+    /// @brief Copy constructor; copies every allocated page.
+    SparseSet( const SparseSet & other )
+        : data( other.data )
+        , revision_( other.revision_ )
+    {
+        copyPagesFrom( other );
+    }
 
     /// @brief Move constructor (defaulted).
-    SparseSet( SparseSet && ) = default;
+    SparseSet( SparseSet && ) noexcept = default;
 
-    /// @brief Copy assignment operator (defaulted).
-    SparseSet & operator=( const SparseSet & ) = default;
+    /// @brief Copy assignment operator; copies every allocated page.
+    SparseSet & operator=( const SparseSet & other )
+    {
+        if( this != &other )
+        {
+            copyPagesFrom( other );
+            data = other.data;
+            revision_ = std::max( revision_, other.revision_ ) + 1;
+        }
+        return *this;
+    }
 
-    /// @brief Move assignment operator (defaulted).
-    SparseSet & operator=( SparseSet && ) = default;
+    /// @brief Move assignment operator.
+    ///
+    /// Revisions only grow: both sets end past either one's revision, so an
+    /// observer of either never sees a revision repeat for different contents.
+    SparseSet & operator=( SparseSet && other ) noexcept
+    {
+        if( this != &other )
+        {
+            pages = std::move( other.pages );
+            data = std::move( other.data );
+            other.pages.clear();
+            other.data.clear();
+            revision_ = other.revision_ = std::max( revision_, other.revision_ ) + 1;
+        }
+        return *this;
+    }
 
     /// @brief Swaps the contents of this sparse set with another.
     ///
@@ -81,53 +180,64 @@ public:
     ///
     /// @param other The sparse set to swap with.
     ///
-    /// @pre Both sparse sets must have the same EntityCount template parameter.
     /// @post This sparse set's contents are swapped with other's contents.
     ///
     /// @note Time complexity: O(1)
     void swap( SparseSet & other ) noexcept
     {
-        assert( dataIndex.size() == other.dataIndex.size() );
-        assert( data.size() == other.data.size() );
         assert( this != &other );
 
-        using std::swap;
-        swap( dataIndex, other.dataIndex );
+        pages.swap( other.pages );
         data.swap( other.data );
+        revision_ = other.revision_ = std::max( revision_, other.revision_ ) + 1;
     }
 
     /// @brief Removes all entities from the sparse set.
     ///
-    /// Clears both the dense array and resets the sparse array to its initial state.
-    /// After this call, the sparse set will be empty.
+    /// Resets only the sparse index entries of live entities and clears the dense
+    /// array. Allocated pages are kept for reuse.
     ///
     /// @post size() == 0 && empty() == true
     ///
-    /// @note Time complexity: O(EntityCount)
+    /// @note Time complexity: O(size())
     void clear() noexcept
     {
-        dataIndex.assign( EntityCount, static_cast< std::size_t >( -1 ) );
+        for( auto value : data )
+        {
+            pages[ pageOf( value ) ][ offsetOf( value ) ] = npos;
+        }
         data.clear();
+        ++revision_;
     }
 
     /// @brief Pre-allocates space in the dense array for entities.
     ///
     /// Reserves capacity in the dense array to avoid reallocations during subsequent
-    /// insert operations. The sparse array size remains fixed at EntityCount.
+    /// insert operations. Pages of the sparse index are still allocated on demand.
     ///
-    /// @param new_cap The new capacity to reserve. Must be >= current size and <= EntityCount.
+    /// @param new_cap The new capacity to reserve. Must be >= current size.
     ///
-    /// @pre new_cap >= size() && new_cap <= EntityCount
+    /// @pre new_cap >= size()
     ///
     /// @note Time complexity: O(1) amortized
     void reserve( std::size_t new_cap )
     {
         assert( new_cap >= data.size() );
-        assert( new_cap <= dataIndex.size() );
 
         data.reserve( new_cap );
     }
 
+    /// @brief Number of pages of the sparse index currently allocated.
+    ///
+    /// @return The count of non-null pages.
+    ///
+    /// @note Time complexity: O(number of page slots)
+    std::size_t allocated_pages() const noexcept
+    {
+        return static_cast< std::size_t >(
+            std::count_if( pages.begin(), pages.end(), []( const PageType & page ) { return page != nullptr; } ) );
+    }
+
     /// @brief Returns the number of entities currently in the sparse set.
     ///
     /// @return The count of active entities.
@@ -150,12 +260,14 @@ public:
 
     /// @brief Inserts an entity into the sparse set.
     ///
-    /// Adds an entity identifiedby the given value. If the entity is already present,
+    /// Adds an entity identified by the given value. If the entity is already present,
     /// the operation has no effect (idempotent). New entities are appended to the dense array.
+    /// The page covering value is allocated if this is its first entity.
     ///
-    /// @param value The entity ID to insert. Must be in the range [0, EntityCount).
+    /// @param value The entity ID to insert.
     ///
-    /// @throw std::out_of_range if value >= EntityCount.
+    /// @throw std::length_error if the set already holds the maximum number of entities
+    ///        addressable by a 32-bit dense index.
     ///
     /// @post contains(value) == true
     ///
@@ -163,23 +275,19 @@ public:
     /// @note If the entity already exists, this is a no-op with O(1) lookup time.
     void insert( std::size_t value )
     {
-        assert( value < EntityCount );
-        assert( dataIndex.size() == EntityCount );
-        assert( data.size() <= EntityCount );
-        assert( this != nullptr );
-
-        if( dataIndex.size() <= value )
+        if( lookup( value ) != npos )
         {
-            throw std::out_of_range( "SparseSet::insert: value out of range" );
+            return; // Already present
         }
-
-        if( dataIndex[ value ] != static_cast< std::size_t >( -1 ) )
+        if( data.size() >= npos )
         {
-            return; // Already present
+            throw std::length_error( "SparseSet::insert: too many entities" );
         }
 
+        auto & index = slot( value );
         data.push_back( value );
-        dataIndex[ value ] = data.size() - 1;
+        index = static_cast< IndexType >( data.size() - 1 );
+        ++revision_;
     }
 
     /// @brief Removes an entity from the sparse set.
@@ -188,59 +296,117 @@ public:
     /// the operation has no effect (idempotent). Uses the "swap and pop" technique
     /// to maintain dense array integrity in O(1) time.
     ///
-    /// @param value The entity ID to erase. Must be in the range [0, EntityCount).
-    ///
-    /// @throw std::out_of_range if value >= EntityCount.
+    /// @param value The entity ID to erase.
     ///
     /// @post contains(value) == false
     ///
-    /// @note Time complexity: O(1) amortized
+    /// @note Time complexity: O(1)
     /// @note If the entity does not exist, this is a no-op with O(1) lookup time.
     /// @warning The iteration order may change after this operation due to the swap.
     void erase( std::size_t value )
     {
-        assert( value < EntityCount );
-        assert( dataIndex.size() == EntityCount );
-        assert( this != nullptr );
-
-        if( dataIndex.size() <= value )
-        {
-            throw std::out_of_range( "SparseSet::erase: value out of range" );
-        }
-
-        std::size_t index = dataIndex[ value ];
-        if( index == static_cast< std::size_t >( -1 ) )
+        IndexType index = lookup( value );
+        if( index == npos )
         {
             return; // Not present
         }
 
         std::size_t lastValue = data.back();
         data[ index ] = lastValue;
-        dataIndex[ lastValue ] = index;
+        pages[ pageOf( lastValue ) ][ offsetOf( lastValue ) ] = index;
 
         data.pop_back();
-        dataIndex[ value ] = static_cast< std::size_t >( -1 );
+        pages[ pageOf( value ) ][ offsetOf( value ) ] = npos;
+        ++revision_;
+    }
+
+    /// @brief Inserts every entity ID of a range.
+    ///
+    /// Equivalent to calling insert() for each ID, but when the range knows its
+    /// size the dense array is grown once up front. IDs already present, or
+    /// repeated within the range, are skipped.
+    ///
+    /// @param values Range of entity IDs.
+    ///
+    /// @throw std::length_error if the set would exceed the maximum number of entities.
+    ///
+    /// @note Time complexity: O(n) amortized for n IDs
+    template < std::ranges::input_range R >
+    void insert_range( R && values )
+    {
+        if constexpr( std::ranges::sized_range< R > )
+        {
+            data.reserve( data.size() + std::ranges::size( values ) );
+        }
+        for( auto value : values )
+        {
+            insert( static_cast< std::size_t >( value ) );
+        }
+    }
+
+    /// @brief Removes every entity ID of a range.
+    ///
+    /// IDs that are not present are ignored.
+    ///
+    /// @param values Range of entity IDs; must not be a view of this set's own entities().
+    ///
+    /// @note Time complexity: O(n) for n IDs
+    template < std::ranges::input_range R >
+    void erase_range( R && values )
+    {
+        for( auto value : values )
+        {
+            erase( static_cast< std::size_t >( value ) );
+        }
+    }
+
+    /// @brief Exchanges the dense positions of two entities.
+    ///
+    /// Lets a caller impose an iteration order, for example to line up the
+    /// dense arrays of two component storages.
+    ///
+    /// @param a First dense index; must be < size().
+    /// @param b Second dense index; must be < size().
+    ///
+    /// @post idFor(a) and idFor(b) are exchanged and indexFor() follows them.
+    ///
+    /// @note Time complexity: O(1)
+    void swapIndices( std::size_t a, std::size_t b ) noexcept
+    {
+        assert( a < data.size() && b < data.size() );
+
+        std::swap( data[ a ], data[ b ] );
+        pages[ pageOf( data[ a ] ) ][ offsetOf( data[ a ] ) ] = static_cast< IndexType >( a );
+        pages[ pageOf( data[ b ] ) ][ offsetOf( data[ b ] ) ] = static_cast< IndexType >( b );
+        ++revision_;
+    }
+
+    /// @brief Counter that changes whenever entities are added, removed or reordered.
+    ///
+    /// Callers that cache something derived from the dense order (such as an
+    /// alignment with another storage) compare revisions to know when to redo it.
+    /// Revisions only ever grow for a given set.
+    ///
+    /// @return The current revision.
+    ///
+    /// @note Time complexity: O(1)
+    std::uint64_t revision() const noexcept
+    {
+        return revision_;
     }
 
     /// @brief Checks whether an entity is in the sparse set.
     ///
     /// Performs a fast membership test on the given entity ID.
     ///
-    /// @param value The entity ID to check. If >= EntityCount, always returns false.
+    /// @param value The entity ID to check. Any value is accepted.
     ///
     /// @return true if the entity is in the set, false otherwise.
     ///
     /// @note Time complexity: O(1)
-    bool contains( std::size_t value ) const
+    bool contains( std::size_t value ) const noexcept
     {
-        assert( dataIndex.size() == EntityCount );
-        assert( this != nullptr );
-
-        if( dataIndex.size() <= value )
-        {
-            return false;
-        }
-        return dataIndex[ value ] != static_cast< std::size_t >( -1 );
+        return lookup( value ) != npos;
     }
 
     /// @brief Gets the index of an entity in the dense array.
@@ -251,21 +417,32 @@ public:
     ///
     /// @return The zero-based index in the dense array where this entity is stored.
     ///
-    /// @throw std::out_of_range if entityId >= EntityCount.
-    ///
-    /// @pre contains(entityId) == true (if precondition is violated, result is undefined)
+    /// @throw std::out_of_range if entityId is not in the set.
     ///
     /// @note Time complexity: O(1)
     std::size_t indexFor( std::size_t entityId ) const
     {
-        assert( dataIndex.size() == EntityCount );
-        assert( this != nullptr );
-
-        if( entityId >= dataIndex.size() )
+        IndexType index = lookup( entityId );
+        if( index == npos )
         {
-            throw std::out_of_range( "SparseSet::indexFor: index out of range" );
+            throw std::out_of_range( "SparseSet::indexFor: entity not present" );
         }
-        return dataIndex[ entityId ];
+        return index;
+    }
+
+    /// @brief Gets the index of an entity in the dense array, if present.
+    ///
+    /// A non-throwing indexFor() for callers that need to test membership and
+    /// locate the entity with a single lookup.
+    ///
+    /// @param entityId The entity ID to look up.
+    ///
+    /// @return The zero-based index in the dense array, or npos if entityId is not in the set.
+    ///
+    /// @note Time complexity: O(1)
+    std::size_t findIndex( std::size_t entityId ) const noexcept
+    {
+        return lookup( entityId );
     }
 
     /// @brief Gets the entity ID at a given index in the dense array.
@@ -283,9 +460,6 @@ public:
     /// @note Time complexity: O(1)
     std::size_t idFor( std::size_t index ) const
     {
-        assert( dataIndex.size() == EntityCount );
-        assert( this != nullptr );
-
         if( index >= data.size() )
         {
             throw std::out_of_range( "SparseSet::idFor: index out of range" );
@@ -293,30 +467,28 @@ public:
         return data[ index ];
     }
 
-    /// @brief Returns a range view over all entity IDs in the sparse set.
+    /// @brief Returns a view over all entity IDs in the sparse set.
     ///
-    /// Provides a std::ranges-compatible view of the dense array for use with
-    /// range algorithms and range-based for loops with pipe operators.
+    /// The span refers to the dense array itself; nothing is copied. Use it with
+    /// range algorithms, views and range-based for loops. It is invalidated by
+    /// any insertion or removal, like an iterator into std::vector.
     ///
-    /// @return A range view over all active entity IDs.
+    /// @return A non-owning, read-only view of the active entity IDs in dense order.
     ///
     /// @note Time complexity: O(1)
     ///
     /// @see begin(), end() for iterator access
-    auto entities() noexcept
+    std::span< const std::size_t > entities() const noexcept
     {
         return data;
     }
 
-    /// @brief Returns a const range view over all entity IDs in the sparse set.
-    ///
-    /// Provides a const std::ranges-compatible view of the dense array for use with
-    /// range algorithms when the sparse set should not be modified.
+    /// @brief Returns the dense array of entity IDs.
     ///
-    /// @return A const range view over all active entity IDs.
+    /// @return A const reference to the entity IDs in dense order; entity dense()[i] has index i.
     ///
     /// @note Time complexity: O(1)
-    auto entities() const noexcept
+    const ContainerType & dense() const noexcept
     {
         return data;
     }
@@ -351,6 +523,26 @@ public:
         return data.end();
     }
 
+    /// @brief Returns a const iterator to the beginning of the dense array (const version).
+    ///
+    /// @return A const iterator pointing to the first entity, or end() if empty.
+    ///
+    /// @note Time complexity: O(1)
+    auto begin() const noexcept
+    {
+        return data.begin();
+    }
+
+    /// @brief Returns a const iterator to the end of the dense array (const version).
+    ///
+    /// @return A const iterator pointing one past the last entity.
+    ///
+    /// @note Time complexity: O(1)
+    auto end() const noexcept
+    {
+        return data.end();
+    }
+
     /// @brief Returns a const iterator to the beginning of the dense array.
     ///
     /// Allows const range-based iteration over all active entities. Useful when
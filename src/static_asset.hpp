@@ -0,0 +1,244 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <boost/beast/zlib.hpp>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/// @file static_asset.hpp
+/// @brief Responses that never change while the server runs, prepared once.
+///
+/// A StaticAsset holds a resource in identity and gzip encodings together with
+/// an ETag for each, derived from its content. Sessions then answer with a view of the
+/// prepared bytes, or with 304 Not Modified when the viewer already has them,
+/// instead of copying and re-encoding the resource on every request.
+
+namespace robot::src::detail::static_asset::inline exports
+{
+/// @brief CRC-32 (ISO-HDLC, as used by gzip) of a byte sequence.
+inline std::uint32_t crc32( std::string_view data ) noexcept
+{
+    static constexpr auto table = [] {
+        std::array< std::uint32_t, 256 > entries{};
+        for( std::uint32_t i = 0; i < entries.size(); ++i )
+        {
+            std::uint32_t c = i;
+            for( int bit = 0; bit < 8; ++bit )
+            {
+                c = ( c & 1u ) ? 0xedb88320u ^ ( c >> 1 ) : c >> 1;
+            }
+            entries[ i ] = c;
+        }
+        return entries;
+    }();
+    std::uint32_t crc = 0xffffffffu;
+    for( unsigned char byte : data )
+    {
+        crc = table[ ( crc ^ byte ) & 0xffu ] ^ ( crc >> 8 );
+    }
+    return crc ^ 0xffffffffu;
+}
+
+/// @brief Compress data into a gzip member (RFC 1952) at the best compression level.
+///
+/// Uses Beast's header-only deflate, so no zlib library is linked.
+///
+/// @throw std::runtime_error if deflate fails or does not consume the whole input,
+///        rather than returning a truncated member.
+inline std::string gzipCompress( std::string_view data )
+{
+    namespace zlib = boost::beast::zlib;
+    zlib::deflate_stream deflate;
+    deflate.reset( 9, 15, 8, zlib::Strategy::normal );
+
+    // Fixed header: magic, deflate, no flags, no mtime, maximum compression, unknown OS
+    std::string out( "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\xff", 10 );
+    auto header_size = out.size();
+    out.resize( header_size + deflate.upper_bound( data.size() ) );
+
+    zlib::z_params params;
+    params.next_in = data.data();
+    params.avail_in = data.size();
+    params.next_out = out.data() + header_size;
+    params.avail_out = out.size() - header_size;
+    boost::beast::error_code ec;
+    deflate.write( params, zlib::Flush::finish, ec );
+    // upper_bound() leaves room to finish in one call; anything else is a bug worth failing loudly on
+    if( ( ec && ec != zlib::error::end_of_stream ) || params.avail_in != 0 )
+    {
+        throw std::runtime_error( "gzip compression failed: "
+                                  + ( ec ? ec.message() : std::string( "input left over" ) ) );
+    }
+    out.resize( header_size + params.total_out );
+
+    auto append_le32 = [ &out ]( std::uint32_t value ) {
+        for( int shift = 0; shift < 32; shift += 8 )
+        {
+            out.push_back( static_cast< char >( ( value >> shift ) & 0xffu ) );
+        }
+    };
+    append_le32( crc32( data ) );
+    append_le32( static_cast< std::uint32_t >( data.size() ) );
+    return out;
+}
+
+/// @brief Whether an If-None-Match header value names an entity tag.
+///
+/// Handles lists, `*` and weak tags (W/"..."), which compare equal to their
+/// strong form as RFC 9110 requires for If-None-Match.
+inline bool etagMatches( std::string_view if_none_match, std::string_view etag )
+{
+    auto strip_weak = []( std::string_view tag ) {
+        return tag.substr( 0, 2 ) == "W/" ? tag.substr( 2 ) : tag;
+    };
+    etag = strip_weak( etag );
+    while( !if_none_match.empty() )
+    {
+        auto comma = if_none_match.find( ',' );
+        auto candidate = if_none_match.substr( 0, comma );
+        if_none_match.remove_prefix( comma == std::string_view::npos ? if_none_match.size() : comma + 1 );
+        while( !candidate.empty() && ( candidate.front() == ' ' || candidate.front() == '\t' ) )
+            candidate.remove_prefix( 1 );
+        while( !candidate.empty() && ( candidate.back() == ' ' || candidate.back() == '\t' ) )
+            candidate.remove_suffix( 1 );
+        if( candidate == "*" || strip_weak( candidate ) == etag )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief Whether an Accept-Encoding header value allows gzip.
+///
+/// Follows RFC 9110: coding names are case-insensitive, an explicit gzip (or
+/// x-gzip) entry takes precedence over `*` wherever it sits in the list, and a
+/// weight of 0 refuses the coding. Entries with a malformed weight are ignored.
+inline bool acceptsGzip( std::string_view accept_encoding )
+{
+    auto trim = []( std::string_view text ) {
+        while( !text.empty() && ( text.front() == ' ' || text.front() == '\t' ) )
+            text.remove_prefix( 1 );
+        while( !text.empty() && ( text.back() == ' ' || text.back() == '\t' ) )
+            text.remove_suffix( 1 );
+        return text;
+    };
+    auto iequals = []( std::string_view a, std::string_view b ) {
+        if( a.size() != b.size() )
+            return false;
+        for( std::size_t i = 0; i < a.size(); ++i )
+        {
+            auto lower = []( char c ) { return c >= 'A' && c <= 'Z' ? static_cast< char >( c - 'A' + 'a' ) : c; };
+            if( lower( a[ i ] ) != lower( b[ i ] ) )
+                return false;
+        }
+        return true;
+    };
+    // Weight of an entry's parameters: 1 when absent, nothing when malformed
+    auto weight = [ & ]( std::string_view parameters ) -> std::optional< double > {
+        while( !parameters.empty() )
+        {
+            auto semicolon = parameters.find( ';' );
+            auto parameter = trim( parameters.substr( 0, semicolon ) );
+            parameters.remove_prefix( semicolon == std::string_view::npos ? parameters.size() : semicolon + 1 );
+            auto equals = parameter.find( '=' );
+            if( equals == std::string_view::npos || !iequals( trim( parameter.substr( 0, equals ) ), "q" ) )
+                continue;
+            auto value = trim( parameter.substr( equals + 1 ) );
+            double q = 0.0;
+            auto [ end, ec ] = std::from_chars( value.data(), value.data() + value.size(), q );
+            if( value.empty() || ec != std::errc{} || end != value.data() + value.size() || q < 0.0 || q > 1.0 )
+                return std::nullopt;
+            return q;
+        }
+        return 1.0;
+    };
+
+    std::optional< double > gzip;
+    std::optional< double > wildcard;
+    while( !accept_encoding.empty() )
+    {
+        auto comma = accept_encoding.find( ',' );
+        auto coding = accept_encoding.substr( 0, comma );
+        accept_encoding.remove_prefix( comma == std::string_view::npos ? accept_encoding.size() : comma + 1 );
+        auto semicolon = coding.find( ';' );
+        auto name = trim( coding.substr( 0, semicolon ) );
+        auto q = weight( semicolon == std::string_view::npos ? std::string_view{} : coding.substr( semicolon + 1 ) );
+        if( !q )
+            continue;
+        if( iequals( name, "gzip" ) || iequals( name, "x-gzip" ) )
+        {
+            gzip = std::max( gzip.value_or( 0.0 ), *q );
+        }
+        else if( name == "*" )
+        {
+            wildcard = std::max( wildcard.value_or( 0.0 ), *q );
+        }
+    }
+    return gzip ? *gzip > 0.0 : wildcard.value_or( 0.0 ) > 0.0;
+}
+
+/// @brief A resource prepared once in every encoding it is served in.
+struct StaticAsset
+{
+    std::string_view content_type; ///< Media type of the resource
+    std::string_view identity; ///< The resource itself; must outlive the asset
+    std::string gzip; ///< The resource compressed with gzipCompress()
+    std::string etag; ///< Strong entity tag of the identity encoding, quoted, derived from the content
+    std::string gzip_etag; ///< Strong entity tag of the gzip encoding: etag with a -gz suffix
+
+    /// @brief Prepare a resource.
+    ///
+    /// The two encodings are different representations with different bytes, so
+    /// each gets its own strong tag (RFC 9110 8.8.3). If compression fails the
+    /// asset is left without a gzip encoding and is served as identity only.
+    ///
+    /// @param content_type Media type of the resource.
+    /// @param identity Bytes of the resource, typically a string literal.
+    static StaticAsset build( std::string_view content_type, std::string_view identity )
+    {
+        // FNV-1a mixed with the CRC, so tags differ even when one of the two collides
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for( unsigned char byte : identity )
+        {
+            hash = ( hash ^ byte ) * 0x100000001b3ull;
+        }
+        std::array< char, 40 > tag{};
+        auto written = std::snprintf( tag.data(), tag.size(), "\"%016llx-%08x\"",
+                                      static_cast< unsigned long long >( hash ), crc32( identity ) );
+        StaticAsset asset;
+        asset.content_type = content_type;
+        asset.identity = identity;
+        asset.etag.assign( tag.data(), static_cast< std::size_t >( written ) );
+        asset.gzip_etag = asset.etag.substr( 0, asset.etag.size() - 1 ) + "-gz\"";
+        try
+        {
+            asset.gzip = gzipCompress( identity );
+        }
+        catch( const std::runtime_error & )
+        {
+            asset.gzip.clear();
+        }
+        return asset;
+    }
+
+    /// @brief Whether the asset can be sent gzip-encoded.
+    bool has_gzip() const noexcept
+    {
+        return !gzip.empty();
+    }
+};
+} // namespace robot::src::detail::static_asset::inline exports
+
+namespace robot::src::inline exports::inline static_asset
+{
+using namespace detail::static_asset::exports;
+}
@@ -0,0 +1,175 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+#include "job_system.hpp"
+
+/// @file system_graph.hpp
+/// @brief Runs systems concurrently when their component accesses do not conflict.
+///
+/// Each system declares which component types it reads and which it writes.
+/// Two systems conflict when one writes a type the other reads or writes; a
+/// system then waits for every earlier-registered system it conflicts with, and
+/// starts as soon as those have finished. The result is the same as running
+/// the systems one after another in registration order, while systems that
+/// touch disjoint data overlap on the job system's threads.
+
+namespace robot::src::detail::system_graph::inline exports
+{
+/// @brief Component types a system only reads.
+template < typename... Ts >
+struct Reads
+{};
+
+/// @brief Component types a system modifies, including adding, removing or reordering entities.
+template < typename... Ts >
+struct Writes
+{};
+
+/// @class SystemGraph
+/// @brief Dependency graph of systems over a store, executed on a JobSystem.
+///
+/// @par Example usage:
+/// @code
+/// SystemGraph< EntityStore > systems;
+/// systems.add( "input", Reads< PlayerInput >{}, Writes< Velocity >{},
+///              []( EntityStore & store, JobSystem & ) { handlePlayerInput( store ); } );
+/// systems.add( "motion", Reads<>{}, Writes< Velocity, Position, Bounds >{},
+///              [ & ]( EntityStore & store, JobSystem & jobs ) { updatePositions( store, layout, jobs ); } );
+/// systems.run( store, jobs );
+/// @endcode
+///
+/// @tparam Store Type passed to every system, usually EntityStore.
+template < typename Store >
+class SystemGraph
+{
+public:
+    using System = std::function< void( Store &, JobSystem & ) >; ///< Callable run as one node of the graph
+
+private:
+    struct Node
+    {
+        std::string name;
+        std::vector< std::type_index > reads;
+        std::vector< std::type_index > writes;
+        System run;
+        std::vector< std::size_t > dependents; ///< Later nodes that wait for this one
+        std::size_t dependencies = 0; ///< Earlier nodes this one waits for
+    };
+
+    std::vector< Node > nodes_;
+    std::unique_ptr< std::atomic< std::size_t >[] > remaining_; ///< Unfinished dependencies during run()
+
+    static bool overlaps( const std::vector< std::type_index > & a, const std::vector< std::type_index > & b )
+    {
+        return std::any_of( a.begin(), a.end(), [ & ]( const auto & type ) {
+            return std::find( b.begin(), b.end(), type ) != b.end();
+        } );
+    }
+
+    static bool conflicts( const Node & a, const Node & b )
+    {
+        return overlaps( a.writes, b.writes ) || overlaps( a.writes, b.reads ) || overlaps( a.reads, b.writes );
+    }
+
+    void launch( std::size_t index, Store & store, JobSystem & jobs, JobCounter & counter )
+    {
+        jobs.submit( counter, [ this, index, &store, &jobs, &counter ] {
+            nodes_[ index ].run( store, jobs );
+            for( auto dependent : nodes_[ index ].dependents )
+            {
+                if( remaining_[ dependent ].fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+                {
+                    launch( dependent, store, jobs, counter );
+                }
+            }
+        } );
+    }
+
+public:
+    /// @brief Register a system after all systems added so far.
+    ///
+    /// @param name Label for diagnostics.
+    /// @param reads Component types the system only reads.
+    /// @param writes Component types the system writes.
+    /// @param system Callable taking the store and the job system, which it may use for data-parallel work.
+    /// @return Index of the system in the graph.
+    template < typename... R, typename... W >
+    std::size_t add( std::string name, Reads< R... >, Writes< W... >, System system )
+    {
+        Node node{ std::move( name ), { std::type_index( typeid( R ) )... }, { std::type_index( typeid( W ) )... },
+                   std::move( system ), {}, 0 };
+        std::size_t index = nodes_.size();
+        for( std::size_t earlier = 0; earlier < index; ++earlier )
+        {
+            if( conflicts( nodes_[ earlier ], node ) )
+            {
+                nodes_[ earlier ].dependents.push_back( index );
+                ++node.dependencies;
+            }
+        }
+        nodes_.push_back( std::move( node ) );
+        remaining_ = std::make_unique< std::atomic< std::size_t >[] >( nodes_.size() );
+        return index;
+    }
+
+    /// @brief Number of registered systems.
+    std::size_t size() const noexcept
+    {
+        return nodes_.size();
+    }
+
+    /// @brief Name of a registered system.
+    const std::string & name( std::size_t index ) const
+    {
+        return nodes_.at( index ).name;
+    }
+
+    /// @brief Whether system later must wait for system earlier.
+    /// @return True if earlier was registered before later and their accesses conflict.
+    bool depends_on( std::size_t later, std::size_t earlier ) const
+    {
+        const auto & dependents = nodes_.at( earlier ).dependents;
+        return std::find( dependents.begin(), dependents.end(), later ) != dependents.end();
+    }
+
+    /// @brief Run every system once, overlapping those that do not conflict.
+    ///
+    /// Returns when all systems have finished. If a system throws, the systems
+    /// that depend on it are skipped and the exception is rethrown here once the
+    /// others have finished. Not reentrant: one run() at a time per graph.
+    ///
+    /// @param store Store passed to every system.
+    /// @param jobs Pool the systems and their data-parallel work run on.
+    void run( Store & store, JobSystem & jobs )
+    {
+        JobCounter counter;
+        for( std::size_t i = 0; i < nodes_.size(); ++i )
+        {
+            remaining_[ i ].store( nodes_[ i ].dependencies, std::memory_order_relaxed );
+        }
+        for( std::size_t i = 0; i < nodes_.size(); ++i )
+        {
+            if( nodes_[ i ].dependencies == 0 )
+            {
+                launch( i, store, jobs, counter );
+            }
+        }
+        jobs.wait( counter );
+    }
+};
+} // namespace robot::src::detail::system_graph::inline exports
+
+namespace robot::src::inline exports::inline system_graph
+{
+using namespace detail::system_graph::exports;
+}
@@ -1,7 +1,21 @@
 static_assert( __cplusplus > 2020'00 );
 #pragma once
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "broad_phase.hpp"
+#include "component_types.hpp"
+#include "job_system.hpp"
+#include "logging.hpp"
+#include "motion.hpp"
 
 namespace robot::src::detail::systems::inline exports
 {
@@ -13,91 +27,428 @@ constexpr float WORLD_MAX_Y = 120.0f;
 constexpr float WORLD_WIDTH = WORLD_MAX_X - WORLD_MIN_X;
 constexpr float WORLD_HEIGHT = WORLD_MAX_Y - WORLD_MIN_Y;
 
+// Edge length of a broad-phase cell, roughly the size of a typical obstacle
+constexpr float COLLISION_CELL_SIZE = 20.0f;
+
+// Smallest batches worth handing to another thread: a SAT test costs well under
+// a microsecond, integrating an entity a few nanoseconds
+constexpr std::size_t COLLISION_PAIRS_PER_JOB = 64;
+constexpr std::size_t MOVERS_PER_JOB = 8192;
+
+// Area that positions wrap around
+inline constexpr AxisAlignedBoundingBox WORLD_BOUNDS{ { WORLD_MIN_X, WORLD_MIN_Y }, { WORLD_MAX_X, WORLD_MAX_Y } };
+
+/// @brief Construct a broad-phase grid covering the world bounds.
+inline UniformGrid makeCollisionGrid()
+{
+    return UniformGrid( WORLD_BOUNDS, COLLISION_CELL_SIZE );
+}
+
 inline float wrapCoordinate( float value, float min_val, float max_val )
 {
     float range = max_val - min_val;
     if( range <= 0.0f )
         return value;
-    while( value < min_val )
-        value += range;
-    while( value >= max_val )
-        value -= range;
-    return value;
+    return wrapPeriodic( value, min_val, range );
 }
 
 inline void handlePlayerInput( EntityStore & store )
 {
+    std::size_t applied = 0;
+    store.view< PlayerInput, Velocity >().for_each(
+        [ & ]( std::size_t, const PlayerInput & input, Velocity & velocity ) {
+            // Apply player input to entity's velocity
+            velocity = Velocity{ input.x, input.y };
+            ++applied;
+        } );
+
     auto & inputs = store.get< PlayerInput >();
-    auto & velocities = store.get< Velocity >();
+    if( applied != inputs.size() )
+    {
+        auto & velocities = store.get< Velocity >();
+        for( auto [ entity, input ] : inputs )
+        {
+            if( !velocities.contains( entity ) )
+            {
+                defaultLogger().warning( "Entity ", entity, " has PlayerInput but no Velocity component!" );
+            }
+        }
+    }
+}
+
+/// @brief Collision geometry of one entity, relative to its Position.
+struct CollisionGeometry
+{
+    ConvexView view; ///< Vertices, and normals when cached, in the frame given by origin
+    Vec2 origin; ///< Offset of the view's frame from the entity's Position
+};
+
+/// @brief Buffers for the vertices of a rotated or scaled shape instance during a collision test.
+struct InstanceScratch
+{
+    std::vector< Float > vertices_x;
+    std::vector< Float > vertices_y;
+};
 
-    for( auto [ entity, input ] : inputs )
+/// @brief Resolve the geometry an entity collides with: its own Polygon, or the shape it instances.
+///
+/// Polygons and translated instances are viewed in place, sharing the cached
+/// normals; only instances that rotate or scale their shape are transformed,
+/// into scratch, with normals derived on the fly.
+///
+/// @param store Entity store to read.
+/// @param entity Entity with a Polygon or a ShapeInstance.
+/// @param scratch Storage for transformed vertices; must outlive the returned view.
+/// @return View of the geometry and its offset from the entity's Position.
+inline CollisionGeometry collisionGeometry( const EntityStore & store, std::size_t entity, InstanceScratch & scratch )
+{
+    if( const auto * polygon = store.get< Polygon >().find( entity ) )
+    {
+        return { polygon->view(), {} };
+    }
+    const auto & instance = store.get< ShapeInstance >()[ entity ];
+    const auto & shape = store.shapes[ instance.shape ].polygon;
+    if( instance.translates_only() )
     {
-        // Apply player input to entity's velocity
-        if( velocities.contains( entity ) )
+        return { shape.view(), instance.transform.translation };
+    }
+
+    scratch.vertices_x.resize( shape.size() );
+    scratch.vertices_y.resize( shape.size() );
+    transformVertices( instance.placement(), shape.vertices_x.data(), shape.vertices_y.data(), shape.size(),
+                       scratch.vertices_x.data(), scratch.vertices_y.data() );
+    return { ConvexView{ scratch.vertices_x.data(), scratch.vertices_y.data(), nullptr, nullptr, shape.size() }, {} };
+}
+
+/// @brief Whether two entities' geometries overlap, measured the short way around the wrapping world.
+/// @param store Entity store to read.
+/// @param entity_a First entity; needs a Position and a Polygon or ShapeInstance.
+/// @param entity_b Second entity; same requirements.
+/// @param world_size Size of the wrapping world.
+/// @param scratch_a Scratch for entity_a's geometry.
+/// @param scratch_b Scratch for entity_b's geometry.
+inline bool geometriesIntersect( const EntityStore & store, std::size_t entity_a, std::size_t entity_b, Vec2 world_size,
+                                 InstanceScratch & scratch_a, InstanceScratch & scratch_b )
+{
+    const auto & positions = store.get< Position >();
+    auto a = collisionGeometry( store, entity_a, scratch_a );
+    auto b = collisionGeometry( store, entity_b, scratch_b );
+    Vec2 offset = wrappedDelta( positions[ entity_a ], positions[ entity_b ], world_size ) + b.origin - a.origin;
+    return satIntersects( a.view, b.view, offset );
+}
+
+/// @brief Earliest time two entities' geometries touch during the coming tick.
+///
+/// Both entities are taken to move by their Velocity, as updatePositions will
+/// move them; entities without one stay put. Distances are measured the short
+/// way around the wrapping world at the start of the tick, which is exact as
+/// long as no entity moves half the world or more in one tick.
+///
+/// @param store Entity store to read.
+/// @param entity_a First entity; needs a Position and a Polygon or ShapeInstance.
+/// @param entity_b Second entity; same requirements.
+/// @param world_size Size of the wrapping world.
+/// @param scratch_a Scratch for entity_a's geometry.
+/// @param scratch_b Scratch for entity_b's geometry.
+/// @return Fraction of the tick at first contact, 0 if they overlap already, or nothing if they stay apart.
+inline std::optional< Float > geometriesTimeOfImpact( const EntityStore & store, std::size_t entity_a,
+                                                      std::size_t entity_b, Vec2 world_size,
+                                                      InstanceScratch & scratch_a, InstanceScratch & scratch_b )
+{
+    const auto & positions = store.get< Position >();
+    const auto & velocities = store.get< Velocity >();
+    auto a = collisionGeometry( store, entity_a, scratch_a );
+    auto b = collisionGeometry( store, entity_b, scratch_b );
+    Vec2 offset = wrappedDelta( positions[ entity_a ], positions[ entity_b ], world_size ) + b.origin - a.origin;
+    Vec2 motion;
+    if( const auto * velocity = velocities.find( entity_b ) )
+    {
+        motion += *velocity;
+    }
+    if( const auto * velocity = velocities.find( entity_a ) )
+    {
+        motion -= *velocity;
+    }
+    return sweptTimeOfImpact( a.view, b.view, offset, motion );
+}
+
+/// @brief World-space box covering a body throughout one tick of motion.
+/// @param box Box at the start of the tick.
+/// @param velocity Displacement over the tick.
+/// @return The union of the box and the box moved by velocity.
+inline AxisAlignedBoundingBox sweptBox( const AxisAlignedBoundingBox & box, Vec2 velocity )
+{
+    return { Vec2{ box.min.x + std::min( velocity.x, 0.0f ), box.min.y + std::min( velocity.y, 0.0f ) },
+             Vec2{ box.max.x + std::max( velocity.x, 0.0f ), box.max.y + std::max( velocity.y, 0.0f ) } };
+}
+
+/// @brief Bucket the swept world-space boxes of every entity with Bounds into the grid.
+///
+/// Moving entities are bucketed by the area they sweep over the coming tick,
+/// so pairs that would meet mid-tick become candidates even if they are apart
+/// now. Entities at rest keep their cached box.
+///
+/// @param store Entity store to read.
+/// @param grid Broad-phase grid to rebuild.
+inline void fillBroadPhase( const EntityStore & store, UniformGrid & grid )
+{
+    [[maybe_unused]] const auto & polygons = store.get< Polygon >();
+    [[maybe_unused]] const auto & instances = store.get< ShapeInstance >();
+    [[maybe_unused]] const auto & positions = store.get< Position >();
+    const auto & velocities = store.get< Velocity >();
+
+    grid.clear();
+    for( auto [ entity, entity_bounds ] : store.get< Bounds >() )
+    {
+        assert( ( polygons.contains( entity ) || instances.contains( entity ) ) && positions.contains( entity ) );
+        const auto * velocity = velocities.find( entity );
+        if( velocity && ( velocity->x != 0.0f || velocity->y != 0.0f ) )
         {
-            velocities[ entity ] = Velocity{ input.x, input.y };
-            //std::cout << "Applied input to entity " << entity << ": velocity = (" << input.x << ", " << input.y << ")"
-            //          << std::endl;
+            grid.insert( entity, sweptBox( entity_bounds.world, *velocity ) );
         }
         else
         {
-            std::cerr << "Entity " << entity << " has PlayerInput but no Velocity component!" << std::endl;
+            grid.insert( entity, entity_bounds.world );
         }
     }
+    grid.build();
 }
 
-inline void handleCollisions( EntityStore & store )
+/// @brief Earliest impact of one entity that responds to hits.
+struct EarliestImpact
+{
+    std::size_t entity = 0; ///< Entity hit
+    Float time = 0.0f; ///< Fraction of the tick at its first contact
+    std::uint32_t contacts = 0; ///< Bodies touched at exactly that time
+};
+
+/// @brief Earliest impact of each entity that responds to hits, gathered over one tick's pairs.
+using ImpactTimes = std::vector< EarliestImpact >;
+
+/// @brief Keep the earliest time of impact of an entity with a HitCounter.
+///
+/// Later impacts are forgotten: the body stops at the first contact and never
+/// reaches them, so only the bodies touched at the earliest time count as hits.
+///
+/// @param store Entity store to read.
+/// @param impacts Impacts of the tick so far; entities without a HitCounter are not added.
+/// @param entity Entity in the colliding pair.
+/// @param time Fraction of the tick at which the pair touches.
+inline void registerImpact( const EntityStore & store, ImpactTimes & impacts, std::size_t entity, Float time )
+{
+    if( !store.get< HitCounter >().contains( entity ) )
+        return;
+    auto earliest = std::find_if( impacts.begin(), impacts.end(),
+                                  [ entity ]( const auto & impact ) { return impact.entity == entity; } );
+    if( earliest == impacts.end() )
+    {
+        impacts.push_back( EarliestImpact{ entity, time, 1 } );
+    }
+    else if( time < earliest->time )
+    {
+        earliest->time = time;
+        earliest->contacts = 1;
+    }
+    else if( time == earliest->time )
+    {
+        earliest->contacts += 1;
+    }
+}
+
+/// @brief Count each impacted entity's earliest contacts as hits and cut its velocity short there.
+///
+/// An entity that already overlaps something stops, as it always has; one that
+/// would reach an obstacle during the tick moves only as far as the contact,
+/// where the next tick finds the overlap, instead of passing through. Obstacles
+/// further along its path are never reached and so are not counted.
+///
+/// @param store Entity store to update.
+/// @param impacts Impacts gathered by registerImpact(); cleared on return.
+inline void applyImpacts( EntityStore & store, ImpactTimes & impacts )
 {
-    auto & polygons = store.get< Polygon >();
     auto & velocities = store.get< Velocity >();
     auto & hit_counters = store.get< HitCounter >();
-
-    // Use AABB checks to find potential collisions as the broad phase
-    for( auto [ entity_a, poly_a ] : polygons )
+    for( auto [ entity, time, contacts ] : impacts )
     {
-        for( auto [ entity_b, poly_b ] : polygons )
+        hit_counters[ entity ].hits += contacts;
+        if( auto * velocity = velocities.find( entity ) )
         {
-            if( entity_a >= entity_b )
-                continue; // Avoid duplicate checks and self-collision
+            *velocity = time == 0.0f ? Velocity{ 0.0f, 0.0f } : Velocity{ velocity->x * time, velocity->y * time };
+        }
+    }
+    impacts.clear();
+}
 
-            if( poly_a.may_intersect( { poly_b } ) )
-            {
-                // Perform narrow phase collision check using SAT
-                if( poly_a.intersects( poly_b ) )
-                {
-                    // We only need to handle the robot's collision, which is the entity with the HitCounter component.
-                    if( hit_counters.contains( entity_a ) )
-                    {
-                        hit_counters[ entity_a ].hits += 1;
-                        // zero out the velocity to stop movement after a hit
-                        if( velocities.contains( entity_a ) )
-                        {
-                            velocities[ entity_a ] = { 0.0f, 0.0f };
-                        }
-                    }
-                }
-            }
+/// @brief Detect collisions between world-placed polygons, record hits and stop the bodies hit.
+///
+/// Every polygon or shape instance that has cached Bounds is bucketed into the broad-phase grid by
+/// the box it sweeps this tick; only the candidate pairs the grid reports are
+/// passed to the swept SAT narrow phase, and only if one of the two has a
+/// HitCounter, since no other entity responds to a hit. Polygons without Bounds
+/// (and hence without a Position) are decorative and never collide. Distances
+/// are measured the short way around the wrapping world.
+///
+/// A body with a HitCounter that overlaps something counts a hit and stops. One
+/// that would touch something before the next tick counts a hit and has its
+/// velocity shortened to stop at the contact, so fast bodies cannot tunnel
+/// through thin ones however low the tick rate. Only the earliest contact of a
+/// tick counts (each body touched at that same time counts once); bodies it
+/// would have reached later in the tick are not hit.
+///
+/// @param store Entity store to update.
+/// @param grid Broad-phase grid, reused across ticks to avoid reallocation.
+inline void handleCollisions( EntityStore & store, UniformGrid & grid )
+{
+    const auto & hit_counters = store.get< HitCounter >();
+
+    fillBroadPhase( store, grid );
+
+    // Perform narrow phase collision check using swept SAT on each candidate pair
+    InstanceScratch scratch_a, scratch_b;
+    ImpactTimes impacts;
+    grid.for_each_candidate_pair( [ & ]( std::size_t entity_a, std::size_t entity_b ) {
+        if( !hit_counters.contains( entity_a ) && !hit_counters.contains( entity_b ) )
+            return;
+        if( auto time = geometriesTimeOfImpact( store, entity_a, entity_b, grid.world_size(), scratch_a, scratch_b ) )
+        {
+            registerImpact( store, impacts, entity_a, *time );
+            registerImpact( store, impacts, entity_b, *time );
+        }
+    } );
+    applyImpacts( store, impacts );
+}
+
+/// @brief Broad-phase grid and buffers reused by the parallel handleCollisions across ticks.
+struct CollisionWorkspace
+{
+    UniformGrid grid = makeCollisionGrid(); ///< Broad phase over the world bounds
+    std::vector< std::pair< UniformGrid::EntityId, UniformGrid::EntityId > > pairs; ///< Candidate pairs of the tick
+    std::vector< std::optional< Float > > impacts; ///< Narrow-phase time of impact for each candidate pair
+    ImpactTimes earliest; ///< Earliest impact of each entity hit, while the hits are applied
+};
+
+/// @brief Detect collisions with the narrow phase split across a job system.
+///
+/// The broad phase runs on the calling thread and collects the candidate pairs
+/// that involve a HitCounter; chunks of pairs are then tested concurrently, each
+/// job writing only its own slots of the impact times. Hits are applied
+/// afterwards in pair order, so the result is identical to the serial handleCollisions.
+///
+/// @param store Entity store to update.
+/// @param workspace Grid and buffers, reused across ticks to avoid reallocation.
+/// @param jobs Pool the narrow phase runs on.
+inline void handleCollisions( EntityStore & store, CollisionWorkspace & workspace, JobSystem & jobs )
+{
+    const auto & hit_counters = store.get< HitCounter >();
+
+    fillBroadPhase( store, workspace.grid );
+    workspace.grid.candidate_pairs( workspace.pairs );
+    std::erase_if( workspace.pairs, [ & ]( const auto & pair ) {
+        return !hit_counters.contains( pair.first ) && !hit_counters.contains( pair.second );
+    } );
+    workspace.impacts.assign( workspace.pairs.size(), std::nullopt );
+
+    Vec2 world_size = workspace.grid.world_size();
+    jobs.parallel_for( 0, workspace.pairs.size(), COLLISION_PAIRS_PER_JOB, [ & ]( std::size_t begin, std::size_t end ) {
+        InstanceScratch scratch_a, scratch_b;
+        for( std::size_t i = begin; i < end; ++i )
+        {
+            auto [ entity_a, entity_b ] = workspace.pairs[ i ];
+            workspace.impacts[ i ]
+                = geometriesTimeOfImpact( store, entity_a, entity_b, world_size, scratch_a, scratch_b );
         }
+    } );
+
+    for( std::size_t i = 0; i < workspace.pairs.size(); ++i )
+    {
+        if( !workspace.impacts[ i ] )
+            continue;
+        registerImpact( store, workspace.earliest, workspace.pairs[ i ].first, *workspace.impacts[ i ] );
+        registerImpact( store, workspace.earliest, workspace.pairs[ i ].second, *workspace.impacts[ i ] );
     }
+    applyImpacts( store, workspace.earliest );
 }
 
-inline void updatePositions( EntityStore & store )
+/// @brief Detect collisions using a temporary broad-phase grid.
+/// @param store Entity store to update.
+/// @see handleCollisions(EntityStore &, UniformGrid &) for the allocation-free form
+inline void handleCollisions( EntityStore & store )
+{
+    auto grid = makeCollisionGrid();
+    handleCollisions( store, grid );
+}
+
+/// @brief Alignment of the Velocity and Position storages kept by updatePositions between ticks.
+///
+/// updatePositions reorders both storages so the entities that have both come
+/// first in the same order, then integrates them as two flat arrays. The
+/// reordering is redone only when either storage's revision changes, so in a
+/// steady scene it costs nothing.
+struct MotionLayout
+{
+    // Storage revisions the alignment was computed for; the defaults match no storage
+    std::uint64_t velocity_revision = std::numeric_limits< std::uint64_t >::max();
+    std::uint64_t position_revision = std::numeric_limits< std::uint64_t >::max();
+    std::size_t size = 0; ///< Number of aligned entities with both components
+};
+
+/// @brief Integrate velocities into positions and refresh cached bounds of movers.
+///
+/// Positions are advanced by the SIMD kernel integrateWrapped() over the
+/// aligned fronts of the Velocity and Position storages. Entities at rest keep
+/// their exact position and their Bounds are never recomputed.
+///
+/// @param store Entity store to update.
+/// @param layout Alignment state, reused across ticks to avoid reordering the storages.
+/// @param jobs Pool the entity range is chunked across.
+inline void updatePositions( EntityStore & store, MotionLayout & layout, JobSystem & jobs )
 {
     auto & velocities = store.get< Velocity >();
     auto & positions = store.get< Position >();
+    auto & bounds = store.get< Bounds >();
 
-    for( auto [ entity, velocity ] : velocities )
+    if( layout.velocity_revision != velocities.revision() || layout.position_revision != positions.revision() )
     {
-        if( positions.contains( entity ) )
+        layout.size = store.align< Velocity, Position >();
+        layout.velocity_revision = velocities.revision();
+        layout.position_revision = positions.revision();
+    }
+
+    auto moving = std::span< const Velocity >( velocities.dense_data() ).first( layout.size );
+    auto placed = std::span< Position >( positions.dense_data() ).first( layout.size );
+    const auto & entities = velocities.dense_entities();
+
+    // Chunks touch disjoint positions and bounds, so they need no synchronization
+    jobs.parallel_for( 0, layout.size, MOVERS_PER_JOB, [ & ]( std::size_t begin, std::size_t end ) {
+        integrateWrapped( placed.subspan( begin, end - begin ), moving.subspan( begin, end - begin ), WORLD_BOUNDS );
+        for( std::size_t i = begin; i < end; ++i )
         {
-            auto & position = positions[ entity ];
-            position.x += velocity.x;
-            position.y += velocity.y;
-            // Wrap coordinates to keep them within world bounds
-            position.x = wrapCoordinate( position.x, WORLD_MIN_X, WORLD_MAX_X );
-            position.y = wrapCoordinate( position.y, WORLD_MIN_Y, WORLD_MAX_Y );
+            if( moving[ i ].x == 0.0f && moving[ i ].y == 0.0f )
+                continue;
+            if( auto * entity_bounds = bounds.find( entities[ i ] ) )
+            {
+                entity_bounds->update( placed[ i ] );
+            }
         }
-    }
+    } );
+}
+
+/// @brief Integrate velocities into positions on the calling thread.
+/// @param store Entity store to update.
+/// @param layout Alignment state, reused across ticks to avoid reordering the storages.
+inline void updatePositions( EntityStore & store, MotionLayout & layout )
+{
+    JobSystem serial( 0 );
+    updatePositions( store, layout, serial );
+}
+
+/// @brief Integrate velocities into positions, aligning the storages from scratch.
+/// @param store Entity store to update.
+/// @see updatePositions(EntityStore &, MotionLayout &) for the form that keeps the alignment
+inline void updatePositions( EntityStore & store )
+{
+    MotionLayout layout;
+    updatePositions( store, layout );
 }
 } // namespace robot::src::detail::systems::inline exports
 
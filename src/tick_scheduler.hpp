@@ -0,0 +1,174 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <stop_token>
+#include <thread>
+
+/// @file tick_scheduler.hpp
+/// @brief Fixed-timestep tick scheduler for the simulation main loop.
+///
+/// The scheduler wakes at absolute deadlines (sleep_until), measures how much
+/// real time has passed, and runs as many fixed-size simulation steps as that
+/// time covers. Every step advances the simulation by exactly one period, so
+/// physics stays deterministic no matter how the host is loaded; when the host
+/// falls behind, up to a bounded number of catch-up steps run back to back and
+/// anything beyond that is dropped rather than allowed to snowball.
+
+namespace robot::src::detail::tick_scheduler::inline exports
+{
+/// @brief Counters describing how the main loop is keeping up.
+///
+/// All members are atomics so other threads (e.g. a metrics endpoint) can read
+/// them while the loop is running.
+struct TickStats
+{
+    std::atomic< std::uint64_t > ticks{ 0 }; ///< Fixed steps executed so far
+    std::atomic< std::uint64_t > overruns{ 0 }; ///< Wake-ups whose work ran past the next deadline
+    std::atomic< std::uint64_t > dropped_steps{ 0 }; ///< Steps discarded by the catch-up limit
+    std::atomic< std::int64_t > last_tick_ns{ 0 }; ///< Duration of the most recent step
+    std::atomic< std::int64_t > max_tick_ns{ 0 }; ///< Longest step observed
+    std::atomic< std::int64_t > total_tick_ns{ 0 }; ///< Sum of all step durations
+};
+
+/// @class TickScheduler
+/// @brief Runs a step function at a fixed rate with a fixed-timestep accumulator.
+///
+/// @par Example usage:
+/// @code
+/// TickScheduler scheduler( std::chrono::milliseconds( 16 ) );
+/// scheduler.run( stop_token, [ & ] {
+///     simulation.step();
+///     snapshots.write_buffer().capture( simulation.store(), simulation.tick() );
+///     snapshots.publish();
+/// } );
+/// @endcode
+class TickScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock; ///< Monotonic clock used for deadlines
+    using Duration = Clock::duration; ///< Duration type of the clock
+
+    /// @brief Default simulation period, ~60 Hz.
+    static constexpr Duration DEFAULT_PERIOD = std::chrono::nanoseconds( 16'666'667 );
+
+    /// @brief Default number of steps that may run back to back to catch up.
+    static constexpr std::size_t DEFAULT_MAX_CATCH_UP_STEPS = 5;
+
+private:
+    Duration period_; ///< Simulated time advanced by one step
+    std::size_t max_catch_up_steps_; ///< Upper bound on steps per wake-up
+    Duration accumulator_{ 0 }; ///< Real time not yet consumed by steps
+    TickStats stats_; ///< Counters exposed to observers
+
+public:
+    /// @brief Construct a scheduler.
+    /// @param period Fixed simulation step; also the target wake-up interval.
+    /// @param max_catch_up_steps Maximum steps run per wake-up when behind.
+    explicit TickScheduler(
+        Duration period = DEFAULT_PERIOD,
+        std::size_t max_catch_up_steps = DEFAULT_MAX_CATCH_UP_STEPS )
+        : period_( period )
+        , max_catch_up_steps_( max_catch_up_steps )
+    {
+        assert( period_ > Duration::zero() );
+        assert( max_catch_up_steps_ > 0 );
+    }
+
+    /// @brief The fixed simulation step.
+    Duration period() const noexcept
+    {
+        return period_;
+    }
+
+    /// @brief Counters describing tick durations and overruns.
+    const TickStats & stats() const noexcept
+    {
+        return stats_;
+    }
+
+    /// @brief Add elapsed real time to the accumulator and consume whole steps.
+    ///
+    /// @param elapsed Real time since the previous call.
+    /// @return Number of fixed steps to run now, at most max_catch_up_steps.
+    ///
+    /// @note Steps beyond the catch-up limit are dropped and counted in
+    ///       TickStats::dropped_steps; the remainder below one period is kept.
+    std::size_t advance( Duration elapsed )
+    {
+        accumulator_ += elapsed;
+        auto due = static_cast< std::size_t >( accumulator_ / period_ );
+        accumulator_ -= period_ * static_cast< Duration::rep >( due );
+        if( due > max_catch_up_steps_ )
+        {
+            stats_.dropped_steps.fetch_add( due - max_catch_up_steps_, std::memory_order_relaxed );
+            due = max_catch_up_steps_;
+        }
+        return due;
+    }
+
+    /// @brief Record the wall-clock duration of one executed step.
+    /// @param busy Time spent inside the step function.
+    void record_tick( Duration busy )
+    {
+        auto ns = std::chrono::duration_cast< std::chrono::nanoseconds >( busy ).count();
+        stats_.ticks.fetch_add( 1, std::memory_order_relaxed );
+        stats_.last_tick_ns.store( ns, std::memory_order_relaxed );
+        stats_.total_tick_ns.fetch_add( ns, std::memory_order_relaxed );
+        auto previous_max = stats_.max_tick_ns.load( std::memory_order_relaxed );
+        while( ns > previous_max
+               && !stats_.max_tick_ns.compare_exchange_weak( previous_max, ns, std::memory_order_relaxed ) )
+        {
+        }
+    }
+
+    /// @brief Run step() at the fixed rate until a stop is requested.
+    ///
+    /// Sleeps until an absolute deadline between wake-ups, so the time spent in
+    /// step() does not push the schedule back. The caller is expected to take any
+    /// locks inside step() only, so nothing is held while the loop sleeps.
+    ///
+    /// @param stop_token Token checked once per wake-up.
+    /// @param step Callable invoked once per fixed step.
+    template < typename Step >
+    void run( std::stop_token stop_token, Step && step )
+    {
+        auto previous = Clock::now();
+        auto deadline = previous + period_;
+        while( !stop_token.stop_requested() )
+        {
+            std::this_thread::sleep_until( deadline );
+            auto now = Clock::now();
+            auto steps = advance( now - previous );
+            previous = now;
+
+            for( std::size_t i = 0; i < steps; ++i )
+            {
+                auto start = Clock::now();
+                step();
+                record_tick( Clock::now() - start );
+            }
+
+            deadline += period_;
+            auto finished = Clock::now();
+            if( finished > deadline )
+            {
+                stats_.overruns.fetch_add( 1, std::memory_order_relaxed );
+                if( finished - deadline > period_ )
+                {
+                    // Too far behind to catch up by sleeping less; restart the schedule
+                    deadline = finished + period_;
+                }
+            }
+        }
+    }
+};
+} // namespace robot::src::detail::tick_scheduler::inline exports
+
+namespace robot::src::inline exports::inline tick_scheduler
+{
+using namespace detail::tick_scheduler::exports;
+}
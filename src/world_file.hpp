@@ -0,0 +1,822 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "component_types.hpp"
+#include "logging.hpp"
+
+/// @file world_file.hpp
+/// @brief Versioned binary snapshots of an EntityStore, for checkpoints and pre-built maps.
+///
+/// A world file holds every component storage as contiguous dense arrays, in
+/// the store's own order, so loading maps the file and bulk-inserts straight
+/// from the mapping instead of parsing entities one by one. Polygons are kept
+/// as flattened vertex and normal arrays plus per-polygon offsets, and are
+/// rebuilt in the simulation's VertexArena. The registry's generations and free
+/// list are saved too, so a restored world hands out the same ids, steps to the
+/// same states, and keeps the same state hash as the world that was saved.
+///
+/// Layout, in native byte order (a marker rejects files from other-endian hosts):
+///
+///     WorldFileHeader | key bytes | section | section | ... | section table
+///
+/// Each section starts on a SECTION_ALIGNMENT boundary and is one array whose
+/// id, element size, offset and count are listed in the table at the end.
+/// WORLD_FILE_VERSION must be bumped whenever a component's layout changes;
+/// element sizes are checked on load as a backstop.
+
+namespace robot::src::detail::world_file
+{
+/// @brief Fixed-size start of a world file.
+struct WorldFileHeader
+{
+    char magic[ 8 ]; ///< "RBWORLD" and a NUL
+    std::uint32_t version; ///< WORLD_FILE_VERSION of the writer
+    std::uint32_t byte_order; ///< BYTE_ORDER_MARK as the writer saw it
+    std::uint64_t tick; ///< Simulation tick the world was saved at
+    std::uint64_t num_assets; ///< Asset count the world was built with
+    std::uint64_t table_offset; ///< Offset of the section table
+    std::uint32_t section_count; ///< Entries in the section table
+    std::uint32_t key_size; ///< Bytes of asset key following the header
+};
+
+/// @brief Where one array lives in a world file.
+struct SectionEntry
+{
+    std::uint32_t id; ///< What the array holds; see the section ids below
+    std::uint32_t element_size; ///< sizeof one element, checked against the reader's type
+    std::uint64_t offset; ///< Offset of the first element from the start of the file
+    std::uint64_t count; ///< Number of elements
+};
+
+inline constexpr char MAGIC[ 8 ] = { 'R', 'B', 'W', 'O', 'R', 'L', 'D', '\0' };
+inline constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304u;
+inline constexpr std::size_t SECTION_ALIGNMENT = 64; ///< A cache line, and enough for any component
+
+inline constexpr std::uint32_t REGISTRY_GENERATIONS = 1;
+inline constexpr std::uint32_t REGISTRY_ALIVE = 2;
+inline constexpr std::uint32_t REGISTRY_FREE = 3;
+inline constexpr std::uint32_t SHAPES = 0x10; ///< Polygon parts below, for the shape registry
+
+// Each storage I of the EntityStore owns the ids ( I + 1 ) << 8 | part
+inline constexpr std::uint32_t PART_ENTITIES = 0;
+inline constexpr std::uint32_t PART_DATA = 1; ///< Dense data of plain-data components
+inline constexpr std::uint32_t PART_OFFSETS = 1; ///< Polygons: first vertex of each, plus the total
+inline constexpr std::uint32_t PART_VERTICES_X = 2;
+inline constexpr std::uint32_t PART_VERTICES_Y = 3;
+inline constexpr std::uint32_t PART_NORMALS_X = 4;
+inline constexpr std::uint32_t PART_NORMALS_Y = 5;
+
+/// @brief Whether a component can be saved and loaded as its bytes.
+///
+/// Vec2 writes its own assignment, which makes every Vec2-derived component
+/// formally not trivially copyable, but they are all plain data.
+template < typename T >
+inline constexpr bool IS_PLAIN_DATA =
+    std::is_trivially_copyable_v< T > || ( std::is_standard_layout_v< T > && std::is_trivially_destructible_v< T > );
+
+constexpr std::uint32_t storageSection( std::size_t storage, std::uint32_t part ) noexcept
+{
+    return static_cast< std::uint32_t >( ( storage + 1 ) << 8 ) | part;
+}
+
+/// @brief Appends sections to an image, then seals it with the table and header.
+class ImageBuilder
+{
+private:
+    std::string & image_;
+    std::vector< SectionEntry > & table_;
+
+public:
+    ImageBuilder( std::string & image, std::vector< SectionEntry > & table, std::string_view key )
+        : image_( image )
+        , table_( table )
+    {
+        image_.assign( sizeof( WorldFileHeader ), '\0' );
+        image_.append( key );
+        table_.clear();
+    }
+
+    /// @brief Start a section of count elements of type T and return where they go.
+    template < typename T >
+    std::byte * begin_section( std::uint32_t id, std::size_t count )
+    {
+        image_.resize( ( image_.size() + SECTION_ALIGNMENT - 1 ) / SECTION_ALIGNMENT * SECTION_ALIGNMENT, '\0' );
+        table_.push_back( SectionEntry{ id, sizeof( T ), image_.size(), count } );
+        image_.resize( image_.size() + count * sizeof( T ) );
+        return reinterpret_cast< std::byte * >( image_.data() + table_.back().offset );
+    }
+
+    /// @brief Add a section copied from a contiguous array.
+    template < typename T >
+    void add( std::uint32_t id, std::span< const T > values )
+    {
+        static_assert( IS_PLAIN_DATA< T > );
+        if( !values.empty() )
+        {
+            std::memcpy( begin_section< T >( id, values.size() ), values.data(), values.size_bytes() );
+        }
+        else
+        {
+            begin_section< T >( id, 0 );
+        }
+    }
+
+    /// @brief Add a section of entity ids, narrowed to the registry's 32 bits.
+    void add_entities( std::uint32_t id, const std::vector< std::size_t > & entities )
+    {
+        auto * out = begin_section< std::uint32_t >( id, entities.size() );
+        for( std::size_t i = 0; i < entities.size(); ++i )
+        {
+            auto entity = static_cast< std::uint32_t >( entities[ i ] );
+            std::memcpy( out + i * sizeof( entity ), &entity, sizeof( entity ) );
+        }
+    }
+
+    /// @brief Add the offsets, vertices and normals of a sequence of polygons.
+    /// @param get Maps an index in [0, count) to the polygon stored there.
+    template < typename Get >
+    void add_polygons( std::uint32_t base, std::size_t count, Get get )
+    {
+        auto * offsets = begin_section< std::uint32_t >( base | PART_OFFSETS, count + 1 );
+        std::uint32_t total = 0;
+        for( std::size_t i = 0; i <= count; ++i )
+        {
+            std::memcpy( offsets + i * sizeof( total ), &total, sizeof( total ) );
+            if( i < count )
+            {
+                total += static_cast< std::uint32_t >( get( i ).size() );
+            }
+        }
+        auto add_vertices = [ & ]( std::uint32_t part, auto member ) {
+            auto * out = begin_section< Float >( base | part, total );
+            for( std::size_t i = 0; i < count; ++i )
+            {
+                const auto & values = get( i ).*member;
+                std::memcpy( out, values.data(), values.size() * sizeof( Float ) );
+                out += values.size() * sizeof( Float );
+            }
+        };
+        add_vertices( PART_VERTICES_X, &Polygon::vertices_x );
+        add_vertices( PART_VERTICES_Y, &Polygon::vertices_y );
+        auto add_normals = [ & ]( std::uint32_t part, auto member, Float Vec2::*axis ) {
+            auto * out = begin_section< Float >( base | part, total );
+            for( std::size_t i = 0; i < count; ++i )
+            {
+                const auto & polygon = get( i );
+                if( polygon.has_normals() )
+                {
+                    const auto & values = polygon.*member;
+                    std::memcpy( out, values.data(), values.size() * sizeof( Float ) );
+                    out += values.size() * sizeof( Float );
+                    continue;
+                }
+                // Stale normals are saved as the narrow phase would compute them, so the loaded cache is valid
+                for( std::size_t j = 0; j < polygon.size(); ++j, out += sizeof( Float ) )
+                {
+                    Float value = polygon.get_edge_normal( j ).*axis;
+                    std::memcpy( out, &value, sizeof( value ) );
+                }
+            }
+        };
+        add_normals( PART_NORMALS_X, &Polygon::normals_x, &Vec2::x );
+        add_normals( PART_NORMALS_Y, &Polygon::normals_y, &Vec2::y );
+    }
+
+    /// @brief Append the table and fill in the header.
+    void seal( std::uint32_t version, std::uint64_t tick, std::uint64_t num_assets, std::size_t key_size )
+    {
+        image_.resize( ( image_.size() + alignof( SectionEntry ) - 1 ) / alignof( SectionEntry )
+                       * alignof( SectionEntry ) );
+        WorldFileHeader header{};
+        std::memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+        header.version = version;
+        header.byte_order = BYTE_ORDER_MARK;
+        header.tick = tick;
+        header.num_assets = num_assets;
+        header.table_offset = image_.size();
+        header.section_count = static_cast< std::uint32_t >( table_.size() );
+        header.key_size = static_cast< std::uint32_t >( key_size );
+        image_.append( reinterpret_cast< const char * >( table_.data() ), table_.size() * sizeof( SectionEntry ) );
+        std::memcpy( image_.data(), &header, sizeof( header ) );
+    }
+};
+
+/// @brief Bounds-checked access to the sections of an image.
+class ImageReader
+{
+private:
+    std::span< const std::byte > image_;
+    WorldFileHeader header_{};
+
+    [[noreturn]] static void fail( const std::string & what )
+    {
+        throw std::runtime_error( "world file: " + what );
+    }
+
+public:
+    ImageReader( std::span< const std::byte > image, std::uint32_t version )
+        : image_( image )
+    {
+        if( image_.size() < sizeof( header_ ) )
+        {
+            fail( "truncated header" );
+        }
+        std::memcpy( &header_, image_.data(), sizeof( header_ ) );
+        if( std::memcmp( header_.magic, MAGIC, sizeof( MAGIC ) ) != 0 )
+        {
+            fail( "not a world file" );
+        }
+        if( header_.byte_order != BYTE_ORDER_MARK )
+        {
+            fail( "written with a different byte order" );
+        }
+        if( header_.version != version )
+        {
+            fail( "version " + std::to_string( header_.version ) + ", expected " + std::to_string( version ) );
+        }
+        if( header_.key_size > image_.size() - sizeof( header_ ) || header_.table_offset > image_.size()
+            || header_.table_offset % alignof( SectionEntry ) != 0
+            || header_.section_count > ( image_.size() - header_.table_offset ) / sizeof( SectionEntry ) )
+        {
+            fail( "truncated" );
+        }
+    }
+
+    const WorldFileHeader & header() const noexcept
+    {
+        return header_;
+    }
+
+    std::string key() const
+    {
+        return { reinterpret_cast< const char * >( image_.data() ) + sizeof( header_ ), header_.key_size };
+    }
+
+    /// @brief The array of a section, which must exist and hold elements of type T.
+    template < typename T >
+    std::span< const T > section( std::uint32_t id ) const
+    {
+        for( std::uint32_t i = 0; i < header_.section_count; ++i )
+        {
+            SectionEntry entry;
+            std::memcpy( &entry, image_.data() + header_.table_offset + i * sizeof( entry ), sizeof( entry ) );
+            if( entry.id != id )
+            {
+                continue;
+            }
+            if( entry.element_size != sizeof( T ) )
+            {
+                fail( "section " + std::to_string( id ) + " has elements of " + std::to_string( entry.element_size )
+                      + " bytes, expected " + std::to_string( sizeof( T ) ) );
+            }
+            if( entry.offset > image_.size() || entry.count > ( image_.size() - entry.offset ) / sizeof( T ) )
+            {
+                fail( "section " + std::to_string( id ) + " runs past the end" );
+            }
+            const auto * data = image_.data() + entry.offset;
+            if( reinterpret_cast< std::uintptr_t >( data ) % alignof( T ) != 0 )
+            {
+                fail( "section " + std::to_string( id ) + " is misaligned" );
+            }
+            return { reinterpret_cast< const T * >( data ), static_cast< std::size_t >( entry.count ) };
+        }
+        fail( "missing section " + std::to_string( id ) );
+    }
+
+    /// @brief Rebuild the polygons of a polygon section group in an arena.
+    /// @param each Called with ( index, Polygon && ) for every polygon in order.
+    template < typename Each >
+    void read_polygons( std::uint32_t base, std::pmr::memory_resource * arena, Each each ) const
+    {
+        auto offsets = section< std::uint32_t >( base | PART_OFFSETS );
+        auto vertices_x = section< Float >( base | PART_VERTICES_X );
+        auto vertices_y = section< Float >( base | PART_VERTICES_Y );
+        auto normals_x = section< Float >( base | PART_NORMALS_X );
+        auto normals_y = section< Float >( base | PART_NORMALS_Y );
+        auto total = vertices_x.size();
+        if( offsets.empty() || offsets.front() != 0 || offsets.back() != total || vertices_y.size() != total
+            || normals_x.size() != total || normals_y.size() != total )
+        {
+            fail( "inconsistent polygon section " + std::to_string( base ) );
+        }
+        for( std::size_t i = 0; i + 1 < offsets.size(); ++i )
+        {
+            auto first = offsets[ i ];
+            auto last = offsets[ i + 1 ];
+            if( last < first || last > total )
+            {
+                fail( "inconsistent polygon section " + std::to_string( base ) );
+            }
+            Polygon polygon{ Polygon::allocator_type( arena ) };
+            polygon.vertices_x.assign( vertices_x.begin() + first, vertices_x.begin() + last );
+            polygon.vertices_y.assign( vertices_y.begin() + first, vertices_y.begin() + last );
+            polygon.normals_x.assign( normals_x.begin() + first, normals_x.begin() + last );
+            polygon.normals_y.assign( normals_y.begin() + first, normals_y.begin() + last );
+            each( i, std::move( polygon ) );
+        }
+    }
+};
+
+/// @brief Close a file descriptor when it goes out of scope.
+class FileDescriptor
+{
+private:
+    int fd_;
+
+public:
+    explicit FileDescriptor( int fd ) noexcept
+        : fd_( fd )
+    {}
+    ~FileDescriptor()
+    {
+        if( fd_ >= 0 )
+        {
+            ::close( fd_ );
+        }
+    }
+    FileDescriptor( const FileDescriptor & ) = delete;
+    FileDescriptor & operator=( const FileDescriptor & ) = delete;
+
+    int get() const noexcept
+    {
+        return fd_;
+    }
+
+    /// @brief Close now, reporting the error a deferred write may only show here.
+    int close() noexcept
+    {
+        int result = ::close( fd_ );
+        fd_ = -1;
+        return result;
+    }
+};
+
+[[noreturn]] inline void throwErrno( const std::string & what )
+{
+    throw std::system_error( errno, std::generic_category(), what );
+}
+} // namespace robot::src::detail::world_file
+
+namespace robot::src::detail::world_file::inline exports
+{
+/// @brief Format version written, and the only one read.
+inline constexpr std::uint32_t WORLD_FILE_VERSION = 1;
+
+/// @brief Ticks between background checkpoints when none is given.
+inline constexpr std::uint64_t DEFAULT_CHECKPOINT_INTERVAL = 600; // Ten seconds at 60 Hz
+
+/// @brief What a world file records besides the store, to carry on from where it was saved.
+struct WorldFileInfo
+{
+    std::string key; ///< Asset key the world was built from
+    std::size_t num_assets = 0; ///< Asset count the world was built with
+    std::uint64_t tick = 0; ///< Simulation tick at the save
+};
+
+/// @brief Encode a store into a world file image.
+///
+/// The image's memory is reused, so encoding into the same string again does
+/// not allocate unless the world grew.
+///
+/// @param store Store to save.
+/// @param info Key, asset count and tick to record alongside it.
+/// @param image Replaced by the encoded file.
+inline void writeWorldImage( const EntityStore & store, const WorldFileInfo & info, std::string & image )
+{
+    thread_local std::vector< SectionEntry > table;
+    ImageBuilder builder( image, table, info.key );
+
+    builder.add< std::uint32_t >( REGISTRY_GENERATIONS, store.registry.generations() );
+    builder.add< std::uint8_t >( REGISTRY_ALIVE, store.registry.alive_flags() );
+    builder.add< std::uint32_t >( REGISTRY_FREE, store.registry.free_list() );
+
+    builder.add_polygons( SHAPES, store.shapes.size(), [ &store ]( std::size_t i ) -> const Polygon & {
+        return store.shapes[ static_cast< ShapeId >( i ) ].polygon;
+    } );
+
+    [ & ]< std::size_t... I >( std::index_sequence< I... > ) {
+        (
+            [ & ] {
+                const auto & storage = std::get< I >( store.storages );
+                using T = typename std::remove_cvref_t< decltype( storage ) >::value_type;
+                builder.add_entities( storageSection( I, PART_ENTITIES ), storage.dense_entities() );
+                const auto & data = storage.dense_data();
+                if constexpr( std::is_same_v< T, Polygon > )
+                {
+                    builder.add_polygons( storageSection( I, 0 ), data.size(),
+                                          [ &data ]( std::size_t i ) -> const Polygon & { return data[ i ]; } );
+                }
+                else
+                {
+                    static_assert( IS_PLAIN_DATA< T >, "other components need an encoding of their own" );
+                    builder.add< T >( storageSection( I, PART_DATA ), data );
+                }
+            }(),
+            ... );
+    }( std::make_index_sequence< std::tuple_size_v< decltype( store.storages ) > >{} );
+
+    builder.seal( WORLD_FILE_VERSION, info.tick, info.num_assets, info.key.size() );
+}
+
+/// @brief Replace the contents of a store with a world file image.
+///
+/// Like buildProceduralAssets, the store is cleared and the arena released
+/// first, and the polygons are rebuilt in the arena. Every other storage is
+/// bulk-inserted from the image's arrays without any per-entity decoding.
+///
+/// @param image Whole file, e.g. MappedFile::bytes(); must be aligned as a mapping or heap block is.
+/// @param store Store to clear and fill.
+/// @param arena Arena owned alongside store; released and refilled.
+/// @return The key, asset count and tick the world was saved with.
+/// @throw std::runtime_error if the image is not a valid world file of this version;
+///        the store is left empty.
+inline WorldFileInfo readWorldImage( std::span< const std::byte > image, EntityStore & store, VertexArena & arena )
+{
+    store.clear();
+    arena.release();
+    try
+    {
+        ImageReader reader( image, WORLD_FILE_VERSION );
+        WorldFileInfo info{ reader.key(), static_cast< std::size_t >( reader.header().num_assets ),
+                            reader.header().tick };
+
+        auto alive = reader.section< std::uint8_t >( REGISTRY_ALIVE );
+        try
+        {
+            store.registry.restore( reader.section< std::uint32_t >( REGISTRY_GENERATIONS ), alive,
+                                    reader.section< std::uint32_t >( REGISTRY_FREE ) );
+        }
+        catch( const std::invalid_argument & e )
+        {
+            throw std::runtime_error( std::string( "world file: " ) + e.what() );
+        }
+
+        reader.read_polygons( SHAPES, arena.resource(), [ &store ]( std::size_t, Polygon && polygon ) {
+            store.shapes.add( std::move( polygon ) );
+        } );
+
+        [ & ]< std::size_t... I >( std::index_sequence< I... > ) {
+            (
+                [ & ] {
+                    auto & storage = std::get< I >( store.storages );
+                    using T = typename std::remove_cvref_t< decltype( storage ) >::value_type;
+                    auto entities = reader.section< std::uint32_t >( storageSection( I, PART_ENTITIES ) );
+                    for( auto entity : entities )
+                    {
+                        if( entity >= alive.size() || !alive[ entity ] )
+                        {
+                            throw std::runtime_error( "world file: component of a dead entity "
+                                                      + std::to_string( entity ) );
+                        }
+                    }
+                    if constexpr( std::is_same_v< T, Polygon > )
+                    {
+                        storage.reserve( entities.size() );
+                        std::size_t count = 0;
+                        reader.read_polygons( storageSection( I, 0 ), arena.resource(),
+                                              [ & ]( std::size_t i, Polygon && polygon ) {
+                                                  if( i < entities.size() )
+                                                      storage.insert( entities[ i ], std::move( polygon ) );
+                                                  ++count;
+                                              } );
+                        if( count != entities.size() )
+                        {
+                            throw std::runtime_error( "world file: polygon count differs from its entities" );
+                        }
+                    }
+                    else
+                    {
+                        auto data = reader.section< T >( storageSection( I, PART_DATA ) );
+                        if( data.size() != entities.size() )
+                        {
+                            throw std::runtime_error( "world file: storage " + std::to_string( I )
+                                                      + " has a different number of entities and values" );
+                        }
+                        storage.insert_range( entities, data );
+                    }
+                }(),
+                ... );
+        }( std::make_index_sequence< std::tuple_size_v< decltype( store.storages ) > >{} );
+
+        for( const auto & instance : store.get< ShapeInstance >().dense_data() )
+        {
+            if( !store.shapes.find( instance.shape ) )
+            {
+                throw std::runtime_error( "world file: instance of unknown shape " + std::to_string( instance.shape ) );
+            }
+        }
+        return info;
+    }
+    catch( ... )
+    {
+        store.clear();
+        arena.release();
+        throw;
+    }
+}
+
+/// @class MappedFile
+/// @brief Read-only memory mapping of a whole file.
+class MappedFile
+{
+private:
+    void * data_ = nullptr;
+    std::size_t size_ = 0;
+
+public:
+    /// @brief Map a file.
+    /// @throw std::system_error if the file cannot be opened or mapped.
+    explicit MappedFile( const std::string & path )
+    {
+        FileDescriptor fd( ::open( path.c_str(), O_RDONLY | O_CLOEXEC ) );
+        if( fd.get() < 0 )
+        {
+            throwErrno( "open " + path );
+        }
+        struct stat status;
+        if( ::fstat( fd.get(), &status ) != 0 )
+        {
+            throwErrno( "stat " + path );
+        }
+        size_ = static_cast< std::size_t >( status.st_size );
+        if( size_ == 0 )
+        {
+            return; // Nothing to map; readers see an empty, and so invalid, image
+        }
+        data_ = ::mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd.get(), 0 );
+        if( data_ == MAP_FAILED )
+        {
+            data_ = nullptr;
+            throwErrno( "mmap " + path );
+        }
+        // The loader streams through the arrays once, front to back. The advice values are
+        // not flags and cannot be or-ed together; each is only a hint, so a refusal is logged
+        for( int advice : { MADV_SEQUENTIAL, MADV_WILLNEED } )
+        {
+            if( ::madvise( data_, size_, advice ) != 0 )
+            {
+                defaultLogger().debug( "madvise ", path, ": ", std::generic_category().message( errno ) );
+            }
+        }
+    }
+
+    ~MappedFile()
+    {
+        if( data_ )
+        {
+            ::munmap( data_, size_ );
+        }
+    }
+
+    MappedFile( const MappedFile & ) = delete;
+    MappedFile & operator=( const MappedFile & ) = delete;
+
+    /// @brief The file's contents; valid for the mapping's lifetime.
+    std::span< const std::byte > bytes() const noexcept
+    {
+        return { static_cast< const std::byte * >( data_ ), size_ };
+    }
+};
+
+/// @brief Replace a file's contents so that readers see either the old or the new file, never a mix.
+///
+/// The bytes go to path + ".tmp", are flushed to disk, and the temporary is
+/// renamed over path. The directory is flushed too, so the rename itself
+/// survives a crash.
+///
+/// @throw std::system_error if any step fails; path is left as it was.
+inline void writeFileAtomically( const std::string & path, std::string_view bytes )
+{
+    auto temporary = path + ".tmp";
+    try
+    {
+        FileDescriptor fd( ::open( temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 ) );
+        if( fd.get() < 0 )
+        {
+            throwErrno( "open " + temporary );
+        }
+        while( !bytes.empty() )
+        {
+            auto written = ::write( fd.get(), bytes.data(), bytes.size() );
+            if( written < 0 )
+            {
+                if( errno == EINTR )
+                    continue;
+                throwErrno( "write " + temporary );
+            }
+            bytes.remove_prefix( static_cast< std::size_t >( written ) );
+        }
+        if( ::fsync( fd.get() ) != 0 )
+        {
+            throwErrno( "fsync " + temporary );
+        }
+        if( fd.close() != 0 )
+        {
+            throwErrno( "close " + temporary );
+        }
+        if( ::rename( temporary.c_str(), path.c_str() ) != 0 )
+        {
+            throwErrno( "rename " + temporary );
+        }
+        auto directory = std::filesystem::path( path ).parent_path().string();
+        if( directory.empty() )
+        {
+            directory = ".";
+        }
+        FileDescriptor dir( ::open( directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC ) );
+        if( dir.get() < 0 || ::fsync( dir.get() ) != 0 )
+        {
+            throwErrno( "fsync " + directory );
+        }
+    }
+    catch( ... )
+    {
+        ::unlink( temporary.c_str() );
+        throw;
+    }
+}
+
+/// @brief Write a store to a world file.
+/// @throw std::system_error if the file cannot be written.
+inline void saveWorld( const std::string & path, const EntityStore & store, const WorldFileInfo & info )
+{
+    std::string image;
+    writeWorldImage( store, info, image );
+    writeFileAtomically( path, image );
+}
+
+/// @brief Replace the contents of a store with a world file.
+/// @throw std::system_error if the file cannot be mapped, std::runtime_error if it is invalid.
+inline WorldFileInfo loadWorld( const std::string & path, EntityStore & store, VertexArena & arena )
+{
+    MappedFile file( path );
+    return readWorldImage( file.bytes(), store, arena );
+}
+
+/// @class Checkpointer
+/// @brief Saves the world every few ticks without making the tick wait for the disk.
+///
+/// The stepping thread only copies the store into a capture the writer owns,
+/// which costs a copy of the dense arrays; a writer thread then encodes the
+/// capture and does the file I/O and fsync. While a write is still in flight,
+/// further checkpoints are skipped rather than queued, so a slow disk or a
+/// large world costs checkpoint frequency, not tick time. The capture and the
+/// image are reused, so steady-state checkpoints of a world that did not grow
+/// do not allocate.
+///
+/// @par Example usage:
+/// @code
+/// Checkpointer checkpointer( "world.bin", 600 );
+/// // after each step, on the stepping thread:
+/// checkpointer.maybe_checkpoint( simulation.store(), { key, num_assets, simulation.tick() } );
+/// @endcode
+class Checkpointer
+{
+private:
+    std::string path_;
+    std::uint64_t interval_;
+    EntityStore captured_; ///< Copy of the store to save; owned by the writer while busy_
+    WorldFileInfo captured_info_; ///< Info saved with captured_
+    std::string image_; ///< Encoded and written by the writer thread
+    bool busy_ = false;
+    std::mutex mutex_;
+    std::condition_variable_any wake_;
+    std::condition_variable idle_;
+    std::atomic< std::uint64_t > written_{ 0 };
+    std::atomic< std::uint64_t > skipped_{ 0 };
+    std::atomic< std::uint64_t > failed_{ 0 };
+    std::jthread writer_; ///< Declared last so it stops before the members it uses are destroyed
+
+    void write( std::stop_token stop_token )
+    {
+        std::unique_lock< std::mutex > lock( mutex_ );
+        // A checkpoint handed over before the stop is still written
+        while( wake_.wait( lock, stop_token, [ this ] { return busy_; } ) )
+        {
+            lock.unlock();
+            try
+            {
+                writeWorldImage( captured_, captured_info_, image_ );
+                writeFileAtomically( path_, image_ );
+                written_.fetch_add( 1, std::memory_order_relaxed );
+            }
+            catch( const std::exception & e )
+            {
+                failed_.fetch_add( 1, std::memory_order_relaxed );
+                defaultLogger().warning( "Checkpoint failed: ", e.what() );
+            }
+            lock.lock();
+            busy_ = false;
+            idle_.notify_all();
+        }
+    }
+
+public:
+    /// @brief Start the writer thread.
+    /// @param path File each checkpoint replaces.
+    /// @param interval_ticks maybe_checkpoint() saves on ticks that are multiples of this; 0 never does.
+    Checkpointer( std::string path, std::uint64_t interval_ticks = DEFAULT_CHECKPOINT_INTERVAL )
+        : path_( std::move( path ) )
+        , interval_( interval_ticks )
+        , writer_( [ this ]( std::stop_token stop_token ) { write( stop_token ); } )
+    {}
+
+    Checkpointer( const Checkpointer & ) = delete;
+    Checkpointer & operator=( const Checkpointer & ) = delete;
+
+    /// @brief Checkpoint if info.tick is due; call after every step.
+    /// @return Whether a checkpoint was handed to the writer.
+    bool maybe_checkpoint( const EntityStore & store, const WorldFileInfo & info )
+    {
+        if( interval_ == 0 || info.tick % interval_ != 0 )
+        {
+            return false;
+        }
+        return checkpoint( store, info );
+    }
+
+    /// @brief Capture the store now and hand it to the writer, unless a write is still in flight.
+    /// @return Whether a checkpoint was handed to the writer.
+    bool checkpoint( const EntityStore & store, const WorldFileInfo & info )
+    {
+        {
+            // Only this thread sets busy_, so the writer cannot become busy behind this check
+            std::lock_guard< std::mutex > lock( mutex_ );
+            if( busy_ )
+            {
+                skipped_.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+        }
+        // The writer is idle, so the capture is this thread's until busy_ is set
+        captured_ = store;
+        captured_info_ = info;
+        {
+            std::lock_guard< std::mutex > lock( mutex_ );
+            busy_ = true;
+        }
+        wake_.notify_one();
+        return true;
+    }
+
+    /// @brief Block until the checkpoint in flight, if any, is on disk.
+    void flush()
+    {
+        std::unique_lock< std::mutex > lock( mutex_ );
+        idle_.wait( lock, [ this ] { return !busy_; } );
+    }
+
+    /// @brief File each checkpoint replaces.
+    const std::string & path() const noexcept
+    {
+        return path_;
+    }
+
+    /// @brief Checkpoints written to disk.
+    std::uint64_t written() const noexcept
+    {
+        return written_.load( std::memory_order_relaxed );
+    }
+
+    /// @brief Checkpoints skipped because the previous one was still being written.
+    std::uint64_t skipped() const noexcept
+    {
+        return skipped_.load( std::memory_order_relaxed );
+    }
+
+    /// @brief Checkpoints that could not be written.
+    std::uint64_t failed() const noexcept
+    {
+        return failed_.load( std::memory_order_relaxed );
+    }
+};
+} // namespace robot::src::detail::world_file::inline exports
+
+namespace robot::src::inline exports::inline world_file
+{
+using namespace detail::world_file::exports;
+}
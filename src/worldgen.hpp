@@ -0,0 +1,474 @@
+static_assert( __cplusplus > 2020'00 );
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "assets.hpp"
+#include "broad_phase.hpp"
+#include "component_types.hpp"
+#include "job_system.hpp"
+#include "systems.hpp"
+
+/// @file worldgen.hpp
+/// @brief Parallel, deterministic procedural generation of large worlds.
+///
+/// The world is cut into a square grid of chunks, and every chunk draws its
+/// bodies from its own stream of a counter-based generator (Philox4x32-10).
+/// A candidate's random numbers are a pure function of the key, its chunk, its
+/// slot and its attempt. Chunks can therefore be generated in any order on any
+/// number of threads and still give the same world for the same key.
+///
+/// Overlap rejection is optional. Chunks are processed in four phases of a 2x2
+/// checkerboard, so no two chunks of a phase touch, even across the wrapping
+/// edges. A chunk checks its candidates against its own accepted bodies, and
+/// through a UniformGrid against those accepted in earlier phases. A chunk is
+/// at least as wide as the largest body, so only neighbouring chunks can clash.
+///
+/// The entities are then created in chunk order and bulk-inserted into
+/// storages reserved for the whole world.
+
+namespace robot::src::detail::worldgen::inline exports
+{
+/// @brief Counter-based random number generator: Philox4x32 with 10 rounds.
+///
+/// Salmon et al., "Parallel random numbers: as easy as 1, 2, 3" (SC 2011).
+/// Each call maps a 128-bit counter and a 64-bit key to 128 random bits, with
+/// no state carried between calls, so any number of independent streams can
+/// be addressed directly.
+struct Philox4x32
+{
+    using Counter = std::array< std::uint32_t, 4 >;
+    using Key = std::array< std::uint32_t, 2 >;
+
+    /// @brief The 128 random bits for a counter under a key.
+    static constexpr Counter generate( Counter counter, Key key ) noexcept
+    {
+        constexpr std::uint32_t M0 = 0xD2511F53u;
+        constexpr std::uint32_t M1 = 0xCD9E8D57u;
+        constexpr std::uint32_t W0 = 0x9E3779B9u; // Golden ratio
+        constexpr std::uint32_t W1 = 0xBB67AE85u; // sqrt( 3 ) - 1
+        for( int round = 0; round < 10; ++round )
+        {
+            if( round > 0 )
+            {
+                key[ 0 ] += W0;
+                key[ 1 ] += W1;
+            }
+            std::uint64_t product0 = std::uint64_t{ M0 } * counter[ 0 ];
+            std::uint64_t product1 = std::uint64_t{ M1 } * counter[ 2 ];
+            counter = { static_cast< std::uint32_t >( product1 >> 32 ) ^ counter[ 1 ] ^ key[ 0 ],
+                        static_cast< std::uint32_t >( product1 ),
+                        static_cast< std::uint32_t >( product0 >> 32 ) ^ counter[ 3 ] ^ key[ 1 ],
+                        static_cast< std::uint32_t >( product0 ) };
+        }
+        return counter;
+    }
+};
+
+/// @brief Map 32 random bits to a float in [0, 1).
+constexpr Float unitFloat( std::uint32_t bits ) noexcept
+{
+    return static_cast< Float >( bits >> 8 ) * ( 1.0f / 16777216.0f );
+}
+
+/// @brief Generator key of a world key.
+///
+/// FNV-1a rather than std::hash, so a key names the same world on every
+/// platform and standard library.
+constexpr Philox4x32::Key worldgenKey( std::string_view key ) noexcept
+{
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for( char c : key )
+    {
+        hash = ( hash ^ static_cast< unsigned char >( c ) ) * 0x100000001b3ull;
+    }
+    return { static_cast< std::uint32_t >( hash ), static_cast< std::uint32_t >( hash >> 32 ) };
+}
+
+/// @brief What generateWorld() builds.
+struct WorldGenOptions
+{
+    std::size_t obstacles = 10; ///< Static polygons to place
+    std::size_t movers = 10; ///< Moving triangles to place
+    std::size_t chunks_per_axis = 8; ///< Chunks along each axis; even, with chunks at least 2 * max_radius wide
+    Float min_radius = 3.0f; ///< Smallest obstacle circumradius
+    Float max_radius = 12.0f; ///< Largest obstacle circumradius
+    bool reject_overlaps = false; ///< Redraw bodies that would overlap one already placed, or the robot
+    std::size_t max_attempts = 8; ///< Draws per body before it is dropped, when rejecting overlaps
+};
+
+/// @brief What generateWorld() placed.
+struct WorldGenStats
+{
+    std::size_t obstacles = 0; ///< Obstacles placed
+    std::size_t movers = 0; ///< Movers placed
+    std::size_t rejected = 0; ///< Candidates redrawn or dropped for overlapping
+};
+
+/// @brief Circumradius of the triangle every mover instances.
+inline constexpr Float MOVER_RADIUS = 7.0710678f; // The corners at ( +-5, -5 )
+
+/// @brief Radius around the origin kept clear for the robot when rejecting overlaps.
+inline constexpr Float ROBOT_CLEARANCE = 14.142136f; // The corners of its 20 x 20 square
+} // namespace robot::src::detail::worldgen::inline exports
+
+namespace robot::src::detail::worldgen
+{
+/// @brief A body placed by a chunk, before it becomes an entity.
+struct Body
+{
+    Vec2 position;
+    Float radius;
+    std::uint32_t vertices; ///< Obstacle vertex count, or 0 for a mover
+    Vec2 velocity; ///< Movers only
+    std::uint32_t first_vertex = 0; ///< Obstacles only: offset of the vertices in the chunk's arrays
+    AxisAlignedBoundingBox local; ///< Obstacles only: bounding box of the vertices
+};
+
+/// @brief Counter word telling obstacle draws from mover draws.
+enum class Draw : std::uint32_t
+{
+    obstacle,
+    mover,
+};
+
+/// @brief Everything one chunk generated; filled by one thread at a time.
+struct Chunk
+{
+    std::vector< Body > bodies; ///< Accepted bodies in draw order, obstacles first
+    std::pmr::vector< Float > vertices_x; ///< Obstacle vertices, back to back
+    std::pmr::vector< Float > vertices_y;
+    std::pmr::vector< Float > normals_x; ///< Edge normals, as Polygon caches them
+    std::pmr::vector< Float > normals_y;
+    std::size_t obstacles = 0;
+    std::size_t rejected = 0;
+};
+
+/// @brief State of one generateWorld() call.
+class ChunkedWorld
+{
+private:
+    const WorldGenOptions & options_;
+    Philox4x32::Key key_;
+    std::size_t chunks_per_axis_;
+    Float chunk_size_;
+    std::vector< Chunk > chunks_;
+    std::vector< Body > earlier_; ///< Bodies of the chunks of earlier phases, indexed by grid_
+    UniformGrid grid_{ WORLD_BOUNDS, COLLISION_CELL_SIZE };
+
+    static std::size_t share( std::size_t total, std::size_t chunk, std::size_t chunks ) noexcept
+    {
+        return total / chunks + ( chunk < total % chunks ? 1 : 0 );
+    }
+
+    static AxisAlignedBoundingBox box( const Body & body ) noexcept
+    {
+        Vec2 extent{ body.radius, body.radius };
+        return { body.position - extent, body.position + extent };
+    }
+
+    static bool overlaps( const Body & a, const Body & b ) noexcept
+    {
+        Vec2 delta = wrappedDelta( a.position, b.position, WORLD_BOUNDS.max - WORLD_BOUNDS.min );
+        Float reach = a.radius + b.radius;
+        return delta.x * delta.x + delta.y * delta.y < reach * reach;
+    }
+
+    bool fits( const Body & body, const std::vector< Body > & own, std::vector< std::size_t > & nearby ) const
+    {
+        if( overlaps( body, Body{ {}, ROBOT_CLEARANCE, 0, {} } ) )
+        {
+            return false;
+        }
+        for( const auto & other : own )
+        {
+            if( overlaps( body, other ) )
+            {
+                return false;
+            }
+        }
+        grid_.query( box( body ), nearby );
+        for( auto index : nearby )
+        {
+            if( overlaps( body, earlier_[ index ] ) )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Body draw( std::size_t chunk, Draw kind, std::size_t slot, std::size_t attempt ) const
+    {
+        auto bits = Philox4x32::generate( { static_cast< std::uint32_t >( chunk ), static_cast< std::uint32_t >( slot ),
+                                            static_cast< std::uint32_t >( attempt ),
+                                            static_cast< std::uint32_t >( kind ) },
+                                          key_ );
+        Vec2 origin{ WORLD_BOUNDS.min.x + chunk_size_ * static_cast< Float >( chunk % chunks_per_axis_ ),
+                     WORLD_BOUNDS.min.y + chunk_size_ * static_cast< Float >( chunk / chunks_per_axis_ ) };
+        Vec2 position{ origin.x + chunk_size_ * unitFloat( bits[ 0 ] ),
+                       origin.y + chunk_size_ * unitFloat( bits[ 1 ] ) };
+        if( kind == Draw::obstacle )
+        {
+            Float radius = options_.min_radius + ( options_.max_radius - options_.min_radius ) * unitFloat( bits[ 2 ] );
+            return Body{ position, radius, 3 + bits[ 3 ] % 5, {} }; // 3 to 7 vertices
+        }
+        return Body{ position, MOVER_RADIUS, 0,
+                     { 20.0f * unitFloat( bits[ 2 ] ) - 10.0f, 20.0f * unitFloat( bits[ 3 ] ) - 10.0f } };
+    }
+
+    /// @brief Lay out an accepted obstacle's vertices as a regular polygon, so that part runs in parallel too.
+    static void add_vertices( Chunk & chunk, Body & body )
+    {
+        body.first_vertex = static_cast< std::uint32_t >( chunk.vertices_x.size() );
+        for( std::uint32_t j = 0; j < body.vertices; ++j )
+        {
+            Float angle = 2.0f * 3.14159265f * static_cast< Float >( j ) / static_cast< Float >( body.vertices );
+            chunk.vertices_x.push_back( body.radius * std::cos( angle ) );
+            chunk.vertices_y.push_back( body.radius * std::sin( angle ) );
+        }
+        const auto * x = chunk.vertices_x.data() + body.first_vertex;
+        const auto * y = chunk.vertices_y.data() + body.first_vertex;
+        body.local = { { x[ 0 ], y[ 0 ] }, { x[ 0 ], y[ 0 ] } };
+        for( std::uint32_t j = 0; j < body.vertices; ++j )
+        {
+            auto next = ( j + 1 ) % body.vertices;
+            chunk.normals_x.push_back( -( y[ next ] - y[ j ] ) );
+            chunk.normals_y.push_back( x[ next ] - x[ j ] );
+            body.local.min = Vec2{ std::min( body.local.min.x, x[ j ] ), std::min( body.local.min.y, y[ j ] ) };
+            body.local.max = Vec2{ std::max( body.local.max.x, x[ j ] ), std::max( body.local.max.y, y[ j ] ) };
+        }
+    }
+
+    void place( std::size_t index, Draw kind, std::size_t count, std::vector< std::size_t > & nearby )
+    {
+        auto & chunk = chunks_[ index ];
+        auto attempts = options_.reject_overlaps ? std::max< std::size_t >( options_.max_attempts, 1 ) : 1;
+        for( std::size_t slot = 0; slot < count; ++slot )
+        {
+            for( std::size_t attempt = 0; attempt < attempts; ++attempt )
+            {
+                auto body = draw( index, kind, slot, attempt );
+                if( !options_.reject_overlaps || fits( body, chunk.bodies, nearby ) )
+                {
+                    if( kind == Draw::obstacle )
+                    {
+                        add_vertices( chunk, body );
+                        ++chunk.obstacles;
+                    }
+                    chunk.bodies.push_back( body );
+                    break;
+                }
+                ++chunk.rejected;
+            }
+        }
+    }
+
+    void generate_chunk( std::size_t index )
+    {
+        auto chunks = chunks_.size();
+        auto obstacles = share( options_.obstacles, index, chunks );
+        auto movers = share( options_.movers, index, chunks );
+        auto & chunk = chunks_[ index ];
+        chunk.bodies.reserve( obstacles + movers );
+        chunk.vertices_x.reserve( obstacles * 7 );
+        chunk.vertices_y.reserve( obstacles * 7 );
+        chunk.normals_x.reserve( obstacles * 7 );
+        chunk.normals_y.reserve( obstacles * 7 );
+        std::vector< std::size_t > nearby;
+        place( index, Draw::obstacle, obstacles, nearby );
+        place( index, Draw::mover, movers, nearby );
+    }
+
+public:
+    ChunkedWorld( std::string_view key, const WorldGenOptions & options )
+        : options_( options )
+        , key_( worldgenKey( key ) )
+        , chunks_per_axis_( options.chunks_per_axis )
+        , chunk_size_( ( WORLD_BOUNDS.max.x - WORLD_BOUNDS.min.x ) / static_cast< Float >( options.chunks_per_axis ) )
+        , chunks_( options.chunks_per_axis * options.chunks_per_axis )
+    {
+        if( chunks_per_axis_ == 0 || chunks_per_axis_ % 2 != 0 )
+        {
+            throw std::invalid_argument( "generateWorld: chunks_per_axis must be even and non-zero" );
+        }
+        if( !( options.min_radius > 0.0f ) || options.max_radius < options.min_radius )
+        {
+            throw std::invalid_argument( "generateWorld: radii must satisfy 0 < min_radius <= max_radius" );
+        }
+        if( options.reject_overlaps && chunk_size_ < 2.0f * std::max( options.max_radius, MOVER_RADIUS ) )
+        {
+            throw std::invalid_argument( "generateWorld: chunks are narrower than the largest body" );
+        }
+    }
+
+    /// @brief Fill every chunk, spreading chunks across the pool.
+    void generate( JobSystem & jobs )
+    {
+        if( !options_.reject_overlaps )
+        {
+            jobs.parallel_for( 0, chunks_.size(), 1, [ this ]( std::size_t begin, std::size_t end ) {
+                for( auto chunk = begin; chunk < end; ++chunk )
+                    generate_chunk( chunk );
+            } );
+            return;
+        }
+        std::vector< std::size_t > phase_chunks;
+        for( std::size_t phase = 0; phase < 4; ++phase )
+        {
+            phase_chunks.clear();
+            for( std::size_t chunk = 0; chunk < chunks_.size(); ++chunk )
+            {
+                auto column = chunk % chunks_per_axis_;
+                auto row = chunk / chunks_per_axis_;
+                if( ( column % 2 ) + 2 * ( row % 2 ) == phase )
+                {
+                    phase_chunks.push_back( chunk );
+                }
+            }
+            jobs.parallel_for( 0, phase_chunks.size(), 1,
+                               [ this, &phase_chunks ]( std::size_t begin, std::size_t end ) {
+                                   for( auto i = begin; i < end; ++i )
+                                       generate_chunk( phase_chunks[ i ] );
+                               } );
+            // Later phases see this one's bodies through the grid
+            for( auto chunk : phase_chunks )
+            {
+                for( const auto & body : chunks_[ chunk ].bodies )
+                {
+                    grid_.insert( earlier_.size(), box( body ) );
+                    earlier_.push_back( body );
+                }
+            }
+            grid_.build();
+        }
+    }
+
+    /// @brief Create the entities of every chunk, obstacles first, in chunk order.
+    WorldGenStats populate( EntityStore & store, const Polygon::allocator_type & allocator ) const
+    {
+        WorldGenStats stats;
+        for( const auto & chunk : chunks_ )
+        {
+            stats.obstacles += chunk.obstacles;
+            stats.movers += chunk.bodies.size() - chunk.obstacles;
+            stats.rejected += chunk.rejected;
+        }
+
+        // Obstacles: a polygon each, copied into the arena from the chunk's arrays
+        std::vector< std::size_t > ids;
+        std::vector< Position > positions;
+        std::vector< Bounds > bounds;
+        std::vector< Polygon > polygons;
+        ids.reserve( stats.obstacles );
+        positions.reserve( stats.obstacles );
+        bounds.reserve( stats.obstacles );
+        polygons.reserve( stats.obstacles );
+        for( const auto & chunk : chunks_ )
+        {
+            for( std::size_t i = 0; i < chunk.obstacles; ++i )
+            {
+                const auto & body = chunk.bodies[ i ];
+                auto first = body.first_vertex;
+                auto last = first + body.vertices;
+                Polygon polygon( allocator );
+                polygon.vertices_x.assign( chunk.vertices_x.begin() + first, chunk.vertices_x.begin() + last );
+                polygon.vertices_y.assign( chunk.vertices_y.begin() + first, chunk.vertices_y.begin() + last );
+                polygon.normals_x.assign( chunk.normals_x.begin() + first, chunk.normals_x.begin() + last );
+                polygon.normals_y.assign( chunk.normals_y.begin() + first, chunk.normals_y.begin() + last );
+                ids.push_back( store.create().id() );
+                positions.push_back( Position{ body.position } );
+                Bounds box;
+                box.local = body.local;
+                box.update( body.position );
+                bounds.push_back( box );
+                polygons.push_back( std::move( polygon ) );
+            }
+        }
+        store.get< Position >().insert_range( ids, positions );
+        store.get< Bounds >().insert_range( ids, bounds );
+        // Moved rather than copied, so the vertex arrays stay in the arena
+        store.get< Polygon >().insert_range(
+            ids, std::ranges::subrange( std::make_move_iterator( polygons.begin() ),
+                                        std::make_move_iterator( polygons.end() ) ) );
+
+        // Movers: instances of one shared triangle
+        ShapeId triangle =
+            store.shapes.add( Polygon( { Vec2{ -5.0f, -5.0f }, Vec2{ 5.0f, -5.0f }, Vec2{ 0.0f, 5.0f } }, allocator ) );
+        ShapeInstance instance{ triangle, {} };
+        Bounds mover_bounds( store.shapes[ triangle ], instance, Vec2{} );
+        ids.clear();
+        positions.clear();
+        bounds.clear();
+        std::vector< Velocity > velocities;
+        velocities.reserve( stats.movers );
+        for( const auto & chunk : chunks_ )
+        {
+            for( std::size_t i = chunk.obstacles; i < chunk.bodies.size(); ++i )
+            {
+                const auto & body = chunk.bodies[ i ];
+                ids.push_back( store.create().id() );
+                positions.push_back( Position{ body.position } );
+                mover_bounds.update( body.position );
+                bounds.push_back( mover_bounds );
+                velocities.push_back( Velocity{ body.velocity } );
+            }
+        }
+        store.get< Position >().insert_range( ids, positions );
+        store.get< Bounds >().insert_range( ids, bounds );
+        store.get< ShapeInstance >().insert_range( ids, std::vector< ShapeInstance >( ids.size(), instance ) );
+        store.get< Velocity >().insert_range( ids, velocities );
+        return stats;
+    }
+};
+} // namespace robot::src::detail::worldgen
+
+namespace robot::src::detail::worldgen::inline exports
+{
+/// @brief Replace the contents of a store with a large procedurally generated world.
+///
+/// The world holds the robot and its eyes, as buildProceduralAssets() makes
+/// them, then options.obstacles polygons and options.movers triangles spread
+/// evenly over the chunks. The same key and options always give the same
+/// world, whatever the number of worker threads.
+///
+/// @param store Store to clear and fill.
+/// @param arena Arena owned alongside store; released and refilled.
+/// @param key Seed of the world.
+/// @param options Counts, sizes and overlap rejection.
+/// @param jobs Pool the chunks are generated on.
+/// @return How many bodies were placed and how many candidates were rejected.
+/// @throw std::invalid_argument if the options describe an impossible chunk layout.
+inline WorldGenStats generateWorld( EntityStore & store, VertexArena & arena, std::string_view key,
+                                    const WorldGenOptions & options, JobSystem & jobs )
+{
+    ChunkedWorld world( key, options );
+    world.generate( jobs );
+
+    store.clear();
+    arena.release();
+    store.get< Polygon >().reserve( 3 + options.obstacles );
+    store.get< ShapeInstance >().reserve( options.movers );
+    store.get< Bounds >().reserve( 1 + options.obstacles + options.movers );
+    store.get< Position >().reserve( 1 + options.obstacles + options.movers );
+    store.get< Velocity >().reserve( 1 + options.movers );
+    addRobot( store, arena.resource() );
+    return world.populate( store, arena.resource() );
+}
+} // namespace robot::src::detail::worldgen::inline exports
+
+namespace robot::src::inline exports::inline worldgen
+{
+using namespace detail::worldgen::exports;
+}
@@ -0,0 +1,198 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <utility>
+#include <vector>
+
+#include "broad_phase.hpp"
+
+namespace bp = robot::src::exports::broad_phase;
+using robot::src::AxisAlignedBoundingBox;
+using robot::src::Vec2;
+
+namespace
+{
+AxisAlignedBoundingBox box( float min_x, float min_y, float max_x, float max_y )
+{
+    return { { min_x, min_y }, { max_x, max_y } };
+}
+
+bp::UniformGrid makeGrid()
+{
+    return bp::UniformGrid( box( -100.0f, -100.0f, 100.0f, 100.0f ), 20.0f );
+}
+} // namespace
+
+SCENARIO( "Wrapped displacements take the short way around", "[broad_phase][wrap]" )
+{
+    GIVEN( "a 200 by 200 world" )
+    {
+        Vec2 world{ 200.0f, 200.0f };
+
+        WHEN( "two points are close together away from the edges" )
+        {
+            auto delta = bp::wrappedDelta( { 10.0f, 10.0f }, { 15.0f, 5.0f }, world );
+
+            THEN( "the displacement is the plain difference" )
+            {
+                REQUIRE_THAT( delta.x, Catch::Matchers::WithinAbs( 5.0f, 1e-5f ) );
+                REQUIRE_THAT( delta.y, Catch::Matchers::WithinAbs( -5.0f, 1e-5f ) );
+            }
+        }
+
+        WHEN( "two points sit on opposite edges of the world" )
+        {
+            auto delta = bp::wrappedDelta( { 95.0f, -95.0f }, { -95.0f, 95.0f }, world );
+
+            THEN( "the displacement crosses the edge" )
+            {
+                REQUIRE_THAT( delta.x, Catch::Matchers::WithinAbs( 10.0f, 1e-4f ) );
+                REQUIRE_THAT( delta.y, Catch::Matchers::WithinAbs( -10.0f, 1e-4f ) );
+            }
+        }
+    }
+
+    GIVEN( "two boxes touching across the right-hand world edge" )
+    {
+        auto left = box( -100.0f, 0.0f, -95.0f, 5.0f );
+        auto right = box( 96.0f, 0.0f, 101.0f, 5.0f );
+
+        THEN( "they overlap once wrapping is applied" )
+        {
+            REQUIRE_FALSE( left.intersects( right ) );
+            REQUIRE( bp::wrappedIntersects( left, right, { 200.0f, 200.0f } ) );
+        }
+    }
+}
+
+SCENARIO( "UniformGrid emits candidate pairs", "[broad_phase][grid]" )
+{
+    GIVEN( "a grid over a 200 by 200 world with 20 unit cells" )
+    {
+        auto grid = makeGrid();
+        std::vector< std::pair< std::size_t, std::size_t > > pairs;
+
+        THEN( "the world is tiled by 10 by 10 cells" )
+        {
+            REQUIRE( grid.dimensions() == std::pair{ 10, 10 } );
+        }
+
+        WHEN( "two overlapping boxes and one distant box are inserted" )
+        {
+            grid.insert( 1, box( 0.0f, 0.0f, 10.0f, 10.0f ) );
+            grid.insert( 2, box( 5.0f, 5.0f, 15.0f, 15.0f ) );
+            grid.insert( 3, box( -80.0f, -80.0f, -70.0f, -70.0f ) );
+            grid.build();
+            grid.candidate_pairs( pairs );
+
+            THEN( "only the overlapping pair is reported" )
+            {
+                REQUIRE( pairs.size() == 1 );
+                REQUIRE( pairs[ 0 ] == std::pair< std::size_t, std::size_t >{ 1, 2 } );
+            }
+        }
+
+        WHEN( "two large boxes sharing many cells are inserted" )
+        {
+            grid.insert( 7, box( -50.0f, -50.0f, 50.0f, 50.0f ) );
+            grid.insert( 8, box( -45.0f, -45.0f, 45.0f, 45.0f ) );
+            grid.build();
+            grid.candidate_pairs( pairs );
+
+            THEN( "the pair is reported exactly once" )
+            {
+                REQUIRE( pairs.size() == 1 );
+            }
+        }
+
+        WHEN( "boxes in adjacent cells do not overlap" )
+        {
+            grid.insert( 1, box( 0.0f, 0.0f, 19.0f, 19.0f ) );
+            grid.insert( 2, box( 19.5f, 0.0f, 30.0f, 19.0f ) );
+            grid.build();
+            grid.candidate_pairs( pairs );
+
+            THEN( "no pair is reported" )
+            {
+                REQUIRE( pairs.empty() );
+            }
+        }
+
+        WHEN( "a box hangs over the world edge next to a box on the opposite side" )
+        {
+            grid.insert( 4, box( 95.0f, -5.0f, 105.0f, 5.0f ) );
+            grid.insert( 5, box( -99.0f, -2.0f, -90.0f, 2.0f ) );
+            grid.build();
+            grid.candidate_pairs( pairs );
+
+            THEN( "the pair is found through the wrapped cells" )
+            {
+                REQUIRE( pairs.size() == 1 );
+                REQUIRE( pairs[ 0 ] == std::pair< std::size_t, std::size_t >{ 4, 5 } );
+            }
+        }
+
+        WHEN( "the grid is cleared and rebuilt" )
+        {
+            grid.insert( 1, box( 0.0f, 0.0f, 10.0f, 10.0f ) );
+            grid.insert( 2, box( 5.0f, 5.0f, 15.0f, 15.0f ) );
+            grid.build();
+            grid.clear();
+            grid.insert( 3, box( 0.0f, 0.0f, 10.0f, 10.0f ) );
+            grid.build();
+            grid.candidate_pairs( pairs );
+
+            THEN( "boxes from the previous build are gone" )
+            {
+                REQUIRE( grid.size() == 1 );
+                REQUIRE( pairs.empty() );
+            }
+        }
+    }
+}
+
+SCENARIO( "UniformGrid finds the boxes inside a query box", "[broad_phase][grid][query]" )
+{
+    GIVEN( "a built grid with boxes spread over the world" )
+    {
+        auto grid = makeGrid();
+        grid.insert( 9, box( -50.0f, -50.0f, 50.0f, 50.0f ) );
+        grid.insert( 1, box( 0.0f, 0.0f, 10.0f, 10.0f ) );
+        grid.insert( 2, box( 60.0f, 60.0f, 70.0f, 70.0f ) );
+        grid.insert( 3, box( 95.0f, -5.0f, 105.0f, 5.0f ) );
+        grid.build();
+        std::vector< std::size_t > found{ 42 };
+
+        WHEN( "a small box in the middle is queried" )
+        {
+            grid.query( box( 5.0f, 5.0f, 8.0f, 8.0f ), found );
+
+            THEN( "the boxes covering it are found once each, in ascending order" )
+            {
+                REQUIRE( found == std::vector< std::size_t >{ 1, 9 } );
+            }
+        }
+
+        WHEN( "a box on the opposite side of the world edge is queried" )
+        {
+            grid.query( box( -100.0f, 0.0f, -97.0f, 3.0f ), found );
+
+            THEN( "the box hanging over the edge is found through the wrapped cells" )
+            {
+                REQUIRE( found == std::vector< std::size_t >{ 3 } );
+            }
+        }
+
+        WHEN( "an empty region is queried" )
+        {
+            grid.query( box( -90.0f, 60.0f, -80.0f, 70.0f ), found );
+
+            THEN( "nothing is found and the output was cleared" )
+            {
+                REQUIRE( found.empty() );
+            }
+        }
+    }
+}
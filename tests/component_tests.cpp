@@ -1,5 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "component.hpp"
 
@@ -166,4 +168,66 @@ SCENARIO( "Component storage and entity management", "[component]" )
             }
         }
     }
-}
\ No newline at end of file
+}
+SCENARIO( "Component bulk operations and entity views", "[component][bulk]" )
+{
+    GIVEN( "a storage filled with insert_range" )
+    {
+        c::Component< Position > components;
+        components.reserve( 64 );
+        std::vector< std::size_t > ids{ 3, 1, 4 };
+        std::vector< Position > values{ { 3.0f, 0.0f }, { 1.0f, 0.0f }, { 4.0f, 0.0f } };
+        components.insert_range( ids, values );
+
+        THEN( "every entity holds its own value" )
+        {
+            REQUIRE( components.size() == 3 );
+            REQUIRE( components[ 4 ].x == 4.0f );
+            REQUIRE( components.dense_data().capacity() >= 64 );
+        }
+
+        THEN( "entities_view is a view of the dense array, not a copy" )
+        {
+            auto view = components.entities_view();
+            REQUIRE( view.data() == components.dense_entities().data() );
+            REQUIRE( std::vector< std::size_t >( view.begin(), view.end() ) == ids );
+        }
+
+        WHEN( "an existing entity is inserted again" )
+        {
+            components.insert( 1, Position{ 10.0f, 10.0f } );
+            components.emplace( 3, 30.0f, 30.0f );
+
+            THEN( "its data is replaced and the storage stays in sync" )
+            {
+                REQUIRE( components.size() == 3 );
+                REQUIRE( components.dense_data().size() == 3 );
+                REQUIRE( components[ 1 ] == Position{ 10.0f, 10.0f } );
+                REQUIRE( components[ 3 ] == Position{ 30.0f, 30.0f } );
+            }
+        }
+
+        WHEN( "a batch is erased, including an unknown entity" )
+        {
+            components.erase_range( std::vector< std::size_t >{ 3, 9, 4 } );
+
+            THEN( "only the remaining entity is left" )
+            {
+                REQUIRE( components.size() == 1 );
+                REQUIRE( components.contains( 1 ) );
+                REQUIRE( components[ 1 ].x == 1.0f );
+            }
+        }
+
+        WHEN( "the id and value batches differ in length" )
+        {
+            THEN( "insert_range throws and inserts nothing" )
+            {
+                REQUIRE_THROWS_AS( components.insert_range( std::vector< std::size_t >{ 7, 8 },
+                                                            std::vector< Position >{ { 7.0f, 0.0f } } ),
+                                   std::invalid_argument );
+                REQUIRE( components.size() == 3 );
+            }
+        }
+    }
+}
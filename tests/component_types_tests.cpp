@@ -1,7 +1,10 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <memory_resource>
+#include <utility>
 
+#include "component.hpp"
 #include "component_types.hpp"
 
 namespace ct = robot::src::exports::component_types;
@@ -295,6 +298,72 @@ SCENARIO( "Polygon component construction", "[component_types][polygon]" )
     }
 }
 
+SCENARIO( "Polygon vertex storage in a VertexArena", "[component_types][polygon][arena]" )
+{
+    GIVEN( "an arena and a triangle built with its resource" )
+    {
+        ct::VertexArena arena;
+        ct::Polygon triangle( { ct::Position{ 0.0f, 0.0f }, ct::Position{ 1.0f, 0.0f }, ct::Position{ 0.0f, 1.0f } },
+                              arena.resource() );
+
+        THEN( "every array of the triangle uses the arena" )
+        {
+            REQUIRE( triangle.get_allocator().resource() == arena.resource() );
+            REQUIRE( triangle.normals_y.get_allocator().resource() == arena.resource() );
+            REQUIRE( triangle.has_normals() );
+        }
+
+        WHEN( "the triangle is moved into a component storage" )
+        {
+            const float * vertices = triangle.vertices_x.data();
+            robot::src::Component< ct::Polygon > polygons;
+            polygons.insert( 7, std::move( triangle ) );
+
+            THEN( "the stored polygon keeps the arena's arrays" )
+            {
+                REQUIRE( polygons[ 7 ].get_allocator().resource() == arena.resource() );
+                REQUIRE( polygons[ 7 ].vertices_x.data() == vertices );
+            }
+        }
+
+        WHEN( "the triangle is copied" )
+        {
+            ct::Polygon copy = triangle;
+            ct::VertexArena other;
+            ct::Polygon moved_over( triangle, other.resource() );
+
+            THEN( "a plain copy goes to the default resource and an allocator-extended copy to the given one" )
+            {
+                REQUIRE( copy.get_allocator().resource() == std::pmr::get_default_resource() );
+                REQUIRE( moved_over.get_allocator().resource() == other.resource() );
+                REQUIRE( copy.intersects( moved_over ) );
+                REQUIRE( moved_over.size() == 3U );
+            }
+        }
+    }
+
+    GIVEN( "two polygons built one after the other in the same arena" )
+    {
+        ct::VertexArena arena;
+        ct::Polygon first( { ct::Position{ 0.0f, 0.0f }, ct::Position{ 1.0f, 0.0f }, ct::Position{ 0.0f, 1.0f } },
+                           arena.resource() );
+        ct::Polygon second( arena.resource() );
+        second.reserve( 4 );
+        second.emplace_back( 0.0f, 0.0f );
+        second.emplace_back( 1.0f, 0.0f );
+        second.emplace_back( 1.0f, 1.0f );
+        second.emplace_back( 0.0f, 1.0f );
+
+        THEN( "the second polygon's vertices follow the first's in the same block" )
+        {
+            auto distance = second.vertices_x.data() - first.vertices_x.data();
+            REQUIRE( distance > 0 );
+            REQUIRE( distance < 64 );
+            REQUIRE( second.vertices_x.capacity() == 4U );
+        }
+    }
+}
+
 SCENARIO( "Polygon AABB computation", "[component_types][polygon][aabb]" )
 {
     GIVEN( "a square polygon from (0,0) to (1,1)" )
@@ -589,4 +658,38 @@ SCENARIO( "Polygon projection onto axis", "[component_types][polygon][projection
             }
         }
     }
-}
\ No newline at end of file
+}
+SCENARIO( "Bounds component caching", "[component_types][bounds]" )
+{
+    GIVEN( "a polygon placed away from the origin" )
+    {
+        ct::Polygon triangle{
+            robot::src::Vec2{ -5.0f, -5.0f }, robot::src::Vec2{ 5.0f, -5.0f }, robot::src::Vec2{ 0.0f, 5.0f } };
+        ct::Bounds bounds( triangle, ct::Position{ 10.0f, 20.0f } );
+
+        THEN( "the local box matches the polygon's AABB" )
+        {
+            REQUIRE( bounds.local.min.x == -5.0f );
+            REQUIRE( bounds.local.max.y == 5.0f );
+        }
+
+        THEN( "the world box is translated by the position" )
+        {
+            REQUIRE( bounds.world.min.x == 5.0f );
+            REQUIRE( bounds.world.min.y == 15.0f );
+            REQUIRE( bounds.world.max.x == 15.0f );
+            REQUIRE( bounds.world.max.y == 25.0f );
+        }
+
+        WHEN( "the bounds are updated for a new position" )
+        {
+            bounds.update( robot::src::Vec2{ 0.0f, 0.0f } );
+
+            THEN( "the world box returns to the local box" )
+            {
+                REQUIRE( bounds.world.min.x == bounds.local.min.x );
+                REQUIRE( bounds.world.max.y == bounds.local.max.y );
+            }
+        }
+    }
+}
@@ -1,5 +1,8 @@
 static_assert( __cplusplus > 2020'00 );
 
+#include <cstddef>
+#include <vector>
+
 #include <catch2/catch_test_macros.hpp>
 
 #include "components.hpp"
@@ -81,4 +84,166 @@ SCENARIO( "Components storage manages multiple component types" )
             }
         }
     }
-}
\ No newline at end of file
+}
+SCENARIO( "Components creates and destroys entities across all storages", "[components][registry]" )
+{
+    GIVEN( "an entity with two components" )
+    {
+        Components< Position, Velocity, Health > components;
+        auto entity = components.create();
+        auto other = components.create();
+        components.get< Position >().insert( entity.id(), Position{ 1.0f, 2.0f } );
+        components.get< Velocity >().insert( entity.id(), Velocity{ 3.0f, 4.0f } );
+        components.get< Position >().insert( other.id(), Position{ 5.0f, 6.0f } );
+
+        WHEN( "the entity is destroyed" )
+        {
+            REQUIRE( components.destroy( entity ) );
+
+            THEN( "it is gone from every storage and the other entity is untouched" )
+            {
+                REQUIRE_FALSE( components.alive( entity ) );
+                REQUIRE_FALSE( components.get< Position >().contains( entity.id() ) );
+                REQUIRE_FALSE( components.get< Velocity >().contains( entity.id() ) );
+                REQUIRE( components.get< Position >()[ other.id() ].x == 5.0f );
+            }
+
+            AND_WHEN( "a new entity reuses the id" )
+            {
+                auto reused = components.create();
+                components.get< Health >().insert( reused.id(), Health{ 10 } );
+
+                THEN( "the stale handle cannot destroy it" )
+                {
+                    REQUIRE( reused.id() == entity.id() );
+                    REQUIRE_FALSE( components.destroy( entity ) );
+                    REQUIRE( components.get< Health >().contains( reused.id() ) );
+                }
+            }
+        }
+
+        WHEN( "the collection is cleared" )
+        {
+            components.clear();
+
+            THEN( "every storage is empty and ids restart at zero" )
+            {
+                REQUIRE( components.get< Position >().empty() );
+                REQUIRE( components.get< Velocity >().empty() );
+                REQUIRE( components.create().id() == 0 );
+            }
+        }
+    }
+}
+
+SCENARIO( "Components views join entities that have every requested component", "[components][view]" )
+{
+    GIVEN( "entities with overlapping sets of components" )
+    {
+        Components< Position, Velocity, Health > components;
+        for( std::size_t entity = 0; entity < 6; ++entity )
+        {
+            components.get< Position >().insert( entity, Position{ float( entity ), 0.0f } );
+        }
+        components.get< Velocity >().insert( 4, Velocity{ 1.0f, 0.0f } );
+        components.get< Velocity >().insert( 1, Velocity{ 2.0f, 0.0f } );
+        components.get< Velocity >().insert( 7, Velocity{ 3.0f, 0.0f } );
+        components.get< Health >().insert( 1, Health{ 5 } );
+
+        WHEN( "a view over Position and Velocity is visited with for_each" )
+        {
+            std::vector< std::size_t > visited;
+            components.view< Position, Velocity >().for_each(
+                [ & ]( std::size_t entity, Position & position, Velocity & velocity ) {
+                    position.x += velocity.dx;
+                    visited.push_back( entity );
+                } );
+
+            THEN( "only entities with both components are visited, in the smaller storage's order" )
+            {
+                REQUIRE( visited == std::vector< std::size_t >{ 4, 1 } );
+                REQUIRE( components.get< Position >()[ 4 ].x == 5.0f );
+                REQUIRE( components.get< Position >()[ 1 ].x == 3.0f );
+                REQUIRE( components.get< Position >()[ 0 ].x == 0.0f );
+            }
+        }
+
+        WHEN( "a three-way view is iterated with a range for" )
+        {
+            std::vector< std::size_t > visited;
+            for( auto [ entity, position, velocity, health ] : components.view< Position, Velocity, Health >() )
+            {
+                health.hp += int( velocity.dx + position.x );
+                visited.push_back( entity );
+            }
+
+            THEN( "the single entity with all three is yielded with mutable references" )
+            {
+                REQUIRE( visited == std::vector< std::size_t >{ 1 } );
+                REQUIRE( components.get< Health >()[ 1 ].hp == 8 );
+            }
+        }
+
+        WHEN( "a view is taken through a const collection" )
+        {
+            const auto & read_only = components;
+            std::size_t count = 0;
+            read_only.view< Velocity, Position >().for_each(
+                [ & ]( std::size_t, const Velocity &, const Position & ) { ++count; } );
+
+            THEN( "it visits the same join" )
+            {
+                REQUIRE( count == 2 );
+            }
+        }
+
+        WHEN( "one of the storages is empty" )
+        {
+            components.get< Health >().clear();
+
+            THEN( "the view yields nothing" )
+            {
+                auto view = components.view< Position, Health >();
+                REQUIRE( view.begin() == view.end() );
+            }
+        }
+    }
+}
+
+SCENARIO( "Components align puts shared entities first in both storages", "[components][align]" )
+{
+    GIVEN( "two storages that share some entities in different orders" )
+    {
+        Components< Position, Velocity > components;
+        for( std::size_t entity : { 5, 1, 8, 3, 9 } )
+        {
+            components.get< Position >().insert( entity, Position{ float( entity ), 0.0f } );
+        }
+        for( std::size_t entity : { 2, 3, 9, 5 } )
+        {
+            components.get< Velocity >().insert( entity, Velocity{ float( entity ), 0.0f } );
+        }
+        auto revision = components.get< Velocity >().revision();
+
+        WHEN( "they are aligned" )
+        {
+            auto shared = components.align< Position, Velocity >();
+
+            THEN( "the fronts hold the shared entities in the first storage's order with their data" )
+            {
+                REQUIRE( shared == 3 );
+                const auto & positions = components.get< Position >();
+                const auto & velocities = components.get< Velocity >();
+                for( std::size_t i = 0; i < shared; ++i )
+                {
+                    REQUIRE( positions.dense_entities()[ i ] == std::vector< std::size_t >{ 5, 3, 9 }[ i ] );
+                    REQUIRE( velocities.dense_entities()[ i ] == positions.dense_entities()[ i ] );
+                    REQUIRE( velocities.dense_data()[ i ].dx == positions.dense_data()[ i ].x );
+                }
+                REQUIRE( velocities[ 2 ].dx == 2.0f );
+                REQUIRE( positions[ 8 ].x == 8.0f );
+                REQUIRE( velocities.revision() != revision );
+            }
+        }
+    }
+}
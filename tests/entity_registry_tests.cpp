@@ -0,0 +1,110 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "entity_registry.hpp"
+
+namespace er = robot::src::exports::entity_registry;
+
+SCENARIO( "EntityRegistry issues and recycles generational handles", "[entity_registry]" )
+{
+    GIVEN( "an empty registry" )
+    {
+        er::EntityRegistry registry;
+
+        THEN( "a default handle is null and not alive" )
+        {
+            REQUIRE( er::Entity{}.is_null() );
+            REQUIRE_FALSE( registry.alive( er::Entity{} ) );
+            REQUIRE( registry.empty() );
+        }
+
+        WHEN( "entities are created" )
+        {
+            auto a = registry.create();
+            auto b = registry.create();
+            auto c = registry.create();
+
+            THEN( "they get consecutive indices starting at zero" )
+            {
+                REQUIRE( a.id() == 0 );
+                REQUIRE( b.id() == 1 );
+                REQUIRE( c.id() == 2 );
+                REQUIRE( registry.size() == 3 );
+                REQUIRE( registry.alive( b ) );
+                REQUIRE( registry.handle( 1 ) == b );
+            }
+
+            AND_WHEN( "one is destroyed and another created" )
+            {
+                REQUIRE( registry.destroy( b ) );
+                auto d = registry.create();
+
+                THEN( "the index is reused with a new generation" )
+                {
+                    REQUIRE( d.id() == b.id() );
+                    REQUIRE( d.generation == b.generation + 1 );
+                    REQUIRE_FALSE( registry.alive( b ) );
+                    REQUIRE( registry.alive( d ) );
+                    REQUIRE( registry.size() == 3 );
+                }
+
+                THEN( "destroying the stale handle does nothing" )
+                {
+                    REQUIRE_FALSE( registry.destroy( b ) );
+                    REQUIRE( registry.alive( d ) );
+                }
+            }
+
+            AND_WHEN( "the registry is cleared" )
+            {
+                registry.clear();
+                auto first = registry.create();
+                auto second = registry.create();
+
+                THEN( "indices are reissued from zero and old handles stay dead" )
+                {
+                    REQUIRE( first.id() == 0 );
+                    REQUIRE( second.id() == 1 );
+                    REQUIRE( registry.size() == 2 );
+                    REQUIRE_FALSE( registry.alive( a ) );
+                    REQUIRE( registry.alive( first ) );
+                    REQUIRE( registry.handle( 2 ).is_null() );
+                }
+            }
+
+            AND_WHEN( "its state is restored into another registry" )
+            {
+                registry.destroy( c );
+                registry.destroy( a );
+                er::EntityRegistry copy;
+                copy.restore( registry.generations(), registry.alive_flags(), registry.free_list() );
+
+                THEN( "the copy holds the same entities and reissues ids in the same order" )
+                {
+                    REQUIRE( copy.size() == 1 );
+                    REQUIRE( copy.alive( b ) );
+                    REQUIRE_FALSE( copy.alive( a ) );
+                    REQUIRE( copy.create() == registry.create() );
+                    REQUIRE( copy.create() == registry.create() );
+                    REQUIRE( copy.create() == registry.create() );
+                }
+
+                THEN( "inconsistent state is refused and leaves the copy unchanged" )
+                {
+                    std::vector< std::uint32_t > free_alive = { 1 };
+                    REQUIRE_THROWS_AS( copy.restore( registry.generations(), registry.alive_flags(), free_alive ),
+                                       std::invalid_argument );
+                    std::vector< std::uint8_t > short_alive = { 1 };
+                    REQUIRE_THROWS_AS( copy.restore( registry.generations(), short_alive, registry.free_list() ),
+                                       std::invalid_argument );
+                    REQUIRE( copy.size() == 1 );
+                    REQUIRE( copy.alive( b ) );
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "component_types.hpp"
+#include "input_recording.hpp"
+
+namespace ct = robot::src::exports::component_types;
+namespace ir = robot::src::exports::input_recording;
+
+SCENARIO( "InputRecorder keeps only the inputs that changed", "[input_recording]" )
+{
+    GIVEN( "a store whose robot is steered and then left alone" )
+    {
+        ct::EntityStore store;
+        ir::InputRecorder recorder;
+        store.get< ct::PlayerInput >().insert( 0, ct::PlayerInput{ 1.0f, 0.0f } );
+        recorder.record( 1, store );
+        recorder.record( 2, store );
+        store.get< ct::PlayerInput >()[ 0 ] = ct::PlayerInput{ 0.0f, -0.5f };
+        recorder.record( 3, store );
+        recorder.record( 4, store );
+
+        THEN( "one event is recorded per change, at the tick it was first seen" )
+        {
+            REQUIRE( recorder.events().size() == 2 );
+            REQUIRE( recorder.events()[ 0 ] == ir::InputEvent{ 1, 0, ct::PlayerInput{ 1.0f, 0.0f } } );
+            REQUIRE( recorder.events()[ 1 ] == ir::InputEvent{ 3, 0, ct::PlayerInput{ 0.0f, -0.5f } } );
+        }
+
+        WHEN( "the events are replayed into a fresh store" )
+        {
+            ct::EntityStore replayed;
+            ir::InputReplay replay( recorder.events() );
+            replay.apply( 2, replayed );
+            auto first = replayed.get< ct::PlayerInput >()[ 0 ];
+            replay.apply( 3, replayed );
+
+            THEN( "each input appears at its tick" )
+            {
+                REQUIRE( first.x == 1.0f );
+                REQUIRE( replayed.get< ct::PlayerInput >()[ 0 ].y == -0.5f );
+                REQUIRE( replay.finished() );
+                REQUIRE( replay.last_tick() == 3 );
+            }
+        }
+    }
+}
+
+SCENARIO( "Input recordings round-trip through text", "[input_recording]" )
+{
+    GIVEN( "a recording with awkward floats and a final hash" )
+    {
+        ir::InputRecording recording;
+        recording.key = "a key with spaces";
+        recording.num_assets = 25;
+        recording.events = { { 7, 0, ct::PlayerInput{ 0.1f, -1.0f / 3.0f } },
+                              { 9, 4, ct::PlayerInput{ 1e-30f, 3e38f } } };
+        recording.worldgen = robot::src::WorldGenOptions{ 400, 300, 6, 0.1f, 9.75f, true, 5 };
+        recording.loaded = ir::LoadedWorld{ 300, 0x5a1e9d0c7b3f2468ull };
+        recording.end_tick = 600;
+        recording.end_hash = 0x9f3b2c6a01d4e857ull;
+
+        WHEN( "it is written and read back" )
+        {
+            std::stringstream text;
+            ir::writeInputRecording( text, recording );
+            auto read = ir::readInputRecording( text );
+
+            THEN( "every field and every float bit is preserved" )
+            {
+                REQUIRE( read.key == recording.key );
+                REQUIRE( read.num_assets == 25 );
+                REQUIRE( read.loaded == recording.loaded );
+                REQUIRE( read.worldgen );
+                REQUIRE( read.worldgen->obstacles == 400 );
+                REQUIRE( read.worldgen->movers == 300 );
+                REQUIRE( read.worldgen->chunks_per_axis == 6 );
+                REQUIRE( read.worldgen->min_radius == 0.1f );
+                REQUIRE( read.worldgen->max_radius == 9.75f );
+                REQUIRE( read.worldgen->reject_overlaps );
+                REQUIRE( read.worldgen->max_attempts == 5 );
+                REQUIRE( read.events == recording.events );
+                REQUIRE( read.end_tick == 600 );
+                REQUIRE( read.end_hash == recording.end_hash );
+            }
+        }
+    }
+
+    GIVEN( "malformed recordings" )
+    {
+        THEN( "reading them throws" )
+        {
+            std::istringstream no_header( "input 1 0 1 0\n" );
+            REQUIRE_THROWS_AS( ir::readInputRecording( no_header ), std::runtime_error );
+            std::istringstream bad_number( "robot-input 1\ninput 1 0 x 0\n" );
+            REQUIRE_THROWS_AS( ir::readInputRecording( bad_number ), std::runtime_error );
+            std::istringstream bad_flag( "robot-input 1\nworldgen 1 1 2 1 2 3 8\n" );
+            REQUIRE_THROWS_AS( ir::readInputRecording( bad_flag ), std::runtime_error );
+            std::istringstream out_of_order( "robot-input 1\ninput 5 0 1 0\ninput 4 0 1 0\n" );
+            REQUIRE_THROWS_AS( ir::readInputRecording( out_of_order ), std::runtime_error );
+        }
+    }
+}
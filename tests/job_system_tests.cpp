@@ -0,0 +1,80 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "job_system.hpp"
+
+namespace js = robot::src::exports::job_system;
+
+SCENARIO( "JobSystem runs batches of jobs across its workers", "[job_system]" )
+{
+    for( std::size_t workers : { 0, 1, 4 } )
+    {
+        GIVEN( "a pool with " + std::to_string( workers ) + " workers" )
+        {
+            js::JobSystem jobs( workers );
+            REQUIRE( jobs.worker_count() == workers );
+
+            WHEN( "a range is split with parallel_for" )
+            {
+                std::vector< std::atomic< int > > visits( 10'000 );
+                jobs.parallel_for( 0, visits.size(), 100, [ & ]( std::size_t begin, std::size_t end ) {
+                    for( auto i = begin; i < end; ++i )
+                    {
+                        visits[ i ].fetch_add( 1 );
+                    }
+                } );
+
+                THEN( "every index is visited exactly once" )
+                {
+                    std::size_t once = 0;
+                    for( auto & count : visits )
+                    {
+                        once += count.load() == 1;
+                    }
+                    REQUIRE( once == visits.size() );
+                }
+            }
+
+            WHEN( "jobs spawn and wait for nested jobs" )
+            {
+                std::atomic< int > leaves{ 0 };
+                jobs.parallel_for( 0, 8, 1, [ & ]( std::size_t begin, std::size_t end ) {
+                    for( auto i = begin; i < end; ++i )
+                    {
+                        jobs.parallel_for( 0, 64, 4, [ & ]( std::size_t b, std::size_t e ) {
+                            leaves.fetch_add( static_cast< int >( e - b ) );
+                        } );
+                    }
+                } );
+
+                THEN( "all nested work completes without deadlock" )
+                {
+                    REQUIRE( leaves.load() == 8 * 64 );
+                }
+            }
+
+            WHEN( "a submitted job throws" )
+            {
+                js::JobCounter counter;
+                std::atomic< int > ran{ 0 };
+                jobs.submit( counter, [ & ] { ran.fetch_add( 1 ); } );
+                jobs.submit( counter, [] { throw std::runtime_error( "job failed" ); } );
+                jobs.submit( counter, [ & ] { ran.fetch_add( 1 ); } );
+
+                THEN( "wait rethrows it after the other jobs have finished" )
+                {
+                    REQUIRE_THROWS_AS( jobs.wait( counter ), std::runtime_error );
+                    REQUIRE( counter.done() );
+                    REQUIRE( ran.load() == 2 );
+                }
+            }
+        }
+    }
+}
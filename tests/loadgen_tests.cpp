@@ -0,0 +1,92 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <string_view>
+#include <vector>
+
+#include "loadgen.hpp"
+
+namespace lg = robot::src::exports::loadgen;
+
+using namespace std::chrono_literals;
+
+SCENARIO( "The load generator reads what it needs from server responses", "[loadgen]" )
+{
+    GIVEN( "a scene packet, an input response and a /metrics page" )
+    {
+        std::string_view packet = R"({"version":2,"type":"delta","base":41,"tick":42,"inputs":17,"shapes":[],)"
+                                  R"("despawn":[],"spawn":[{"id":3,"tick":5}],"move":[]})";
+        std::string_view metrics = "# TYPE robot_ticks_total counter\n"
+                                   "robot_ticks_total_seconds 3\n"
+                                   "robot_ticks_total 1200\n"
+                                   "robot_tick_overruns_total{world=\"0\"} 9\n"
+                                   "robot_tick_overruns_total 12\n";
+
+        THEN( "header members are found without parsing the rest of the document" )
+        {
+            REQUIRE( lg::jsonUnsigned( packet, "tick" ) == 42 );
+            REQUIRE( lg::jsonUnsigned( packet, "inputs" ) == 17 );
+            REQUIRE( lg::jsonUnsigned( R"({"status":"ok","input":5})", "input" ) == 5 );
+            REQUIRE_FALSE( lg::jsonUnsigned( packet, "horizon" ) );
+            REQUIRE_FALSE( lg::jsonUnsigned( packet, "type" ) );
+        }
+
+        THEN( "only unlabelled samples of exactly the metric asked for are read" )
+        {
+            REQUIRE( lg::prometheusValue( metrics, "robot_ticks_total" ) == 1200.0 );
+            REQUIRE( lg::prometheusValue( metrics, "robot_tick_overruns_total" ) == 12.0 );
+            REQUIRE_FALSE( lg::prometheusValue( metrics, "robot_inputs_rejected_total" ) );
+        }
+    }
+}
+
+SCENARIO( "Inputs are timed to the first scene that applied them", "[loadgen]" )
+{
+    GIVEN( "four inputs and the scenes the viewers saw" )
+    {
+        auto t0 = lg::Clock::time_point{} + 1s;
+        std::vector< lg::SentInput > sent{ { 2, t0 + 5ms }, { 1, t0 }, { 3, t0 + 6ms }, { 9, t0 + 8ms } };
+        lg::LatencyLog log;
+        for( const auto & input : sent )
+        {
+            log.sent( input );
+        }
+        log.seen( 0, t0 + 1ms );
+        log.seen( 2, t0 + 10ms );
+        log.seen( 1, t0 + 11ms );
+        log.seen( 4, t0 + 30ms );
+
+        WHEN( "they are matched" )
+        {
+            auto result = log.latencies();
+
+            THEN( "each input seen waits for the first scene whose count reached its number" )
+            {
+                REQUIRE( result.latencies == std::vector< std::chrono::nanoseconds >{ 5ms, 10ms, 24ms } );
+                REQUIRE( result.unseen == 1 );
+            }
+
+            THEN( "percentiles take the nearest rank" )
+            {
+                REQUIRE( lg::percentile( result.latencies, 0.5 ) == 10ms );
+                REQUIRE( lg::percentile( result.latencies, 0.99 ) == 24ms );
+                REQUIRE( lg::percentile( result.latencies, 0.0 ) == 5ms );
+                REQUIRE( lg::percentile( {}, 0.5 ) == 0ns );
+            }
+        }
+    }
+
+    GIVEN( "a report with and without the server's tick counters" )
+    {
+        lg::LoadReport report;
+        REQUIRE_FALSE( report.overrun_rate() );
+        report.ticks = 600.0;
+        report.overruns = 3.0;
+
+        THEN( "the overrun rate is per tick" )
+        {
+            REQUIRE( report.overrun_rate() == 0.005 );
+        }
+    }
+}
@@ -0,0 +1,72 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+#include "logging.hpp"
+
+namespace lg = robot::src::exports::logging;
+
+SCENARIO( "Logger writes enabled messages from its own thread", "[logging]" )
+{
+    GIVEN( "a logger at info level over string streams" )
+    {
+        std::ostringstream out;
+        std::ostringstream err;
+        lg::Logger logger( out, err, lg::LogLevel::info );
+
+        WHEN( "messages of every level are logged and flushed" )
+        {
+            REQUIRE_FALSE( logger.debug( "hidden" ) );
+            REQUIRE( logger.info( "client ", 7, " connected" ) );
+            REQUIRE( logger.error( "write failed" ) );
+            logger.flush();
+
+            THEN( "info goes to the output stream and errors to the error stream, debug nowhere" )
+            {
+                REQUIRE( out.str() == "[info] client 7 connected\n" );
+                REQUIRE( err.str() == "[error] write failed\n" );
+            }
+        }
+
+        WHEN( "the level is raised to off" )
+        {
+            logger.set_level( lg::LogLevel::off );
+
+            THEN( "nothing is enabled" )
+            {
+                REQUIRE_FALSE( logger.enabled( lg::LogLevel::error ) );
+                REQUIRE_FALSE( logger.error( "dropped" ) );
+            }
+        }
+    }
+
+    GIVEN( "a logger that is destroyed right after logging" )
+    {
+        std::ostringstream out;
+        {
+            lg::Logger logger( out, out, lg::LogLevel::debug );
+            for( int i = 0; i < 100; ++i )
+            {
+                logger.debug( i );
+            }
+        }
+
+        THEN( "every queued message was written before the writer stopped" )
+        {
+            auto text = out.str();
+            REQUIRE( text.rfind( "[debug] 99\n" ) != std::string::npos );
+            REQUIRE( static_cast< std::size_t >( std::count( text.begin(), text.end(), '\n' ) ) == 100 );
+        }
+    }
+}
+
+SCENARIO( "Log levels parse from their names", "[logging]" )
+{
+    REQUIRE( lg::parseLogLevel( "warning" ) == lg::LogLevel::warning );
+    REQUIRE( lg::parseLogLevel( "off" ) == lg::LogLevel::off );
+    REQUIRE_FALSE( lg::parseLogLevel( "verbose" ).has_value() );
+}
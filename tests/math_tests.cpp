@@ -0,0 +1,146 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "math.hpp"
+
+using namespace robot::src::exports::math;
+
+namespace
+{
+constexpr Affine2 PLACEMENT = Affine2::trs( { 4.0f, -2.0f }, 0.0f, 1.0f, { 2.0f, 3.0f } );
+
+// Composition and application are usable in constant expressions
+static_assert( Affine2::translation( { 1.0f, 2.0f } ) * Affine2::scaled( { 3.0f, 3.0f } )
+               == Affine2{ 3.0f, 0.0f, 0.0f, 3.0f, 1.0f, 2.0f } );
+static_assert( Affine2::translation( { 4.0f, -2.0f } ) * Affine2::rotation( 0.0f, 1.0f )
+                   * Affine2::scaled( { 2.0f, 3.0f } )
+               == PLACEMENT );
+static_assert( ( PLACEMENT * Vec2{ 1.0f, 1.0f } ).x == 1.0f && ( PLACEMENT * Vec2{ 1.0f, 1.0f } ).y == 0.0f );
+static_assert( Affine2::fromMatrix( PLACEMENT.toMatrix() ) == PLACEMENT );
+static_assert( ( Mat3::translation( { 1.0f, 0.0f } ) * Mat3::scaled( { 2.0f, 2.0f } ) )( 0, 0 ) == 2.0f );
+static_assert( toCanvas( PLACEMENT ).e == 4.0f );
+
+bool sameMatrix( const Mat3 & x, const Mat3 & y )
+{
+    for( std::size_t i = 0; i < x.m.size(); ++i )
+    {
+        if( std::abs( x.m[ i ] - y.m[ i ] ) > 1e-5f )
+            return false;
+    }
+    return true;
+}
+} // namespace
+
+SCENARIO( "Affine2 composes like the homogeneous Mat3", "[math][affine]" )
+{
+    GIVEN( "a translated, rotated and scaled Transform2D" )
+    {
+        Transform2D transform{ { 3.0f, -7.0f }, 0.6f, { 1.5f, 0.25f } };
+
+        THEN( "its closed-form affine equals the product of the three matrices" )
+        {
+            Mat3 product = Mat3::translation( transform.translation ) * Mat3::rotation( transform.rotationRadians )
+                           * Mat3::scaled( transform.scale );
+            REQUIRE( sameMatrix( transform.toAffine().toMatrix(), product ) );
+            REQUIRE( sameMatrix( transform.toMatrix(), product ) );
+        }
+
+        THEN( "composing affines matches multiplying their matrices" )
+        {
+            Affine2 x = transform.toAffine();
+            Affine2 y = Transform2D{ { -1.0f, 2.0f }, -1.1f, { 2.0f, 2.0f } }.toAffine();
+            REQUIRE( sameMatrix( ( x * y ).toMatrix(), x.toMatrix() * y.toMatrix() ) );
+
+            Vec2 point{ 0.3f, -4.0f };
+            Vec2 twice = x * ( y * point );
+            Vec2 once = ( x * y ) * point;
+            REQUIRE( std::abs( twice.x - once.x ) < 1e-4f );
+            REQUIRE( std::abs( twice.y - once.y ) < 1e-4f );
+            REQUIRE( ( x.linear( point ) + Vec2{ x.e, x.f } ).x == ( x * point ).x );
+            REQUIRE( ( x.linear( point ) + Vec2{ x.e, x.f } ).y == ( x * point ).y );
+        }
+
+        THEN( "the canvas export of both forms agrees" )
+        {
+            auto from_affine = toCanvas( transform.toAffine() );
+            auto from_matrix = toCanvas( transform.toMatrix() );
+            REQUIRE( from_affine.a == from_matrix.a );
+            REQUIRE( from_affine.c == from_matrix.c );
+            REQUIRE( from_affine.f == from_matrix.f );
+        }
+    }
+}
+
+SCENARIO( "Transform2D scales, then rotates, then translates", "[math][affine]" )
+{
+    GIVEN( "a quarter turn with a non-uniform scale and a translation" )
+    {
+        Transform2D transform{ { 10.0f, 0.0f }, 1.5707963f, { 2.0f, 3.0f } };
+
+        THEN( "a point lands where T * R * S puts it, not where S * R * T would" )
+        {
+            // S: ( 1, 1 ) -> ( 2, 3 ); R: -> ( -3, 2 ); T: -> ( 7, 2 ). S * R * T would give ( -2, 33 ).
+            Vec2 affine = transform.toAffine() * Vec2{ 1.0f, 1.0f };
+            Vec2 matrix = transform.toMatrix() * Vec2{ 1.0f, 1.0f };
+            REQUIRE( std::abs( affine.x - 7.0f ) < 1e-5f );
+            REQUIRE( std::abs( affine.y - 2.0f ) < 1e-5f );
+            REQUIRE( std::abs( matrix.x - 7.0f ) < 1e-5f );
+            REQUIRE( std::abs( matrix.y - 2.0f ) < 1e-5f );
+
+            Vec2 axis = transform.toAffine() * Vec2{ 1.0f, 0.0f };
+            REQUIRE( std::abs( axis.x - 10.0f ) < 1e-5f );
+            REQUIRE( std::abs( axis.y - 2.0f ) < 1e-5f );
+        }
+    }
+}
+
+SCENARIO( "Batched vertex transforms match transforming one vertex at a time", "[math][affine]" )
+{
+    GIVEN( "more vertices than fit in one SIMD batch, and a transform" )
+    {
+        std::vector< Float > xs, ys;
+        for( int i = 0; i < 19; ++i )
+        {
+            xs.push_back( static_cast< Float >( i ) * 0.5f - 4.0f );
+            ys.push_back( static_cast< Float >( i * i ) * 0.1f );
+        }
+        Affine2 transform = Transform2D{ { 10.0f, -3.0f }, 2.0f, { 0.5f, 4.0f } }.toAffine();
+
+        WHEN( "they are transformed into separate arrays" )
+        {
+            std::vector< Float > out_x( xs.size() ), out_y( ys.size() );
+            transformVertices( transform, xs.data(), ys.data(), xs.size(), out_x.data(), out_y.data() );
+
+            THEN( "every vertex, including the scalar tail, is transformed" )
+            {
+                for( std::size_t i = 0; i < xs.size(); ++i )
+                {
+                    Vec2 expected = transform * Vec2{ xs[ i ], ys[ i ] };
+                    REQUIRE( std::abs( out_x[ i ] - expected.x ) < 1e-4f );
+                    REQUIRE( std::abs( out_y[ i ] - expected.y ) < 1e-4f );
+                }
+            }
+        }
+
+        WHEN( "they are transformed in place" )
+        {
+            auto in_x = xs;
+            auto in_y = ys;
+            transformVertices( transform, xs.data(), ys.data(), xs.size(), xs.data(), ys.data() );
+
+            THEN( "each vertex is read before it is overwritten" )
+            {
+                for( std::size_t i = 0; i < xs.size(); ++i )
+                {
+                    Vec2 expected = transform * Vec2{ in_x[ i ], in_y[ i ] };
+                    REQUIRE( std::abs( xs[ i ] - expected.x ) < 1e-4f );
+                    REQUIRE( std::abs( ys[ i ] - expected.y ) < 1e-4f );
+                }
+            }
+        }
+    }
+}
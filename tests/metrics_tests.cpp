@@ -0,0 +1,147 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+#include "metrics.hpp"
+#include "tick_scheduler.hpp"
+
+namespace mx = robot::src::exports::metrics;
+namespace ts = robot::src::exports::tick_scheduler;
+
+SCENARIO( "Histogram sorts samples into power-of-two buckets", "[metrics]" )
+{
+    GIVEN( "a histogram with bounds 16, 32 and 64" )
+    {
+        mx::Histogram histogram( 4, 3 );
+
+        WHEN( "samples on, between and beyond the bounds are observed" )
+        {
+            for( auto value : { 0, 16, 17, 32, 64, 65, 1000 } )
+            {
+                histogram.observe( value );
+            }
+
+            THEN( "each lands in the smallest bucket whose bound is not below it" )
+            {
+                REQUIRE( histogram.bound( 0 ) == 16 );
+                REQUIRE( histogram.bound( 2 ) == 64 );
+                REQUIRE( histogram.bucket_count( 0 ) == 2 );
+                REQUIRE( histogram.bucket_count( 1 ) == 2 );
+                REQUIRE( histogram.bucket_count( 2 ) == 1 );
+                REQUIRE( histogram.bucket_count( 3 ) == 2 );
+            }
+
+            THEN( "count and sum cover every sample" )
+            {
+                REQUIRE( histogram.count() == 7 );
+                REQUIRE( histogram.sum() == 0 + 16 + 17 + 32 + 64 + 65 + 1000 );
+            }
+        }
+    }
+}
+
+SCENARIO( "HistogramFamily renders the Prometheus text format", "[metrics]" )
+{
+    GIVEN( "a labelled family with two members" )
+    {
+        mx::HistogramFamily family( "robot_test_bytes", "Bytes seen.", "route", 1.0, 4, 2 );
+        auto & output = family.add( "/output" );
+        family.add( "/input" ).observe( 100 );
+        output.observe( 10 );
+        output.observe( 20 );
+
+        WHEN( "a member is looked up again" )
+        {
+            THEN( "the same histogram is returned" )
+            {
+                REQUIRE( &family.add( "/output" ) == &output );
+            }
+        }
+
+        WHEN( "the family is written" )
+        {
+            std::string text;
+            family.write_prometheus( text );
+
+            THEN( "it has a type line and cumulative buckets per member" )
+            {
+                REQUIRE( text.find( "# TYPE robot_test_bytes histogram\n" ) != std::string::npos );
+                REQUIRE( text.find( "robot_test_bytes_bucket{route=\"/output\",le=\"16\"} 1\n" )
+                         != std::string::npos );
+                REQUIRE( text.find( "robot_test_bytes_bucket{route=\"/output\",le=\"32\"} 2\n" )
+                         != std::string::npos );
+                REQUIRE( text.find( "robot_test_bytes_bucket{route=\"/output\",le=\"+Inf\"} 2\n" )
+                         != std::string::npos );
+                REQUIRE( text.find( "robot_test_bytes_sum{route=\"/output\"} 30\n" ) != std::string::npos );
+                REQUIRE( text.find( "robot_test_bytes_bucket{route=\"/input\",le=\"32\"} 0\n" )
+                         != std::string::npos );
+                REQUIRE( text.find( "robot_test_bytes_count{route=\"/input\"} 1\n" ) != std::string::npos );
+            }
+        }
+    }
+}
+
+SCENARIO( "Metrics groups the robot's histograms", "[metrics]" )
+{
+    GIVEN( "metrics attached to scheduler counters" )
+    {
+        ts::TickStats stats;
+        stats.ticks = 42;
+        mx::Metrics metrics( &stats );
+
+        WHEN( "routes are looked up" )
+        {
+            THEN( "known paths get their own histograms and the rest share \"other\"" )
+            {
+                REQUIRE( metrics.route( "/output" ).name == "/output" );
+                REQUIRE( metrics.route( "/favicon.ico" ).name == "other" );
+                REQUIRE( &metrics.route( "/nope" ).seconds == &metrics.route( "other" ).seconds );
+            }
+        }
+
+        WHEN( "a system is timed and everything is written" )
+        {
+            {
+                mx::ScopedTimer timer( metrics.system( "updatePositions" ) );
+            }
+            std::string text;
+            metrics.write_prometheus( text );
+
+            THEN( "the timer's sample and the scheduler counters are exposed" )
+            {
+                REQUIRE( metrics.system( "updatePositions" ).count() == 1 );
+                REQUIRE( text.find( "robot_system_seconds_count{system=\"updatePositions\"} 1\n" )
+                         != std::string::npos );
+                REQUIRE( text.find( "robot_ticks_total 42\n" ) != std::string::npos );
+                REQUIRE( text.find( "robot_tick_seconds_count 0\n" ) != std::string::npos );
+            }
+        }
+    }
+}
+
+SCENARIO( "Metrics shared by several worlds sum their schedulers' counters", "[metrics]" )
+{
+    GIVEN( "the counters of three worlds' schedulers" )
+    {
+        ts::TickStats first, second, third;
+        first.ticks = 40;
+        second.ticks = 2;
+        third.overruns = 5;
+        mx::Metrics metrics( std::vector< const ts::TickStats * >{ &first, &second, &third } );
+
+        WHEN( "they are written" )
+        {
+            std::string text;
+            metrics.write_prometheus( text );
+
+            THEN( "each counter is exposed once, as the total over the worlds" )
+            {
+                REQUIRE( text.find( "robot_ticks_total 42\n" ) != std::string::npos );
+                REQUIRE( text.find( "robot_tick_overruns_total 5\n" ) != std::string::npos );
+                REQUIRE( text.find( "robot_ticks_total 40\n" ) == std::string::npos );
+            }
+        }
+    }
+}
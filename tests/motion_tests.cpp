@@ -0,0 +1,70 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "component_types.hpp"
+#include "motion.hpp"
+
+namespace motion = robot::src::exports::motion;
+using namespace robot::src::exports::component_types;
+using robot::src::AxisAlignedBoundingBox;
+
+SCENARIO( "integrateWrapped advances and wraps positions", "[motion]" )
+{
+    GIVEN( "a rectangular world and more positions than one SIMD batch" )
+    {
+        const AxisAlignedBoundingBox world{ { -10.0f, 0.0f }, { 10.0f, 5.0f } };
+        std::vector< Position > positions;
+        std::vector< Velocity > velocities;
+        for( std::size_t i = 0; i < 37; ++i )
+        {
+            positions.push_back( Position{ float( i % 20 ) - 10.0f, float( i % 5 ) } );
+            velocities.push_back( Velocity{ float( i ) * 0.75f - 12.0f, i % 3 == 0 ? 0.0f : 4.5f } );
+        }
+        auto expected = positions;
+        for( std::size_t i = 0; i < expected.size(); ++i )
+        {
+            expected[ i ].x = motion::wrapPeriodic( expected[ i ].x + velocities[ i ].x, -10.0f, 20.0f );
+            expected[ i ].y = motion::wrapPeriodic( expected[ i ].y + velocities[ i ].y, 0.0f, 5.0f );
+        }
+
+        WHEN( "the kernel runs" )
+        {
+            motion::integrateWrapped( std::span< Position >( positions ), std::span< const Velocity >( velocities ),
+                                      world );
+
+            THEN( "every position matches the scalar wrap and stays inside the world" )
+            {
+                for( std::size_t i = 0; i < positions.size(); ++i )
+                {
+                    REQUIRE( positions[ i ].x == expected[ i ].x );
+                    REQUIRE( positions[ i ].y == expected[ i ].y );
+                    REQUIRE( positions[ i ].x >= -10.0f );
+                    REQUIRE( positions[ i ].x < 10.0f );
+                    REQUIRE( positions[ i ].y >= 0.0f );
+                    REQUIRE( positions[ i ].y < 5.0f );
+                }
+            }
+        }
+
+        WHEN( "every velocity is zero" )
+        {
+            auto before = positions;
+            std::vector< Velocity > still( positions.size(), Velocity{ 0.0f, 0.0f } );
+            motion::integrateWrapped( std::span< Position >( positions ), std::span< const Velocity >( still ), world );
+
+            THEN( "positions inside the world are unchanged" )
+            {
+                for( std::size_t i = 0; i < positions.size(); ++i )
+                {
+                    REQUIRE( positions[ i ].x == before[ i ].x );
+                    REQUIRE( positions[ i ].y == before[ i ].y );
+                }
+            }
+        }
+    }
+}
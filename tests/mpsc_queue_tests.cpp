@@ -0,0 +1,133 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "component_types.hpp"
+#include "input_queue.hpp"
+#include "mpsc_queue.hpp"
+
+namespace ct = robot::src::exports::component_types;
+namespace iq = robot::src::exports::input_queue;
+using robot::src::exports::mpsc_queue::MpscQueue;
+
+SCENARIO( "MpscQueue is a bounded FIFO", "[mpsc_queue]" )
+{
+    GIVEN( "a queue asked for a capacity of 3" )
+    {
+        MpscQueue< int > queue( 3 );
+
+        THEN( "the capacity is rounded up to a power of two" )
+        {
+            REQUIRE( queue.capacity() == 4 );
+        }
+
+        WHEN( "it is filled past its capacity" )
+        {
+            for( int i = 0; i < 4; ++i )
+            {
+                REQUIRE( queue.try_push( i ) );
+            }
+
+            THEN( "further pushes are rejected and counted" )
+            {
+                REQUIRE_FALSE( queue.try_push( 4 ) );
+                REQUIRE( queue.rejected() == 1 );
+                REQUIRE( queue.pushed() == 4 );
+            }
+
+            THEN( "elements come out oldest first, and the freed cells are reused" )
+            {
+                int value = -1;
+                REQUIRE( queue.try_pop( value ) );
+                REQUIRE( value == 0 );
+                REQUIRE( queue.try_push( 4 ) );
+                std::vector< int > rest;
+                REQUIRE( queue.drain( [ & ]( int v ) { rest.push_back( v ); } ) == 4 );
+                REQUIRE( rest == std::vector< int >{ 1, 2, 3, 4 } );
+                REQUIRE_FALSE( queue.try_pop( value ) );
+                REQUIRE( queue.pushed() == 5 );
+                REQUIRE( queue.popped() == 5 );
+            }
+        }
+    }
+
+    GIVEN( "several producer threads and one consumer" )
+    {
+        constexpr int producers = 4;
+        constexpr int per_producer = 20'000;
+        MpscQueue< int > queue( 256 );
+        std::vector< int > next( producers, 0 );
+        bool in_order = true;
+        std::size_t received = 0;
+
+        {
+            std::vector< std::jthread > threads;
+            for( int p = 0; p < producers; ++p )
+            {
+                threads.emplace_back( [ &queue, p ] {
+                    for( int i = 0; i < per_producer; ++i )
+                    {
+                        while( !queue.try_push( p * per_producer + i ) )
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                } );
+            }
+            while( received < static_cast< std::size_t >( producers * per_producer ) )
+            {
+                received += queue.drain( [ & ]( int value ) {
+                    auto producer = value / per_producer;
+                    in_order = in_order && value % per_producer == next[ producer ];
+                    ++next[ producer ];
+                } );
+            }
+        }
+
+        THEN( "every element arrives exactly once, in each producer's order" )
+        {
+            REQUIRE( in_order );
+            REQUIRE( next == std::vector< int >( producers, per_producer ) );
+        }
+    }
+}
+
+SCENARIO( "Queued input commands coalesce per entity when drained", "[mpsc_queue][input_queue]" )
+{
+    GIVEN( "a store of four entities, one destroyed, and commands for two live entities and two others" )
+    {
+        ct::EntityStore store;
+        for( int i = 0; i < 4; ++i )
+        {
+            store.create();
+        }
+        store.destroy( store.registry.handle( 2 ) );
+        iq::InputQueue queue( 16 );
+        queue.try_push( iq::InputCommand{ 0, ct::PlayerInput{ 1.0f, 0.0f } } );
+        queue.try_push( iq::InputCommand{ 3, ct::PlayerInput{ 0.0f, 1.0f } } );
+        queue.try_push( iq::InputCommand{ 2, ct::PlayerInput{ 1.0f, 1.0f } } );
+        queue.try_push( iq::InputCommand{ 7, ct::PlayerInput{ 1.0f, 1.0f } } );
+        queue.try_push( iq::InputCommand{ 0, ct::PlayerInput{ -1.0f, 0.5f } } );
+
+        WHEN( "the queue is drained" )
+        {
+            auto drained = iq::drainInputCommands( queue, store );
+            const auto & inputs = store.get< ct::PlayerInput >();
+
+            THEN( "each live entity holds its newest input and the other commands are dropped" )
+            {
+                REQUIRE( drained == 5 );
+                REQUIRE_FALSE( inputs.contains( 2 ) );
+                REQUIRE_FALSE( inputs.contains( 7 ) );
+                REQUIRE( inputs.size() == 2 );
+                REQUIRE( inputs[ 0 ].x == -1.0f );
+                REQUIRE( inputs[ 0 ].y == 0.5f );
+                REQUIRE( inputs[ 3 ].y == 1.0f );
+                REQUIRE( iq::drainInputCommands( queue, store ) == 0 );
+            }
+        }
+    }
+}
@@ -0,0 +1,183 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <vector>
+
+#include "component_types.hpp"
+#include "narrow_phase.hpp"
+
+namespace np = robot::src::exports::narrow_phase;
+namespace ct = robot::src::exports::component_types;
+using robot::src::Vec2;
+
+namespace
+{
+ct::Polygon regularPolygon( int vertex_count, float radius )
+{
+    ct::Polygon polygon;
+    for( int i = 0; i < vertex_count; ++i )
+    {
+        float angle = ( 2.0f * 3.14159265f * i ) / vertex_count;
+        polygon.emplace_back( radius * std::cos( angle ), radius * std::sin( angle ) );
+    }
+    return polygon;
+}
+} // namespace
+
+SCENARIO( "Projection extents over SoA vertex arrays", "[narrow_phase][projection]" )
+{
+    GIVEN( "more vertices than fit in one SIMD batch" )
+    {
+        std::vector< float > xs{ 1, -7, 3, 4, 9, -2, 0, 5, 6, -3, 2 };
+        std::vector< float > ys( xs.size(), 0.0f );
+
+        WHEN( "projecting onto the x axis" )
+        {
+            auto [ lo, hi ] = np::projectExtents( xs.data(), ys.data(), xs.size(), Vec2{ 1.0f, 0.0f } );
+
+            THEN( "the extents cover every vertex, including the scalar tail" )
+            {
+                REQUIRE( lo == -7.0f );
+                REQUIRE( hi == 9.0f );
+            }
+        }
+    }
+
+    GIVEN( "no vertices" )
+    {
+        WHEN( "projecting onto any axis" )
+        {
+            auto [ lo, hi ] = np::projectExtents( nullptr, nullptr, 0, Vec2{ 1.0f, 0.0f } );
+
+            THEN( "the extents are empty" )
+            {
+                REQUIRE( lo > hi );
+            }
+        }
+    }
+}
+
+SCENARIO( "Polygon edge normals are cached next to the vertices", "[narrow_phase][normals]" )
+{
+    GIVEN( "a polygon built one vertex at a time" )
+    {
+        auto polygon = regularPolygon( 6, 10.0f );
+
+        THEN( "one normal per edge is cached" )
+        {
+            REQUIRE( polygon.has_normals() );
+            REQUIRE( polygon.normals_x.size() == 6U );
+        }
+
+        THEN( "the cached normals match normals derived from the vertices" )
+        {
+            np::ConvexView uncached{ polygon.vertices_x.data(), polygon.vertices_y.data(), nullptr, nullptr, 6 };
+            for( std::size_t i = 0; i < polygon.size(); ++i )
+            {
+                auto cached = polygon.get_edge_normal( i );
+                auto derived = uncached.edge_normal( i );
+                REQUIRE( cached.x == derived.x );
+                REQUIRE( cached.y == derived.y );
+            }
+        }
+    }
+
+    GIVEN( "a polygon whose vertex arrays were written directly" )
+    {
+        ct::Polygon polygon;
+        polygon.vertices_x = { 0.0f, 1.0f, 0.0f };
+        polygon.vertices_y = { 0.0f, 0.0f, 1.0f };
+
+        THEN( "its view falls back to deriving normals on the fly" )
+        {
+            REQUIRE_FALSE( polygon.has_normals() );
+            REQUIRE( polygon.view().normals_x == nullptr );
+        }
+
+        WHEN( "update_normals() is called" )
+        {
+            polygon.update_normals();
+
+            THEN( "the normals are cached" )
+            {
+                REQUIRE( polygon.has_normals() );
+                REQUIRE( polygon.view().normals_x != nullptr );
+            }
+        }
+    }
+}
+
+SCENARIO( "SAT with a relative offset between polygons", "[narrow_phase][sat]" )
+{
+    GIVEN( "two eight-sided polygons of radius 5" )
+    {
+        auto a = regularPolygon( 8, 5.0f );
+        auto b = regularPolygon( 8, 5.0f );
+
+        THEN( "they intersect when their centers are 9 units apart" )
+        {
+            REQUIRE( a.intersects( b, Vec2{ 9.0f, 0.0f } ) );
+            REQUIRE( np::satIntersects( b.view(), a.view(), Vec2{ -9.0f, 0.0f } ) );
+        }
+
+        THEN( "they are separated when their centers are 11 units apart" )
+        {
+            REQUIRE_FALSE( a.intersects( b, Vec2{ 11.0f, 0.0f } ) );
+            REQUIRE_FALSE( a.intersects( b, Vec2{ 0.0f, -11.0f } ) );
+        }
+    }
+
+    GIVEN( "a triangle and a square whose bounding boxes overlap but whose shapes do not" )
+    {
+        ct::Polygon triangle{ Vec2{ 0.0f, 0.0f }, Vec2{ 4.0f, 0.0f }, Vec2{ 0.0f, 4.0f } };
+        ct::Polygon square{ Vec2{ 0.0f, 0.0f }, Vec2{ 1.0f, 0.0f }, Vec2{ 1.0f, 1.0f }, Vec2{ 0.0f, 1.0f } };
+
+        THEN( "the triangle's hypotenuse separates them" )
+        {
+            REQUIRE_FALSE( triangle.intersects( square, Vec2{ 2.6f, 2.6f } ) );
+            REQUIRE( triangle.intersects( square, Vec2{ 1.0f, 1.0f } ) );
+        }
+    }
+}
+
+SCENARIO( "Swept SAT finds when translating polygons first touch", "[narrow_phase][swept]" )
+{
+    GIVEN( "two unit squares 10 units apart along x" )
+    {
+        ct::Polygon square{ Vec2{ -0.5f, -0.5f }, Vec2{ 0.5f, -0.5f }, Vec2{ 0.5f, 0.5f }, Vec2{ -0.5f, 0.5f } };
+        Vec2 offset{ 10.0f, 0.0f };
+
+        THEN( "closing the gap of 9 units over 18 touches halfway through the step" )
+        {
+            auto time = np::sweptTimeOfImpact( square.view(), square.view(), offset, Vec2{ -18.0f, 0.0f } );
+            REQUIRE( time );
+            REQUIRE( *time == 0.5f );
+        }
+
+        THEN( "passing clean through the other square within the step is still a contact" )
+        {
+            REQUIRE( np::sweptTimeOfImpact( square.view(), square.view(), offset, Vec2{ -30.0f, 0.0f } ) );
+        }
+
+        THEN( "falling short, moving away or sliding past is not" )
+        {
+            REQUIRE_FALSE( np::sweptTimeOfImpact( square.view(), square.view(), offset, Vec2{ -8.0f, 0.0f } ) );
+            REQUIRE_FALSE( np::sweptTimeOfImpact( square.view(), square.view(), offset, Vec2{ 20.0f, 0.0f } ) );
+            REQUIRE_FALSE( np::sweptTimeOfImpact( square.view(), square.view(), offset, Vec2{ -20.0f, 5.0f } ) );
+            REQUIRE_FALSE( np::sweptTimeOfImpact( square.view(), square.view(), offset, Vec2{} ) );
+        }
+    }
+
+    GIVEN( "two eight-sided polygons that already overlap" )
+    {
+        auto a = regularPolygon( 8, 5.0f );
+        auto b = regularPolygon( 8, 5.0f );
+
+        THEN( "the impact is at the start of the step, whatever the motion" )
+        {
+            REQUIRE( np::sweptTimeOfImpact( a.view(), b.view(), Vec2{ 9.0f, 0.0f }, Vec2{} ) == 0.0f );
+            REQUIRE( np::sweptTimeOfImpact( a.view(), b.view(), Vec2{ 9.0f, 0.0f }, Vec2{ 50.0f, 3.0f } ) == 0.0f );
+        }
+    }
+}
@@ -0,0 +1,250 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/json.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "component_types.hpp"
+#include "input_queue.hpp"
+#include "metrics.hpp"
+#include "rest.hpp"
+#include "scene_interest.hpp"
+#include "scene_snapshot.hpp"
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+namespace rest = robot::src::exports::rest;
+namespace si = robot::src::exports::scene_interest;
+namespace snap = robot::src::exports::scene_snapshot;
+using namespace robot::src::exports::component_types;
+using robot::src::Vec2;
+
+namespace
+{
+/// @brief Run every handler that is ready, without waiting for more.
+void drain( net::io_context & ioc )
+{
+    while( ioc.poll() > 0 )
+    {
+    }
+}
+
+/// @brief Read one frame from a stream client.
+std::string readFrame( websocket::stream< tcp::socket > & client )
+{
+    beast::flat_buffer buffer;
+    client.read( buffer );
+    return beast::buffers_to_string( buffer.data() );
+}
+} // namespace
+
+SCENARIO( "Client-supplied view margins are checked before use", "[rest][view]" )
+{
+    GIVEN( "culled request targets" )
+    {
+        THEN( "an absent margin takes the default and a valid one is read" )
+        {
+            REQUIRE( rest::viewMargin( "/output?view=0,0,1,1" ) == si::DEFAULT_VIEW_MARGIN );
+            REQUIRE( rest::viewMargin( "/output?view=0,0,1,1&margin=2.5" ) == 2.5f );
+            REQUIRE( rest::viewMargin( "/stream?margin=0" ) == 0.0f );
+        }
+
+        THEN( "negative, non-finite, out-of-range and malformed margins are rejected" )
+        {
+            REQUIRE_FALSE( rest::viewMargin( "/output?margin=-1" ) );
+            REQUIRE_FALSE( rest::viewMargin( "/output?margin=nan" ) );
+            REQUIRE_FALSE( rest::viewMargin( "/output?margin=inf" ) );
+            REQUIRE_FALSE( rest::viewMargin( "/output?margin=1e39" ) );
+            REQUIRE_FALSE( rest::viewMargin( "/output?margin=5x" ) );
+            REQUIRE_FALSE( rest::viewMargin( "/output?margin=" ) );
+        }
+    }
+}
+
+SCENARIO( "Stream view messages are checked before use", "[rest][view][json]" )
+{
+    GIVEN( "view members of stream messages" )
+    {
+        THEN( "four finite ordered numbers give a viewport and null clears it" )
+        {
+            auto view = rest::parseViewJson( boost::json::parse( "[-50,-30.5,50,30]" ) );
+            REQUIRE( view );
+            REQUIRE( view->min.y == -30.5f );
+            REQUIRE_FALSE( rest::parseViewJson( boost::json::parse( "null" ) ) );
+        }
+
+        THEN( "numbers beyond float's range, inverted boxes and wrong shapes throw" )
+        {
+            REQUIRE_THROWS_AS( rest::parseViewJson( boost::json::parse( "[0,0,1e300,1]" ) ), std::invalid_argument );
+            REQUIRE_THROWS_AS( rest::parseViewJson( boost::json::parse( "[-1e39,0,1,1]" ) ), std::invalid_argument );
+            REQUIRE_THROWS_AS( rest::parseViewJson( boost::json::parse( "[5,0,1,4]" ) ), std::invalid_argument );
+            REQUIRE_THROWS( rest::parseViewJson( boost::json::parse( "[1,2,3]" ) ) );
+            REQUIRE_THROWS( rest::parseViewNumber( boost::json::parse( "\"wide\"" ) ) );
+        }
+    }
+}
+
+SCENARIO( "StreamHub pushes the newest snapshot to its sessions", "[rest][stream]" )
+{
+    GIVEN( "a stream session subscribed over loopback to a buffer holding tick 1" )
+    {
+        EntityStore store;
+        store.get< Polygon >().insert( 0, Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 1.0f, 0.0f }, Vec2{ 0.0f, 1.0f } } );
+        store.get< Position >().insert( 0, Position{ 5.0f, 6.0f } );
+        snap::SnapshotBuffer snapshots;
+        auto publish = [ & ]( std::uint64_t tick ) {
+            snapshots.write_buffer().capture( store, tick, snapshots.latest().get() );
+            snapshots.publish();
+        };
+        publish( 1 );
+
+        // The server side is driven by hand with drain(), so nothing runs between the test's steps
+        net::io_context ioc;
+        robot::src::InputQueue inputs( robot::src::INPUT_QUEUE_CAPACITY );
+        robot::src::Metrics metrics;
+        rest::StreamHub hub;
+        tcp::acceptor acceptor( ioc, tcp::endpoint( net::ip::make_address( "127.0.0.1" ), 0 ) );
+
+        net::io_context client_ioc;
+        websocket::stream< tcp::socket > client( client_ioc );
+        std::thread handshake( [ & ] {
+            client.next_layer().connect( acceptor.local_endpoint() );
+            client.handshake( "127.0.0.1", "/stream" );
+        } );
+        auto socket = acceptor.accept();
+        beast::flat_buffer request_buffer;
+        http::request< http::string_body > request;
+        http::read( socket, request_buffer, request );
+        std::make_shared< rest::StreamSession >( std::move( socket ), inputs, snapshots, hub, metrics )
+            ->run( std::move( request ) );
+        while( hub.size() == 0 )
+        {
+            ioc.run_one();
+        }
+        drain( ioc );
+        handshake.join();
+
+        THEN( "the first frame is a keyframe of the latest tick" )
+        {
+            auto frame = readFrame( client );
+            REQUIRE( frame.find( "\"type\":\"keyframe\"" ) != std::string::npos );
+            REQUIRE( frame.find( "\"tick\":1," ) != std::string::npos );
+        }
+
+        WHEN( "a tick is published and broadcast" )
+        {
+            readFrame( client );
+            publish( 2 );
+            hub.broadcast();
+            drain( ioc );
+
+            THEN( "the session sends it as a delta from the tick before" )
+            {
+                auto frame = readFrame( client );
+                REQUIRE( frame.find( "\"base\":1,\"tick\":2," ) != std::string::npos );
+            }
+        }
+
+        WHEN( "several ticks are broadcast before the session gets to run" )
+        {
+            readFrame( client );
+            for( std::uint64_t tick = 2; tick <= 4; ++tick )
+            {
+                publish( tick );
+                hub.broadcast();
+            }
+            drain( ioc );
+            publish( 5 );
+            hub.broadcast();
+            drain( ioc );
+
+            THEN( "only the newest is sent and the ones in between are dropped" )
+            {
+                REQUIRE( readFrame( client ).find( "\"base\":1,\"tick\":4," ) != std::string::npos );
+                REQUIRE( readFrame( client ).find( "\"base\":4,\"tick\":5," ) != std::string::npos );
+            }
+        }
+
+        WHEN( "the viewer disconnects" )
+        {
+            client.next_layer().close();
+            drain( ioc );
+            REQUIRE( hub.size() == 1 );
+            hub.broadcast();
+
+            THEN( "the next broadcast drops the closed session" )
+            {
+                REQUIRE( hub.size() == 0 );
+            }
+        }
+    }
+}
+
+SCENARIO( "Request paths are routed to the world they name", "[rest][worlds]" )
+{
+    GIVEN( "paths with and without a /worlds/<id> prefix" )
+    {
+        THEN( "a prefix is split into its world and the path within it" )
+        {
+            auto root = rest::splitWorldPath( "/worlds/0/" );
+            REQUIRE( root );
+            REQUIRE( root->world == 0 );
+            REQUIRE( root->path == "/" );
+            REQUIRE( root->prefixed );
+            auto output = rest::splitWorldPath( "/worlds/12/output" );
+            REQUIRE( output );
+            REQUIRE( output->world == 12 );
+            REQUIRE( output->path == "/output" );
+        }
+
+        THEN( "a prefix without a trailing slash leaves an empty path to redirect" )
+        {
+            auto world = rest::splitWorldPath( "/worlds/1" );
+            REQUIRE( world );
+            REQUIRE( world->world == 1 );
+            REQUIRE( world->path.empty() );
+            REQUIRE( world->prefixed );
+        }
+
+        THEN( "unprefixed paths address world 0" )
+        {
+            auto output = rest::splitWorldPath( "/output" );
+            REQUIRE( output );
+            REQUIRE( output->world == 0 );
+            REQUIRE( output->path == "/output" );
+            REQUIRE_FALSE( output->prefixed );
+        }
+
+        THEN( "ids that are not canonical numbers are rejected" )
+        {
+            REQUIRE_FALSE( rest::splitWorldPath( "/worlds/x/" ) );
+            REQUIRE_FALSE( rest::splitWorldPath( "/worlds//" ) );
+            REQUIRE_FALSE( rest::splitWorldPath( "/worlds/" ) );
+            REQUIRE_FALSE( rest::splitWorldPath( "/worlds/1x/output" ) );
+            REQUIRE_FALSE( rest::splitWorldPath( "/worlds/-1/" ) );
+            REQUIRE_FALSE( rest::splitWorldPath( "/worlds/+1/" ) );
+            REQUIRE_FALSE( rest::splitWorldPath( "/worlds/01/" ) );
+            REQUIRE_FALSE( rest::splitWorldPath( "/worlds/00" ) );
+            REQUIRE_FALSE( rest::splitWorldPath( "/worlds/99999999999999999999999/" ) );
+        }
+
+        THEN( "only worlds the server runs are routed to, and bad prefixes never reach world 0" )
+        {
+            REQUIRE( rest::routeWorldPath( "/worlds/2/stream", 3 ) );
+            REQUIRE( rest::routeWorldPath( "/stream", 1 ) );
+            REQUIRE_FALSE( rest::routeWorldPath( "/worlds/3/stream", 3 ) );
+            REQUIRE_FALSE( rest::routeWorldPath( "/worlds/18446744073709551615/", 3 ) );
+            REQUIRE_FALSE( rest::routeWorldPath( "/worlds/x/output", 3 ) );
+            REQUIRE_FALSE( rest::routeWorldPath( "/worlds/01/output", 3 ) );
+        }
+    }
+}
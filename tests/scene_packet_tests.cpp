@@ -0,0 +1,433 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "component_types.hpp"
+#include "scene_codec.hpp"
+#include "scene_interest.hpp"
+#include "scene_packet.hpp"
+#include "scene_snapshot.hpp"
+
+namespace codec = robot::src::exports::scene_codec;
+namespace snap = robot::src::exports::scene_snapshot;
+namespace si = robot::src::exports::scene_interest;
+using robot::src::exports::scene_packet::ScenePacket;
+using namespace robot::src::exports::component_types;
+using robot::src::AxisAlignedBoundingBox;
+using robot::src::Vec2;
+
+namespace
+{
+EntityStore makeStore()
+{
+    EntityStore store;
+    store.get< Polygon >().insert( 0, Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 1.0f, 0.0f }, Vec2{ 0.0f, 1.0f } } );
+    store.get< Position >().insert( 0, Position{ 5.0f, 6.0f } );
+    store.get< Polygon >().insert(
+        1,
+        Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 2.0f, 0.0f }, Vec2{ 2.0f, 2.0f }, Vec2{ 0.0f, 2.0f } } );
+    return store;
+}
+
+std::vector< std::uint32_t > words( const std::string & buffer )
+{
+    std::vector< std::uint32_t > result( buffer.size() / sizeof( std::uint32_t ) );
+    std::memcpy( result.data(), buffer.data(), result.size() * sizeof( std::uint32_t ) );
+    return result;
+}
+
+float asFloat( std::uint32_t word )
+{
+    float value;
+    std::memcpy( &value, &word, sizeof( value ) );
+    return value;
+}
+} // namespace
+
+SCENARIO( "Binary scene updates are flat 32-bit words", "[scene_codec][binary]" )
+{
+    GIVEN( "a snapshot of a positioned triangle and an unpositioned square" )
+    {
+        auto store = makeStore();
+        auto first = std::make_shared< snap::SceneSnapshot >();
+        first->capture( store, 1 );
+
+        WHEN( "a keyframe is encoded" )
+        {
+            std::string buffer;
+            ScenePacket{ first, 0 }.write_binary( buffer );
+            auto w = words( buffer );
+
+            THEN( "the header describes the sections" )
+            {
+                REQUIRE( buffer.size() % 4 == 0 );
+                REQUIRE( w[ 0 ] == codec::SCENE_BINARY_MAGIC );
+                REQUIRE( w[ 1 ] == codec::SCENE_BINARY_KEYFRAME );
+                REQUIRE( w[ 2 ] == 1 );
+                REQUIRE( w[ 6 ] == 0 ); // despawns
+                REQUIRE( w[ 7 ] == 2 ); // spawns
+                REQUIRE( w[ 8 ] == 0 ); // moves
+                REQUIRE( w[ 9 ] == 7 ); // vertices
+                REQUIRE( w[ 10 ] == 0 ); // shapes
+                REQUIRE( w[ 11 ] == 0 ); // shape vertices
+                REQUIRE( w.size() == codec::SCENE_BINARY_HEADER_WORDS + 2 * 11 + 1 + 7 * 2 + 1 );
+            }
+
+            THEN( "ids, flags, shapes, transforms, offsets, positions and vertices follow in order" )
+            {
+                auto at = codec::SCENE_BINARY_HEADER_WORDS;
+                REQUIRE( w[ at + 0 ] == 0 );
+                REQUIRE( w[ at + 1 ] == 1 );
+                REQUIRE( w[ at + 2 ] == codec::SCENE_BINARY_HAS_POSITION );
+                REQUIRE( w[ at + 3 ] == 0 );
+                REQUIRE( w[ at + 4 ] == NO_SHAPE );
+                REQUIRE( asFloat( w[ at + 6 + 3 ] ) == 1.0f ); // identity scale of the first transform
+                REQUIRE( std::vector< std::uint32_t >( w.begin() + at + 16, w.begin() + at + 19 )
+                         == std::vector< std::uint32_t >{ 0, 3, 7 } );
+                REQUIRE( asFloat( w[ at + 19 ] ) == 5.0f );
+                REQUIRE( asFloat( w[ at + 20 ] ) == 6.0f );
+                // Second vertex of the square, interleaved x, y
+                REQUIRE( asFloat( w[ at + 23 + 2 * 4 ] ) == 2.0f );
+                REQUIRE( asFloat( w[ at + 23 + 2 * 4 + 1 ] ) == 0.0f );
+                REQUIRE( w.back() == 0 ); // shape offsets sentinel
+            }
+        }
+
+        WHEN( "a delta is encoded after the triangle moves and the square is removed" )
+        {
+            store.get< Position >()[ 0 ] = Position{ 7.0f, 6.0f };
+            store.get< Polygon >().erase( 1 );
+            auto second = std::make_shared< snap::SceneSnapshot >();
+            second->capture( store, 2, first.get() );
+
+            std::string buffer;
+            ScenePacket{ second, 1 }.write_binary( buffer );
+            auto w = words( buffer );
+
+            THEN( "only the despawn and the move are sent" )
+            {
+                REQUIRE( w[ 1 ] == codec::SCENE_BINARY_DELTA );
+                REQUIRE( w[ 4 ] == 1 ); // base
+                REQUIRE( w[ 6 ] == 1 );
+                REQUIRE( w[ 7 ] == 0 );
+                REQUIRE( w[ 8 ] == 1 );
+                auto at = codec::SCENE_BINARY_HEADER_WORDS;
+                REQUIRE( w[ at ] == 1 ); // despawned id
+                REQUIRE( w[ at + 1 ] == 0 ); // spawn offsets sentinel
+                REQUIRE( w[ at + 2 ] == 0 ); // moved id
+                REQUIRE( asFloat( w[ at + 3 ] ) == 7.0f );
+                REQUIRE( w[ at + 5 ] == 0 ); // shape offsets sentinel
+                REQUIRE( w.size() == at + 6 );
+            }
+
+            AND_WHEN( "the viewer is beyond the history window" )
+            {
+                ScenePacket{ second, 0 }.write_binary( buffer );
+
+                THEN( "a keyframe is sent instead" )
+                {
+                    REQUIRE( words( buffer )[ 1 ] == codec::SCENE_BINARY_KEYFRAME );
+                }
+            }
+        }
+    }
+}
+
+SCENARIO( "ScenePacket writes JSON without building a document", "[scene_packet][json]" )
+{
+    GIVEN( "a snapshot of a positioned triangle and an unpositioned square" )
+    {
+        auto store = makeStore();
+        auto first = std::make_shared< snap::SceneSnapshot >();
+        first->capture( store, 1 );
+
+        THEN( "a keyframe lists every entity with its id" )
+        {
+            ScenePacket packet{ first, 0 };
+            REQUIRE( packet.keyframe() );
+            REQUIRE(
+                packet.to_json()
+                == R"({"version":2,"type":"keyframe","tick":1,"inputs":0,"shapes":[],"spawn":[)"
+                   R"({"id":0,"vertices":[[0,0],[1,0],[0,1]],"position":[5,6]},)"
+                   R"({"id":1,"vertices":[[0,0],[2,0],[2,2],[0,2]]}]})" );
+        }
+
+        THEN( "the unversioned format omits ids" )
+        {
+            std::string out;
+            ScenePacket{ first, 0 }.write_geometries_json( out );
+            REQUIRE(
+                out
+                == R"({"geometries":[{"vertices":[[0,0],[1,0],[0,1]],"position":[5,6]},)"
+                   R"({"vertices":[[0,0],[2,0],[2,2],[0,2]]}]})" );
+        }
+
+        THEN( "the header reports how many input commands the tick had applied" )
+        {
+            auto steered = std::make_shared< snap::SceneSnapshot >();
+            steered->capture( store, 3 );
+            steered->inputs = 7;
+            REQUIRE( ScenePacket{ steered, 0 }.to_json().starts_with(
+                R"({"version":2,"type":"keyframe","tick":3,"inputs":7,"shapes":[])" ) );
+        }
+
+        THEN( "an empty packet is an empty keyframe" )
+        {
+            REQUIRE( ScenePacket{}.to_json()
+                     == R"({"version":2,"type":"keyframe","tick":0,"inputs":0,"shapes":[],"spawn":[]})" );
+        }
+
+        WHEN( "the triangle moves by a fraction and the square is removed" )
+        {
+            store.get< Position >()[ 0 ] = Position{ 5.1f, 6.0f };
+            store.get< Polygon >().erase( 1 );
+            auto second = std::make_shared< snap::SceneSnapshot >();
+            second->capture( store, 2, first.get() );
+
+            THEN( "the delta carries the despawn and the shortest round-trip position" )
+            {
+                REQUIRE(
+                    ScenePacket{ second, 1 }.to_json()
+                    == R"({"version":2,"type":"delta","base":1,"tick":2,"inputs":0,"shapes":[],)"
+                       R"("despawn":[1],"spawn":[],"move":[[0,5.1,6]]})" );
+            }
+
+            THEN( "write() replaces the buffer contents" )
+            {
+                std::string out = "stale";
+                ScenePacket{ second, 2 }.write( codec::SceneFormat::json, out );
+                REQUIRE( out
+                         == R"({"version":2,"type":"delta","base":2,"tick":2,"inputs":0,"shapes":[],"despawn":[],)"
+                            R"("spawn":[],"move":[]})" );
+            }
+        }
+    }
+}
+
+SCENARIO( "ScenePacket sends shared shapes once", "[scene_packet][shapes]" )
+{
+    GIVEN( "two entities instancing one registered triangle" )
+    {
+        EntityStore store;
+        ShapeId triangle = store.shapes.add( Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 1.0f, 0.0f }, Vec2{ 0.0f, 1.0f } } );
+        store.get< ShapeInstance >().insert( 0, ShapeInstance{ triangle, {} } );
+        store.get< Position >().insert( 0, Position{ 5.0f, 6.0f } );
+        ShapeInstance doubled{ triangle, {} };
+        doubled.transform.scale = Vec2{ 2.0f, 2.0f };
+        store.get< ShapeInstance >().insert( 1, doubled );
+        auto first = std::make_shared< snap::SceneSnapshot >();
+        first->capture( store, 1 );
+
+        THEN( "a keyframe carries the shape once and references it from both entities" )
+        {
+            REQUIRE( ScenePacket{ first, 0 }.to_json()
+                     == R"({"version":2,"type":"keyframe","tick":1,"inputs":0,)"
+                        R"("shapes":[{"shape":0,"vertices":[[0,0],[1,0],[0,1]]}],)"
+                        R"("spawn":[{"id":0,"shape":0,"transform":[0,0,0,1,1],"position":[5,6]},)"
+                        R"({"id":1,"shape":0,"transform":[0,0,0,2,2]}]})" );
+        }
+
+        THEN( "the unversioned format writes each instance's transformed vertices" )
+        {
+            std::string out;
+            ScenePacket{ first, 0 }.write_geometries_json( out );
+            REQUIRE( out
+                     == R"({"geometries":[{"vertices":[[0,0],[1,0],[0,1]],"position":[5,6]},)"
+                        R"({"vertices":[[0,0],[2,0],[0,2]]}]})" );
+        }
+
+        THEN( "a binary keyframe has one shape section and no per-entity vertices" )
+        {
+            std::string buffer;
+            ScenePacket{ first, 0 }.write_binary( buffer );
+            auto w = words( buffer );
+            REQUIRE( w[ 7 ] == 2 ); // spawns
+            REQUIRE( w[ 9 ] == 0 ); // vertices
+            REQUIRE( w[ 10 ] == 1 ); // shapes
+            REQUIRE( w[ 11 ] == 3 ); // shape vertices
+            auto at = codec::SCENE_BINARY_HEADER_WORDS;
+            REQUIRE( w[ at + 2 ] == ( codec::SCENE_BINARY_HAS_POSITION | codec::SCENE_BINARY_INSTANCE ) );
+            REQUIRE( w[ at + 3 ] == codec::SCENE_BINARY_INSTANCE );
+            REQUIRE( w[ at + 4 ] == triangle );
+            REQUIRE( w.size() == at + 2 * 11 + 1 + 1 + 2 + 3 * 2 );
+            REQUIRE( asFloat( w.back() ) == 1.0f ); // y of the triangle's last vertex
+        }
+
+        WHEN( "the first instance moves" )
+        {
+            store.get< Position >()[ 0 ] = Position{ 6.0f, 6.0f };
+            auto second = std::make_shared< snap::SceneSnapshot >();
+            second->capture( store, 2, first.get() );
+
+            THEN( "the delta sends the move but neither the shape nor the instances again" )
+            {
+                REQUIRE( ScenePacket{ second, 1 }.to_json()
+                         == R"({"version":2,"type":"delta","base":1,"tick":2,"inputs":0,"shapes":[],)"
+                            R"("despawn":[],"spawn":[],"move":[[0,6,6]]})" );
+            }
+        }
+    }
+}
+
+SCENARIO( "A SceneInterest culls packets to a viewport", "[scene_packet][interest]" )
+{
+    GIVEN( "three unit squares spread along the x axis" )
+    {
+        EntityStore store;
+        for( std::size_t entity = 0; entity < 3; ++entity )
+        {
+            store.get< Polygon >().insert(
+                entity, Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 1.0f, 0.0f }, Vec2{ 1.0f, 1.0f }, Vec2{ 0.0f, 1.0f } } );
+            store.get< Position >().insert( entity, Position{ -60.0f + 60.0f * static_cast< float >( entity ), 0.0f } );
+        }
+        auto first = std::make_shared< snap::SceneSnapshot >();
+        first->capture( store, 1 );
+        AxisAlignedBoundingBox left_view{ { -70.0f, -10.0f }, { -50.0f, 10.0f } };
+        si::SceneInterest interest;
+
+        THEN( "the snapshot indexes each geometry by its world bounds" )
+        {
+            REQUIRE( first->bounds[ 1 ].min.x == 0.0f );
+            REQUIRE( first->bounds[ 1 ].max.x == 1.0f );
+            std::vector< std::size_t > found;
+            first->index.query( { { -1.0f, -1.0f }, { 2.0f, 2.0f } }, found );
+            REQUIRE( found == std::vector< std::size_t >{ 1 } );
+        }
+
+        WHEN( "a new viewer asks for the left of the world" )
+        {
+            interest.select( *first, left_view, 0 );
+            ScenePacket packet{ first, 0, &interest };
+
+            THEN( "its keyframe holds only the square in view" )
+            {
+                REQUIRE( packet.keyframe() );
+                REQUIRE( packet.to_json()
+                         == R"({"version":2,"type":"keyframe","tick":1,"inputs":0,"shapes":[],"spawn":[)"
+                            R"({"id":0,"vertices":[[0,0],[1,0],[1,1],[0,1]],"position":[-60,0]}]})" );
+                std::string out;
+                packet.write_geometries_json( out );
+                REQUIRE( out == R"({"geometries":[{"vertices":[[0,0],[1,0],[1,1],[0,1]],"position":[-60,0]}]})" );
+            }
+
+            AND_WHEN( "the middle square moves into view and the left one moves within it" )
+            {
+                store.get< Position >()[ 0 ] = Position{ -61.0f, 0.0f };
+                store.get< Position >()[ 1 ] = Position{ -55.0f, 0.0f };
+                auto second = std::make_shared< snap::SceneSnapshot >();
+                second->capture( store, 2, first.get() );
+                interest.select( *second, left_view, 1 );
+
+                THEN( "the newcomer is spawned in full and the other only moved" )
+                {
+                    REQUIRE( ScenePacket{ second, 1, &interest }.to_json()
+                             == R"({"version":2,"type":"delta","base":1,"tick":2,"inputs":0,"shapes":[],"despawn":[],)"
+                                R"("spawn":[{"id":1,"vertices":[[0,0],[1,0],[1,1],[0,1]],"position":[-55,0]}],)"
+                                R"("move":[[0,-61,0]]})" );
+                }
+
+                AND_WHEN( "the viewer pans to the right of the world" )
+                {
+                    auto third = std::make_shared< snap::SceneSnapshot >();
+                    third->capture( store, 3, second.get() );
+                    interest.select( *third, { { 50.0f, -10.0f }, { 70.0f, 10.0f } }, 2 );
+                    std::string buffer;
+                    ScenePacket{ third, 2, &interest }.write_binary( buffer );
+                    auto w = words( buffer );
+
+                    THEN( "what left the view is despawned and what entered it spawned" )
+                    {
+                        REQUIRE( w[ 1 ] == codec::SCENE_BINARY_DELTA );
+                        REQUIRE( w[ 6 ] == 2 ); // despawns
+                        REQUIRE( w[ 7 ] == 1 ); // spawns
+                        REQUIRE( w[ 8 ] == 0 ); // moves
+                        auto at = codec::SCENE_BINARY_HEADER_WORDS;
+                        REQUIRE( w[ at ] == 0 );
+                        REQUIRE( w[ at + 1 ] == 1 );
+                        REQUIRE( w[ at + 2 ] == 2 );
+                    }
+                }
+            }
+
+        }
+
+        WHEN( "viewers send boxes whole worlds away, far wider than the world, or with a huge margin" )
+        {
+            auto width = first->index.world_size().x;
+            AxisAlignedBoundingBox far_view{ { left_view.min.x + 7.0f * width, left_view.min.y },
+                                             { left_view.max.x + 7.0f * width, left_view.max.y } };
+            si::SceneInterest far, huge, margin;
+            far.select( *first, far_view, 0 );
+            huge.select( *first, { { -1e30f, -1e30f }, { 1e30f, 1e30f } }, 0 );
+            margin.select( *first, si::expandBox( left_view, 3e38f ), 0 );
+
+            THEN( "each is folded onto the world instead of overflowing the grid" )
+            {
+                REQUIRE( far.spawns() == std::vector< std::size_t >{ 0 } );
+                REQUIRE( huge.spawns() == std::vector< std::size_t >{ 0, 1, 2 } );
+                REQUIRE( margin.spawns() == std::vector< std::size_t >{ 0, 1, 2 } );
+            }
+
+            THEN( "a folded box keeps its width and starts inside the world" )
+            {
+                const auto & world = first->index.bounds();
+                auto folded = si::wrapViewToWorld( far_view, world );
+                REQUIRE( folded.min.x >= world.min.x );
+                REQUIRE( folded.min.x < world.max.x );
+                REQUIRE( folded.max.x - folded.min.x == left_view.max.x - left_view.min.x );
+                REQUIRE( folded.min.y == left_view.min.y );
+                auto whole = si::wrapViewToWorld( si::expandBox( left_view, 3e38f ), world );
+                REQUIRE( whole.min.x == world.min.x );
+                REQUIRE( whole.max.y == world.max.y );
+            }
+        }
+
+        WHEN( "a viewer on a new connection claims to hold tick 1" )
+        {
+            interest.select( *first, left_view, 1 );
+
+            THEN( "it is sent a keyframe of the view, and a delta the next time" )
+            {
+                REQUIRE( interest.keyframe() );
+                REQUIRE( interest.spawns() == std::vector< std::size_t >{ 0 } );
+                interest.select( *first, left_view, 1 );
+                REQUIRE_FALSE( interest.keyframe() );
+                REQUIRE( interest.spawns().empty() );
+            }
+        }
+    }
+
+    GIVEN( "viewport query strings" )
+    {
+        THEN( "four ordered numbers parse and anything else is rejected" )
+        {
+            auto view = si::parseViewport( "-50,-30.5,50,30" );
+            REQUIRE( view );
+            REQUIRE( view->min.y == -30.5f );
+            REQUIRE( view->max.x == 50.0f );
+            REQUIRE_FALSE( si::parseViewport( "1,2,3" ) );
+            REQUIRE_FALSE( si::parseViewport( "1,2,3,4,5" ) );
+            REQUIRE_FALSE( si::parseViewport( "5,0,1,4" ) );
+            REQUIRE_FALSE( si::parseViewport( "a,b,c,d" ) );
+            REQUIRE_FALSE( si::parseViewport( "nan,0,1,1" ) );
+            REQUIRE_FALSE( si::parseViewport( "0,0,inf,1" ) );
+            REQUIRE_FALSE( si::parseViewport( "-inf,-inf,inf,inf" ) );
+            REQUIRE_FALSE( si::parseViewport( "0,0,1e39,1" ) );
+        }
+
+        THEN( "margins must be finite and not negative" )
+        {
+            REQUIRE( si::isValidViewMargin( 0.0f ) );
+            REQUIRE( si::isValidViewMargin( 25.0f ) );
+            REQUIRE_FALSE( si::isValidViewMargin( -1.0f ) );
+            REQUIRE_FALSE( si::isValidViewMargin( std::numeric_limits< float >::infinity() ) );
+            REQUIRE_FALSE( si::isValidViewMargin( std::numeric_limits< float >::quiet_NaN() ) );
+        }
+    }
+}
@@ -0,0 +1,368 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "component_types.hpp"
+#include "scene_snapshot.hpp"
+#include "systems.hpp"
+
+namespace snap = robot::src::exports::scene_snapshot;
+namespace sys = robot::src::exports::systems;
+using namespace robot::src::exports::component_types;
+using robot::src::Vec2;
+
+namespace
+{
+EntityStore makeStore()
+{
+    EntityStore store;
+    store.get< Polygon >().insert( 0, Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 1.0f, 0.0f }, Vec2{ 0.0f, 1.0f } } );
+    store.get< Position >().insert( 0, Position{ 5.0f, 6.0f } );
+    store.get< Polygon >().insert(
+        1,
+        Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 2.0f, 0.0f }, Vec2{ 2.0f, 2.0f }, Vec2{ 0.0f, 2.0f } } );
+    return store;
+}
+} // namespace
+
+SCENARIO( "SceneSnapshot copies renderable state out of the store", "[scene_snapshot]" )
+{
+    GIVEN( "a store with a positioned triangle and an unpositioned square" )
+    {
+        auto store = makeStore();
+
+        WHEN( "a snapshot is captured" )
+        {
+            snap::SceneSnapshot snapshot;
+            snapshot.capture( store, 42 );
+
+            THEN( "it records the tick and one entry per polygon" )
+            {
+                REQUIRE( snapshot.tick == 42 );
+                REQUIRE( snapshot.size() == 2 );
+                REQUIRE( snapshot.entities[ 0 ] == 0 );
+                REQUIRE( snapshot.entities[ 1 ] == 1 );
+            }
+
+            THEN( "positions are copied where present" )
+            {
+                REQUIRE( snapshot.has_position[ 0 ] == 1 );
+                REQUIRE( snapshot.positions[ 0 ].x == 5.0f );
+                REQUIRE( snapshot.positions[ 0 ].y == 6.0f );
+                REQUIRE( snapshot.has_position[ 1 ] == 0 );
+            }
+
+            THEN( "vertices are stored flat with per-geometry offsets" )
+            {
+                REQUIRE( snapshot.vertex_offsets == std::vector< std::uint32_t >{ 0, 3, 7 } );
+                REQUIRE( snapshot.vertices_x.size() == 7 );
+                REQUIRE( snapshot.vertices_x[ 4 ] == 2.0f );
+                REQUIRE( snapshot.vertices_y[ 5 ] == 2.0f );
+            }
+
+            AND_WHEN( "the store changes and the snapshot is captured again" )
+            {
+                store.get< Polygon >().erase( 1 );
+                snapshot.capture( store, 43 );
+
+                THEN( "the old contents are replaced" )
+                {
+                    REQUIRE( snapshot.tick == 43 );
+                    REQUIRE( snapshot.size() == 1 );
+                    REQUIRE( snapshot.vertex_offsets == std::vector< std::uint32_t >{ 0, 3 } );
+                }
+            }
+        }
+    }
+}
+
+SCENARIO( "SnapshotBuffer publishes snapshots to readers", "[scene_snapshot][buffer]" )
+{
+    GIVEN( "an empty buffer" )
+    {
+        snap::SnapshotBuffer buffer;
+        auto store = makeStore();
+
+        THEN( "there is nothing to read yet" )
+        {
+            REQUIRE( buffer.latest() == nullptr );
+        }
+
+        WHEN( "a snapshot is written and published" )
+        {
+            buffer.write_buffer().capture( store, 1 );
+            buffer.publish();
+
+            THEN( "readers see it" )
+            {
+                auto latest = buffer.latest();
+                REQUIRE( latest != nullptr );
+                REQUIRE( latest->tick == 1 );
+                REQUIRE( latest->size() == 2 );
+            }
+        }
+
+        WHEN( "a reader holds a snapshot while several newer ones are published" )
+        {
+            buffer.write_buffer().capture( store, 1 );
+            buffer.publish();
+            auto held = buffer.latest();
+
+            for( std::uint64_t tick = 2; tick <= 10; ++tick )
+            {
+                buffer.write_buffer().capture( store, tick );
+                buffer.publish();
+            }
+
+            THEN( "the held snapshot is never overwritten" )
+            {
+                REQUIRE( held->tick == 1 );
+                REQUIRE( buffer.latest()->tick == 10 );
+                REQUIRE( held.get() != buffer.latest().get() );
+            }
+        }
+
+        WHEN( "readers hold every slot" )
+        {
+            std::vector< std::shared_ptr< const snap::SceneSnapshot > > pinned;
+            for( std::uint64_t tick = 1; tick <= snap::SnapshotBuffer::SLOT_COUNT; ++tick )
+            {
+                buffer.write_buffer().capture( store, tick );
+                buffer.publish();
+                pinned.push_back( buffer.latest() );
+            }
+            buffer.write_buffer().capture( store, 99 );
+            buffer.publish();
+
+            THEN( "a fresh snapshot is published without disturbing the pinned ones" )
+            {
+                REQUIRE( buffer.latest()->tick == 99 );
+                for( std::size_t i = 0; i < pinned.size(); ++i )
+                {
+                    REQUIRE( pinned[ i ]->tick == i + 1 );
+                }
+            }
+        }
+    }
+}
+
+SCENARIO( "SceneSnapshot tracks per-entity versions across ticks", "[scene_snapshot][versions]" )
+{
+    GIVEN( "a snapshot of the initial store" )
+    {
+        auto store = makeStore();
+        snap::SceneSnapshot first;
+        first.capture( store, 1 );
+
+        THEN( "everything counts as spawned on the first tick" )
+        {
+            REQUIRE( first.spawn_ticks == std::vector< std::uint64_t >{ 1, 1 } );
+            REQUIRE( first.slot_of( 1 ) == 1 );
+            REQUIRE( first.slot_of( 7 ) == snap::SceneSnapshot::NO_SLOT );
+            REQUIRE_FALSE( first.can_delta_from( 0 ) );
+        }
+
+        WHEN( "one entity moves, one is removed and one is added" )
+        {
+            store.get< Position >()[ 0 ] = Position{ 5.5f, 6.0f };
+            store.get< Polygon >().erase( 1 );
+            store.get< Polygon >().insert( 2, Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 1.0f, 1.0f }, Vec2{ 1.0f, 0.0f } } );
+            snap::SceneSnapshot second;
+            second.capture( store, 2, &first );
+
+            THEN( "only the changes carry the new tick" )
+            {
+                auto moved = second.slot_of( 0 );
+                auto spawned = second.slot_of( 2 );
+                REQUIRE( second.spawn_ticks[ moved ] == 1 );
+                REQUIRE( second.move_ticks[ moved ] == 2 );
+                REQUIRE( second.spawn_ticks[ spawned ] == 2 );
+                REQUIRE( second.despawns.size() == 1 );
+                REQUIRE( second.despawns[ 0 ].first == 1 );
+                REQUIRE( second.despawns[ 0 ].second == 2 );
+                REQUIRE( second.can_delta_from( 1 ) );
+            }
+
+            AND_WHEN( "nothing changes on the next tick" )
+            {
+                snap::SceneSnapshot third;
+                third.capture( store, 3, &second );
+
+                THEN( "versions and the despawn log carry forward" )
+                {
+                    REQUIRE( third.move_ticks[ third.slot_of( 0 ) ] == 2 );
+                    REQUIRE( third.spawn_ticks[ third.slot_of( 2 ) ] == 2 );
+                    REQUIRE( third.despawns.size() == 1 );
+                    REQUIRE( third.can_delta_from( 1 ) );
+                }
+            }
+        }
+
+        WHEN( "the history window is exceeded" )
+        {
+            auto previous = first;
+            snap::SceneSnapshot next;
+            for( std::uint64_t tick = 2; tick <= snap::SceneSnapshot::HISTORY_TICKS + 10; ++tick )
+            {
+                next.capture( store, tick, &previous );
+                std::swap( next, previous );
+            }
+
+            THEN( "deltas from ticks older than the horizon are refused" )
+            {
+                REQUIRE( previous.horizon == 10 );
+                REQUIRE_FALSE( previous.can_delta_from( 9 ) );
+                REQUIRE( previous.can_delta_from( 10 ) );
+            }
+        }
+    }
+}
+
+SCENARIO( "SceneSnapshot treats a recycled entity id as a new entity", "[scene_snapshot][versions]" )
+{
+    GIVEN( "an entity created through the registry" )
+    {
+        EntityStore store;
+        auto square = Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 1.0f, 0.0f }, Vec2{ 1.0f, 1.0f }, Vec2{ 0.0f, 1.0f } };
+        auto entity = store.create();
+        store.get< Polygon >().insert( entity.id(), square );
+        snap::SceneSnapshot first;
+        first.capture( store, 1 );
+
+        WHEN( "it is destroyed and an identical entity reuses its id within one tick" )
+        {
+            store.destroy( entity );
+            auto replacement = store.create();
+            store.get< Polygon >().insert( replacement.id(), square );
+            snap::SceneSnapshot second;
+            second.capture( store, 2, &first );
+
+            THEN( "the replacement counts as spawned" )
+            {
+                REQUIRE( replacement.id() == entity.id() );
+                REQUIRE( second.spawn_ticks[ second.slot_of( replacement.id() ) ] == 2 );
+            }
+        }
+    }
+}
+
+SCENARIO( "SceneSnapshot keeps shared shapes in their own table", "[scene_snapshot][shapes]" )
+{
+    GIVEN( "an instance of a registered triangle" )
+    {
+        EntityStore store;
+        auto triangle = Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 1.0f, 0.0f }, Vec2{ 0.0f, 1.0f } };
+        ShapeId shape = store.shapes.add( triangle );
+        ShapeInstance instance{ shape, {} };
+        instance.transform.translation = Vec2{ 10.0f, 0.0f };
+        store.get< ShapeInstance >().insert( 0, instance );
+        snap::SceneSnapshot first;
+        first.capture( store, 1 );
+
+        THEN( "the geometry refers to the shape instead of owning vertices" )
+        {
+            REQUIRE( first.size() == 1 );
+            REQUIRE( first.shapes[ 0 ] == shape );
+            REQUIRE( first.vertices_x.empty() );
+            REQUIRE( first.shape_count() == 1 );
+            REQUIRE( first.shape_vertices_x == std::vector< float >{ 0.0f, 1.0f, 0.0f } );
+
+            std::vector< float > xs;
+            first.for_each_vertex( 0, [ & ]( float x, float ) { xs.push_back( x ); } );
+            REQUIRE( xs == std::vector< float >{ 10.0f, 11.0f, 10.0f } );
+        }
+
+        WHEN( "the scene is rebuilt with a different shape under the same id" )
+        {
+            store.shapes.clear();
+            store.shapes.add( Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 2.0f, 0.0f }, Vec2{ 0.0f, 2.0f } } );
+            snap::SceneSnapshot second;
+            second.capture( store, 2, &first );
+
+            THEN( "the shape and its instance both count as new" )
+            {
+                REQUIRE( second.shape_ticks[ shape ] == 2 );
+                REQUIRE( second.spawn_ticks[ second.slot_of( 0 ) ] == 2 );
+            }
+        }
+
+        WHEN( "nothing changes" )
+        {
+            snap::SceneSnapshot second;
+            second.capture( store, 2, &first );
+
+            THEN( "the shape keeps its original tick" )
+            {
+                REQUIRE( second.shape_ticks[ shape ] == 1 );
+                REQUIRE( second.spawn_ticks[ second.slot_of( 0 ) ] == 1 );
+            }
+        }
+    }
+}
+
+SCENARIO( "Translated and rotated instances are placed by one composition", "[scene_snapshot][shapes]" )
+{
+    GIVEN( "a triangle instanced once translated only and once translated and turned a quarter" )
+    {
+        EntityStore store;
+        ShapeId shape = store.shapes.add( Polygon{ Vec2{ 0.0f, 0.0f }, Vec2{ 1.0f, 0.0f }, Vec2{ 0.0f, 1.0f } } );
+        ShapeInstance moved{ shape, {} };
+        moved.transform.translation = Vec2{ 10.0f, 0.0f };
+        ShapeInstance turned = moved;
+        turned.transform.rotationRadians = 1.5707964f;
+        auto place = [ & ]( std::size_t entity, ShapeInstance instance ) {
+            store.get< ShapeInstance >().insert( entity, instance );
+            store.get< Position >().insert( entity, Position{ 0.0f, 0.0f } );
+            store.get< Bounds >().insert( entity, Bounds( store.shapes[ shape ], instance, Position{ 0.0f, 0.0f } ) );
+        };
+        place( 0, moved );
+        place( 1, turned );
+        snap::SceneSnapshot snapshot;
+        snapshot.capture( store, 1 );
+
+        // Rotate, then translate: ( x, y ) -> ( 10 - y, x ) for the turned one, ( x + 10, y ) for the other
+        const std::vector< Vec2 > expected_moved{ { 10.0f, 0.0f }, { 11.0f, 0.0f }, { 10.0f, 1.0f } };
+        const std::vector< Vec2 > expected_turned{ { 10.0f, 0.0f }, { 10.0f, 1.0f }, { 9.0f, 0.0f } };
+        auto near = []( Vec2 a, Vec2 b ) { return std::abs( a.x - b.x ) < 1e-5f && std::abs( a.y - b.y ) < 1e-5f; };
+
+        THEN( "the snapshot's vertices put both where the transform says" )
+        {
+            for( std::size_t entity : { std::size_t{ 0 }, std::size_t{ 1 } } )
+            {
+                const auto & expected = entity == 0 ? expected_moved : expected_turned;
+                std::vector< Vec2 > vertices;
+                snapshot.for_each_vertex( snapshot.slot_of( entity ),
+                                          [ & ]( float x, float y ) { vertices.push_back( { x, y } ); } );
+                REQUIRE( vertices.size() == expected.size() );
+                for( std::size_t v = 0; v < expected.size(); ++v )
+                {
+                    REQUIRE( near( vertices[ v ], expected[ v ] ) );
+                }
+            }
+        }
+
+        THEN( "the collision geometry and the bounds agree with the snapshot" )
+        {
+            sys::InstanceScratch scratch;
+            for( std::size_t entity : { std::size_t{ 0 }, std::size_t{ 1 } } )
+            {
+                const auto & expected = entity == 0 ? expected_moved : expected_turned;
+                auto geometry = sys::collisionGeometry( store, entity, scratch );
+                REQUIRE( geometry.view.count == expected.size() );
+                for( std::size_t v = 0; v < expected.size(); ++v )
+                {
+                    Vec2 vertex{ geometry.view.vertices_x[ v ] + geometry.origin.x,
+                                 geometry.view.vertices_y[ v ] + geometry.origin.y };
+                    REQUIRE( near( vertex, expected[ v ] ) );
+                }
+            }
+            REQUIRE( near( store.get< Bounds >()[ 0 ].local.min, { 10.0f, 0.0f } ) );
+            REQUIRE( near( store.get< Bounds >()[ 0 ].local.max, { 11.0f, 1.0f } ) );
+            REQUIRE( near( store.get< Bounds >()[ 1 ].local.min, { 9.0f, 0.0f } ) );
+            REQUIRE( near( store.get< Bounds >()[ 1 ].local.max, { 10.0f, 1.0f } ) );
+        }
+    }
+}
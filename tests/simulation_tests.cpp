@@ -0,0 +1,187 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+
+#include "component_types.hpp"
+#include "headless.hpp"
+#include "input_queue.hpp"
+#include "input_recording.hpp"
+#include "simulation.hpp"
+
+namespace ct = robot::src::exports::component_types;
+namespace hl = robot::src::exports::headless;
+namespace iq = robot::src::exports::input_queue;
+namespace ir = robot::src::exports::input_recording;
+namespace sim = robot::src::exports::simulation;
+
+SCENARIO( "Simulations of the same world agree bit for bit", "[simulation]" )
+{
+    GIVEN( "two simulations of one key with different worker counts" )
+    {
+        sim::Simulation serial( 0 );
+        sim::Simulation parallel( 3 );
+        serial.build( "example_key", 40 );
+        parallel.build( "example_key", 40 );
+
+        THEN( "they start from the same hash" )
+        {
+            REQUIRE( sim::stateHash( serial.store() ) == sim::stateHash( parallel.store() ) );
+        }
+
+        WHEN( "both are stepped with the same input" )
+        {
+            for( int i = 0; i < 120; ++i )
+            {
+                for( auto * simulation : { &serial, &parallel } )
+                {
+                    if( i == 30 )
+                    {
+                        simulation->store().get< ct::PlayerInput >().insert( 0, ct::PlayerInput{ 1.0f, 0.5f } );
+                    }
+                    simulation->step();
+                }
+            }
+
+            THEN( "their states still hash the same, and differ from the start" )
+            {
+                REQUIRE( serial.tick() == 120 );
+                REQUIRE( sim::stateHash( serial.store() ) == sim::stateHash( parallel.store() ) );
+                sim::Simulation fresh( 0 );
+                fresh.build( "example_key", 40 );
+                REQUIRE( sim::stateHash( serial.store() ) != sim::stateHash( fresh.store() ) );
+            }
+        }
+    }
+}
+
+SCENARIO( "Headless runs replay their own recordings", "[simulation][headless]" )
+{
+    GIVEN( "a headless run with a scripted input" )
+    {
+        hl::HeadlessOptions options;
+        options.ticks = 200;
+        options.sim_threads = 2;
+        options.replay = ir::InputRecording{};
+        options.replay->events = { { 10, 0, ct::PlayerInput{ -1.0f, 0.25f } } };
+        auto first = hl::runHeadless( options );
+
+        THEN( "the run is recorded with its tick count and hash" )
+        {
+            REQUIRE( first.recording.end_tick == 200 );
+            REQUIRE( first.recording.events == options.replay->events );
+            REQUIRE_FALSE( first.matches_replay.has_value() );
+        }
+
+        WHEN( "the recording is replayed with another worker count" )
+        {
+            hl::HeadlessOptions again;
+            again.sim_threads = 0;
+            again.replay = first.recording;
+            auto second = hl::runHeadless( again );
+
+            THEN( "it runs to the recorded tick and reaches the recorded hash" )
+            {
+                REQUIRE( second.recording.end_tick == 200 );
+                REQUIRE( second.matches_replay == true );
+            }
+        }
+
+        WHEN( "the recorded hash is wrong" )
+        {
+            hl::HeadlessOptions tampered;
+            tampered.replay = first.recording;
+            *tampered.replay->end_hash ^= 1;
+
+            THEN( "the replay reports that it diverged" )
+            {
+                REQUIRE( hl::runHeadless( tampered ).matches_replay == false );
+            }
+        }
+    }
+}
+
+SCENARIO( "Headless runs of chunked worlds replay from their recordings", "[simulation][headless]" )
+{
+    GIVEN( "a recorded run of a world generated in chunks without overlaps" )
+    {
+        hl::HeadlessOptions options;
+        options.ticks = 120;
+        options.sim_threads = 2;
+        options.num_assets = 40;
+        options.worldgen = robot::src::WorldGenOptions{};
+        options.worldgen->chunks_per_axis = 4;
+        options.worldgen->reject_overlaps = true;
+        auto first = hl::runHeadless( options );
+
+        THEN( "the recording carries the generator options with the asset count" )
+        {
+            REQUIRE( first.recording.worldgen );
+            REQUIRE( first.recording.worldgen->obstacles == 40 );
+            REQUIRE( first.recording.worldgen->chunks_per_axis == 4 );
+            REQUIRE( first.recording.worldgen->reject_overlaps );
+        }
+
+        WHEN( "it is replayed without any generator options of its own" )
+        {
+            hl::HeadlessOptions again;
+            again.sim_threads = 0;
+            again.replay = first.recording;
+
+            THEN( "the same world is generated and reaches the recorded hash" )
+            {
+                REQUIRE( hl::runHeadless( again ).matches_replay == true );
+            }
+        }
+
+        WHEN( "its generator options are dropped" )
+        {
+            hl::HeadlessOptions built;
+            built.replay = first.recording;
+            built.replay->worldgen.reset();
+
+            THEN( "the built world diverges" )
+            {
+                REQUIRE( hl::runHeadless( built ).matches_replay == false );
+            }
+        }
+    }
+}
+
+SCENARIO( "Queued input is recorded on the tick that applies it", "[simulation][headless]" )
+{
+    GIVEN( "a recording simulation that receives input through its queue" )
+    {
+        sim::Simulation simulation( 1 );
+        simulation.build( "example_key" );
+        ir::InputRecorder recorder;
+        simulation.record_inputs( &recorder );
+        for( int i = 0; i < 50; ++i )
+        {
+            if( i == 20 )
+            {
+                simulation.inputs().try_push( iq::InputCommand{ 0, ct::PlayerInput{ 0.5f, -1.0f } } );
+            }
+            simulation.step();
+        }
+
+        THEN( "the input is attributed to the step that drained it" )
+        {
+            REQUIRE( recorder.events().size() == 1 );
+            REQUIRE( recorder.events()[ 0 ].tick == 21 );
+        }
+
+        WHEN( "the recording is replayed headless" )
+        {
+            hl::HeadlessOptions options;
+            options.sim_threads = 0;
+            options.replay = ir::InputRecording{ "example_key", 10, std::nullopt, std::nullopt, recorder.events(),
+                                                 simulation.tick(), sim::stateHash( simulation.store() ) };
+
+            THEN( "it reaches the same state" )
+            {
+                REQUIRE( hl::runHeadless( options ).matches_replay == true );
+            }
+        }
+    }
+}
@@ -1,6 +1,9 @@
 #include <algorithm>
 #include <catch2/catch_test_macros.hpp>
 #include <sparse_set.hpp>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace ss = robot::src::exports::sparse_set;
 
@@ -152,4 +155,175 @@ SCENARIO( "SparseSet manages entity-component associations", "[sparse_set]" )
             }
         }
     }
-}
\ No newline at end of file
+}
+SCENARIO( "SparseSet pages its sparse index lazily", "[sparse_set][paging]" )
+{
+    GIVEN( "an empty SparseSet with small pages" )
+    {
+        ss::SparseSet< 64 > set;
+
+        THEN( "no pages are allocated" )
+        {
+            REQUIRE( set.allocated_pages() == 0 );
+            REQUIRE_FALSE( set.contains( 1'000'000 ) );
+            REQUIRE( set.allocated_pages() == 0 );
+        }
+
+        WHEN( "entities far apart are inserted" )
+        {
+            set.insert( 3 );
+            set.insert( 5'000'000 );
+            set.insert( 5'000'001 );
+
+            THEN( "only the pages covering them are allocated" )
+            {
+                REQUIRE( set.allocated_pages() == 2 );
+                REQUIRE( set.contains( 5'000'000 ) );
+                REQUIRE( set.indexFor( 5'000'001 ) == 2 );
+                REQUIRE_FALSE( set.contains( 5'000'002 ) );
+            }
+
+            THEN( "looking up the index of an absent entity throws" )
+            {
+                REQUIRE_THROWS_AS( set.indexFor( 4 ), std::out_of_range );
+                REQUIRE_THROWS_AS( set.indexFor( 99'999'999 ), std::out_of_range );
+            }
+
+            AND_WHEN( "the set is cleared" )
+            {
+                set.clear();
+
+                THEN( "it is empty but keeps its pages for reuse" )
+                {
+                    REQUIRE( set.empty() );
+                    REQUIRE_FALSE( set.contains( 3 ) );
+                    REQUIRE_FALSE( set.contains( 5'000'000 ) );
+                    REQUIRE( set.allocated_pages() == 2 );
+                }
+
+                AND_WHEN( "entities are inserted again" )
+                {
+                    set.insert( 5'000'001 );
+
+                    THEN( "dense indices start from zero" )
+                    {
+                        REQUIRE( set.indexFor( 5'000'001 ) == 0 );
+                        REQUIRE( set.size() == 1 );
+                    }
+                }
+            }
+
+            AND_WHEN( "the set is copied and the copy modified" )
+            {
+                auto copy = set;
+                copy.erase( 3 );
+                copy.insert( 7 );
+
+                THEN( "the original is unaffected" )
+                {
+                    REQUIRE( set.contains( 3 ) );
+                    REQUIRE_FALSE( set.contains( 7 ) );
+                    REQUIRE( copy.contains( 7 ) );
+                    REQUIRE( copy.indexFor( 5'000'001 ) == 0 );
+                    REQUIRE( set.indexFor( 5'000'001 ) == 2 );
+                }
+            }
+
+            AND_WHEN( "an entity in the middle is erased" )
+            {
+                set.erase( 5'000'000 );
+
+                THEN( "the last entity takes its dense index" )
+                {
+                    REQUIRE( set.indexFor( 5'000'001 ) == 1 );
+                    REQUIRE( set.idFor( 1 ) == 5'000'001 );
+                }
+            }
+        }
+    }
+}
+
+SCENARIO( "SparseSet reorders entities and tracks revisions", "[sparse_set][revision]" )
+{
+    GIVEN( "a set with three entities" )
+    {
+        ss::SparseSet<> set;
+        set.insert( 10 );
+        set.insert( 20 );
+        set.insert( 30 );
+        auto revision = set.revision();
+
+        WHEN( "two dense indices are swapped" )
+        {
+            set.swapIndices( 0, 2 );
+
+            THEN( "the ids and their indices follow each other and the revision grows" )
+            {
+                REQUIRE( set.idFor( 0 ) == 30 );
+                REQUIRE( set.indexFor( 30 ) == 0 );
+                REQUIRE( set.indexFor( 10 ) == 2 );
+                REQUIRE( set.revision() > revision );
+            }
+        }
+
+        WHEN( "an older set is moved over it" )
+        {
+            ss::SparseSet<> older;
+            older.insert( 40 );
+            auto older_revision = older.revision();
+            set = std::move( older );
+
+            THEN( "it takes the other's contents and both revisions still grow" )
+            {
+                REQUIRE( set.contains( 40 ) );
+                REQUIRE_FALSE( set.contains( 10 ) );
+                REQUIRE( set.revision() > revision );
+                REQUIRE( older.revision() > older_revision );
+                REQUIRE( older.empty() );
+            }
+        }
+
+        WHEN( "only lookups and no-op updates are made" )
+        {
+            set.insert( 20 );
+            set.erase( 99 );
+
+            THEN( "the revision is unchanged" )
+            {
+                REQUIRE( set.contains( 20 ) );
+                REQUIRE( set.findIndex( 99 ) == ss::SparseSet<>::npos );
+                REQUIRE( set.revision() == revision );
+            }
+        }
+    }
+}
+
+SCENARIO( "SparseSet bulk insertion and removal", "[sparse_set][bulk]" )
+{
+    GIVEN( "a set filled from a range with a repeated id" )
+    {
+        ss::SparseSet<> set;
+        set.insert_range( std::vector< std::size_t >{ 4, 8, 4, 15 } );
+
+        THEN( "each id is present once, in first-seen order, and entities() views the dense array" )
+        {
+            auto entities = set.entities();
+            REQUIRE( entities.size() == 3 );
+            REQUIRE( entities.data() == set.dense().data() );
+            REQUIRE( std::vector< std::size_t >( entities.begin(), entities.end() )
+                     == std::vector< std::size_t >{ 4, 8, 15 } );
+        }
+
+        WHEN( "a range is erased" )
+        {
+            set.erase_range( std::vector< std::size_t >{ 15, 4, 99 } );
+
+            THEN( "only the other ids remain" )
+            {
+                REQUIRE( set.size() == 1 );
+                REQUIRE( set.contains( 8 ) );
+                REQUIRE( set.indexFor( 8 ) == 0 );
+            }
+        }
+    }
+}
@@ -0,0 +1,141 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <boost/beast/zlib.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "static_asset.hpp"
+
+namespace sa = robot::src::exports::static_asset;
+
+namespace
+{
+std::string inflateGzip( const std::string & gzip )
+{
+    namespace zlib = boost::beast::zlib;
+    zlib::inflate_stream inflate;
+    inflate.reset( 15 );
+    std::string out( 1 << 16, '\0' );
+    zlib::z_params params;
+    // Skip the fixed 10-byte header; the member ends with an 8-byte trailer
+    params.next_in = gzip.data() + 10;
+    params.avail_in = gzip.size() - 18;
+    params.next_out = out.data();
+    params.avail_out = out.size();
+    boost::beast::error_code ec;
+    inflate.write( params, zlib::Flush::finish, ec );
+    out.resize( params.total_out );
+    return out;
+}
+
+std::uint32_t readLe32( const std::string & bytes, std::size_t at )
+{
+    std::uint32_t value = 0;
+    for( int i = 3; i >= 0; --i )
+    {
+        value = ( value << 8 ) | static_cast< unsigned char >( bytes[ at + i ] );
+    }
+    return value;
+}
+} // namespace
+
+SCENARIO( "gzipCompress produces a gzip member that inflates back to its input", "[static_asset]" )
+{
+    GIVEN( "a repetitive page" )
+    {
+        std::string page;
+        for( int i = 0; i < 200; ++i )
+        {
+            page += "<div class=\"info\">Robot " + std::to_string( i ) + "</div>\n";
+        }
+
+        WHEN( "it is compressed" )
+        {
+            auto gzip = sa::gzipCompress( page );
+
+            THEN( "it is smaller, framed as gzip, and inflates to the original" )
+            {
+                REQUIRE( gzip.size() < page.size() / 2 );
+                REQUIRE( static_cast< unsigned char >( gzip[ 0 ] ) == 0x1f );
+                REQUIRE( static_cast< unsigned char >( gzip[ 1 ] ) == 0x8b );
+                REQUIRE( inflateGzip( gzip ) == page );
+                REQUIRE( readLe32( gzip, gzip.size() - 8 ) == sa::crc32( page ) );
+                REQUIRE( readLe32( gzip, gzip.size() - 4 ) == page.size() );
+            }
+        }
+    }
+
+    GIVEN( "the check string of CRC-32" )
+    {
+        THEN( "crc32 gives the published check value" )
+        {
+            REQUIRE( sa::crc32( "123456789" ) == 0xcbf43926u );
+            REQUIRE( sa::crc32( "" ) == 0u );
+        }
+    }
+}
+
+SCENARIO( "StaticAsset tags content and conditional headers match the tag", "[static_asset]" )
+{
+    GIVEN( "two assets with different content" )
+    {
+        auto first = sa::StaticAsset::build( "text/html", "<p>one</p>" );
+        auto second = sa::StaticAsset::build( "text/html", "<p>two</p>" );
+
+        THEN( "each has a quoted, stable tag of its own" )
+        {
+            REQUIRE( first.etag.front() == '"' );
+            REQUIRE( first.etag.back() == '"' );
+            REQUIRE( first.etag == sa::StaticAsset::build( "text/html", "<p>one</p>" ).etag );
+            REQUIRE( first.etag != second.etag );
+            REQUIRE( inflateGzip( first.gzip ) == first.identity );
+        }
+
+        THEN( "the gzip encoding has a strong tag of its own that the identity tag does not match" )
+        {
+            REQUIRE( first.has_gzip() );
+            REQUIRE( first.gzip_etag == first.etag.substr( 0, first.etag.size() - 1 ) + "-gz\"" );
+            REQUIRE( sa::etagMatches( first.gzip_etag, first.gzip_etag ) );
+            REQUIRE_FALSE( sa::etagMatches( first.etag, first.gzip_etag ) );
+            REQUIRE_FALSE( sa::etagMatches( first.gzip_etag, first.etag ) );
+        }
+
+        THEN( "If-None-Match matches the tag alone, in a list, weakly or with *" )
+        {
+            REQUIRE( sa::etagMatches( first.etag, first.etag ) );
+            REQUIRE( sa::etagMatches( second.etag + ", " + first.etag, first.etag ) );
+            REQUIRE( sa::etagMatches( "W/" + first.etag, first.etag ) );
+            REQUIRE( sa::etagMatches( "*", first.etag ) );
+            REQUIRE_FALSE( sa::etagMatches( second.etag, first.etag ) );
+            REQUIRE_FALSE( sa::etagMatches( "", first.etag ) );
+        }
+    }
+
+    GIVEN( "Accept-Encoding values" )
+    {
+        THEN( "gzip is used only when offered with a non-zero weight" )
+        {
+            REQUIRE( sa::acceptsGzip( "gzip, deflate, br" ) );
+            REQUIRE( sa::acceptsGzip( "br;q=1.0, gzip;q=0.8" ) );
+            REQUIRE( sa::acceptsGzip( "*" ) );
+            REQUIRE_FALSE( sa::acceptsGzip( "" ) );
+            REQUIRE_FALSE( sa::acceptsGzip( "deflate, br" ) );
+            REQUIRE_FALSE( sa::acceptsGzip( "gzip;q=0" ) );
+        }
+
+        THEN( "names are case-insensitive, weights are trimmed and gzip outranks *" )
+        {
+            REQUIRE( sa::acceptsGzip( "GZIP" ) );
+            REQUIRE( sa::acceptsGzip( "x-gzip;q=0.5" ) );
+            REQUIRE( sa::acceptsGzip( "*;q=0, gzip" ) );
+            REQUIRE( sa::acceptsGzip( "gzip ; q = 0.5 " ) );
+            REQUIRE( sa::acceptsGzip( "br, *;q=0.1" ) );
+            REQUIRE_FALSE( sa::acceptsGzip( "gzip;q=0 " ) );
+            REQUIRE_FALSE( sa::acceptsGzip( "gzip;q=0.000, *" ) );
+            REQUIRE_FALSE( sa::acceptsGzip( "*;q=0" ) );
+            REQUIRE_FALSE( sa::acceptsGzip( "gzip;q=x" ) );
+        }
+    }
+}
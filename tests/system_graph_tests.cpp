@@ -0,0 +1,112 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "job_system.hpp"
+#include "system_graph.hpp"
+
+namespace js = robot::src::exports::job_system;
+namespace sg = robot::src::exports::system_graph;
+
+namespace
+{
+struct A
+{};
+struct B
+{};
+struct C
+{};
+
+struct Log
+{
+    std::mutex mutex;
+    std::vector< std::string > entries;
+
+    void add( std::string entry )
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        entries.push_back( std::move( entry ) );
+    }
+
+    std::size_t position( const std::string & entry ) const
+    {
+        for( std::size_t i = 0; i < entries.size(); ++i )
+        {
+            if( entries[ i ] == entry )
+            {
+                return i;
+            }
+        }
+        return entries.size();
+    }
+};
+} // namespace
+
+SCENARIO( "SystemGraph orders systems by their component accesses", "[system_graph]" )
+{
+    GIVEN( "systems with overlapping and disjoint accesses" )
+    {
+        sg::SystemGraph< Log > graph;
+        auto logger = []( std::string name ) {
+            return [ name ]( Log & log, js::JobSystem & ) { log.add( name ); };
+        };
+        auto write_a = graph.add( "write_a", sg::Reads<>{}, sg::Writes< A >{}, logger( "write_a" ) );
+        auto read_a = graph.add( "read_a", sg::Reads< A >{}, sg::Writes< B >{}, logger( "read_a" ) );
+        auto read_a_too = graph.add( "read_a_too", sg::Reads< A >{}, sg::Writes< C >{}, logger( "read_a_too" ) );
+        auto read_b = graph.add( "read_b", sg::Reads< B, C >{}, sg::Writes<>{}, logger( "read_b" ) );
+
+        THEN( "writers and readers of the same type depend on each other, readers of disjoint writes do not" )
+        {
+            REQUIRE( graph.size() == 4 );
+            REQUIRE( graph.name( read_b ) == "read_b" );
+            REQUIRE( graph.depends_on( read_a, write_a ) );
+            REQUIRE( graph.depends_on( read_a_too, write_a ) );
+            REQUIRE_FALSE( graph.depends_on( read_a_too, read_a ) );
+            REQUIRE( graph.depends_on( read_b, read_a ) );
+            REQUIRE( graph.depends_on( read_b, read_a_too ) );
+            REQUIRE_FALSE( graph.depends_on( read_b, write_a ) );
+        }
+
+        WHEN( "the graph runs on a pool, repeatedly" )
+        {
+            js::JobSystem jobs( 3 );
+            for( int run = 0; run < 50; ++run )
+            {
+                Log log;
+                graph.run( log, jobs );
+
+                REQUIRE( log.entries.size() == 4 );
+                REQUIRE( log.position( "write_a" ) < log.position( "read_a" ) );
+                REQUIRE( log.position( "write_a" ) < log.position( "read_a_too" ) );
+                REQUIRE( log.position( "read_a" ) < log.position( "read_b" ) );
+                REQUIRE( log.position( "read_a_too" ) < log.position( "read_b" ) );
+            }
+        }
+    }
+
+    GIVEN( "a system that throws" )
+    {
+        sg::SystemGraph< Log > graph;
+        graph.add( "fails", sg::Reads<>{}, sg::Writes< A >{},
+                   []( Log &, js::JobSystem & ) { throw std::runtime_error( "system failed" ); } );
+        graph.add( "after", sg::Reads< A >{}, sg::Writes<>{},
+                   []( Log & log, js::JobSystem & ) { log.add( "after" ); } );
+        graph.add( "independent", sg::Reads<>{}, sg::Writes< B >{},
+                   []( Log & log, js::JobSystem & ) { log.add( "independent" ); } );
+
+        THEN( "run rethrows, skipping its dependents but not unrelated systems" )
+        {
+            js::JobSystem jobs( 2 );
+            Log log;
+            REQUIRE_THROWS_AS( graph.run( log, jobs ), std::runtime_error );
+            REQUIRE( log.entries == std::vector< std::string >{ "independent" } );
+        }
+    }
+}
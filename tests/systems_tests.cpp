@@ -0,0 +1,378 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "component_types.hpp"
+#include "systems.hpp"
+
+namespace sys = robot::src::exports::systems;
+using namespace robot::src::exports::component_types;
+using robot::src::Vec2;
+
+namespace
+{
+Polygon square( float half )
+{
+    return Polygon( { Vec2{ -half, -half }, Vec2{ half, -half }, Vec2{ half, half }, Vec2{ -half, half } } );
+}
+
+void addBody( EntityStore & store, std::size_t entity, Polygon polygon, Position position )
+{
+    store.get< Bounds >().insert( entity, Bounds( polygon, position ) );
+    store.get< Polygon >().insert( entity, std::move( polygon ) );
+    store.get< Position >().insert( entity, position );
+}
+
+void addRobot( EntityStore & store, Position position )
+{
+    addBody( store, 0, square( 10.0f ), position );
+    store.get< Velocity >().insert( 0, Velocity{ 1.0f, 0.0f } );
+    store.get< HitCounter >().insert( 0, HitCounter{ 0 } );
+}
+} // namespace
+
+SCENARIO( "handleCollisions detects hits in world space", "[systems][collisions]" )
+{
+    GIVEN( "a robot and an obstacle far apart in the world" )
+    {
+        EntityStore store;
+        addRobot( store, Position{ 0.0f, 0.0f } );
+        addBody( store, 1, square( 5.0f ), Position{ 60.0f, 60.0f } );
+
+        WHEN( "collisions are handled" )
+        {
+            sys::handleCollisions( store );
+
+            THEN( "no hit is recorded even though the local geometry overlaps" )
+            {
+                REQUIRE( store.get< HitCounter >()[ 0 ].hits == 0 );
+                REQUIRE( store.get< Velocity >()[ 0 ].x == 1.0f );
+            }
+        }
+    }
+
+    GIVEN( "a robot overlapping an obstacle" )
+    {
+        EntityStore store;
+        addRobot( store, Position{ 0.0f, 0.0f } );
+        addBody( store, 1, square( 5.0f ), Position{ 12.0f, 0.0f } );
+
+        WHEN( "collisions are handled" )
+        {
+            sys::handleCollisions( store );
+
+            THEN( "the robot records a hit and stops" )
+            {
+                REQUIRE( store.get< HitCounter >()[ 0 ].hits == 1 );
+                REQUIRE( store.get< Velocity >()[ 0 ].x == 0.0f );
+            }
+        }
+    }
+
+    GIVEN( "a robot at the right world edge and an obstacle at the left edge" )
+    {
+        EntityStore store;
+        addRobot( store, Position{ sys::WORLD_MAX_X - 5.0f, 0.0f } );
+        addBody( store, 1, square( 5.0f ), Position{ sys::WORLD_MIN_X + 5.0f, 0.0f } );
+
+        WHEN( "collisions are handled" )
+        {
+            sys::handleCollisions( store );
+
+            THEN( "the hit is detected across the wrapped edge" )
+            {
+                REQUIRE( store.get< HitCounter >()[ 0 ].hits == 1 );
+            }
+        }
+    }
+
+    GIVEN( "a robot overlapping a polygon that has no Position" )
+    {
+        EntityStore store;
+        addRobot( store, Position{ 0.0f, 0.0f } );
+        store.get< Polygon >().insert( 1, square( 5.0f ) );
+
+        WHEN( "collisions are handled" )
+        {
+            sys::handleCollisions( store );
+
+            THEN( "the decorative polygon is ignored" )
+            {
+                REQUIRE( store.get< HitCounter >()[ 0 ].hits == 0 );
+            }
+        }
+    }
+}
+
+SCENARIO( "handleCollisions catches fast bodies before they tunnel", "[systems][collisions][swept]" )
+{
+    auto makeStore = []( float robot_speed, float wall_speed ) {
+        EntityStore store;
+        addRobot( store, Position{ 0.0f, 0.0f } );
+        store.get< Velocity >()[ 0 ] = Velocity{ robot_speed, 0.0f };
+        Polygon wall( { Vec2{ -0.5f, -30.0f }, Vec2{ 0.5f, -30.0f }, Vec2{ 0.5f, 30.0f }, Vec2{ -0.5f, 30.0f } } );
+        addBody( store, 1, std::move( wall ), Position{ 30.0f, 0.0f } );
+        store.get< Velocity >().insert( 1, Velocity{ wall_speed, 0.0f } );
+        return store;
+    };
+
+    GIVEN( "a robot moving 50 units a tick towards a wall one unit thick, 19.5 units ahead" )
+    {
+        auto store = makeStore( 50.0f, 0.0f );
+
+        WHEN( "collisions are handled and positions updated" )
+        {
+            sys::handleCollisions( store );
+            auto hits = store.get< HitCounter >()[ 0 ].hits;
+            auto speed = store.get< Velocity >()[ 0 ].x;
+            sys::updatePositions( store );
+
+            THEN( "the robot records a hit and stops against the wall instead of jumping past it" )
+            {
+                REQUIRE( hits == 1 );
+                REQUIRE( speed > 19.0f );
+                REQUIRE( speed < 20.0f );
+                REQUIRE( store.get< Position >()[ 0 ].x + 10.0f <= 29.5f + 1e-4f );
+            }
+
+            THEN( "the next tick finds the contact and keeps it stopped" )
+            {
+                store.get< Velocity >()[ 0 ] = Velocity{ 50.0f, 0.0f };
+                sys::handleCollisions( store );
+                REQUIRE( store.get< HitCounter >()[ 0 ].hits == 2 );
+                REQUIRE( store.get< Velocity >()[ 0 ].x == 0.0f );
+            }
+        }
+    }
+
+    GIVEN( "a robot too slow to reach the wall this tick" )
+    {
+        auto store = makeStore( 10.0f, 0.0f );
+        sys::handleCollisions( store );
+
+        THEN( "nothing is hit and the robot keeps its speed" )
+        {
+            REQUIRE( store.get< HitCounter >()[ 0 ].hits == 0 );
+            REQUIRE( store.get< Velocity >()[ 0 ].x == 10.0f );
+        }
+    }
+
+    GIVEN( "a resting robot and a wall rushing at it" )
+    {
+        auto store = makeStore( 0.0f, -60.0f );
+        sys::handleCollisions( store );
+
+        THEN( "the robot records the hit and the wall keeps moving" )
+        {
+            REQUIRE( store.get< HitCounter >()[ 0 ].hits == 1 );
+            REQUIRE( store.get< Velocity >()[ 0 ].x == 0.0f );
+            REQUIRE( store.get< Velocity >()[ 1 ].x == -60.0f );
+        }
+    }
+
+    GIVEN( "a second, nearer wall in the robot's way" )
+    {
+        auto store = makeStore( 50.0f, 0.0f );
+        Polygon near_wall( { Vec2{ -0.5f, -30.0f }, Vec2{ 0.5f, -30.0f }, Vec2{ 0.5f, 30.0f }, Vec2{ -0.5f, 30.0f } } );
+        addBody( store, 2, std::move( near_wall ), Position{ 20.0f, 0.0f } );
+        auto parallel = makeStore( 50.0f, 0.0f );
+        addBody( parallel, 2, Polygon( store.get< Polygon >()[ 2 ] ), Position{ 20.0f, 0.0f } );
+
+        WHEN( "collisions are handled serially and on a job system" )
+        {
+            sys::handleCollisions( store );
+            robot::src::JobSystem jobs( 2 );
+            sys::CollisionWorkspace workspace;
+            sys::handleCollisions( parallel, workspace, jobs );
+            auto speed = store.get< Velocity >()[ 0 ].x;
+            sys::updatePositions( store );
+
+            THEN( "only the nearer wall counts and the robot stops against it, short of the far wall" )
+            {
+                REQUIRE( store.get< HitCounter >()[ 0 ].hits == 1 );
+                REQUIRE( speed < 10.0f );
+                REQUIRE( store.get< Position >()[ 0 ].x + 10.0f <= 19.5f + 1e-4f );
+                REQUIRE( store.get< Position >()[ 0 ].x + 10.0f < 29.5f );
+                REQUIRE( parallel.get< HitCounter >()[ 0 ].hits == 1 );
+                REQUIRE( parallel.get< Velocity >()[ 0 ].x == speed );
+            }
+        }
+    }
+}
+
+SCENARIO( "handleCollisions tests instances of shared shapes", "[systems][collisions][shapes]" )
+{
+    GIVEN( "a robot and a long thin shared bar placed beside it" )
+    {
+        EntityStore store;
+        addRobot( store, Position{ 0.0f, 0.0f } );
+        ShapeId bar = store.shapes.add(
+            Polygon( { Vec2{ -20.0f, -1.0f }, Vec2{ 20.0f, -1.0f }, Vec2{ 20.0f, 1.0f }, Vec2{ -20.0f, 1.0f } } ) );
+        auto place = [ & ]( std::size_t entity, ShapeInstance instance, Position position ) {
+            store.get< Bounds >().insert( entity, Bounds( store.shapes[ bar ], instance, position ) );
+            store.get< ShapeInstance >().insert( entity, instance );
+            store.get< Position >().insert( entity, position );
+        };
+
+        WHEN( "the bar lies horizontally above the robot" )
+        {
+            place( 1, ShapeInstance{ bar, {} }, Position{ 0.0f, 15.0f } );
+            sys::handleCollisions( store );
+
+            THEN( "no hit is registered" )
+            {
+                REQUIRE( store.get< HitCounter >()[ 0 ].hits == 0 );
+            }
+        }
+
+        WHEN( "the same bar is rotated upright so it reaches down into the robot" )
+        {
+            ShapeInstance upright{ bar, {} };
+            upright.transform.rotationRadians = 1.5707964f;
+            place( 1, upright, Position{ 0.0f, 15.0f } );
+            sys::handleCollisions( store );
+
+            THEN( "its bounds follow the rotation and the hit is registered" )
+            {
+                REQUIRE( store.get< Bounds >()[ 1 ].local.min.y < -19.0f );
+                REQUIRE( store.get< HitCounter >()[ 0 ].hits == 1 );
+            }
+        }
+
+        WHEN( "the bar is translated down by its instance transform" )
+        {
+            ShapeInstance lowered{ bar, {} };
+            lowered.transform.translation = Vec2{ 0.0f, -10.0f };
+            place( 1, lowered, Position{ 0.0f, 15.0f } );
+            sys::handleCollisions( store );
+
+            THEN( "the hit is registered" )
+            {
+                REQUIRE( store.get< HitCounter >()[ 0 ].hits == 1 );
+            }
+        }
+    }
+}
+
+SCENARIO( "updatePositions keeps cached bounds in sync", "[systems][positions][bounds]" )
+{
+    GIVEN( "a moving robot and a static obstacle" )
+    {
+        EntityStore store;
+        addRobot( store, Position{ 0.0f, 0.0f } );
+        addBody( store, 1, square( 5.0f ), Position{ 50.0f, 50.0f } );
+        store.get< Velocity >().insert( 1, Velocity{ 0.0f, 0.0f } );
+
+        WHEN( "positions are updated" )
+        {
+            sys::updatePositions( store );
+
+            THEN( "the robot's world bounds follow its new position" )
+            {
+                auto & bounds = store.get< Bounds >()[ 0 ];
+                REQUIRE( store.get< Position >()[ 0 ].x == 1.0f );
+                REQUIRE( bounds.world.min.x == -9.0f );
+                REQUIRE( bounds.world.max.x == 11.0f );
+                REQUIRE( bounds.local.min.x == -10.0f );
+            }
+
+            THEN( "the obstacle's bounds are unchanged" )
+            {
+                auto & bounds = store.get< Bounds >()[ 1 ];
+                REQUIRE( bounds.world.min.x == 45.0f );
+                REQUIRE( bounds.world.max.y == 55.0f );
+            }
+        }
+
+        WHEN( "the robot moves across the world edge" )
+        {
+            store.get< Position >()[ 0 ] = Position{ sys::WORLD_MAX_X - 0.5f, 0.0f };
+            sys::updatePositions( store );
+
+            THEN( "its bounds are rebuilt around the wrapped position" )
+            {
+                auto & bounds = store.get< Bounds >()[ 0 ];
+                REQUIRE( store.get< Position >()[ 0 ].x == sys::WORLD_MIN_X + 0.5f );
+                REQUIRE( bounds.world.min.x == sys::WORLD_MIN_X - 9.5f );
+            }
+        }
+    }
+}
+
+SCENARIO( "wrapCoordinate folds values into the world from any distance", "[systems][positions]" )
+{
+    THEN( "values inside are unchanged and values outside move by whole periods" )
+    {
+        REQUIRE( sys::wrapCoordinate( 10.0f, -120.0f, 120.0f ) == 10.0f );
+        REQUIRE( sys::wrapCoordinate( 130.0f, -120.0f, 120.0f ) == -110.0f );
+        REQUIRE( sys::wrapCoordinate( -130.0f, -120.0f, 120.0f ) == 110.0f );
+        REQUIRE( sys::wrapCoordinate( 120.0f, -120.0f, 120.0f ) == -120.0f );
+        REQUIRE( sys::wrapCoordinate( 10.0f + 240.0f * 5, -120.0f, 120.0f ) == 10.0f );
+        REQUIRE( sys::wrapCoordinate( 5.0f, 1.0f, 1.0f ) == 5.0f );
+    }
+}
+
+SCENARIO( "updatePositions keeps its layout in step with the storages", "[systems][positions]" )
+{
+    GIVEN( "a layout aligned for a robot and a velocity without a position" )
+    {
+        EntityStore store;
+        store.get< Velocity >().insert( 7, Velocity{ 5.0f, 5.0f } );
+        addRobot( store, Position{ 0.0f, 0.0f } );
+        sys::MotionLayout layout;
+        sys::updatePositions( store, layout );
+        REQUIRE( layout.size == 1 );
+
+        WHEN( "another moving body is added and the layout is reused" )
+        {
+            addBody( store, 3, square( 1.0f ), Position{ 10.0f, 10.0f } );
+            store.get< Velocity >().insert( 3, Velocity{ 0.0f, -2.0f } );
+            sys::updatePositions( store, layout );
+
+            THEN( "both bodies move and the entity without a position is left alone" )
+            {
+                REQUIRE( layout.size == 2 );
+                REQUIRE( store.get< Position >()[ 0 ].x == 2.0f );
+                REQUIRE( store.get< Position >()[ 3 ].y == 8.0f );
+                REQUIRE( store.get< Bounds >()[ 3 ].world.min.y == 7.0f );
+                REQUIRE_FALSE( store.get< Position >().contains( 7 ) );
+            }
+        }
+    }
+}
+
+SCENARIO( "handleCollisions on a job system matches the serial narrow phase", "[systems][collisions][jobs]" )
+{
+    GIVEN( "a robot overlapping several of many obstacles" )
+    {
+        auto makeStore = [] {
+            EntityStore store;
+            addRobot( store, Position{ 0.0f, 0.0f } );
+            for( std::size_t i = 1; i <= 200; ++i )
+            {
+                float x = float( i % 20 ) * 12.0f - 114.0f;
+                float y = float( i / 20 ) * 12.0f - 60.0f;
+                addBody( store, i, square( 5.0f ), Position{ x, y } );
+            }
+            return store;
+        };
+        auto serial = makeStore();
+        auto parallel = makeStore();
+
+        WHEN( "both stores are processed" )
+        {
+            sys::handleCollisions( serial );
+            robot::src::JobSystem jobs( 3 );
+            sys::CollisionWorkspace workspace;
+            sys::handleCollisions( parallel, workspace, jobs );
+
+            THEN( "the robot records the same hits and stops" )
+            {
+                REQUIRE( serial.get< HitCounter >()[ 0 ].hits > 0 );
+                REQUIRE( parallel.get< HitCounter >()[ 0 ].hits == serial.get< HitCounter >()[ 0 ].hits );
+                REQUIRE( parallel.get< Velocity >()[ 0 ].x == 0.0f );
+                REQUIRE( workspace.impacts.size() == workspace.pairs.size() );
+            }
+        }
+    }
+}
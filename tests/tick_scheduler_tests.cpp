@@ -0,0 +1,97 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+
+#include "tick_scheduler.hpp"
+
+namespace ts = robot::src::exports::tick_scheduler;
+using namespace std::chrono_literals;
+
+SCENARIO( "TickScheduler converts elapsed time into fixed steps", "[tick_scheduler]" )
+{
+    GIVEN( "a scheduler with a 10 ms period and at most 3 catch-up steps" )
+    {
+        ts::TickScheduler scheduler( 10ms, 3 );
+
+        WHEN( "less than one period has elapsed" )
+        {
+            auto steps = scheduler.advance( 4ms );
+
+            THEN( "no step is due yet" )
+            {
+                REQUIRE( steps == 0 );
+            }
+
+            AND_WHEN( "the remainder of the period elapses" )
+            {
+                auto more = scheduler.advance( 6ms );
+
+                THEN( "the leftover time is carried over into one step" )
+                {
+                    REQUIRE( more == 1 );
+                }
+            }
+        }
+
+        WHEN( "two and a half periods have elapsed" )
+        {
+            auto steps = scheduler.advance( 25ms );
+
+            THEN( "two steps are due and half a period is retained" )
+            {
+                REQUIRE( steps == 2 );
+                REQUIRE( scheduler.advance( 5ms ) == 1 );
+            }
+        }
+
+        WHEN( "the host stalls for a full second" )
+        {
+            auto steps = scheduler.advance( 1s );
+
+            THEN( "the catch-up limit caps the burst and the excess is dropped" )
+            {
+                REQUIRE( steps == 3 );
+                REQUIRE( scheduler.stats().dropped_steps.load() == 97 );
+                REQUIRE( scheduler.advance( 0ms ) == 0 );
+            }
+        }
+
+        WHEN( "tick durations are recorded" )
+        {
+            scheduler.record_tick( 2ms );
+            scheduler.record_tick( 7ms );
+            scheduler.record_tick( 3ms );
+
+            THEN( "the counters track the count, last, max and total durations" )
+            {
+                auto const & stats = scheduler.stats();
+                REQUIRE( stats.ticks.load() == 3 );
+                REQUIRE( stats.last_tick_ns.load() == 3'000'000 );
+                REQUIRE( stats.max_tick_ns.load() == 7'000'000 );
+                REQUIRE( stats.total_tick_ns.load() == 12'000'000 );
+            }
+        }
+    }
+
+    GIVEN( "a running scheduler with a 1 ms period" )
+    {
+        ts::TickScheduler scheduler( 1ms );
+        std::stop_source stop;
+        int steps = 0;
+
+        WHEN( "it runs until the step function requests a stop" )
+        {
+            scheduler.run( stop.get_token(), [ & ] {
+                if( ++steps == 5 )
+                    stop.request_stop();
+            } );
+
+            THEN( "every step was counted" )
+            {
+                REQUIRE( steps >= 5 );
+                REQUIRE( scheduler.stats().ticks.load() == static_cast< std::uint64_t >( steps ) );
+            }
+        }
+    }
+}
@@ -0,0 +1,327 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "component_types.hpp"
+#include "headless.hpp"
+#include "input_recording.hpp"
+#include "simulation.hpp"
+#include "world_file.hpp"
+
+namespace ct = robot::src::exports::component_types;
+namespace hl = robot::src::exports::headless;
+namespace ir = robot::src::exports::input_recording;
+namespace sim = robot::src::exports::simulation;
+namespace wf = robot::src::exports::world_file;
+
+namespace
+{
+/// @brief A file path in the temporary directory, removed with its temporaries at scope exit.
+struct TemporaryPath
+{
+    std::string path;
+
+    explicit TemporaryPath( const std::string & name )
+        : path( ( std::filesystem::temp_directory_path()
+                  / ( "robot_" + std::to_string( ::getpid() ) + "_" + name ) )
+                    .string() )
+    {}
+
+    ~TemporaryPath()
+    {
+        std::filesystem::remove( path );
+        std::filesystem::remove( path + ".tmp" );
+    }
+};
+
+std::span< const std::byte > bytes( const std::string & image )
+{
+    return std::as_bytes( std::span( image ) );
+}
+} // namespace
+
+SCENARIO( "A saved world restores to the same state and steps on identically", "[world_file]" )
+{
+    GIVEN( "a world that has been stepped, steered and had an entity destroyed" )
+    {
+        sim::Simulation original( 0 );
+        original.build( "example_key", 40 );
+        for( int i = 0; i < 90; ++i )
+        {
+            if( i == 20 )
+            {
+                original.store().get< ct::PlayerInput >().insert( 0, ct::PlayerInput{ 1.0f, -0.5f } );
+            }
+            original.step();
+        }
+        original.store().destroy( original.store().registry.handle( 5 ) );
+        TemporaryPath file( "world.bin" );
+        wf::saveWorld( file.path, original.store(), original.world_info() );
+
+        WHEN( "it is restored into another simulation" )
+        {
+            sim::Simulation restored( 2 );
+            restored.build( "other_key", 3 );
+            restored.restore( file.path );
+
+            THEN( "the key, tick, state and geometry are those saved" )
+            {
+                REQUIRE( restored.key() == "example_key" );
+                REQUIRE( restored.num_assets() == 40 );
+                REQUIRE( restored.tick() == 90 );
+                REQUIRE( sim::stateHash( restored.store() ) == sim::stateHash( original.store() ) );
+                REQUIRE( restored.store().registry.size() == original.store().registry.size() );
+                REQUIRE( restored.store().shapes.size() == original.store().shapes.size() );
+
+                const auto & polygons = original.store().get< ct::Polygon >();
+                const auto & loaded = restored.store().get< ct::Polygon >();
+                REQUIRE( loaded.dense_entities() == polygons.dense_entities() );
+                for( std::size_t i = 0; i < polygons.size(); ++i )
+                {
+                    const auto & a = polygons.dense_data()[ i ];
+                    const auto & b = loaded.dense_data()[ i ];
+                    REQUIRE( b.vertices_x == a.vertices_x );
+                    REQUIRE( b.vertices_y == a.vertices_y );
+                    REQUIRE( b.normals_x == a.normals_x );
+                    REQUIRE( b.normals_y == a.normals_y );
+                }
+            }
+
+            THEN( "the registry reissues the destroyed id with its next generation" )
+            {
+                auto reused = restored.store().create();
+                REQUIRE( reused == original.store().create() );
+                REQUIRE( reused.index == 5 );
+                REQUIRE( reused.generation == 1 );
+            }
+
+            THEN( "both simulations reach the same state" )
+            {
+                for( int i = 0; i < 120; ++i )
+                {
+                    original.step();
+                    restored.step();
+                }
+                REQUIRE( restored.tick() == original.tick() );
+                REQUIRE( sim::stateHash( restored.store() ) == sim::stateHash( original.store() ) );
+            }
+        }
+    }
+}
+
+SCENARIO( "Invalid world images are rejected and leave the store empty", "[world_file]" )
+{
+    GIVEN( "the image of a built world" )
+    {
+        sim::Simulation simulation( 0 );
+        simulation.build( "example_key" );
+        std::string image;
+        wf::writeWorldImage( simulation.store(), simulation.world_info(), image );
+        ct::EntityStore store;
+        ct::VertexArena arena;
+
+        THEN( "it reads back as it was written" )
+        {
+            auto info = wf::readWorldImage( bytes( image ), store, arena );
+            REQUIRE( info.key == "example_key" );
+            REQUIRE( info.num_assets == 10 );
+            REQUIRE( info.tick == 0 );
+            REQUIRE( sim::stateHash( store ) == sim::stateHash( simulation.store() ) );
+        }
+
+        WHEN( "it is truncated" )
+        {
+            image.resize( image.size() - 8 );
+
+            THEN( "reading it throws" )
+            {
+                REQUIRE_THROWS_AS( wf::readWorldImage( bytes( image ), store, arena ), std::runtime_error );
+                REQUIRE( store.registry.empty() );
+                REQUIRE( store.get< ct::Polygon >().empty() );
+            }
+        }
+
+        WHEN( "its magic or version is wrong" )
+        {
+            auto bad_magic = image;
+            bad_magic[ 0 ] = 'X';
+            auto bad_version = image;
+            ++bad_version[ 8 ];
+
+            THEN( "reading it throws" )
+            {
+                REQUIRE_THROWS_AS( wf::readWorldImage( bytes( bad_magic ), store, arena ), std::runtime_error );
+                REQUIRE_THROWS_AS( wf::readWorldImage( bytes( bad_version ), store, arena ), std::runtime_error );
+                REQUIRE_THROWS_AS( wf::readWorldImage( {}, store, arena ), std::runtime_error );
+            }
+        }
+
+        WHEN( "it is read into a store that already holds a world" )
+        {
+            ct::EntityStore busy;
+            wf::readWorldImage( bytes( image ), busy, arena );
+            auto shapes = busy.shapes.size();
+            wf::readWorldImage( bytes( image ), busy, arena );
+
+            THEN( "the old world is replaced, not added to" )
+            {
+                REQUIRE( busy.shapes.size() == shapes );
+                REQUIRE( busy.registry.size() == simulation.store().registry.size() );
+            }
+        }
+    }
+
+    GIVEN( "a path that does not exist" )
+    {
+        ct::EntityStore store;
+        ct::VertexArena arena;
+
+        THEN( "loading it throws a system error" )
+        {
+            REQUIRE_THROWS_AS( wf::loadWorld( "/nonexistent/world.bin", store, arena ), std::system_error );
+        }
+    }
+}
+
+SCENARIO( "The checkpointer saves due ticks in the background", "[world_file]" )
+{
+    GIVEN( "a checkpointer saving every 30 ticks" )
+    {
+        TemporaryPath file( "checkpoint.bin" );
+        sim::Simulation simulation( 0 );
+        simulation.build( "example_key" );
+        wf::Checkpointer checkpointer( file.path, 30 );
+
+        WHEN( "the simulation runs for 100 ticks" )
+        {
+            std::uint64_t handed = 0;
+            for( int i = 0; i < 100; ++i )
+            {
+                simulation.step();
+                handed += checkpointer.maybe_checkpoint( simulation.store(), simulation.world_info() );
+            }
+            checkpointer.flush();
+
+            THEN( "ticks 30, 60 and 90 were checkpointed or skipped, and the last one written loads" )
+            {
+                REQUIRE( handed + checkpointer.skipped() == 3 );
+                REQUIRE( checkpointer.written() == handed );
+                REQUIRE( checkpointer.failed() == 0 );
+                REQUIRE( handed >= 1 );
+
+                sim::Simulation restored( 0 );
+                restored.restore( file.path );
+                REQUIRE( restored.tick() % 30 == 0 );
+                REQUIRE( restored.tick() >= 30 );
+                while( restored.tick() < simulation.tick() )
+                {
+                    restored.step();
+                }
+                REQUIRE( sim::stateHash( restored.store() ) == sim::stateHash( simulation.store() ) );
+            }
+        }
+
+        WHEN( "the world moves on while a checkpoint is being written" )
+        {
+            simulation.step();
+            auto saved_hash = sim::stateHash( simulation.store() );
+            REQUIRE( checkpointer.checkpoint( simulation.store(), simulation.world_info() ) );
+            for( int i = 0; i < 10; ++i )
+            {
+                simulation.step();
+            }
+            simulation.store().clear();
+            checkpointer.flush();
+
+            THEN( "the file holds the world as it was captured" )
+            {
+                sim::Simulation restored( 0 );
+                restored.restore( file.path );
+                REQUIRE( restored.tick() == 1 );
+                REQUIRE( sim::stateHash( restored.store() ) == saved_hash );
+            }
+        }
+
+        WHEN( "a checkpoint cannot be written" )
+        {
+            wf::Checkpointer broken( "/nonexistent/checkpoint.bin", 0 );
+            REQUIRE( broken.checkpoint( simulation.store(), simulation.world_info() ) );
+            broken.flush();
+
+            THEN( "it is counted as failed" )
+            {
+                REQUIRE( broken.failed() == 1 );
+                REQUIRE( broken.written() == 0 );
+            }
+        }
+    }
+}
+
+SCENARIO( "Runs started from a world file only replay from that file", "[world_file][headless]" )
+{
+    GIVEN( "a world saved at tick 60 and a run recorded from it" )
+    {
+        TemporaryPath saved( "replay_source.bin" );
+        hl::HeadlessOptions save;
+        save.ticks = 60;
+        save.sim_threads = 0;
+        save.checkpoint_path = saved.path;
+        save.checkpoint_interval = 0;
+        REQUIRE( hl::runHeadless( save ).checkpoints_failed == 0 );
+
+        hl::HeadlessOptions run;
+        run.ticks = 120;
+        run.sim_threads = 0;
+        run.load_path = saved.path;
+        auto recorded = hl::runHeadless( run ).recording;
+
+        THEN( "the recording names the tick and state the file was loaded at" )
+        {
+            REQUIRE( recorded.loaded );
+            REQUIRE( recorded.loaded->tick == 60 );
+        }
+
+        WHEN( "it is replayed from the same file" )
+        {
+            run.ticks = 0;
+            run.replay = recorded;
+
+            THEN( "it reaches the recorded hash" )
+            {
+                REQUIRE( hl::runHeadless( run ).matches_replay == true );
+            }
+        }
+
+        WHEN( "it is replayed without the file, or from a different one" )
+        {
+            hl::HeadlessOptions built;
+            built.replay = recorded;
+            run.replay = recorded;
+            run.replay->loaded->hash ^= 1;
+
+            THEN( "the replay is refused" )
+            {
+                REQUIRE_THROWS_AS( hl::runHeadless( built ), std::invalid_argument );
+                REQUIRE_THROWS_AS( hl::runHeadless( run ), std::invalid_argument );
+            }
+        }
+
+        WHEN( "a recording of a built world is replayed from the file" )
+        {
+            run.replay = recorded;
+            run.replay->loaded.reset();
+
+            THEN( "the replay is refused" )
+            {
+                REQUIRE_THROWS_AS( hl::runHeadless( run ), std::invalid_argument );
+            }
+        }
+    }
+}
@@ -0,0 +1,187 @@
+static_assert( __cplusplus > 2020'00 );
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "broad_phase.hpp"
+#include "component_types.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+#include "simulation.hpp"
+#include "systems.hpp"
+#include "worldgen.hpp"
+
+namespace bp = robot::src::exports::broad_phase;
+namespace ct = robot::src::exports::component_types;
+namespace js = robot::src::exports::job_system;
+namespace math = robot::src::exports::math;
+namespace sim = robot::src::exports::simulation;
+namespace sys = robot::src::exports::systems;
+namespace wg = robot::src::exports::worldgen;
+
+SCENARIO( "Philox4x32-10 matches the published known-answer vectors", "[worldgen]" )
+{
+    GIVEN( "the Random123 test counters and keys" )
+    {
+        THEN( "the outputs are those of the reference implementation" )
+        {
+            using Counter = wg::Philox4x32::Counter;
+            REQUIRE( wg::Philox4x32::generate( { 0, 0, 0, 0 }, { 0, 0 } )
+                     == Counter{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } );
+            REQUIRE( wg::Philox4x32::generate( { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+                                               { 0xffffffff, 0xffffffff } )
+                     == Counter{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } );
+            REQUIRE( wg::Philox4x32::generate( { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 },
+                                               { 0xa4093822, 0x299f31d0 } )
+                     == Counter{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } );
+        }
+    }
+}
+
+SCENARIO( "Chunked worlds depend only on their key and options", "[worldgen]" )
+{
+    GIVEN( "a world of a few thousand bodies" )
+    {
+        wg::WorldGenOptions options;
+        options.obstacles = 3000;
+        options.movers = 1000;
+
+        WHEN( "it is generated with and without worker threads" )
+        {
+            sim::Simulation serial( 0 );
+            sim::Simulation parallel( 3 );
+            auto stats = serial.generate( "example_key", options );
+            parallel.generate( "example_key", options );
+
+            THEN( "every body requested is placed, after the robot" )
+            {
+                REQUIRE( stats.obstacles == 3000 );
+                REQUIRE( stats.movers == 1000 );
+                REQUIRE( stats.rejected == 0 );
+                const auto & store = serial.store();
+                REQUIRE( store.registry.size() == 3 + 3000 + 1000 );
+                REQUIRE( store.get< ct::Polygon >().size() == 3 + 3000 );
+                REQUIRE( store.get< ct::ShapeInstance >().size() == 1000 );
+                REQUIRE( store.get< ct::Velocity >().size() == 1 + 1000 );
+                REQUIRE( store.get< ct::HitCounter >().contains( 0 ) );
+                REQUIRE( serial.num_assets() == 3000 );
+            }
+
+            THEN( "both threads counts give the same world" )
+            {
+                REQUIRE( sim::stateHash( serial.store() ) == sim::stateHash( parallel.store() ) );
+                REQUIRE( serial.store().get< ct::Polygon >()[ 100 ].vertices_x
+                         == parallel.store().get< ct::Polygon >()[ 100 ].vertices_x );
+            }
+
+            THEN( "bodies lie in the world, with bounds and normals that match their geometry" )
+            {
+                const auto & store = serial.store();
+                for( auto [ entity, position ] : store.get< ct::Position >() )
+                {
+                    REQUIRE( position.x >= sys::WORLD_BOUNDS.min.x );
+                    REQUIRE( position.x <= sys::WORLD_BOUNDS.max.x );
+                    REQUIRE( position.y >= sys::WORLD_BOUNDS.min.y );
+                    REQUIRE( position.y <= sys::WORLD_BOUNDS.max.y );
+                }
+                for( std::size_t entity : { std::size_t{ 3 }, std::size_t{ 1500 }, std::size_t{ 3002 } } )
+                {
+                    const auto & polygon = store.get< ct::Polygon >()[ entity ];
+                    ct::Polygon copy( polygon );
+                    copy.update_normals();
+                    REQUIRE( copy.normals_x == polygon.normals_x );
+                    REQUIRE( copy.normals_y == polygon.normals_y );
+                    ct::Bounds expected( polygon, store.get< ct::Position >()[ entity ] );
+                    REQUIRE( store.get< ct::Bounds >()[ entity ].world.min.x == expected.world.min.x );
+                    REQUIRE( store.get< ct::Bounds >()[ entity ].world.max.y == expected.world.max.y );
+                }
+            }
+
+            THEN( "a different key gives a different world" )
+            {
+                sim::Simulation other( 0 );
+                other.generate( "other_key", options );
+                REQUIRE( sim::stateHash( other.store() ) != sim::stateHash( serial.store() ) );
+            }
+        }
+    }
+}
+
+SCENARIO( "Overlap rejection keeps every body apart", "[worldgen]" )
+{
+    GIVEN( "a crowded world with rejection on" )
+    {
+        wg::WorldGenOptions options;
+        options.obstacles = 400;
+        options.movers = 100;
+        options.reject_overlaps = true;
+        js::JobSystem jobs( 2 );
+        ct::EntityStore store;
+        ct::VertexArena arena;
+        auto stats = wg::generateWorld( store, arena, "example_key", options, jobs );
+
+        THEN( "some candidates were rejected, and no two placed bodies, or a body and the robot, overlap" )
+        {
+            REQUIRE( stats.rejected > 0 );
+            REQUIRE( stats.obstacles + stats.movers > 100 );
+            REQUIRE( store.registry.size() == 3 + stats.obstacles + stats.movers );
+
+            struct Circle
+            {
+                math::Vec2 center;
+                math::Float radius;
+            };
+            std::vector< Circle > circles{ { { 0.0f, 0.0f }, wg::ROBOT_CLEARANCE } };
+            for( auto [ entity, position ] : store.get< ct::Position >() )
+            {
+                if( entity < 3 )
+                    continue;
+                const auto * polygon = store.get< ct::Polygon >().find( entity );
+                // Vertex 0 of an obstacle lies on its circumcircle, at ( radius, 0 )
+                circles.push_back( { position, polygon ? polygon->vertices_x[ 0 ] : wg::MOVER_RADIUS } );
+            }
+            auto world_size = sys::WORLD_BOUNDS.max - sys::WORLD_BOUNDS.min;
+            for( std::size_t i = 0; i < circles.size(); ++i )
+            {
+                for( std::size_t j = i + 1; j < circles.size(); ++j )
+                {
+                    auto delta = bp::wrappedDelta( circles[ i ].center, circles[ j ].center, world_size );
+                    auto reach = circles[ i ].radius + circles[ j ].radius;
+                    REQUIRE( delta.x * delta.x + delta.y * delta.y >= reach * reach * 0.999f );
+                }
+            }
+        }
+
+        THEN( "the same world comes out of a serial run" )
+        {
+            js::JobSystem serial( 0 );
+            ct::EntityStore again;
+            ct::VertexArena again_arena;
+            auto again_stats = wg::generateWorld( again, again_arena, "example_key", options, serial );
+            REQUIRE( again_stats.obstacles == stats.obstacles );
+            REQUIRE( again_stats.rejected == stats.rejected );
+            REQUIRE( sim::stateHash( again ) == sim::stateHash( store ) );
+        }
+    }
+
+    GIVEN( "impossible chunk layouts" )
+    {
+        js::JobSystem jobs( 0 );
+        ct::EntityStore store;
+        ct::VertexArena arena;
+        wg::WorldGenOptions odd;
+        odd.chunks_per_axis = 7;
+        wg::WorldGenOptions narrow;
+        narrow.chunks_per_axis = 16;
+        narrow.reject_overlaps = true;
+
+        THEN( "generation refuses them" )
+        {
+            REQUIRE_THROWS_AS( wg::generateWorld( store, arena, "k", odd, jobs ), std::invalid_argument );
+            REQUIRE_THROWS_AS( wg::generateWorld( store, arena, "k", narrow, jobs ), std::invalid_argument );
+        }
+    }
+}